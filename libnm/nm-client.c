@@ -263,6 +263,12 @@ typedef struct {
 	CList obj_changed_lst_head;
 	GCancellable *name_owner_get_cancellable;
 	GCancellable *get_managed_objects_cancellable;
+	GCancellable *get_all_settings_cancellable;
+
+	/* remote connections for which a GetSettings() call was requested
+	 * while handling the current batch of D-Bus changes. They get fetched
+	 * together with one GetAllSettings() call. */
+	struct _GetSettingsBatch *get_settings_batch;
 
 	CList queue_notify_lst_head;
 	CList notify_event_lst_head;
@@ -298,6 +304,7 @@ typedef struct {
 	bool notify_event_lst_changed:1;
 	bool check_dbobj_visible_all:1;
 	bool nm_running:1;
+	bool get_all_settings_unsupported:1;
 
 	struct {
 		NMLDBusPropertyO property_o[_PROPERTY_O_IDX_NM_NUM];
@@ -322,6 +329,17 @@ typedef struct {
 	struct {
 		NMLDBusPropertyAO connections;
 		char *hostname;
+
+		/* lookup indexes for nm_client_get_connection_by_uuid() and
+		 * nm_client_get_connection_by_id(). They map the UUID (or ID) to
+		 * a GPtrArray of the connections with that value, and are updated
+		 * when a connection gets added, removed or its settings change.
+		 * connections_idx maps each indexed connection to its ConnectionIdxData,
+		 * which remembers the UUID and ID under which it is indexed. */
+		GHashTable *connections_idx;
+		GHashTable *connections_by_uuid;
+		GHashTable *connections_by_id;
+
 		bool can_modify;
 	} settings;
 
@@ -374,6 +392,12 @@ static void name_owner_get_call (NMClient *self);
 
 static void _set_nm_running (NMClient *self);
 
+static void _get_settings_batch_flush (NMClient *self);
+
+static void _connection_index_update (NMClient *self,
+                                      NMRemoteConnection *connection,
+                                      gboolean is_added);
+
 /*****************************************************************************/
 
 static NMRefString *_dbus_path_nm          = NULL;
@@ -2786,6 +2810,9 @@ again:
 		/* we got new changes enqueued. Need to check again. */
 		goto again;
 	}
+	/* objects may request their settings while being notified (for example
+	 * NMRemoteConnection, if the light-weight properties are missing). */
+	_get_settings_batch_flush (self);
 }
 
 static void
@@ -2834,6 +2861,8 @@ _dbus_handle_obj_changed_dbus (NMClient *self,
 	/* D-Bus changes can only be enqueued in an earlier stage. We don't expect
 	 * anymore changes of type D-Bus at this point. */
 	nm_assert (!nml_dbus_object_obj_changed_any_linked (self, NML_DBUS_OBJ_CHANGED_TYPE_DBUS));
+
+	_get_settings_batch_flush (self);
 }
 
 static void
@@ -3222,17 +3251,14 @@ _nm_client_get_settings_call_cb (GObject *source, GAsyncResult *result, gpointer
 	_dbus_handle_changes_commit (self, TRUE);
 }
 
-void
-_nm_client_get_settings_call (NMClient *self,
-                              NMLDBusObject *dbobj)
+static void
+_get_settings_call_single (NMClient *self,
+                           NMRemoteConnection *remote_connection,
+                           GCancellable *cancellable)
 {
-	GCancellable *cancellable;
-
-	cancellable = _nm_remote_settings_get_settings_prepare (NM_REMOTE_CONNECTION (dbobj->nmobj));
-
 	_nm_client_dbus_call_simple (self,
 	                             cancellable,
-	                             dbobj->dbus_path->str,
+	                             _nm_object_get_path (remote_connection),
 	                             NM_DBUS_INTERFACE_SETTINGS_CONNECTION,
 	                             "GetSettings",
 	                             g_variant_new ("()"),
@@ -3240,7 +3266,194 @@ _nm_client_get_settings_call (NMClient *self,
 	                             G_DBUS_CALL_FLAGS_NONE,
 	                             NM_DBUS_DEFAULT_TIMEOUT_MSEC,
 	                             _nm_client_get_settings_call_cb,
-	                             dbobj->nmobj);
+	                             remote_connection);
+}
+
+typedef struct _GetSettingsBatch {
+	NMClient *self;
+	GPtrArray *remote_connections;
+	GPtrArray *cancellables;
+} GetSettingsBatch;
+
+static void
+_get_settings_batch_free (GetSettingsBatch *batch)
+{
+	g_ptr_array_unref (batch->remote_connections);
+	g_ptr_array_unref (batch->cancellables);
+	g_slice_free (GetSettingsBatch, batch);
+}
+
+static void
+_get_all_settings_call_cb (GObject *source, GAsyncResult *result, gpointer user_data)
+{
+	GetSettingsBatch *batch = user_data;
+	NMClient *self;
+	NMClientPrivate *priv;
+	gs_unref_variant GVariant *ret = NULL;
+	gs_unref_variant GVariant *dict = NULL;
+	gs_free_error GError *error = NULL;
+	gboolean fallback = FALSE;
+	guint i;
+
+	ret = g_dbus_connection_call_finish (G_DBUS_CONNECTION (source), result, &error);
+	if (   !ret
+	    && nm_utils_error_is_cancelled (error)) {
+		_get_settings_batch_free (batch);
+		return;
+	}
+
+	self = batch->self;
+	priv = NM_CLIENT_GET_PRIVATE (self);
+
+	if (!ret) {
+		NML_NMCLIENT_LOG_T (self, "GetAllSettings() for %u connections completed with error: %s",
+		                    batch->remote_connections->len,
+		                    error->message);
+		if (g_error_matches (error, G_DBUS_ERROR, G_DBUS_ERROR_UNKNOWN_METHOD)) {
+			/* NetworkManager is too old. Fetch the settings one by one. */
+			priv->get_all_settings_unsupported = TRUE;
+			fallback = TRUE;
+		}
+	} else {
+		NML_NMCLIENT_LOG_T (self, "GetAllSettings() for %u connections completed with success",
+		                    batch->remote_connections->len);
+		g_variant_get (ret,
+		               "(@a{oa{sa{sv}}})",
+		               &dict);
+	}
+
+	for (i = 0; i < batch->remote_connections->len; i++) {
+		NMRemoteConnection *remote_connection = batch->remote_connections->pdata[i];
+		GCancellable *cancellable = batch->cancellables->pdata[i];
+		gs_unref_variant GVariant *settings = NULL;
+
+		if (g_cancellable_is_cancelled (cancellable)) {
+			/* the connection got unregistered or a newer GetSettings()
+			 * request is pending. */
+			continue;
+		}
+
+		if (fallback) {
+			_get_settings_call_single (self, remote_connection, cancellable);
+			continue;
+		}
+
+		if (dict) {
+			settings = g_variant_lookup_value (dict,
+			                                   _nm_object_get_path (remote_connection),
+			                                   G_VARIANT_TYPE ("a{sa{sv}}"));
+		}
+
+		_nm_remote_settings_get_settings_commit (remote_connection, settings);
+	}
+
+	_get_settings_batch_free (batch);
+
+	if (!fallback)
+		_dbus_handle_changes_commit (self, TRUE);
+}
+
+static void
+_get_settings_batch_flush (NMClient *self)
+{
+	NMClientPrivate *priv = NM_CLIENT_GET_PRIVATE (self);
+	GetSettingsBatch *batch;
+	guint n_all;
+	guint i;
+
+	batch = g_steal_pointer (&priv->get_settings_batch);
+	if (!batch)
+		return;
+
+	/* drop the requests that were already obsoleted. */
+	for (i = batch->remote_connections->len; i > 0; i--) {
+		if (g_cancellable_is_cancelled (batch->cancellables->pdata[i - 1])) {
+			g_ptr_array_remove_index (batch->remote_connections, i - 1);
+			g_ptr_array_remove_index (batch->cancellables, i - 1);
+		}
+	}
+
+	if (   batch->remote_connections->len == 0
+	    || !priv->name_owner) {
+		_get_settings_batch_free (batch);
+		return;
+	}
+
+	/* GetAllSettings() returns all profiles. That only pays off if most of
+	 * them are pending anyway (like during the initial load). Otherwise,
+	 * fetching a few changed profiles would transfer all the others too. */
+	n_all =   priv->settings.connections.hash
+	        ? g_hash_table_size (priv->settings.connections.hash)
+	        : 0u;
+
+	if (   batch->remote_connections->len == 1
+	    || batch->remote_connections->len < (n_all + 1u) / 2u
+	    || priv->get_all_settings_unsupported) {
+		for (i = 0; i < batch->remote_connections->len; i++) {
+			_get_settings_call_single (self,
+			                           batch->remote_connections->pdata[i],
+			                           batch->cancellables->pdata[i]);
+		}
+		_get_settings_batch_free (batch);
+		return;
+	}
+
+	if (!priv->get_all_settings_cancellable)
+		priv->get_all_settings_cancellable = g_cancellable_new ();
+
+	NML_NMCLIENT_LOG_T (self, "GetAllSettings() for %u connections started",
+	                    batch->remote_connections->len);
+
+	_nm_client_dbus_call_simple (self,
+	                             priv->get_all_settings_cancellable,
+	                             NM_DBUS_PATH_SETTINGS,
+	                             NM_DBUS_INTERFACE_SETTINGS,
+	                             "GetAllSettings",
+	                             g_variant_new ("()"),
+	                             G_VARIANT_TYPE ("(a{oa{sa{sv}}})"),
+	                             G_DBUS_CALL_FLAGS_NONE,
+	                             NM_DBUS_DEFAULT_TIMEOUT_MSEC,
+	                             _get_all_settings_call_cb,
+	                             batch);
+}
+
+void
+_nm_client_get_settings_flush (NMClient *self)
+{
+	_get_settings_batch_flush (self);
+}
+
+void
+_nm_client_get_settings_call (NMClient *self,
+                              NMLDBusObject *dbobj)
+{
+	NMClientPrivate *priv = NM_CLIENT_GET_PRIVATE (self);
+	NMRemoteConnection *remote_connection = NM_REMOTE_CONNECTION (dbobj->nmobj);
+	GCancellable *cancellable;
+	GetSettingsBatch *batch;
+
+	cancellable = _nm_remote_settings_get_settings_prepare (remote_connection);
+
+	if (priv->get_all_settings_unsupported) {
+		_get_settings_call_single (self, remote_connection, cancellable);
+		return;
+	}
+
+	/* Defer the request. Requests that pile up while handling one batch
+	 * of D-Bus changes (like the initial GetManagedObjects()) are fetched
+	 * together by _get_settings_batch_flush(). */
+	batch = priv->get_settings_batch;
+	if (!batch) {
+		batch = g_slice_new (GetSettingsBatch);
+		*batch = (GetSettingsBatch) {
+			.self               = self,
+			.remote_connections = g_ptr_array_new_with_free_func (g_object_unref),
+			.cancellables       = g_ptr_array_new_with_free_func (g_object_unref),
+		};
+		priv->get_settings_batch = batch;
+	}
+	g_ptr_array_add (batch->remote_connections, g_object_ref (remote_connection));
+	g_ptr_array_add (batch->cancellables, g_object_ref (cancellable));
 }
 
 static void
@@ -3277,7 +3490,13 @@ _dbus_settings_updated_cb (GDBusConnection *connection,
 	NML_NMCLIENT_LOG_T (self, "%s: [%s] Updated signal received",
 	                    log_context, object_path);
 
+	if (_nm_remote_settings_get_settings_is_deferred (NM_REMOTE_CONNECTION (dbobj->nmobj))) {
+		/* the settings were not yet loaded. There is nothing to refresh. */
+		return;
+	}
+
 	_nm_client_get_settings_call (self, dbobj);
+	_get_settings_batch_flush (self);
 }
 
 /*****************************************************************************/
@@ -3543,6 +3762,8 @@ _property_ao_notify_changed_connections_cb (NMLDBusPropertyAO *pr_ao,
                                             NMObject *nmobj,
                                             gboolean is_added /* or else removed */)
 {
+	_connection_index_update (self, NM_REMOTE_CONNECTION (nmobj), is_added);
+
 	_nm_client_notify_event_queue_emit_obj_signal (self,
 	                                               G_OBJECT (self),
 	                                               nmobj,
@@ -5425,6 +5646,148 @@ nm_client_get_connections (NMClient *client)
 	return nml_dbus_property_ao_get_objs_as_ptrarray (&NM_CLIENT_GET_PRIVATE (client)->settings.connections);
 }
 
+typedef struct {
+	NMRemoteConnection *connection;
+	char *uuid;
+	char *id;
+} ConnectionIdxData;
+
+static void
+_connection_idx_data_free (gpointer data)
+{
+	ConnectionIdxData *idx_data = data;
+
+	g_free (idx_data->uuid);
+	g_free (idx_data->id);
+	g_slice_free (ConnectionIdxData, idx_data);
+}
+
+static void
+_connection_idx_bucket_add (GHashTable *idx,
+                            const char *key,
+                            NMRemoteConnection *connection)
+{
+	GPtrArray *bucket;
+
+	if (!key)
+		return;
+
+	bucket = g_hash_table_lookup (idx, key);
+	if (!bucket) {
+		bucket = g_ptr_array_new ();
+		g_hash_table_insert (idx, g_strdup (key), bucket);
+	}
+	g_ptr_array_add (bucket, connection);
+}
+
+static void
+_connection_idx_bucket_remove (GHashTable *idx,
+                               const char *key,
+                               NMRemoteConnection *connection)
+{
+	GPtrArray *bucket;
+
+	if (!key)
+		return;
+
+	bucket = g_hash_table_lookup (idx, key);
+	if (!bucket)
+		g_return_if_reached ();
+
+	/* keep the order, the first connection added wins on lookup. */
+	if (!g_ptr_array_remove (bucket, connection))
+		g_return_if_reached ();
+	if (bucket->len == 0)
+		g_hash_table_remove (idx, key);
+}
+
+static void
+_connection_index_update (NMClient *self,
+                          NMRemoteConnection *connection,
+                          gboolean is_added /* or else removed */)
+{
+	NMClientPrivate *priv = NM_CLIENT_GET_PRIVATE (self);
+	ConnectionIdxData *idx_data;
+	const char *uuid;
+	const char *id;
+
+	if (!priv->settings.connections_idx) {
+		if (!is_added)
+			return;
+		priv->settings.connections_idx = g_hash_table_new_full (nm_direct_hash, NULL, NULL, _connection_idx_data_free);
+		priv->settings.connections_by_uuid = g_hash_table_new_full (nm_str_hash, g_str_equal, g_free, (GDestroyNotify) g_ptr_array_unref);
+		priv->settings.connections_by_id = g_hash_table_new_full (nm_str_hash, g_str_equal, g_free, (GDestroyNotify) g_ptr_array_unref);
+	}
+
+	idx_data = g_hash_table_lookup (priv->settings.connections_idx, connection);
+
+	if (!is_added) {
+		if (!idx_data)
+			return;
+		_connection_idx_bucket_remove (priv->settings.connections_by_uuid, idx_data->uuid, connection);
+		_connection_idx_bucket_remove (priv->settings.connections_by_id, idx_data->id, connection);
+		g_hash_table_remove (priv->settings.connections_idx, connection);
+		return;
+	}
+
+	if (!idx_data) {
+		idx_data = g_slice_new0 (ConnectionIdxData);
+		idx_data->connection = connection;
+		g_hash_table_insert (priv->settings.connections_idx, connection, idx_data);
+	}
+
+	/* only touch the buckets of the values that changed. */
+	uuid = nm_connection_get_uuid (NM_CONNECTION (connection));
+	if (!nm_streq0 (uuid, idx_data->uuid)) {
+		_connection_idx_bucket_remove (priv->settings.connections_by_uuid, idx_data->uuid, connection);
+		g_free (idx_data->uuid);
+		idx_data->uuid = g_strdup (uuid);
+		_connection_idx_bucket_add (priv->settings.connections_by_uuid, idx_data->uuid, connection);
+	}
+
+	id = nm_connection_get_id (NM_CONNECTION (connection));
+	if (!nm_streq0 (id, idx_data->id)) {
+		_connection_idx_bucket_remove (priv->settings.connections_by_id, idx_data->id, connection);
+		g_free (idx_data->id);
+		idx_data->id = g_strdup (id);
+		_connection_idx_bucket_add (priv->settings.connections_by_id, idx_data->id, connection);
+	}
+}
+
+void
+_nm_client_connection_index_changed (NMClient *self,
+                                     NMRemoteConnection *connection)
+{
+	NMClientPrivate *priv = NM_CLIENT_GET_PRIVATE (self);
+
+	/* only connections that are part of nm_client_get_connections() are
+	 * indexed. Others get indexed once they are added. */
+	if (   !priv->settings.connections_idx
+	    || !g_hash_table_contains (priv->settings.connections_idx, connection))
+		return;
+
+	_connection_index_update (self, connection, TRUE);
+}
+
+static void
+_connection_index_clear (NMClient *self)
+{
+	NMClientPrivate *priv = NM_CLIENT_GET_PRIVATE (self);
+
+	nm_clear_pointer (&priv->settings.connections_by_uuid, g_hash_table_unref);
+	nm_clear_pointer (&priv->settings.connections_by_id, g_hash_table_unref);
+	nm_clear_pointer (&priv->settings.connections_idx, g_hash_table_unref);
+}
+
+static NMRemoteConnection *
+_connection_index_lookup (GHashTable *idx, const char *key)
+{
+	GPtrArray *bucket;
+
+	bucket = idx ? g_hash_table_lookup (idx, key) : NULL;
+	return bucket ? bucket->pdata[0] : NULL;
+}
+
 /**
  * nm_client_get_connection_by_id:
  * @client: the %NMClient
@@ -5441,20 +5804,10 @@ nm_client_get_connections (NMClient *client)
 NMRemoteConnection *
 nm_client_get_connection_by_id (NMClient *client, const char *id)
 {
-	const GPtrArray *arr;
-	guint i;
-
 	g_return_val_if_fail (NM_IS_CLIENT (client), NULL);
 	g_return_val_if_fail (id, NULL);
 
-	arr = nm_client_get_connections (client);
-	for (i = 0; i < arr->len; i++) {
-		NMRemoteConnection *c = NM_REMOTE_CONNECTION (arr->pdata[i]);
-
-		if (nm_streq0 (id, nm_connection_get_id (NM_CONNECTION (c))))
-			return c;
-	}
-	return NULL;
+	return _connection_index_lookup (NM_CLIENT_GET_PRIVATE (client)->settings.connections_by_id, id);
 }
 
 /**
@@ -5495,20 +5848,10 @@ nm_client_get_connection_by_path (NMClient *client, const char *path)
 NMRemoteConnection *
 nm_client_get_connection_by_uuid (NMClient *client, const char *uuid)
 {
-	const GPtrArray *arr;
-	guint i;
-
 	g_return_val_if_fail (NM_IS_CLIENT (client), NULL);
 	g_return_val_if_fail (uuid, NULL);
 
-	arr = nm_client_get_connections (client);
-	for (i = 0; i < arr->len; i++) {
-		NMRemoteConnection *c = NM_REMOTE_CONNECTION (arr->pdata[i]);
-
-		if (nm_streq0 (uuid, nm_connection_get_uuid (NM_CONNECTION (c))))
-			return c;
-	}
-	return NULL;
+	return _connection_index_lookup (NM_CLIENT_GET_PRIVATE (client)->settings.connections_by_uuid, uuid);
 }
 
 /*****************************************************************************/
@@ -5783,6 +6126,207 @@ nm_client_add_connection2_finish (NMClient *client,
 	                                                   error));
 }
 
+/**
+ * nm_client_add_connections_async:
+ * @client: the %NMClient
+ * @connections: (element-type NMConnection): the connections to add. Note that
+ *   the settings of the objects will be added, not the objects themselves.
+ * @flags: the %NMSettingsAddConnection2Flags argument. It applies to all
+ *   profiles.
+ * @args: (allow-none): the "a{sv}" #GVariant with extra argument or %NULL
+ *   for no extra arguments.
+ * @cancellable: a #GCancellable, or %NULL
+ * @callback: (scope async): callback to be called when the add operation completes
+ * @user_data: (closure): caller-specific data passed to @callback
+ *
+ * Call AddConnections() D-Bus API asynchronously. This adds several
+ * profiles with one request. The request is authorized only once and
+ * the server writes and announces the profiles together.
+ *
+ * Since: 1.24
+ **/
+void
+nm_client_add_connections_async (NMClient *client,
+                                 const GPtrArray *connections,
+                                 NMSettingsAddConnection2Flags flags,
+                                 GVariant *args,
+                                 GCancellable *cancellable,
+                                 GAsyncReadyCallback callback,
+                                 gpointer user_data)
+{
+	GVariantBuilder builder;
+	guint i;
+
+	g_return_if_fail (NM_IS_CLIENT (client));
+	g_return_if_fail (connections);
+	g_return_if_fail (!args || g_variant_is_of_type (args, G_VARIANT_TYPE ("a{sv}")));
+
+	for (i = 0; i < connections->len; i++)
+		g_return_if_fail (NM_IS_CONNECTION (connections->pdata[i]));
+
+	g_variant_builder_init (&builder, G_VARIANT_TYPE ("aa{sa{sv}}"));
+	for (i = 0; i < connections->len; i++) {
+		g_variant_builder_add_value (&builder,
+		                             nm_connection_to_dbus (connections->pdata[i], NM_CONNECTION_SERIALIZE_ALL));
+	}
+
+	_nm_client_dbus_call (client,
+	                      client,
+	                      nm_client_add_connections_async,
+	                      cancellable,
+	                      callback,
+	                      user_data,
+	                      NM_DBUS_PATH_SETTINGS,
+	                      NM_DBUS_INTERFACE_SETTINGS,
+	                      "AddConnections",
+	                      g_variant_new ("(aa{sa{sv}}u@a{sv})",
+	                                     &builder,
+	                                     (guint32) flags,
+	                                        args
+	                                     ?: g_variant_new_array (G_VARIANT_TYPE ("{sv}"), NULL, 0)),
+	                      G_VARIANT_TYPE ("(aa{sv})"),
+	                      G_DBUS_CALL_FLAGS_NONE,
+	                      NM_DBUS_DEFAULT_TIMEOUT_MSEC,
+	                      nm_dbus_connection_call_finish_variant_strip_dbus_error_cb);
+}
+
+static GVariant *
+_batch_connections_finish (NMClient *client,
+                           GAsyncResult *result,
+                           gpointer source_tag,
+                           GError **error)
+{
+	gs_unref_variant GVariant *ret = NULL;
+	GVariant *v_results;
+
+	g_return_val_if_fail (NM_IS_CLIENT (client), NULL);
+	g_return_val_if_fail (nm_g_task_is_valid (result, client, source_tag), NULL);
+
+	ret = g_task_propagate_pointer (G_TASK (result), error);
+	if (!ret)
+		return NULL;
+
+	g_variant_get (ret,
+	               "(@aa{sv})",
+	               &v_results);
+
+	return v_results;
+}
+
+/**
+ * nm_client_add_connections_finish:
+ * @client: the #NMClient
+ * @result: the #GAsyncResult
+ * @error: (allow-none): the error argument.
+ *
+ * Gets the result of a call to nm_client_add_connections_async().
+ *
+ * Returns: (transfer full): on success, a "aa{sv}" #GVariant with one
+ *   result for each requested connection, in the same order. On success,
+ *   the result contains the "path" of the new profile. Otherwise, it
+ *   contains an "error" string. The function only fails as a whole
+ *   if the request itself failed.
+ *
+ * Since: 1.24
+ **/
+GVariant *
+nm_client_add_connections_finish (NMClient *client,
+                                  GAsyncResult *result,
+                                  GError **error)
+{
+	return _batch_connections_finish (client, result, nm_client_add_connections_async, error);
+}
+
+/**
+ * nm_client_update_connections_async:
+ * @client: the %NMClient
+ * @connections: (element-type NMRemoteConnection): the connections to update.
+ *   Like for nm_remote_connection_commit_changes_async(), the local settings
+ *   and properties of each connection are sent to NetworkManager.
+ * @flags: the %NMSettingsUpdate2Flags argument. It applies to all profiles.
+ * @args: (allow-none): the "a{sv}" #GVariant with extra argument or %NULL
+ *   for no extra arguments.
+ * @cancellable: a #GCancellable, or %NULL
+ * @callback: (scope async): callback to be called when the update operation completes
+ * @user_data: (closure): caller-specific data passed to @callback
+ *
+ * Call UpdateConnections() D-Bus API asynchronously. This updates several
+ * profiles with one request.
+ *
+ * Since: 1.24
+ **/
+void
+nm_client_update_connections_async (NMClient *client,
+                                    const GPtrArray *connections,
+                                    NMSettingsUpdate2Flags flags,
+                                    GVariant *args,
+                                    GCancellable *cancellable,
+                                    GAsyncReadyCallback callback,
+                                    gpointer user_data)
+{
+	GVariantBuilder builder;
+	guint i;
+
+	g_return_if_fail (NM_IS_CLIENT (client));
+	g_return_if_fail (connections);
+	g_return_if_fail (!args || g_variant_is_of_type (args, G_VARIANT_TYPE ("a{sv}")));
+
+	for (i = 0; i < connections->len; i++)
+		g_return_if_fail (NM_IS_REMOTE_CONNECTION (connections->pdata[i]));
+
+	g_variant_builder_init (&builder, G_VARIANT_TYPE ("a(oa{sa{sv}})"));
+	for (i = 0; i < connections->len; i++) {
+		NMRemoteConnection *connection = connections->pdata[i];
+
+		g_variant_builder_add (&builder,
+		                       "(o@a{sa{sv}})",
+		                       _nm_object_get_path (connection),
+		                       nm_connection_to_dbus (NM_CONNECTION (connection),
+		                                              NM_CONNECTION_SERIALIZE_ALL));
+	}
+
+	_nm_client_dbus_call (client,
+	                      client,
+	                      nm_client_update_connections_async,
+	                      cancellable,
+	                      callback,
+	                      user_data,
+	                      NM_DBUS_PATH_SETTINGS,
+	                      NM_DBUS_INTERFACE_SETTINGS,
+	                      "UpdateConnections",
+	                      g_variant_new ("(a(oa{sa{sv}})u@a{sv})",
+	                                     &builder,
+	                                     (guint32) flags,
+	                                        args
+	                                     ?: g_variant_new_array (G_VARIANT_TYPE ("{sv}"), NULL, 0)),
+	                      G_VARIANT_TYPE ("(aa{sv})"),
+	                      G_DBUS_CALL_FLAGS_NONE,
+	                      NM_DBUS_DEFAULT_TIMEOUT_MSEC,
+	                      nm_dbus_connection_call_finish_variant_strip_dbus_error_cb);
+}
+
+/**
+ * nm_client_update_connections_finish:
+ * @client: the #NMClient
+ * @result: the #GAsyncResult
+ * @error: (allow-none): the error argument.
+ *
+ * Gets the result of a call to nm_client_update_connections_async().
+ *
+ * Returns: (transfer full): on success, a "aa{sv}" #GVariant with one
+ *   result for each requested connection, in the same order. See
+ *   nm_client_add_connections_finish().
+ *
+ * Since: 1.24
+ **/
+GVariant *
+nm_client_update_connections_finish (NMClient *client,
+                                     GAsyncResult *result,
+                                     GError **error)
+{
+	return _batch_connections_finish (client, result, nm_client_update_connections_async, error);
+}
+
 /*****************************************************************************/
 
 /**
@@ -6752,6 +7296,8 @@ _init_release_all (NMClient *self)
 
 	nm_clear_g_cancellable (&priv->permissions_cancellable);
 	nm_clear_g_cancellable (&priv->get_managed_objects_cancellable);
+	nm_clear_g_cancellable (&priv->get_all_settings_cancellable);
+	priv->get_all_settings_unsupported = FALSE;
 
 	nm_clear_g_dbus_connection_signal (priv->dbus_connection,
 	                                   &priv->dbsid_nm_object_manager);
@@ -6805,6 +7351,7 @@ _init_release_all (NMClient *self)
 	 * away. Note that a NMLDBusObject can be alive due to a NMLDBusObjWatcher, but
 	 * even those should be all cleaned up. */
 	nm_assert (c_list_is_empty (&priv->obj_changed_lst_head));
+	nm_assert (!priv->get_settings_batch);
 	nm_assert (c_list_is_empty (&priv->dbus_objects_lst_head_watched_only));
 	nm_assert (c_list_is_empty (&priv->dbus_objects_lst_head_on_dbus));
 	nm_assert (c_list_is_empty (&priv->dbus_objects_lst_head_with_nmobj_not_ready));
@@ -7676,6 +8223,7 @@ dispose (GObject *object)
 
 	nml_dbus_property_ao_clear (&priv->settings.connections, NULL);
 	nm_clear_g_free (&priv->settings.hostname);
+	_connection_index_clear (self);
 
 	nm_clear_pointer (&priv->dns_manager.configuration, g_ptr_array_unref);
 	nm_clear_g_free (&priv->dns_manager.mode);
@@ -24,12 +24,20 @@ G_BEGIN_DECLS
  *   can be disabled. You can toggle this flag to enable and disable automatic
  *   fetching of the permissions. Watch also nm_client_get_permissions_state()
  *   to know whether the permissions are up to date.
+ * @NM_CLIENT_INSTANCE_FLAGS_NO_AUTO_FETCH_SETTINGS: by default, NMClient
+ *   fetches the settings of all connection profiles. With this flag, only
+ *   the "connection.id", "connection.uuid" and "connection.type" of the
+ *   profiles are populated from light-weight D-Bus properties. The full
+ *   settings of a #NMRemoteConnection are only fetched on demand, by calling
+ *   nm_remote_connection_load_settings_async(). This flag can only be set
+ *   during construction. Since 1.24.
  *
  * Since: 1.24
  */
 typedef enum { /*< flags >*/
 	NM_CLIENT_INSTANCE_FLAGS_NONE                      = 0,
 	NM_CLIENT_INSTANCE_FLAGS_NO_AUTO_FETCH_PERMISSIONS = 1,
+	NM_CLIENT_INSTANCE_FLAGS_NO_AUTO_FETCH_SETTINGS    = 2,
 } NMClientInstanceFlags;
 
 #define NM_TYPE_CLIENT            (nm_client_get_type ())
@@ -379,6 +387,34 @@ NMRemoteConnection *nm_client_add_connection2_finish (NMClient *client,
                                                       GVariant **out_result,
                                                       GError **error);
 
+NM_AVAILABLE_IN_1_24
+void nm_client_add_connections_async (NMClient *client,
+                                      const GPtrArray *connections,
+                                      NMSettingsAddConnection2Flags flags,
+                                      GVariant *args,
+                                      GCancellable *cancellable,
+                                      GAsyncReadyCallback callback,
+                                      gpointer user_data);
+
+NM_AVAILABLE_IN_1_24
+GVariant *nm_client_add_connections_finish (NMClient *client,
+                                            GAsyncResult *result,
+                                            GError **error);
+
+NM_AVAILABLE_IN_1_24
+void nm_client_update_connections_async (NMClient *client,
+                                         const GPtrArray *connections,
+                                         NMSettingsUpdate2Flags flags,
+                                         GVariant *args,
+                                         GCancellable *cancellable,
+                                         GAsyncReadyCallback callback,
+                                         gpointer user_data);
+
+NM_AVAILABLE_IN_1_24
+GVariant *nm_client_update_connections_finish (NMClient *client,
+                                               GAsyncResult *result,
+                                               GError **error);
+
 _NM_DEPRECATED_SYNC_METHOD
 gboolean nm_client_load_connections        (NMClient *client,
                                             char **filenames,
@@ -233,7 +233,7 @@ typedef enum {
 
 /*****************************************************************************/
 
-#define NM_CLIENT_INSTANCE_FLAGS_ALL ((NMClientInstanceFlags) 0x1)
+#define NM_CLIENT_INSTANCE_FLAGS_ALL ((NMClientInstanceFlags) 0x3)
 
 typedef struct {
 	GType (*get_o_type_fcn) (void);
@@ -995,8 +995,15 @@ void _nm_client_set_property_sync_legacy (NMClient *self,
 void _nm_client_get_settings_call (NMClient *self,
                                    NMLDBusObject *dbobj);
 
+void _nm_client_get_settings_flush (NMClient *self);
+
+void _nm_client_connection_index_changed (NMClient *self,
+                                          NMRemoteConnection *connection);
+
 GCancellable *_nm_remote_settings_get_settings_prepare (NMRemoteConnection *self);
 
+gboolean _nm_remote_settings_get_settings_is_deferred (NMRemoteConnection *self);
+
 void _nm_remote_settings_get_settings_commit (NMRemoteConnection *self,
                                               GVariant *settings);
 
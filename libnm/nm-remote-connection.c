@@ -36,13 +36,31 @@ NM_GOBJECT_PROPERTIES_DEFINE (NMRemoteConnection,
 
 typedef struct {
 	GCancellable *get_settings_cancellable;
+	GSList *load_settings_tasks;
 
 	char *filename;
 	guint32 flags;
 	bool unsaved;
 
+	/* the light-weight "Id", "Uuid" and "Type" properties. They are used
+	 * to populate the connection setting as long as the full settings
+	 * are not loaded. */
+	struct {
+		char *id;
+		char *uuid;
+		char *type;
+	} lw;
+
 	bool visible:1;
 	bool is_initialized:1;
+
+	/* whether the client was created with NM_CLIENT_INSTANCE_FLAGS_NO_AUTO_FETCH_SETTINGS. */
+	bool lazy:1;
+
+	/* whether we fetch (and refresh) the full settings via GetSettings(). */
+	bool fetch_settings:1;
+
+	bool settings_loaded:1;
 } NMRemoteConnectionPrivate;
 
 struct _NMRemoteConnection {
@@ -626,8 +644,215 @@ nm_remote_connection_get_visible (NMRemoteConnection *connection)
 	return NM_REMOTE_CONNECTION_GET_PRIVATE (connection)->visible;
 }
 
+/**
+ * nm_remote_connection_get_settings_loaded:
+ * @connection: the #NMRemoteConnection
+ *
+ * If the #NMClient was created with %NM_CLIENT_INSTANCE_FLAGS_NO_AUTO_FETCH_SETTINGS,
+ * the connection only contains the "connection.id", "connection.uuid" and
+ * "connection.type" until the settings get loaded with
+ * nm_remote_connection_load_settings_async().
+ *
+ * Returns: %TRUE if the full settings of the connection are loaded.
+ *
+ * Since: 1.24
+ **/
+gboolean
+nm_remote_connection_get_settings_loaded (NMRemoteConnection *connection)
+{
+	g_return_val_if_fail (NM_IS_REMOTE_CONNECTION (connection), FALSE);
+
+	return NM_REMOTE_CONNECTION_GET_PRIVATE (connection)->settings_loaded;
+}
+
+/**
+ * nm_remote_connection_load_settings_async:
+ * @connection: the #NMRemoteConnection
+ * @cancellable: a #GCancellable, or %NULL
+ * @callback: callback to be called when the settings are loaded
+ * @user_data: caller-specific data passed to @callback
+ *
+ * Fetches the full settings of the connection. This is only necessary
+ * if the #NMClient was created with %NM_CLIENT_INSTANCE_FLAGS_NO_AUTO_FETCH_SETTINGS.
+ * Otherwise, the settings are already loaded and the request completes
+ * right away.
+ *
+ * Once loaded, the settings are kept up to date like for any other
+ * connection.
+ *
+ * Since: 1.24
+ **/
+void
+nm_remote_connection_load_settings_async (NMRemoteConnection *connection,
+                                          GCancellable *cancellable,
+                                          GAsyncReadyCallback callback,
+                                          gpointer user_data)
+{
+	NMRemoteConnectionPrivate *priv;
+	gs_unref_object GTask *task = NULL;
+	NMClient *client;
+
+	g_return_if_fail (NM_IS_REMOTE_CONNECTION (connection));
+	g_return_if_fail (!cancellable || G_IS_CANCELLABLE (cancellable));
+
+	priv = NM_REMOTE_CONNECTION_GET_PRIVATE (connection);
+
+	task = nm_g_task_new (connection, cancellable, nm_remote_connection_load_settings_async, callback, user_data);
+
+	client = _nm_object_get_client (connection);
+	if (!client) {
+		g_task_return_error (task, _nm_client_new_error_nm_not_cached ());
+		return;
+	}
+
+	if (   priv->settings_loaded
+	    && !priv->get_settings_cancellable) {
+		g_task_return_boolean (task, TRUE);
+		return;
+	}
+
+	priv->load_settings_tasks = g_slist_append (priv->load_settings_tasks, g_steal_pointer (&task));
+
+	if (!priv->get_settings_cancellable) {
+		priv->fetch_settings = TRUE;
+		_nm_client_get_settings_call (client, _nm_object_get_dbobj (connection));
+		_nm_client_get_settings_flush (client);
+	}
+}
+
+/**
+ * nm_remote_connection_load_settings_finish:
+ * @connection: the #NMRemoteConnection
+ * @result: the result passed to the #GAsyncReadyCallback
+ * @error: location for a #GError, or %NULL
+ *
+ * Gets the result of a call to nm_remote_connection_load_settings_async().
+ *
+ * Returns: %TRUE if the settings were loaded. On success, the
+ * #NMRemoteConnection contains the full settings.
+ *
+ * Since: 1.24
+ **/
+gboolean
+nm_remote_connection_load_settings_finish (NMRemoteConnection *connection,
+                                           GAsyncResult *result,
+                                           GError **error)
+{
+	g_return_val_if_fail (NM_IS_REMOTE_CONNECTION (connection), FALSE);
+	g_return_val_if_fail (nm_g_task_is_valid (result, connection, nm_remote_connection_load_settings_async), FALSE);
+
+	return g_task_propagate_boolean (G_TASK (result), error);
+}
+
+static void
+_load_settings_tasks_complete (NMRemoteConnection *self,
+                               GError *error)
+{
+	NMRemoteConnectionPrivate *priv = NM_REMOTE_CONNECTION_GET_PRIVATE (self);
+	GSList *tasks;
+	GSList *iter;
+
+	tasks = g_steal_pointer (&priv->load_settings_tasks);
+	for (iter = tasks; iter; iter = iter->next) {
+		gs_unref_object GTask *task = iter->data;
+
+		if (error)
+			g_task_return_error (task, g_error_copy (error));
+		else
+			g_task_return_boolean (task, TRUE);
+	}
+	g_slist_free (tasks);
+}
+
+static void
+_lw_settings_apply (NMRemoteConnection *self)
+{
+	NMRemoteConnectionPrivate *priv = NM_REMOTE_CONNECTION_GET_PRIVATE (self);
+	NMSettingConnection *s_con;
+
+	nm_assert (!priv->settings_loaded);
+
+	if (!priv->lw.uuid) {
+		/* without UUID the connection is not valid. Wait for the properties. */
+		return;
+	}
+
+	s_con = nm_connection_get_setting_connection (NM_CONNECTION (self));
+	if (!s_con) {
+		s_con = NM_SETTING_CONNECTION (nm_setting_connection_new ());
+		nm_connection_add_setting (NM_CONNECTION (self), NM_SETTING (s_con));
+	}
+
+	g_object_set (s_con,
+	              NM_SETTING_CONNECTION_ID, priv->lw.id,
+	              NM_SETTING_CONNECTION_UUID, priv->lw.uuid,
+	              NM_SETTING_CONNECTION_TYPE, priv->lw.type,
+	              NULL);
+}
+
+static void
+_lw_settings_fallback (NMRemoteConnection *self)
+{
+	NMRemoteConnectionPrivate *priv = NM_REMOTE_CONNECTION_GET_PRIVATE (self);
+
+	/* The daemon doesn't export the light-weight properties. Either it is
+	 * too old, or the profile is restricted to certain users. Fall back
+	 * to GetSettings(), which also tells whether the profile is visible
+	 * to us. From now on, the settings are kept up to date as usual. */
+	priv->fetch_settings = TRUE;
+	_nm_client_get_settings_call (_nm_object_get_client (self), _nm_object_get_dbobj (self));
+}
+
+static NMLDBusNotifyUpdatePropFlags
+_notify_update_prop_lw (NMClient *client,
+                        NMLDBusObject *dbobj,
+                        const NMLDBusMetaIface *meta_iface,
+                        guint dbus_property_idx,
+                        GVariant *value)
+{
+	NMRemoteConnection *self = NM_REMOTE_CONNECTION (dbobj->nmobj);
+	NMRemoteConnectionPrivate *priv = NM_REMOTE_CONNECTION_GET_PRIVATE (self);
+	const char *dbus_property_name = meta_iface->dbus_properties[dbus_property_idx].dbus_property_name;
+	const char *str = NULL;
+	char **p_str;
+
+	if (nm_streq (dbus_property_name, "Id"))
+		p_str = &priv->lw.id;
+	else if (nm_streq (dbus_property_name, "Uuid"))
+		p_str = &priv->lw.uuid;
+	else {
+		nm_assert (nm_streq (dbus_property_name, "Type"));
+		p_str = &priv->lw.type;
+	}
+
+	if (value)
+		str = g_variant_get_string (value, NULL);
+
+	if (!nm_utils_strdup_reset (p_str, nm_str_not_empty (str)))
+		return NML_DBUS_NOTIFY_UPDATE_PROP_FLAGS_NONE;
+
+	if (   priv->is_initialized
+	    && !priv->settings_loaded
+	    && !priv->fetch_settings) {
+		if (priv->lw.uuid)
+			_lw_settings_apply (self);
+		else {
+			/* the profile got restricted to certain users. */
+			_lw_settings_fallback (self);
+		}
+	}
+
+	return NML_DBUS_NOTIFY_UPDATE_PROP_FLAGS_NONE;
+}
+
 /*****************************************************************************/
 
+gboolean
+_nm_remote_settings_get_settings_is_deferred (NMRemoteConnection *self)
+{
+	return !NM_REMOTE_CONNECTION_GET_PRIVATE (self)->fetch_settings;
+}
+
 GCancellable *
 _nm_remote_settings_get_settings_prepare (NMRemoteConnection *self)
 {
@@ -668,6 +893,18 @@ _nm_remote_settings_get_settings_commit (NMRemoteConnection *self,
 	} else
 		nm_connection_clear_settings (NM_CONNECTION (self));
 
+	priv->settings_loaded = visible;
+
+	if (   priv->lazy
+	    && !visible
+	    && priv->lw.uuid) {
+		/* loading the settings on demand failed. Keep what we know from the
+		 * light-weight properties. The daemon exports the connection, so we
+		 * still consider it visible. */
+		_lw_settings_apply (self);
+		visible = TRUE;
+	}
+
 	if (priv->visible != visible) {
 		priv->visible = visible;
 		_nm_client_queue_notify_object (_nm_object_get_client (self),
@@ -678,6 +915,17 @@ _nm_remote_settings_get_settings_commit (NMRemoteConnection *self,
 
 	if (changed)
 		_nm_client_notify_object_changed (_nm_object_get_client (self), _nm_object_get_dbobj (self));
+
+	if (priv->load_settings_tasks) {
+		gs_free_error GError *error = NULL;
+
+		if (!priv->settings_loaded) {
+			error = g_error_new_literal (NM_CLIENT_ERROR,
+			                             NM_CLIENT_ERROR_FAILED,
+			                             "failure to load the settings of the connection");
+		}
+		_load_settings_tasks_complete (self, error);
+	}
 }
 
 /*****************************************************************************/
@@ -700,10 +948,46 @@ register_client (NMObject *nmobj,
                  NMClient *client,
                  NMLDBusObject *dbobj)
 {
+	NMRemoteConnectionPrivate *priv = NM_REMOTE_CONNECTION_GET_PRIVATE (nmobj);
+
 	NM_OBJECT_CLASS (nm_remote_connection_parent_class)->register_client (nmobj, client, dbobj);
 	nm_connection_set_path (NM_CONNECTION (nmobj),
 	                        dbobj->dbus_path->str);
-	_nm_client_get_settings_call (client, dbobj);
+
+	priv->lazy = NM_FLAGS_HAS (nm_client_get_instance_flags (client),
+	                           NM_CLIENT_INSTANCE_FLAGS_NO_AUTO_FETCH_SETTINGS);
+	priv->fetch_settings = !priv->lazy;
+
+	if (priv->fetch_settings)
+		_nm_client_get_settings_call (client, dbobj);
+
+	/* Otherwise, don't fetch the settings and use the light-weight properties
+	 * instead. They are not yet set at this point, obj_changed_notify() decides
+	 * once they are. */
+}
+
+static void
+obj_changed_notify (NMObject *nmobj)
+{
+	NMRemoteConnection *self = NM_REMOTE_CONNECTION (nmobj);
+	NMRemoteConnectionPrivate *priv = NM_REMOTE_CONNECTION_GET_PRIVATE (self);
+
+	NM_OBJECT_CLASS (nm_remote_connection_parent_class)->obj_changed_notify (nmobj);
+
+	if (   priv->is_initialized
+	    || priv->fetch_settings)
+		return;
+
+	nm_assert (priv->lazy);
+
+	if (!priv->lw.uuid) {
+		_lw_settings_fallback (self);
+		return;
+	}
+
+	priv->is_initialized = TRUE;
+	priv->visible = TRUE;
+	_lw_settings_apply (self);
 }
 
 static void
@@ -711,7 +995,14 @@ unregister_client (NMObject *nmobj,
                    NMClient *client,
                    NMLDBusObject *dbobj)
 {
-	nm_clear_g_cancellable (&NM_REMOTE_CONNECTION_GET_PRIVATE (nmobj)->get_settings_cancellable);
+	NMRemoteConnectionPrivate *priv = NM_REMOTE_CONNECTION_GET_PRIVATE (nmobj);
+
+	nm_clear_g_cancellable (&priv->get_settings_cancellable);
+	if (priv->load_settings_tasks) {
+		gs_free_error GError *error = _nm_client_new_error_nm_not_cached ();
+
+		_load_settings_tasks_complete (NM_REMOTE_CONNECTION (nmobj), error);
+	}
 	NM_OBJECT_CLASS (nm_remote_connection_parent_class)->unregister_client (nmobj, client, dbobj);
 }
 
@@ -753,6 +1044,9 @@ dispose (GObject *object)
 	NMRemoteConnectionPrivate *priv = NM_REMOTE_CONNECTION_GET_PRIVATE (object);
 
 	nm_clear_g_free (&priv->filename);
+	nm_clear_g_free (&priv->lw.id);
+	nm_clear_g_free (&priv->lw.uuid);
+	nm_clear_g_free (&priv->lw.type);
 
 	G_OBJECT_CLASS (nm_remote_connection_parent_class)->dispose (object);
 }
@@ -762,9 +1056,12 @@ const NMLDBusMetaIface _nml_dbus_meta_iface_nm_settings_connection = NML_DBUS_ME
 	nm_remote_connection_get_type,
 	NML_DBUS_META_INTERFACE_PRIO_INSTANTIATE_HIGH,
 	NML_DBUS_META_IFACE_DBUS_PROPERTIES (
-		NML_DBUS_META_PROPERTY_INIT_S ("Filename", PROP_FILENAME, NMRemoteConnection, _priv.filename ),
-		NML_DBUS_META_PROPERTY_INIT_U ("Flags",    PROP_FLAGS,    NMRemoteConnection, _priv.flags    ),
-		NML_DBUS_META_PROPERTY_INIT_B ("Unsaved",  PROP_UNSAVED,  NMRemoteConnection, _priv.unsaved  ),
+		NML_DBUS_META_PROPERTY_INIT_S   ("Filename", PROP_FILENAME, NMRemoteConnection, _priv.filename ),
+		NML_DBUS_META_PROPERTY_INIT_U   ("Flags",    PROP_FLAGS,    NMRemoteConnection, _priv.flags    ),
+		NML_DBUS_META_PROPERTY_INIT_FCN ("Id",       0,             "s",                _notify_update_prop_lw ),
+		NML_DBUS_META_PROPERTY_INIT_FCN ("Type",     0,             "s",                _notify_update_prop_lw ),
+		NML_DBUS_META_PROPERTY_INIT_B   ("Unsaved",  PROP_UNSAVED,  NMRemoteConnection, _priv.unsaved  ),
+		NML_DBUS_META_PROPERTY_INIT_FCN ("Uuid",     0,             "s",                _notify_update_prop_lw ),
 	),
 );
 
@@ -777,9 +1074,10 @@ nm_remote_connection_class_init (NMRemoteConnectionClass *klass)
 	object_class->get_property = get_property;
 	object_class->dispose      = dispose;
 
-	nm_object_class->is_ready          = is_ready;
-	nm_object_class->register_client   = register_client;
-	nm_object_class->unregister_client = unregister_client;
+	nm_object_class->is_ready           = is_ready;
+	nm_object_class->obj_changed_notify = obj_changed_notify;
+	nm_object_class->register_client    = register_client;
+	nm_object_class->unregister_client  = unregister_client;
 
 	/**
 	 * NMRemoteConnection:unsaved:
@@ -841,7 +1139,19 @@ nm_remote_connection_class_init (NMRemoteConnectionClass *klass)
 	_nml_dbus_meta_class_init_with_properties (object_class, &_nml_dbus_meta_iface_nm_settings_connection);
 }
 
+static void
+_connection_changed (NMConnection *connection)
+{
+	NMClient *client;
+
+	/* the ID of the connection might have changed. */
+	client = _nm_object_get_client (connection);
+	if (client)
+		_nm_client_connection_index_changed (client, NM_REMOTE_CONNECTION (connection));
+}
+
 static void
 nm_remote_connection_connection_iface_init (NMConnectionInterface *iface)
 {
+	iface->changed = _connection_changed;
 }
@@ -116,6 +116,19 @@ const char *nm_remote_connection_get_filename (NMRemoteConnection *connection);
 
 gboolean nm_remote_connection_get_visible (NMRemoteConnection *connection);
 
+NM_AVAILABLE_IN_1_24
+gboolean nm_remote_connection_get_settings_loaded (NMRemoteConnection *connection);
+
+NM_AVAILABLE_IN_1_24
+void     nm_remote_connection_load_settings_async  (NMRemoteConnection *connection,
+                                                    GCancellable *cancellable,
+                                                    GAsyncReadyCallback callback,
+                                                    gpointer user_data);
+NM_AVAILABLE_IN_1_24
+gboolean nm_remote_connection_load_settings_finish (NMRemoteConnection *connection,
+                                                    GAsyncResult *result,
+                                                    GError **error);
+
 G_END_DECLS
 
 #endif  /* __NM_REMOTE_CONNECTION__ */
@@ -468,6 +468,294 @@ test_save_hostname (void)
 
 /*****************************************************************************/
 
+static void
+batch_cb (GObject *s,
+          GAsyncResult *result,
+          gpointer user_data)
+{
+	GVariant **p_ret = user_data;
+	gs_free_error GError *error = NULL;
+
+	if (g_async_result_is_tagged (result, nm_client_add_connections_async))
+		*p_ret = nm_client_add_connections_finish (gl.client, result, &error);
+	else
+		*p_ret = nm_client_update_connections_finish (gl.client, result, &error);
+	nmtst_assert_success (*p_ret, error);
+}
+
+static const char *
+_batch_result_get (GVariant *results, guint idx, gboolean *out_is_error)
+{
+	gs_unref_variant GVariant *result = NULL;
+	const char *str;
+
+	g_assert (idx < g_variant_n_children (results));
+	result = g_variant_get_child_value (results, idx);
+
+	if (g_variant_lookup (result, "path", "&o", &str)) {
+		*out_is_error = FALSE;
+		return str;
+	}
+	g_assert (g_variant_lookup (result, "error", "&s", &str));
+	*out_is_error = TRUE;
+	return str;
+}
+
+static void
+test_batch_connections (void)
+{
+	gs_unref_ptrarray GPtrArray *connections = NULL;
+	gs_unref_variant GVariant *ret = NULL;
+	NMRemoteConnection *remote_mem;
+	NMRemoteConnection *remote_disk;
+	gs_free char *path_mem = NULL;
+	gs_free char *path_disk = NULL;
+	const char *str;
+	gboolean is_error;
+
+	if (!nmtstc_service_available (gl.sinfo))
+		return;
+
+	/* This only tests the client side: that nm_client_add_connections_async()
+	 * and nm_client_update_connections_async() pass the flags and return the
+	 * per-item results in order. The per-profile handling of the daemon in
+	 * nm_settings_update_connections() is not covered, the test service
+	 * mimics it. */
+
+	/* Add three profiles in one request. The test daemon doesn't support
+	 * bond connections, so the second one fails while the others get
+	 * added. */
+	connections = g_ptr_array_new_with_free_func (g_object_unref);
+	g_ptr_array_add (connections, nmtst_create_minimal_connection ("batch-mem", NULL, NM_SETTING_WIRED_SETTING_NAME, NULL));
+	g_ptr_array_add (connections, nmtst_create_minimal_connection ("batch-bad", NULL, NM_SETTING_BOND_SETTING_NAME, NULL));
+	g_ptr_array_add (connections, nmtst_create_minimal_connection ("batch-disk", NULL, NM_SETTING_WIRED_SETTING_NAME, NULL));
+
+	nm_client_add_connections_async (gl.client,
+	                                 connections,
+	                                 NM_SETTINGS_ADD_CONNECTION2_FLAG_IN_MEMORY,
+	                                 NULL,
+	                                 NULL,
+	                                 batch_cb,
+	                                 &ret);
+	nmtst_main_context_iterate_until_assert (NULL, 5000, ret);
+
+	g_assert_cmpint (g_variant_n_children (ret), ==, 3);
+	path_mem = g_strdup (_batch_result_get (ret, 0, &is_error));
+	g_assert (!is_error);
+	_batch_result_get (ret, 1, &is_error);
+	g_assert (is_error);
+	path_disk = g_strdup (_batch_result_get (ret, 2, &is_error));
+	g_assert (!is_error);
+	g_clear_pointer (&ret, g_variant_unref);
+
+	nmtst_main_context_iterate_until_assert (NULL, 5000,
+	                                            nm_client_get_connection_by_path (gl.client, path_mem)
+	                                         && nm_client_get_connection_by_path (gl.client, path_disk));
+	remote_mem = nm_client_get_connection_by_path (gl.client, path_mem);
+	remote_disk = nm_client_get_connection_by_path (gl.client, path_disk);
+
+	/* Move the second profile to disk on its own, so that the profiles of the
+	 * next batch have different storage. */
+	g_ptr_array_set_size (connections, 0);
+	g_ptr_array_add (connections, g_object_ref (remote_disk));
+	nm_client_update_connections_async (gl.client,
+	                                    connections,
+	                                    NM_SETTINGS_UPDATE2_FLAG_TO_DISK,
+	                                    NULL,
+	                                    NULL,
+	                                    batch_cb,
+	                                    &ret);
+	nmtst_main_context_iterate_until_assert (NULL, 5000, ret);
+	g_clear_pointer (&ret, g_variant_unref);
+
+	nmtst_main_context_iterate_until_assert (NULL, 5000,
+	                                            nm_remote_connection_get_unsaved (remote_mem)
+	                                         && !nm_remote_connection_get_unsaved (remote_disk));
+
+	/* Update both profiles in one request, keeping the storage of each. The
+	 * UUID of the second profile cannot change, so only the first update
+	 * succeeds. */
+	g_object_set (nm_connection_get_setting_connection (NM_CONNECTION (remote_mem)),
+	              NM_SETTING_CONNECTION_ID, "batch-mem-updated",
+	              NULL);
+	g_object_set (nm_connection_get_setting_connection (NM_CONNECTION (remote_disk)),
+	              NM_SETTING_CONNECTION_UUID, "a9a5c67f-6a24-4b6d-8f05-b3b5bff0e4ab",
+	              NULL);
+
+	g_ptr_array_set_size (connections, 0);
+	g_ptr_array_add (connections, g_object_ref (remote_mem));
+	g_ptr_array_add (connections, g_object_ref (remote_disk));
+	nm_client_update_connections_async (gl.client,
+	                                    connections,
+	                                    NM_SETTINGS_UPDATE2_FLAG_NONE,
+	                                    NULL,
+	                                    NULL,
+	                                    batch_cb,
+	                                    &ret);
+	nmtst_main_context_iterate_until_assert (NULL, 5000, ret);
+
+	g_assert_cmpint (g_variant_n_children (ret), ==, 2);
+	str = _batch_result_get (ret, 0, &is_error);
+	g_assert (!is_error);
+	g_assert_cmpstr (str, ==, path_mem);
+	_batch_result_get (ret, 1, &is_error);
+	g_assert (is_error);
+
+	/* each profile keeps its own storage (as reported by the test service). */
+	g_assert (nm_remote_connection_get_unsaved (remote_mem));
+	g_assert (!nm_remote_connection_get_unsaved (remote_disk));
+	g_assert_cmpstr (nm_connection_get_id (NM_CONNECTION (remote_mem)), ==, "batch-mem-updated");
+}
+
+/*****************************************************************************/
+
+static void
+_get_settings_call_counts (guint32 *out_single, guint32 *out_all)
+{
+	gs_unref_variant GVariant *ret = NULL;
+	gs_free_error GError *error = NULL;
+
+	ret = g_dbus_proxy_call_sync (gl.sinfo->proxy,
+	                              "GetSettingsCallCounts",
+	                              NULL,
+	                              G_DBUS_CALL_FLAGS_NO_AUTO_START,
+	                              3000,
+	                              NULL,
+	                              &error);
+	nmtst_assert_success (ret, error);
+	g_variant_get (ret, "(uu)", out_single, out_all);
+}
+
+static void
+test_get_all_settings (void)
+{
+	gs_unref_object NMClient *client = NULL;
+	gs_unref_object NMConnection *connection = NULL;
+	gs_free char *path = NULL;
+	NMRemoteConnection *remote;
+	guint32 n_single_1, n_all_1;
+	guint32 n_single_2, n_all_2;
+	guint i;
+
+	if (!nmtstc_service_available (gl.sinfo))
+		return;
+
+	for (i = 0; i < 4; i++) {
+		gs_free char *id = g_strdup_printf ("get-all-settings-%u", i);
+		gs_unref_object NMConnection *c = NULL;
+
+		c = nmtst_create_minimal_connection (id, NULL, NM_SETTING_WIRED_SETTING_NAME, NULL);
+		nmtstc_service_add_connection (gl.sinfo, c, TRUE, i == 0 ? &path : NULL);
+		if (i == 0)
+			connection = g_steal_pointer (&c);
+	}
+
+	/* let the existing client fetch the new profiles first, so that its
+	 * calls don't interfere with the counting below. */
+	nmtst_main_context_iterate_until_assert (NULL, 5000,
+	                                            nm_client_get_connection_by_id (gl.client, "get-all-settings-0")
+	                                         && nm_client_get_connection_by_id (gl.client, "get-all-settings-1")
+	                                         && nm_client_get_connection_by_id (gl.client, "get-all-settings-2")
+	                                         && nm_client_get_connection_by_id (gl.client, "get-all-settings-3"));
+
+	/* a new client loads all profiles with one GetAllSettings() call. */
+	_get_settings_call_counts (&n_single_1, &n_all_1);
+	client = nmtstc_client_new (TRUE);
+	_get_settings_call_counts (&n_single_2, &n_all_2);
+	g_assert_cmpint (n_single_2, ==, n_single_1);
+	g_assert_cmpint (n_all_2, ==, n_all_1 + 1);
+
+	for (i = 0; i < 4; i++) {
+		gs_free char *id = g_strdup_printf ("get-all-settings-%u", i);
+
+		g_assert (nm_client_get_connection_by_id (client, id));
+	}
+
+	/* a single changed profile is refreshed with GetSettings() (once by
+	 * each client). */
+	g_object_set (nm_connection_get_setting_connection (connection),
+	              NM_SETTING_CONNECTION_ID, "get-all-settings-changed",
+	              NULL);
+	nmtstc_service_update_connection (gl.sinfo, path, connection, TRUE);
+
+	remote = nm_client_get_connection_by_path (client, path);
+	g_assert (remote);
+	nmtst_main_context_iterate_until_assert (NULL, 5000,
+	                                            nm_client_get_connection_by_id (client, "get-all-settings-changed")
+	                                         && nm_client_get_connection_by_id (gl.client, "get-all-settings-changed"));
+	g_assert (nm_client_get_connection_by_id (client, "get-all-settings-changed") == remote);
+
+	_get_settings_call_counts (&n_single_1, &n_all_1);
+	g_assert_cmpint (n_single_1, ==, n_single_2 + 2);
+	g_assert_cmpint (n_all_1, ==, n_all_2);
+}
+
+/*****************************************************************************/
+
+static NMRemoteConnection *
+_index_add_connection (const char *id, NMConnection **out_connection)
+{
+	gs_unref_object NMConnection *connection = NULL;
+	gs_free char *path = NULL;
+
+	connection = nmtst_create_minimal_connection (id, NULL, NM_SETTING_WIRED_SETTING_NAME, NULL);
+	nmtstc_service_add_connection (gl.sinfo, connection, TRUE, &path);
+	nmtst_main_context_iterate_until_assert (NULL, 5000,
+	                                         nm_client_get_connection_by_path (gl.client, path));
+	nm_connection_set_path (connection, path);
+	*out_connection = g_steal_pointer (&connection);
+	return nm_client_get_connection_by_path (gl.client, path);
+}
+
+static void
+_index_rename (NMConnection *connection, const char *id)
+{
+	g_object_set (nm_connection_get_setting_connection (connection),
+	              NM_SETTING_CONNECTION_ID, id,
+	              NULL);
+	nmtstc_service_update_connection (gl.sinfo, NULL, connection, TRUE);
+	nmtst_main_context_iterate_until_assert (NULL, 5000,
+	                                         nm_client_get_connection_by_id (gl.client, id));
+}
+
+static void
+test_connection_index (void)
+{
+	gs_unref_object NMConnection *connection_a = NULL;
+	gs_unref_object NMConnection *connection_b = NULL;
+	NMRemoteConnection *remote_a;
+	NMRemoteConnection *remote_b;
+
+	if (!nmtstc_service_available (gl.sinfo))
+		return;
+
+	remote_a = _index_add_connection ("index-old", &connection_a);
+	g_assert (nm_client_get_connection_by_id (gl.client, "index-old") == remote_a);
+	g_assert (nm_client_get_connection_by_uuid (gl.client, nm_connection_get_uuid (connection_a)) == remote_a);
+
+	/* renaming updates the index for the old and the new ID. */
+	_index_rename (connection_a, "index-new");
+	g_assert (nm_client_get_connection_by_id (gl.client, "index-new") == remote_a);
+	g_assert (!nm_client_get_connection_by_id (gl.client, "index-old"));
+	g_assert (nm_client_get_connection_by_uuid (gl.client, nm_connection_get_uuid (connection_a)) == remote_a);
+
+	/* with two profiles of the same ID, renaming one leaves the other. */
+	remote_b = _index_add_connection ("index-new", &connection_b);
+	g_assert (NM_IN_SET (nm_client_get_connection_by_id (gl.client, "index-new"), remote_a, remote_b));
+	g_assert (nm_client_get_connection_by_uuid (gl.client, nm_connection_get_uuid (connection_b)) == remote_b);
+
+	_index_rename (connection_a, "index-renamed");
+	g_assert (nm_client_get_connection_by_id (gl.client, "index-renamed") == remote_a);
+	g_assert (nm_client_get_connection_by_id (gl.client, "index-new") == remote_b);
+
+	/* the old ID is free again. */
+	_index_rename (connection_b, "index-old");
+	g_assert (nm_client_get_connection_by_id (gl.client, "index-old") == remote_b);
+	g_assert (!nm_client_get_connection_by_id (gl.client, "index-new"));
+}
+
+/*****************************************************************************/
+
 NMTST_DEFINE ();
 
 int
@@ -497,6 +785,9 @@ main (int argc, char **argv)
 	g_test_add_func ("/client/add_remove_connection", test_add_remove_connection);
 	g_test_add_func ("/client/add_bad_connection", test_add_bad_connection);
 	g_test_add_func ("/client/save_hostname", test_save_hostname);
+	g_test_add_func ("/client/batch_connections", test_batch_connections);
+	g_test_add_func ("/client/get_all_settings", test_get_all_settings);
+	g_test_add_func ("/client/connection_index", test_connection_index);
 
 	ret = g_test_run ();
 
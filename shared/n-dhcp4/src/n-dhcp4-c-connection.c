@@ -135,8 +135,41 @@ static void n_dhcp4_c_connection_outgoing_set_secs(NDhcp4Outgoing *message) {
         n_dhcp4_outgoing_set_secs(message, secs);
 }
 
+/*
+ * Update the index of the shared socket. A connection is indexed while it
+ * listens on the shared socket and waits for a reply to a request, keyed by
+ * the xid of that request.
+ */
+static void n_dhcp4_c_connection_reindex(NDhcp4CConnection *connection) {
+        NDhcp4ClientSocket *sk = connection->client_config->socket;
+        uint32_t xid;
+
+        if (!sk)
+                return;
+
+        n_dhcp4_client_socket_unlink(sk, connection);
+
+        if (connection->state != N_DHCP4_C_CONNECTION_STATE_PACKET || !connection->request)
+                return;
+
+        n_dhcp4_outgoing_get_xid(connection->request, &xid);
+        n_dhcp4_client_socket_link(sk, connection, xid);
+}
+
+static void n_dhcp4_c_connection_unshare(NDhcp4CConnection *connection) {
+        NDhcp4Incoming *message, *t_message;
+
+        if (connection->client_config && connection->client_config->socket)
+                n_dhcp4_client_socket_unlink(connection->client_config->socket, connection);
+
+        c_list_for_each_entry_safe(message, t_message, &connection->socket_queue, queue_link)
+                n_dhcp4_incoming_free(message);
+        connection->n_socket_queue = 0;
+}
+
 int n_dhcp4_c_connection_listen(NDhcp4CConnection *connection) {
         _c_cleanup_(c_closep) int fd_packet = -1;
+        NDhcp4ClientSocket *sk = connection->client_config->socket;
         int r;
 
         if (connection->state == N_DHCP4_C_CONNECTION_STATE_PACKET)
@@ -156,23 +189,33 @@ int n_dhcp4_c_connection_listen(NDhcp4CConnection *connection) {
                 connection->fd_udp = c_close(connection->fd_udp);
         }
 
-        r = n_dhcp4_c_socket_packet_new(&fd_packet, connection->client_config->ifindex);
-        if (r)
-                return r;
+        n_dhcp4_c_connection_unshare(connection);
 
-        r = epoll_ctl(connection->fd_epoll,
-                      EPOLL_CTL_ADD,
-                      fd_packet,
-                      &(struct epoll_event){
-                              .events = EPOLLIN,
-                              .data = { .u32 = N_DHCP4_CLIENT_EPOLL_IO },
-                      });
-        if (r < 0)
-                return -errno;
+        if (!sk) {
+                r = n_dhcp4_c_socket_packet_new(&fd_packet, connection->client_config->ifindex);
+                if (r)
+                        return r;
+
+                r = epoll_ctl(connection->fd_epoll,
+                              EPOLL_CTL_ADD,
+                              fd_packet,
+                              &(struct epoll_event){
+                                      .events = EPOLLIN,
+                                      .data = { .u32 = N_DHCP4_CLIENT_EPOLL_IO },
+                              });
+                if (r < 0)
+                        return -errno;
+        }
 
+        /*
+         * With a shared socket, there is no packet FD. Replies are received
+         * by n_dhcp4_client_socket_dispatch() and queued on this connection,
+         * once it is indexed by the xid of a request.
+         */
         connection->state = N_DHCP4_C_CONNECTION_STATE_PACKET;
         connection->fd_packet = fd_packet;
         fd_packet = -1;
+        n_dhcp4_c_connection_reindex(connection);
         return 0;
 }
 
@@ -202,15 +245,22 @@ int n_dhcp4_c_connection_connect(NDhcp4CConnection *connection,
                 goto exit_fd;
         }
 
-        r = packet_shutdown(connection->fd_packet);
-        if (r < 0)
-                goto exit_epoll;
+        if (!connection->client_config->socket) {
+                r = packet_shutdown(connection->fd_packet);
+                if (r < 0)
+                        goto exit_epoll;
+        }
 
+        /*
+         * Stop receiving from the shared socket. Messages that are already
+         * queued are still drained.
+         */
         connection->state = N_DHCP4_C_CONNECTION_STATE_DRAINING;
         connection->fd_udp = fd_udp;
         connection->client_ip = client->s_addr;
         connection->server_ip = server->s_addr;
         fd_udp = -1;
+        n_dhcp4_c_connection_reindex(connection);
         return 0;
 
 exit_epoll:
@@ -221,6 +271,8 @@ exit_fd:
 }
 
 void n_dhcp4_c_connection_close(NDhcp4CConnection *connection) {
+        n_dhcp4_c_connection_unshare(connection);
+
         if (connection->fd_udp >= 0) {
                 epoll_ctl(connection->fd_epoll, EPOLL_CTL_DEL, connection->fd_udp, NULL);
                 connection->fd_udp = c_close(connection->fd_udp);
@@ -380,7 +432,9 @@ static int n_dhcp4_c_connection_packet_broadcast(NDhcp4CConnection *connection,
 
         c_assert(connection->state == N_DHCP4_C_CONNECTION_STATE_PACKET);
 
-        r = n_dhcp4_c_socket_packet_send(connection->fd_packet,
+        r = n_dhcp4_c_socket_packet_send(connection->client_config->socket ?
+                                                 connection->client_config->socket->fd :
+                                                 connection->fd_packet,
                                          connection->client_config->ifindex,
                                          connection->client_config->broadcast_mac,
                                          connection->client_config->n_broadcast_mac,
@@ -1043,11 +1097,16 @@ static int n_dhcp4_c_connection_send_request(NDhcp4CConnection *connection,
         case N_DHCP4_C_MESSAGE_SELECT:
         case N_DHCP4_C_MESSAGE_REBOOT:
         case N_DHCP4_C_MESSAGE_DECLINE:
-        case N_DHCP4_C_MESSAGE_REBIND:
                 broadcast = true;
                 r = n_dhcp4_c_connection_packet_broadcast(connection, request);
                 break;
         case N_DHCP4_C_MESSAGE_INFORM:
+        case N_DHCP4_C_MESSAGE_REBIND:
+                /*
+                 * REBIND is only sent once the address is configured and the
+                 * packet socket is gone, so it goes out as UDP broadcast from
+                 * the client address.
+                 */
                 broadcast = true;
                 r = n_dhcp4_c_connection_udp_broadcast(connection, request);
                 break;
@@ -1108,10 +1167,13 @@ int n_dhcp4_c_connection_start_request(NDhcp4CConnection *connection,
         connection->request = n_dhcp4_outgoing_free(connection->request);
 
         r = n_dhcp4_c_connection_send_request(connection, request, timestamp);
-        if (r)
+        if (r) {
+                n_dhcp4_c_connection_reindex(connection);
                 return r;
+        }
 
         connection->request = request;
+        n_dhcp4_c_connection_reindex(connection);
 
         return 0;
 }
@@ -1129,13 +1191,96 @@ int n_dhcp4_c_connection_dispatch_timer(NDhcp4CConnection *connection,
         if (timeout > timestamp)
                 return 0;
 
+        /* a resend might pick a new xid */
         r = n_dhcp4_c_connection_send_request(connection, connection->request, timestamp);
+        n_dhcp4_c_connection_reindex(connection);
         if (r)
                 return r;
 
         return 0;
 }
 
+/**
+ * n_dhcp4_c_connection_match() - check whether a shared message is ours
+ * @connection:                 connection to operate on
+ * @ifindex:                    interface the message was received on
+ * @message:                    message received on the shared socket
+ *
+ * This checks whether @message, received on a shared socket, is a reply to
+ * the pending request of @connection. Only the properties required to tell
+ * connections apart are checked here, the message is fully verified once it
+ * is dispatched by the connection.
+ *
+ * Return: true if @message belongs to @connection.
+ */
+bool n_dhcp4_c_connection_match(NDhcp4CConnection *connection,
+                                int ifindex,
+                                NDhcp4Incoming *message) {
+        NDhcp4Header *header = n_dhcp4_incoming_get_header(message);
+        uint32_t request_xid;
+
+        if (connection->client_config->ifindex != ifindex || !connection->request)
+                return false;
+
+        n_dhcp4_outgoing_get_xid(connection->request, &request_xid);
+        if (header->xid != request_xid)
+                return false;
+
+        if (connection->client_config->transport == N_DHCP4_TRANSPORT_ETHERNET) {
+                if (header->hlen != ETH_ALEN)
+                        return false;
+                if (memcmp(header->chaddr, connection->client_config->mac, ETH_ALEN) != 0)
+                        return false;
+        }
+
+        return true;
+}
+
+/**
+ * n_dhcp4_c_connection_enqueue() - queue a message from a shared socket
+ * @connection:                 connection to operate on
+ * @message:                    message to queue
+ *
+ * This queues @message on @connection. The connection takes ownership of
+ * @message. If the connection does not keep up, the oldest queued message is
+ * dropped.
+ */
+void n_dhcp4_c_connection_enqueue(NDhcp4CConnection *connection,
+                                  NDhcp4Incoming *message) {
+        NDhcp4Incoming *oldest;
+
+        if (connection->n_socket_queue >= N_DHCP4_C_CONNECTION_QUEUE_MAX) {
+                oldest = c_list_first_entry(&connection->socket_queue, NDhcp4Incoming, queue_link);
+                n_dhcp4_incoming_free(oldest);
+                --connection->n_socket_queue;
+        }
+
+        c_list_link_tail(&connection->socket_queue, &message->queue_link);
+        ++connection->n_socket_queue;
+}
+
+static int n_dhcp4_c_connection_packet_recv(NDhcp4CConnection *connection,
+                                            NDhcp4Incoming **messagep) {
+        NDhcp4Incoming *message;
+
+        if (!connection->client_config->socket)
+                return n_dhcp4_c_socket_packet_recv(connection->fd_packet,
+                                                    connection->scratch_buffer,
+                                                    sizeof(connection->scratch_buffer),
+                                                    messagep,
+                                                    NULL);
+
+        message = c_list_first_entry(&connection->socket_queue, NDhcp4Incoming, queue_link);
+        if (!message)
+                return N_DHCP4_E_AGAIN;
+
+        c_list_unlink(&message->queue_link);
+        --connection->n_socket_queue;
+
+        *messagep = message;
+        return 0;
+}
+
 int n_dhcp4_c_connection_dispatch_io(NDhcp4CConnection *connection,
                                      NDhcp4Incoming **messagep) {
         _c_cleanup_(n_dhcp4_incoming_freep) NDhcp4Incoming *message = NULL;
@@ -1146,19 +1291,13 @@ int n_dhcp4_c_connection_dispatch_io(NDhcp4CConnection *connection,
 
         switch (connection->state) {
         case N_DHCP4_C_CONNECTION_STATE_PACKET:
-                r = n_dhcp4_c_socket_packet_recv(connection->fd_packet,
-                                                 connection->scratch_buffer,
-                                                 sizeof(connection->scratch_buffer),
-                                                 &message);
+                r = n_dhcp4_c_connection_packet_recv(connection, &message);
                 if (r)
                         return r;
 
                 break;
         case N_DHCP4_C_CONNECTION_STATE_DRAINING:
-                r = n_dhcp4_c_socket_packet_recv(connection->fd_packet,
-                                                 connection->scratch_buffer,
-                                                 sizeof(connection->scratch_buffer),
-                                                 &message);
+                r = n_dhcp4_c_connection_packet_recv(connection, &message);
                 if (!r)
                         break;
                 else if (r != N_DHCP4_E_AGAIN)
@@ -1169,9 +1308,11 @@ int n_dhcp4_c_connection_dispatch_io(NDhcp4CConnection *connection,
                  * and drained, clean up the packet socket and fall through to
                  * dispatching the UDP socket.
                  */
-                r = epoll_ctl(connection->fd_epoll, EPOLL_CTL_DEL, connection->fd_packet, NULL);
-                c_assert(!r);
-                connection->fd_packet = c_close(connection->fd_packet);
+                if (connection->fd_packet >= 0) {
+                        r = epoll_ctl(connection->fd_epoll, EPOLL_CTL_DEL, connection->fd_packet, NULL);
+                        c_assert(!r);
+                        connection->fd_packet = c_close(connection->fd_packet);
+                }
                 connection->state = N_DHCP4_C_CONNECTION_STATE_UDP;
 
                 /* fall-through */
@@ -1228,6 +1369,7 @@ int n_dhcp4_c_connection_dispatch_io(NDhcp4CConnection *connection,
                          * accept several, so we do not free the pinned request.
                          */
                         connection->request = n_dhcp4_outgoing_free(connection->request);
+                        n_dhcp4_c_connection_reindex(connection);
                 }
 
                 break;
@@ -436,6 +436,8 @@ int n_dhcp4_client_probe_new(NDhcp4ClientProbe **probep,
         if (r)
                 return r;
 
+        probe->connection.probe = probe;
+
         if (probe->config->requested_ip.s_addr != INADDR_ANY)
                 probe->last_address = probe->config->requested_ip;
 
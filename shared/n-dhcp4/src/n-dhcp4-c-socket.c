@@ -0,0 +1,284 @@
+/*
+ * DHCP4 Shared Client Sockets
+ *
+ * Every client connection opens its own packet socket while it has no IP
+ * address configured, and each of these sockets runs its filter on every
+ * DHCP packet received on its interface. With many clients (for instance on
+ * hundreds of VLAN interfaces), this means many file-descriptors and a lot of
+ * redundant filtering.
+ *
+ * A shared client socket is a single packet socket, not bound to any
+ * interface, that serves all clients of a network namespace configured to use
+ * it. Those clients do not open a packet socket, nor any wakeup FD in its
+ * place. Incoming packets are looked up by the receiving interface and the
+ * transaction id in a hash table of the waiting connections, and are handed
+ * to the matching client right away. Packets are also sent through the shared
+ * socket.
+ *
+ * The caller has to dispatch the shared socket in addition to the clients.
+ */
+
+#include <assert.h>
+#include <c-list.h>
+#include <c-stdaux.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include "n-dhcp4.h"
+#include "n-dhcp4-private.h"
+
+/* the number of packets dispatched in one go, before yielding to the caller */
+#define N_DHCP4_CLIENT_SOCKET_BATCH (128)
+
+/* the initial number of hash buckets, it doubles as connections are added */
+#define N_DHCP4_CLIENT_SOCKET_BUCKETS (16)
+
+static size_t n_dhcp4_client_socket_hash(NDhcp4ClientSocket *sk, int ifindex, uint32_t xid) {
+        /*
+         * The xids are random, the interface index only separates equal xids
+         * on different interfaces. Fold both with a multiplicative hash.
+         */
+        return (size_t)((xid ^ ((uint32_t)ifindex * 0x9e3779b1U)) * 0x85ebca6bU) & (sk->n_buckets - 1);
+}
+
+static void n_dhcp4_client_socket_grow(NDhcp4ClientSocket *sk) {
+        NDhcp4CConnection *connection;
+        CList *buckets, *old_buckets = sk->buckets;
+        size_t i, n_old_buckets = sk->n_buckets;
+
+        buckets = malloc(sizeof(*buckets) * n_old_buckets * 2);
+        if (!buckets) {
+                /* keep the current table, lookups just get slower */
+                return;
+        }
+
+        for (i = 0; i < n_old_buckets * 2; ++i)
+                buckets[i] = (CList)C_LIST_INIT(buckets[i]);
+
+        sk->buckets = buckets;
+        sk->n_buckets = n_old_buckets * 2;
+
+        for (i = 0; i < n_old_buckets; ++i) {
+                while ((connection = c_list_first_entry(&old_buckets[i], NDhcp4CConnection, socket_link))) {
+                        c_list_unlink(&connection->socket_link);
+                        c_list_link_tail(&buckets[n_dhcp4_client_socket_hash(sk,
+                                                                             connection->client_config->ifindex,
+                                                                             connection->socket_xid)],
+                                         &connection->socket_link);
+                }
+        }
+
+        free(old_buckets);
+}
+
+/**
+ * n_dhcp4_client_socket_new() - allocate new shared client socket
+ * @skp:                        output argument for new socket
+ *
+ * This creates a new shared client socket. It receives DHCP replies for all
+ * interfaces of the network namespace it is created in. Pass it to
+ * n_dhcp4_client_config_set_socket() for all clients that shall use it.
+ *
+ * Return: 0 on success, negative error code on failure.
+ */
+_c_public_ int n_dhcp4_client_socket_new(NDhcp4ClientSocket **skp) {
+        _c_cleanup_(n_dhcp4_client_socket_unrefp) NDhcp4ClientSocket *sk = NULL;
+        size_t i;
+        int r;
+
+        sk = malloc(sizeof(*sk));
+        if (!sk)
+                return -ENOMEM;
+
+        *sk = (NDhcp4ClientSocket)N_DHCP4_CLIENT_SOCKET_NULL(*sk);
+
+        sk->buckets = malloc(sizeof(*sk->buckets) * N_DHCP4_CLIENT_SOCKET_BUCKETS);
+        if (!sk->buckets)
+                return -ENOMEM;
+
+        sk->n_buckets = N_DHCP4_CLIENT_SOCKET_BUCKETS;
+        for (i = 0; i < sk->n_buckets; ++i)
+                sk->buckets[i] = (CList)C_LIST_INIT(sk->buckets[i]);
+
+        r = n_dhcp4_c_socket_packet_new(&sk->fd, 0);
+        if (r)
+                return r;
+
+        *skp = sk;
+        sk = NULL;
+        return 0;
+}
+
+static void n_dhcp4_client_socket_free(NDhcp4ClientSocket *sk) {
+        c_assert(!sk->n_connections);
+
+        if (sk->fd >= 0)
+                close(sk->fd);
+
+        free(sk->buckets);
+        free(sk);
+}
+
+/**
+ * n_dhcp4_client_socket_ref() - acquire shared socket reference
+ * @sk:                         socket to operate on, or NULL
+ *
+ * This acquires a reference to the shared socket given as @sk. If @sk is
+ * NULL, this function is a no-op.
+ *
+ * Return: @sk is returned.
+ */
+_c_public_ NDhcp4ClientSocket *n_dhcp4_client_socket_ref(NDhcp4ClientSocket *sk) {
+        if (sk)
+                ++sk->n_refs;
+        return sk;
+}
+
+/**
+ * n_dhcp4_client_socket_unref() - release shared socket reference
+ * @sk:                         socket to operate on, or NULL
+ *
+ * This releases a reference to the shared socket given as @sk. If @sk is
+ * NULL, this is a no-op.
+ *
+ * Client configurations and clients hold references to the socket they use,
+ * so the socket stays alive as long as any client uses it.
+ *
+ * Return: NULL is returned.
+ */
+_c_public_ NDhcp4ClientSocket *n_dhcp4_client_socket_unref(NDhcp4ClientSocket *sk) {
+        if (sk && !--sk->n_refs)
+                n_dhcp4_client_socket_free(sk);
+        return NULL;
+}
+
+/**
+ * n_dhcp4_client_socket_get_fd() - retrieve event FD
+ * @sk:                         socket to operate on
+ * @fdp:                        output argument to store FD
+ *
+ * This retrieves the FD of the shared socket. The caller must call
+ * n_dhcp4_client_socket_dispatch() whenever the FD is readable.
+ */
+_c_public_ void n_dhcp4_client_socket_get_fd(NDhcp4ClientSocket *sk, int *fdp) {
+        *fdp = sk->fd;
+}
+
+/**
+ * n_dhcp4_client_socket_link() - index connection
+ * @sk:                         socket to operate on
+ * @connection:                 connection to index
+ * @xid:                        xid of the pending request of @connection
+ *
+ * This adds @connection to the index of @sk, so replies received on @sk with
+ * the interface of @connection and @xid are handed to it. @connection must
+ * not be indexed already.
+ */
+void n_dhcp4_client_socket_link(NDhcp4ClientSocket *sk,
+                                NDhcp4CConnection *connection,
+                                uint32_t xid) {
+        c_assert(!c_list_is_linked(&connection->socket_link));
+
+        if (sk->n_connections >= sk->n_buckets)
+                n_dhcp4_client_socket_grow(sk);
+
+        connection->socket_xid = xid;
+        c_list_link_tail(&sk->buckets[n_dhcp4_client_socket_hash(sk, connection->client_config->ifindex, xid)],
+                         &connection->socket_link);
+        ++sk->n_connections;
+}
+
+/**
+ * n_dhcp4_client_socket_unlink() - remove connection from index
+ * @sk:                         socket to operate on
+ * @connection:                 connection to remove
+ *
+ * This removes @connection from the index of @sk. If @connection is not
+ * indexed, this is a no-op.
+ */
+void n_dhcp4_client_socket_unlink(NDhcp4ClientSocket *sk,
+                                  NDhcp4CConnection *connection) {
+        if (!c_list_is_linked(&connection->socket_link))
+                return;
+
+        c_list_unlink(&connection->socket_link);
+        --sk->n_connections;
+}
+
+static NDhcp4CConnection *n_dhcp4_client_socket_lookup(NDhcp4ClientSocket *sk,
+                                                       int ifindex,
+                                                       NDhcp4Incoming *message) {
+        NDhcp4CConnection *connection;
+        uint32_t xid = n_dhcp4_incoming_get_header(message)->xid;
+
+        c_list_for_each_entry(connection,
+                              &sk->buckets[n_dhcp4_client_socket_hash(sk, ifindex, xid)],
+                              socket_link) {
+                if (connection->socket_xid != xid)
+                        continue;
+                if (n_dhcp4_c_connection_match(connection, ifindex, message))
+                        return connection;
+        }
+
+        return NULL;
+}
+
+/**
+ * n_dhcp4_client_socket_dispatch() - dispatch shared socket
+ * @sk:                         socket to operate on
+ *
+ * This reads pending packets from the shared socket and hands each of them to
+ * the client connection it is destined to. Packets that no connection is
+ * waiting for are discarded. The clients process the packets right away, and
+ * queue the resulting events. The caller is expected to retrieve them with
+ * n_dhcp4_client_pop_event() afterwards, for every client using @sk.
+ *
+ * This function never blocks.
+ *
+ * Return: 0 on success, negative error code on failure, N_DHCP4_E_PREEMPTED if
+ *         there is more data to dispatch.
+ */
+_c_public_ int n_dhcp4_client_socket_dispatch(NDhcp4ClientSocket *sk) {
+        NDhcp4CConnection *connection;
+        unsigned int i;
+        int r, ifindex;
+
+        for (i = 0; i < N_DHCP4_CLIENT_SOCKET_BATCH; ++i) {
+                _c_cleanup_(n_dhcp4_incoming_freep) NDhcp4Incoming *message = NULL;
+
+                ifindex = 0;
+                r = n_dhcp4_c_socket_packet_recv(sk->fd,
+                                                 sk->scratch_buffer,
+                                                 sizeof(sk->scratch_buffer),
+                                                 &message,
+                                                 &ifindex);
+                if (r) {
+                        if (r == N_DHCP4_E_AGAIN)
+                                return 0;
+                        else if (r == N_DHCP4_E_MALFORMED || r == N_DHCP4_E_DOWN)
+                                continue;
+
+                        return r;
+                }
+
+                connection = n_dhcp4_client_socket_lookup(sk, ifindex, message);
+                if (!connection)
+                        continue;
+
+                n_dhcp4_c_connection_enqueue(connection, message);
+                message = NULL; /* consumed */
+
+                /*
+                 * Connections that belong to a client are dispatched right
+                 * away. Bare connections (as used by the tests) keep the
+                 * message queued until they are dispatched explicitly.
+                 */
+                if (connection->probe) {
+                        r = n_dhcp4_client_dispatch_queue(connection->probe->client);
+                        if (r)
+                                return r;
+                }
+        }
+
+        return N_DHCP4_E_PREEMPTED;
+}
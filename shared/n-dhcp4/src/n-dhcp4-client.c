@@ -63,6 +63,7 @@ _c_public_ NDhcp4ClientConfig *n_dhcp4_client_config_free(NDhcp4ClientConfig *co
         if (!config)
                 return NULL;
 
+        n_dhcp4_client_socket_unref(config->socket);
         free(config->client_id);
         free(config);
 
@@ -97,6 +98,7 @@ int n_dhcp4_client_config_dup(NDhcp4ClientConfig *config, NDhcp4ClientConfig **d
         dup->log.level = config->log.level;
         dup->log.func = config->log.func;
         dup->log.data = config->log.data;
+        dup->socket = config->socket ? n_dhcp4_client_socket_ref(config->socket) : NULL;
 
         r = n_dhcp4_client_config_set_client_id(dup,
                                                 config->client_id,
@@ -251,6 +253,27 @@ _c_public_ int n_dhcp4_client_config_set_client_id(NDhcp4ClientConfig *config, c
         return 0;
 }
 
+/**
+ * n_dhcp4_client_config_set_socket() - set shared socket property
+ * @config:                     client configuration to operate on
+ * @sk:                         shared socket to use, or NULL
+ *
+ * This sets the shared-socket property of the client configuration. By
+ * default, every client opens its own packet socket while it has no IP address
+ * configured. If a shared socket is set, the client instead receives its
+ * messages through @sk, which is shared with other clients in the same network
+ * namespace. See n_dhcp4_client_socket_new() for details.
+ *
+ * The configuration takes a reference to @sk. The caller is responsible for
+ * dispatching @sk, in addition to the clients.
+ */
+_c_public_ void n_dhcp4_client_config_set_socket(NDhcp4ClientConfig *config, NDhcp4ClientSocket *sk) {
+        if (sk)
+                n_dhcp4_client_socket_ref(sk);
+        n_dhcp4_client_socket_unref(config->socket);
+        config->socket = sk;
+}
+
 _c_public_ void n_dhcp4_client_config_set_log_level(NDhcp4ClientConfig *config, int level) {
         config->log.level = level;
 }
@@ -626,6 +649,44 @@ static int n_dhcp4_client_dispatch_io(NDhcp4Client *client, struct epoll_event *
         return r;
 }
 
+/**
+ * n_dhcp4_client_dispatch_queue() - dispatch queued messages
+ * @client:                     client to operate on
+ *
+ * This processes the messages that a shared socket queued on the connection of
+ * the current probe of @client. It is called by
+ * n_dhcp4_client_socket_dispatch(), as there is no FD of the client that would
+ * signal them.
+ *
+ * Return: 0 on success, negative error code on failure.
+ */
+int n_dhcp4_client_dispatch_queue(NDhcp4Client *client) {
+        unsigned int i;
+        int r;
+
+        for (i = 0; i < N_DHCP4_C_CONNECTION_QUEUE_MAX; ++i) {
+                if (!client->current_probe ||
+                    c_list_is_empty(&client->current_probe->connection.socket_queue))
+                        break;
+
+                r = n_dhcp4_client_probe_dispatch_io(client->current_probe, EPOLLIN);
+                if (r) {
+                        if (r != N_DHCP4_E_DOWN)
+                                return r;
+
+                        r = n_dhcp4_client_raise(client,
+                                                 NULL,
+                                                 N_DHCP4_CLIENT_EVENT_DOWN);
+                        if (r)
+                                return r;
+                }
+        }
+
+        n_dhcp4_client_arm_timer(client);
+
+        return 0;
+}
+
 /**
  * n_dhcp4_client_dispatch() - dispatch client
  * @client:                     client to operate on
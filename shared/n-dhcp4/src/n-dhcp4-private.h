@@ -213,6 +213,8 @@ struct NDhcp4Outgoing {
         }
 
 struct NDhcp4Incoming {
+        CList queue_link;
+
         struct {
                 uint8_t *value;
                 size_t size;
@@ -230,6 +232,7 @@ struct NDhcp4Incoming {
 };
 
 #define N_DHCP4_INCOMING_NULL(_x) {                                             \
+                .queue_link = C_LIST_INIT((_x).queue_link),                     \
         }
 
 struct NDhcp4ClientConfig {
@@ -242,6 +245,7 @@ struct NDhcp4ClientConfig {
         size_t n_broadcast_mac;
         uint8_t *client_id;
         size_t n_client_id;
+        NDhcp4ClientSocket *socket;
         struct {
                 int level;
                 NDhcp4LogFunc func;
@@ -290,15 +294,51 @@ struct NDhcp4CEventNode {
                 .probe_link = C_LIST_INIT((_x).probe_link),                     \
         }
 
+/*
+ * A packet socket shared by the client connections of many interfaces. It is
+ * not bound to an interface, so a single socket (and a single run of the BPF
+ * filter) serves all of them. Received messages are demultiplexed based on the
+ * receiving interface, transaction id and hardware address, and handed to the
+ * matching connection.
+ *
+ * The connections waiting for a reply are indexed by interface and xid of
+ * their pending request, in a hash table of @n_buckets buckets.
+ */
+struct NDhcp4ClientSocket {
+        unsigned long n_refs;
+        int fd;
+
+        CList *buckets;
+        size_t n_buckets;
+        size_t n_connections;
+
+        /* see NDhcp4CConnection.scratch_buffer */
+        uint8_t scratch_buffer[UINT16_MAX];
+};
+
+#define N_DHCP4_CLIENT_SOCKET_NULL(_x) {                                        \
+                .n_refs = 1,                                                    \
+                .fd = -1,                                                       \
+        }
+
+/* the number of messages a connection keeps queued from a shared socket */
+#define N_DHCP4_C_CONNECTION_QUEUE_MAX (16)
+
 struct NDhcp4CConnection {
         NDhcp4ClientConfig *client_config;
         NDhcp4ClientProbeConfig *probe_config;
         int fd_epoll;
 
         unsigned int state;             /* current connection state */
-        int fd_packet;                  /* packet socket */
+        int fd_packet;                  /* packet socket, or -1 if shared */
         int fd_udp;                     /* udp socket */
 
+        NDhcp4ClientProbe *probe;       /* owning probe, or NULL */
+        CList socket_link;              /* link into the shared socket index */
+        uint32_t socket_xid;            /* xid the connection is indexed by */
+        CList socket_queue;             /* messages from the shared socket */
+        size_t n_socket_queue;
+
         NDhcp4Outgoing *request;        /* current request */
 
         uint32_t client_ip;             /* client IP address, or 0 */
@@ -318,6 +358,8 @@ struct NDhcp4CConnection {
 #define N_DHCP4_C_CONNECTION_NULL(_x) {                                         \
                 .fd_packet = -1,                                                \
                 .fd_udp = -1,                                                   \
+                .socket_link = C_LIST_INIT((_x).socket_link),                   \
+                .socket_queue = C_LIST_INIT((_x).socket_queue),                 \
         }
 
 struct NDhcp4Client {
@@ -456,6 +498,17 @@ struct NDhcp4ServerLease {
 
         NDhcp4Incoming *request;
         NDhcp4Incoming *reply;
+
+        /* htype and chaddr, used if the client sent no identifier */
+        uint8_t hw_client_id[1 + sizeof(((NDhcp4Header *)NULL)->chaddr)];
+        size_t n_hw_client_id;
+
+        struct in_addr yiaddr;
+        uint32_t lifetime;
+
+        /* options appended by the caller, as consecutive code/len/data */
+        uint8_t *options;
+        size_t n_options;
 };
 
 #define N_DHCP4_SERVER_LEASE_NULL(_x) {                                         \
@@ -539,7 +592,8 @@ int n_dhcp4_s_socket_udp_broadcast(int sockfd,
 int n_dhcp4_c_socket_packet_recv(int sockfd,
                                  uint8_t *buf,
                                  size_t n_buf,
-                                 NDhcp4Incoming **messagep);
+                                 NDhcp4Incoming **messagep,
+                                 int *ifindexp);
 int n_dhcp4_c_socket_udp_recv(int sockfd,
                               uint8_t *buf,
                               size_t n_buf,
@@ -612,11 +666,25 @@ int n_dhcp4_c_connection_dispatch_timer(NDhcp4CConnection *connection,
                                         uint64_t timestamp);
 int n_dhcp4_c_connection_dispatch_io(NDhcp4CConnection *connection,
                                      NDhcp4Incoming **messagep);
+bool n_dhcp4_c_connection_match(NDhcp4CConnection *connection,
+                                int ifindex,
+                                NDhcp4Incoming *message);
+void n_dhcp4_c_connection_enqueue(NDhcp4CConnection *connection,
+                                  NDhcp4Incoming *message);
+
+/* shared client sockets */
+
+void n_dhcp4_client_socket_link(NDhcp4ClientSocket *sk,
+                                NDhcp4CConnection *connection,
+                                uint32_t xid);
+void n_dhcp4_client_socket_unlink(NDhcp4ClientSocket *sk,
+                                  NDhcp4CConnection *connection);
 
 /* clients */
 
 int n_dhcp4_client_raise(NDhcp4Client *client, NDhcp4CEventNode **nodep, unsigned int event);
 void n_dhcp4_client_arm_timer(NDhcp4Client *client);
+int n_dhcp4_client_dispatch_queue(NDhcp4Client *client);
 
 /* client probes */
 
@@ -677,6 +745,19 @@ void n_dhcp4_s_connection_ip_deinit(NDhcp4SConnectionIp *ip);
 void n_dhcp4_s_connection_ip_link(NDhcp4SConnectionIp *ip, NDhcp4SConnection *connection);
 void n_dhcp4_s_connection_ip_unlink(NDhcp4SConnectionIp *ip);
 
+/* servers */
+
+int n_dhcp4_s_event_node_new(NDhcp4SEventNode **nodep);
+NDhcp4SEventNode *n_dhcp4_s_event_node_free(NDhcp4SEventNode *node);
+
+int n_dhcp4_server_raise(NDhcp4Server *server, NDhcp4SEventNode **nodep, unsigned int event);
+
+/* server leases */
+
+int n_dhcp4_server_lease_new(NDhcp4ServerLease **leasep, NDhcp4Incoming *message);
+void n_dhcp4_server_lease_link(NDhcp4ServerLease *lease, NDhcp4Server *server);
+void n_dhcp4_server_lease_unlink(NDhcp4ServerLease *lease);
+
 /* inline helpers */
 
 static inline void n_dhcp4_outgoing_freep(NDhcp4Outgoing **outgoing) {
@@ -189,7 +189,7 @@ int n_dhcp4_s_connection_send_reply(NDhcp4SConnection *connection,
                                               message);
                 if (r)
                         return r;
-        } else if (header->flags & htons(N_DHCP4_MESSAGE_FLAG_BROADCAST)) {
+        } else if (header->flags & N_DHCP4_MESSAGE_FLAG_BROADCAST) {
                 r = n_dhcp4_s_socket_udp_broadcast(connection->fd_udp,
                                                    server_addr,
                                                    message);
@@ -261,8 +261,12 @@ static int n_dhcp4_s_connection_new_reply(NDhcp4SConnection *connection,
         int r;
 
         r = n_dhcp4_incoming_query_max_message_size(request, &max_message_size);
-        if (r)
-                return r;
+        if (r) {
+                if (r != N_DHCP4_E_UNSET)
+                        return r;
+
+                max_message_size = N_DHCP4_NETWORK_IP_MINIMUM_MAX_SIZE;
+        }
 
         r = n_dhcp4_outgoing_new(&message,
                                  max_message_size,
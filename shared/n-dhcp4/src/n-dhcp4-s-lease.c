@@ -16,6 +16,7 @@
  */
 int n_dhcp4_server_lease_new(NDhcp4ServerLease **leasep, NDhcp4Incoming *message) {
         _c_cleanup_(n_dhcp4_server_lease_unrefp) NDhcp4ServerLease *lease = NULL;
+        NDhcp4Header *header;
 
         c_assert(leasep);
 
@@ -27,17 +28,21 @@ int n_dhcp4_server_lease_new(NDhcp4ServerLease **leasep, NDhcp4Incoming *message
 
         lease->request = message;
 
+        header = n_dhcp4_incoming_get_header(message);
+        lease->hw_client_id[0] = header->htype;
+        lease->n_hw_client_id = 1 + c_min((size_t)header->hlen, sizeof(header->chaddr));
+        memcpy(lease->hw_client_id + 1, header->chaddr, lease->n_hw_client_id - 1);
+
         *leasep = lease;
         lease = NULL;
         return 0;
 }
 
 static void n_dhcp4_server_lease_free(NDhcp4ServerLease *lease) {
-        c_assert(!lease->server);
-
-        c_list_unlink(&lease->server_link);
+        n_dhcp4_server_lease_unlink(lease);
 
         n_dhcp4_incoming_free(lease->request);
+        free(lease->options);
         free(lease);
 }
 
@@ -59,6 +64,34 @@ _c_public_ NDhcp4ServerLease *n_dhcp4_server_lease_unref(NDhcp4ServerLease *leas
         return NULL;
 }
 
+/**
+ * n_dhcp4_server_lease_link() - link lease into server
+ * @lease:                      the lease to operate on
+ * @server:                     the server to link the lease into
+ *
+ * Associate a lease with the server that received the request. The lease may
+ * not already be linked.
+ */
+void n_dhcp4_server_lease_link(NDhcp4ServerLease *lease, NDhcp4Server *server) {
+        c_assert(!lease->server);
+        c_assert(!c_list_is_linked(&lease->server_link));
+
+        lease->server = server;
+        c_list_link_tail(&server->lease_list, &lease->server_link);
+}
+
+/**
+ * n_dhcp4_server_lease_unlink() - unlink lease from its server
+ * @lease:                      the lease to operate on
+ *
+ * Dissassociate a lease from a server if it is associated with one. Otherwise,
+ * this is a noop. An unlinked lease can no longer be answered.
+ */
+void n_dhcp4_server_lease_unlink(NDhcp4ServerLease *lease) {
+        lease->server = NULL;
+        c_list_unlink(&lease->server_link);
+}
+
 /**
  * n_dhcp4_server_lease_query() - XXX
  */
@@ -82,22 +115,209 @@ _c_public_ int n_dhcp4_server_lease_query(NDhcp4ServerLease *lease, uint8_t opti
         return n_dhcp4_incoming_query(lease->request, option, datap, n_datap);
 }
 
+/**
+ * n_dhcp4_server_lease_get_client_id() - get the client identifier
+ * @lease:                      the lease to operate on
+ * @idp:                        return argument for the identifier
+ * @n_idp:                      return argument for the length of the identifier
+ *
+ * Return the client identifier option of the request. If the client did not
+ * send one, the hardware type followed by the hardware address is returned,
+ * as suggested by RFC2132.
+ *
+ * Return: 0 on success, negative error code on failure.
+ */
+_c_public_ int n_dhcp4_server_lease_get_client_id(NDhcp4ServerLease *lease, const uint8_t **idp, size_t *n_idp) {
+        uint8_t *data;
+        size_t n_data;
+        int r;
+
+        r = n_dhcp4_incoming_query(lease->request, N_DHCP4_OPTION_CLIENT_IDENTIFIER, &data, &n_data);
+        if (!r && n_data > 0) {
+                *idp = data;
+                *n_idp = n_data;
+                return 0;
+        } else if (r && r != N_DHCP4_E_UNSET) {
+                return r;
+        }
+
+        *idp = lease->hw_client_id;
+        *n_idp = lease->n_hw_client_id;
+        return 0;
+}
+
+/**
+ * n_dhcp4_server_lease_get_requested_ip() - get the address the client asks for
+ * @lease:                      the lease to operate on
+ * @addrp:                      return argument for the address
+ *
+ * Return the requested IP address option of the request, or, if unset, the
+ * client address of the header, as used by renewing and releasing clients.
+ *
+ * Return: 0 on success, N_DHCP4_E_UNSET if the client asks for no specific
+ *         address, negative error code on failure.
+ */
+_c_public_ int n_dhcp4_server_lease_get_requested_ip(NDhcp4ServerLease *lease, struct in_addr *addrp) {
+        NDhcp4Header *header;
+        int r;
+
+        r = n_dhcp4_incoming_query_requested_ip(lease->request, addrp);
+        if (r != N_DHCP4_E_UNSET)
+                return r;
+
+        header = n_dhcp4_incoming_get_header(lease->request);
+        if (!header->ciaddr)
+                return N_DHCP4_E_UNSET;
+
+        addrp->s_addr = header->ciaddr;
+        return 0;
+}
+
+/**
+ * n_dhcp4_server_lease_set_yiaddr() - set the address to hand out
+ * @lease:                      the lease to operate on
+ * @yiaddr:                     the client address
+ * @lifetime:                   the lease time in seconds
+ *
+ * Set the address and lease time used by n_dhcp4_server_lease_offer() and
+ * n_dhcp4_server_lease_ack().
+ */
+_c_public_ void n_dhcp4_server_lease_set_yiaddr(NDhcp4ServerLease *lease, struct in_addr yiaddr, uint32_t lifetime) {
+        lease->yiaddr = yiaddr;
+        lease->lifetime = lifetime;
+}
+
+/**
+ * n_dhcp4_server_lease_append() - append an option to the reply
+ * @lease:                      the lease to operate on
+ * @option:                     the option code
+ * @data:                       the option data
+ * @n_data:                     the length of @data
+ *
+ * Append an option, which is sent with the offer or acknowledgement of this
+ * lease. Options managed by the server itself cannot be appended.
+ *
+ * Return: 0 on success, negative error code on failure.
+ */
 _c_public_ int n_dhcp4_server_lease_append(NDhcp4ServerLease *lease, uint8_t option, uint8_t *data, size_t n_data) {
-        /* XXX */
-        return -ENOTRECOVERABLE;
+        uint8_t *options;
+
+        switch (option) {
+        case N_DHCP4_OPTION_PAD:
+        case N_DHCP4_OPTION_IP_ADDRESS_LEASE_TIME:
+        case N_DHCP4_OPTION_OVERLOAD:
+        case N_DHCP4_OPTION_MESSAGE_TYPE:
+        case N_DHCP4_OPTION_SERVER_IDENTIFIER:
+        case N_DHCP4_OPTION_CLIENT_IDENTIFIER:
+        case N_DHCP4_OPTION_RENEWAL_T1_TIME:
+        case N_DHCP4_OPTION_REBINDING_T2_TIME:
+        case N_DHCP4_OPTION_END:
+                return -EINVAL;
+        }
+
+        if (n_data > UINT8_MAX)
+                return -EINVAL;
+
+        options = realloc(lease->options, lease->n_options + 2 + n_data);
+        if (!options)
+                return -ENOMEM;
+
+        options[lease->n_options] = option;
+        options[lease->n_options + 1] = n_data;
+        if (n_data)
+                memcpy(options + lease->n_options + 2, data, n_data);
+
+        lease->options = options;
+        lease->n_options += 2 + n_data;
+        return 0;
 }
 
+static int n_dhcp4_server_lease_reply(NDhcp4ServerLease *lease, uint8_t type) {
+        _c_cleanup_(n_dhcp4_outgoing_freep) NDhcp4Outgoing *reply = NULL;
+        NDhcp4SConnection *connection;
+        const struct in_addr *server_address;
+        size_t i;
+        int r;
+
+        if (!lease->server || !lease->server->connection.ip)
+                return -ENOTCONN;
+
+        connection = &lease->server->connection;
+        server_address = &connection->ip->ip;
+
+        switch (type) {
+        case N_DHCP4_MESSAGE_OFFER:
+                r = n_dhcp4_s_connection_offer_new(connection,
+                                                   &reply,
+                                                   lease->request,
+                                                   server_address,
+                                                   &lease->yiaddr,
+                                                   lease->lifetime);
+                break;
+        case N_DHCP4_MESSAGE_ACK:
+                r = n_dhcp4_s_connection_ack_new(connection,
+                                                 &reply,
+                                                 lease->request,
+                                                 server_address,
+                                                 &lease->yiaddr,
+                                                 lease->lifetime);
+                break;
+        default:
+                r = n_dhcp4_s_connection_nak_new(connection,
+                                                 &reply,
+                                                 lease->request,
+                                                 server_address);
+                break;
+        }
+        if (r)
+                return r;
+
+        if (type != N_DHCP4_MESSAGE_NAK) {
+                for (i = 0; i < lease->n_options; i += 2 + lease->options[i + 1]) {
+                        r = n_dhcp4_outgoing_append(reply,
+                                                    lease->options[i],
+                                                    lease->options + i + 2,
+                                                    lease->options[i + 1]);
+                        if (r)
+                                return r;
+                }
+        }
+
+        return n_dhcp4_s_connection_send_reply(connection, server_address, reply);
+}
+
+/**
+ * n_dhcp4_server_lease_offer() - offer the lease to the client
+ * @lease:                      the lease to operate on
+ *
+ * Send a DHCPOFFER for the address set with n_dhcp4_server_lease_set_yiaddr().
+ *
+ * Return: 0 on success, negative error code on failure.
+ */
 _c_public_ int n_dhcp4_server_lease_offer(NDhcp4ServerLease *lease) {
-        /* XXX */
-        return -ENOTRECOVERABLE;
+        return n_dhcp4_server_lease_reply(lease, N_DHCP4_MESSAGE_OFFER);
 }
 
+/**
+ * n_dhcp4_server_lease_ack() - acknowledge the lease to the client
+ * @lease:                      the lease to operate on
+ *
+ * Send a DHCPACK for the address set with n_dhcp4_server_lease_set_yiaddr().
+ *
+ * Return: 0 on success, negative error code on failure.
+ */
 _c_public_ int n_dhcp4_server_lease_ack(NDhcp4ServerLease *lease) {
-        /* XXX */
-        return -ENOTRECOVERABLE;
+        return n_dhcp4_server_lease_reply(lease, N_DHCP4_MESSAGE_ACK);
 }
 
+/**
+ * n_dhcp4_server_lease_nack() - reject the request of the client
+ * @lease:                      the lease to operate on
+ *
+ * Send a DHCPNAK.
+ *
+ * Return: 0 on success, negative error code on failure.
+ */
 _c_public_ int n_dhcp4_server_lease_nack(NDhcp4ServerLease *lease) {
-        /* XXX */
-        return -ENOTRECOVERABLE;
+        return n_dhcp4_server_lease_reply(lease, N_DHCP4_MESSAGE_NAK);
 }
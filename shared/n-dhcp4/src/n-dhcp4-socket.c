@@ -23,13 +23,15 @@
 /**
  * n_dhcp4_c_socket_packet_new() - create a new DHCP4 client packet socket
  * @sockfdp:            return argumnet for the new socket
- * @ifindex:            interface index to bind to
+ * @ifindex:            interface index to bind to, or 0
  *
  * Create a new AF_PACKET/SOCK_DGRAM socket usable to listen to and send DHCP client
  * packets before an IP address has been configured.
  *
  * Only unfragmented DHCP packets from a server to a client destined for the given
- * ifindex is returned.
+ * ifindex is returned. If @ifindex is 0, packets of all interfaces in the
+ * network namespace are returned, and the caller has to demultiplex them based
+ * on the interface reported by n_dhcp4_c_socket_packet_recv().
  *
  * Return: 0 on success, or a negative error code on failure.
  */
@@ -553,12 +555,13 @@ int n_dhcp4_s_socket_udp_broadcast(int sockfd,
 int n_dhcp4_c_socket_packet_recv(int sockfd,
                                  uint8_t *buf,
                                  size_t n_buf,
-                                 NDhcp4Incoming **messagep) {
+                                 NDhcp4Incoming **messagep,
+                                 int *ifindexp) {
         _c_cleanup_(n_dhcp4_incoming_freep) NDhcp4Incoming *message = NULL;
         size_t len;
         int r;
 
-        r = packet_recv_udp(sockfd, buf, n_buf, &len);
+        r = packet_recvfrom_udp(sockfd, buf, n_buf, &len, NULL, ifindexp);
         if (r < 0) {
                 if (r == -ENETDOWN)
                         return N_DHCP4_E_DOWN;
@@ -379,10 +379,262 @@ static void test_connection(void) {
         link_del_ip4(&link_server, &addr_server, 8);
 }
 
+static void test_c_connection_init_shared(int netns,
+                                          NDhcp4CConnection *connection,
+                                          NDhcp4ClientConfig **client_configp,
+                                          NDhcp4ClientProbeConfig **probe_configp,
+                                          NDhcp4ClientSocket *sk,
+                                          Link *link,
+                                          const struct ether_addr *mac,
+                                          unsigned short seed,
+                                          int efd) {
+        int r;
+
+        r = n_dhcp4_client_config_new(client_configp);
+        c_assert(!r);
+
+        n_dhcp4_client_config_set_ifindex(*client_configp, link->ifindex);
+        n_dhcp4_client_config_set_transport(*client_configp, N_DHCP4_TRANSPORT_ETHERNET);
+        n_dhcp4_client_config_set_request_broadcast(*client_configp, true);
+        n_dhcp4_client_config_set_mac(*client_configp, mac->ether_addr_octet, ETH_ALEN);
+        n_dhcp4_client_config_set_broadcast_mac(*client_configp,
+                                                (const uint8_t[]){
+                                                        0xff, 0xff, 0xff,
+                                                        0xff, 0xff, 0xff,
+                                                },
+                                                ETH_ALEN);
+        n_dhcp4_client_config_set_socket(*client_configp, sk);
+
+        r = n_dhcp4_client_probe_config_new(probe_configp);
+        c_assert(!r);
+
+        /* without a probe, nobody seeds the entropy of the xids */
+        r = seed48_r((unsigned short[3]){ seed, seed, seed }, &(*probe_configp)->entropy);
+        c_assert(!r);
+
+        r = n_dhcp4_c_connection_init(connection, *client_configp, *probe_configp, efd);
+        c_assert(!r);
+        test_c_connection_listen(netns, connection);
+}
+
+static void test_shared_discover(NDhcp4SConnection *connection_server,
+                                 NDhcp4CConnection *connection_client,
+                                 NDhcp4Incoming **requestp) {
+        NDhcp4Outgoing *request_out = NULL;
+        int r;
+
+        r = n_dhcp4_c_connection_discover_new(connection_client, &request_out);
+        c_assert(!r);
+
+        r = n_dhcp4_c_connection_start_request(connection_client, request_out, 0);
+        c_assert(!r);
+
+        test_server_receive(connection_server, N_DHCP4_MESSAGE_DISCOVER, requestp);
+}
+
+static void test_shared_offer(NDhcp4SConnection *connection_server,
+                              NDhcp4Incoming *request,
+                              const struct in_addr *addr_server,
+                              uint32_t yiaddr,
+                              bool wrong_xid) {
+        _c_cleanup_(n_dhcp4_outgoing_freep) NDhcp4Outgoing *reply = NULL;
+        int r;
+
+        r = n_dhcp4_s_connection_offer_new(connection_server,
+                                           &reply,
+                                           request,
+                                           addr_server,
+                                           &(struct in_addr){ yiaddr },
+                                           60);
+        c_assert(!r);
+
+        if (wrong_xid)
+                n_dhcp4_outgoing_get_header(reply)->xid ^= 1;
+
+        r = n_dhcp4_s_connection_send_reply(connection_server, addr_server, reply);
+        c_assert(!r);
+}
+
+/*
+ * Dispatch the shared socket until the offer of @yiaddr is the last message
+ * queued on @connection.
+ */
+static void test_shared_dispatch(NDhcp4ClientSocket *sk, NDhcp4CConnection *connection, uint32_t yiaddr) {
+        NDhcp4Incoming *last;
+        int r, fd;
+
+        n_dhcp4_client_socket_get_fd(sk, &fd);
+
+        for (;;) {
+                last = c_list_last_entry(&connection->socket_queue, NDhcp4Incoming, queue_link);
+                if (last && n_dhcp4_incoming_get_header(last)->yiaddr == yiaddr)
+                        return;
+
+                test_poll_server(fd);
+
+                r = n_dhcp4_client_socket_dispatch(sk);
+                c_assert(!r);
+        }
+}
+
+/*
+ * Shared connections have no FD of their own, the queued messages are fetched
+ * without polling.
+ */
+static void test_shared_receive(NDhcp4CConnection *connection, uint32_t yiaddr) {
+        _c_cleanup_(n_dhcp4_incoming_freep) NDhcp4Incoming *offer = NULL;
+        uint8_t type;
+        int r;
+
+        r = n_dhcp4_c_connection_dispatch_io(connection, &offer);
+        c_assert(!r);
+        c_assert(offer);
+
+        r = n_dhcp4_incoming_query_message_type(offer, &type);
+        c_assert(!r);
+        c_assert(type == N_DHCP4_MESSAGE_OFFER);
+        c_assert(n_dhcp4_incoming_get_header(offer)->yiaddr == yiaddr);
+}
+
+static void test_connection_shared(void) {
+        const struct in_addr addr_server1 = (struct in_addr){ htonl(10 << 24 | 1) };
+        const struct in_addr addr_server2 = (struct in_addr){ htonl(11 << 24 | 1) };
+        _c_cleanup_(netns_closep) int ns_server = -1, ns_client = -1;
+        _c_cleanup_(link_deinit) Link link_server1 = LINK_NULL(link_server1);
+        _c_cleanup_(link_deinit) Link link_client1 = LINK_NULL(link_client1);
+        _c_cleanup_(link_deinit) Link link_server2 = LINK_NULL(link_server2);
+        _c_cleanup_(link_deinit) Link link_client2 = LINK_NULL(link_client2);
+        _c_cleanup_(c_closep) int efd_client1 = -1, efd_client2 = -1;
+        int r, oldns;
+
+        /* setup */
+
+        netns_new(&ns_server);
+        netns_new(&ns_client);
+
+        link_new_veth(&link_server1, &link_client1, ns_server, ns_client);
+        link_new_veth(&link_server2, &link_client2, ns_server, ns_client);
+        link_add_ip4(&link_server1, &addr_server1, 8);
+        link_add_ip4(&link_server2, &addr_server2, 8);
+
+        efd_client1 = epoll_create1(EPOLL_CLOEXEC);
+        c_assert(efd_client1 >= 0);
+        efd_client2 = epoll_create1(EPOLL_CLOEXEC);
+        c_assert(efd_client2 >= 0);
+
+        /* test two connections on one shared socket */
+        {
+                _c_cleanup_(n_dhcp4_client_socket_unrefp) NDhcp4ClientSocket *sk = NULL;
+                _c_cleanup_(n_dhcp4_client_config_freep) NDhcp4ClientConfig *client_config1 = NULL;
+                _c_cleanup_(n_dhcp4_client_config_freep) NDhcp4ClientConfig *client_config2 = NULL;
+                _c_cleanup_(n_dhcp4_client_probe_config_freep) NDhcp4ClientProbeConfig *probe_config1 = NULL;
+                _c_cleanup_(n_dhcp4_client_probe_config_freep) NDhcp4ClientProbeConfig *probe_config2 = NULL;
+                NDhcp4SConnection connection_server1 = N_DHCP4_S_CONNECTION_NULL(connection_server1);
+                NDhcp4SConnection connection_server2 = N_DHCP4_S_CONNECTION_NULL(connection_server2);
+                NDhcp4SConnectionIp connection_server1_ip = N_DHCP4_S_CONNECTION_IP_NULL(connection_server1_ip);
+                NDhcp4SConnectionIp connection_server2_ip = N_DHCP4_S_CONNECTION_IP_NULL(connection_server2_ip);
+                NDhcp4CConnection connection_client1 = N_DHCP4_C_CONNECTION_NULL(connection_client1);
+                NDhcp4CConnection connection_client2 = N_DHCP4_C_CONNECTION_NULL(connection_client2);
+                _c_cleanup_(n_dhcp4_incoming_freep) NDhcp4Incoming *request1 = NULL;
+                _c_cleanup_(n_dhcp4_incoming_freep) NDhcp4Incoming *request2 = NULL;
+                NDhcp4Incoming *message;
+                unsigned int i;
+
+                test_s_connection_init(ns_server, &connection_server1, link_server1.ifindex);
+                n_dhcp4_s_connection_ip_init(&connection_server1_ip, addr_server1);
+                n_dhcp4_s_connection_ip_link(&connection_server1_ip, &connection_server1);
+
+                test_s_connection_init(ns_server, &connection_server2, link_server2.ifindex);
+                n_dhcp4_s_connection_ip_init(&connection_server2_ip, addr_server2);
+                n_dhcp4_s_connection_ip_link(&connection_server2_ip, &connection_server2);
+
+                netns_get(&oldns);
+                netns_set(ns_client);
+                r = n_dhcp4_client_socket_new(&sk);
+                c_assert(!r);
+                netns_set(oldns);
+
+                /*
+                 * Like VLANs of the same parent, both clients use the same
+                 * MAC address, and the servers broadcast their replies.
+                 */
+                test_c_connection_init_shared(ns_client, &connection_client1, &client_config1, &probe_config1,
+                                              sk, &link_client1, &link_client1.mac, 1, efd_client1);
+                test_c_connection_init_shared(ns_client, &connection_client2, &client_config2, &probe_config2,
+                                              sk, &link_client2, &link_client1.mac, 2, efd_client2);
+
+                c_assert(connection_client1.fd_packet < 0);
+                c_assert(connection_client2.fd_packet < 0);
+                c_assert(sk->n_connections == 0);
+
+                test_shared_discover(&connection_server1, &connection_client1, &request1);
+                test_shared_discover(&connection_server2, &connection_client2, &request2);
+                c_assert(sk->n_connections == 2);
+
+                /* each connection gets the reply to its own request */
+                test_shared_offer(&connection_server2, request2, &addr_server2, htonl(11 << 24 | 2), false);
+                test_shared_offer(&connection_server1, request1, &addr_server1, htonl(10 << 24 | 2), false);
+
+                test_shared_dispatch(sk, &connection_client1, htonl(10 << 24 | 2));
+                test_shared_dispatch(sk, &connection_client2, htonl(11 << 24 | 2));
+                c_assert(connection_client1.n_socket_queue == 1);
+                c_assert(connection_client2.n_socket_queue == 1);
+
+                test_shared_receive(&connection_client1, htonl(10 << 24 | 2));
+                test_shared_receive(&connection_client2, htonl(11 << 24 | 2));
+
+                /*
+                 * A reply with a foreign xid is dropped, and so is the reply
+                 * to the second client that arrives on the link of the first.
+                 */
+                test_shared_offer(&connection_server1, request1, &addr_server1, htonl(10 << 24 | 3), true);
+                test_shared_offer(&connection_server1, request2, &addr_server1, htonl(10 << 24 | 5), false);
+                test_shared_offer(&connection_server1, request1, &addr_server1, htonl(10 << 24 | 4), false);
+
+                test_shared_dispatch(sk, &connection_client1, htonl(10 << 24 | 4));
+                c_assert(connection_client1.n_socket_queue == 1);
+                c_assert(connection_client2.n_socket_queue == 0);
+
+                test_shared_receive(&connection_client1, htonl(10 << 24 | 4));
+
+                /* a connection that does not keep up loses its oldest messages */
+                for (i = 0; i < N_DHCP4_C_CONNECTION_QUEUE_MAX + 2; ++i)
+                        test_shared_offer(&connection_server1, request1, &addr_server1, htonl(10 << 24 | (16 + i)), false);
+
+                test_shared_dispatch(sk, &connection_client1, htonl(10 << 24 | (16 + N_DHCP4_C_CONNECTION_QUEUE_MAX + 1)));
+                c_assert(connection_client1.n_socket_queue == N_DHCP4_C_CONNECTION_QUEUE_MAX);
+                c_assert(connection_client2.n_socket_queue == 0);
+
+                for (i = 2; i < N_DHCP4_C_CONNECTION_QUEUE_MAX + 2; ++i)
+                        test_shared_receive(&connection_client1, htonl(10 << 24 | (16 + i)));
+
+                r = n_dhcp4_c_connection_dispatch_io(&connection_client1, &message);
+                c_assert(r == N_DHCP4_E_AGAIN);
+                r = n_dhcp4_c_connection_dispatch_io(&connection_client2, &message);
+                c_assert(r == N_DHCP4_E_AGAIN);
+
+                n_dhcp4_c_connection_deinit(&connection_client2);
+                n_dhcp4_c_connection_deinit(&connection_client1);
+                c_assert(sk->n_connections == 0);
+                n_dhcp4_s_connection_ip_unlink(&connection_server2_ip);
+                n_dhcp4_s_connection_ip_deinit(&connection_server2_ip);
+                n_dhcp4_s_connection_deinit(&connection_server2);
+                n_dhcp4_s_connection_ip_unlink(&connection_server1_ip);
+                n_dhcp4_s_connection_ip_deinit(&connection_server1_ip);
+                n_dhcp4_s_connection_deinit(&connection_server1);
+        }
+
+        /* teardown */
+
+        link_del_ip4(&link_server2, &addr_server2, 8);
+        link_del_ip4(&link_server1, &addr_server1, 8);
+}
+
 int main(int argc, char **argv) {
         test_setup();
 
         test_connection();
+        test_connection_shared();
 
         return 0;
 }
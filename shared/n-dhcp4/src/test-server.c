@@ -0,0 +1,407 @@
+/*
+ * Tests for DHCP4 Servers
+ *
+ * A client connection in one network namespace talks to an NDhcp4Server in
+ * another one. The tests answer each request with the public lease API and
+ * verify what the client receives.
+ */
+
+#undef NDEBUG
+#include <assert.h>
+#include <c-stdaux.h>
+#include <endian.h>
+#include <errno.h>
+#include <poll.h>
+#include <linux/if_packet.h>
+#include <net/if_arp.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include "n-dhcp4.h"
+#include "n-dhcp4-private.h"
+#include "test.h"
+#include "util/link.h"
+#include "util/netns.h"
+#include "util/packet.h"
+
+static const uint8_t test_client_id[] = { 'c', 'l', 'i', 'e', 'n', 't', '-', 'i', 'd' };
+
+static void test_poll(int fd) {
+        struct pollfd pfd = { .fd = fd, .events = POLLIN };
+        int r;
+
+        r = poll(&pfd, 1, -1);
+        c_assert(r == 1);
+        c_assert(pfd.revents == POLLIN);
+}
+
+static void test_server_new(int netns, NDhcp4Server **serverp, int ifindex) {
+        _c_cleanup_(n_dhcp4_server_config_freep) NDhcp4ServerConfig *config = NULL;
+        int r, oldns;
+
+        r = n_dhcp4_server_config_new(&config);
+        c_assert(!r);
+
+        n_dhcp4_server_config_set_ifindex(config, ifindex);
+
+        netns_get(&oldns);
+        netns_set(netns);
+
+        r = n_dhcp4_server_new(serverp, config);
+        c_assert(!r);
+
+        netns_set(oldns);
+}
+
+static void test_c_connection_listen(int netns, NDhcp4CConnection *connection) {
+        int r, oldns;
+
+        netns_get(&oldns);
+        netns_set(netns);
+
+        r = n_dhcp4_c_connection_listen(connection);
+        c_assert(!r);
+
+        netns_set(oldns);
+}
+
+static void test_c_connection_connect(int netns,
+                                      NDhcp4CConnection *connection,
+                                      const struct in_addr *client,
+                                      const struct in_addr *server) {
+        int r, oldns;
+
+        netns_get(&oldns);
+        netns_set(netns);
+
+        r = n_dhcp4_c_connection_connect(connection, client, server);
+        c_assert(!r);
+
+        netns_set(oldns);
+}
+
+static void test_client_send(NDhcp4CConnection *connection, NDhcp4Outgoing *request) {
+        int r;
+
+        r = n_dhcp4_c_connection_start_request(connection, request, 0);
+        c_assert(!r);
+}
+
+/*
+ * Wait for the next request on the server and return the lease of the event
+ * it raised. Every request raises exactly one event.
+ */
+static void test_server_event(NDhcp4Server *server, unsigned int expected_event, NDhcp4ServerLease **leasep) {
+        NDhcp4ServerEvent *event;
+        const uint8_t *id;
+        size_t n_id;
+        int r, fd;
+
+        n_dhcp4_server_get_fd(server, &fd);
+
+        do {
+                test_poll(fd);
+
+                r = n_dhcp4_server_dispatch(server);
+                c_assert(!r);
+
+                r = n_dhcp4_server_pop_event(server, &event);
+                c_assert(!r);
+        } while (!event);
+
+        c_assert(event->event == expected_event);
+
+        r = n_dhcp4_server_lease_get_client_id(event->discover.lease, &id, &n_id);
+        c_assert(!r);
+        c_assert(n_id == sizeof(test_client_id));
+        c_assert(!memcmp(id, test_client_id, n_id));
+
+        *leasep = n_dhcp4_server_lease_ref(event->discover.lease);
+
+        r = n_dhcp4_server_pop_event(server, &event);
+        c_assert(!r);
+        c_assert(!event);
+}
+
+static void test_client_receive(NDhcp4CConnection *connection, uint8_t expected_type, NDhcp4Incoming **messagep) {
+        _c_cleanup_(n_dhcp4_incoming_freep) NDhcp4Incoming *message = NULL;
+        uint8_t received_type;
+        int r;
+
+        do {
+                test_poll(connection->fd_epoll);
+
+                r = n_dhcp4_c_connection_dispatch_io(connection, &message);
+                c_assert(!r);
+        } while (!message);
+
+        r = n_dhcp4_incoming_query_message_type(message, &received_type);
+        c_assert(!r);
+        c_assert(received_type == expected_type);
+
+        if (messagep) {
+                *messagep = message;
+                message = NULL;
+        }
+}
+
+static void test_client_verify(NDhcp4Incoming *message,
+                               const struct in_addr *addr_server,
+                               const struct in_addr *addr_client) {
+        struct in_addr server_id;
+        uint8_t *data;
+        size_t n_data;
+        int r;
+
+        c_assert(n_dhcp4_incoming_get_header(message)->yiaddr == addr_client->s_addr);
+
+        r = n_dhcp4_incoming_query_server_identifier(message, &server_id);
+        c_assert(!r);
+        c_assert(server_id.s_addr == addr_server->s_addr);
+
+        r = n_dhcp4_incoming_query(message, N_DHCP4_OPTION_DOMAIN_NAME_SERVER, &data, &n_data);
+        c_assert(!r);
+        c_assert(n_data == sizeof(*addr_server));
+        c_assert(!memcmp(data, addr_server, n_data));
+}
+
+static void test_server_answer(NDhcp4ServerLease *lease, const struct in_addr *addr_server, const struct in_addr *addr_client, bool ack) {
+        int r;
+
+        n_dhcp4_server_lease_set_yiaddr(lease, *addr_client, 60);
+
+        /* options that the server manages itself cannot be overridden */
+        r = n_dhcp4_server_lease_append(lease, N_DHCP4_OPTION_SERVER_IDENTIFIER, (uint8_t *)addr_client, sizeof(*addr_client));
+        c_assert(r == -EINVAL);
+
+        r = n_dhcp4_server_lease_append(lease, N_DHCP4_OPTION_DOMAIN_NAME_SERVER, (uint8_t *)addr_server, sizeof(*addr_server));
+        c_assert(!r);
+
+        r = ack ? n_dhcp4_server_lease_ack(lease) : n_dhcp4_server_lease_offer(lease);
+        c_assert(!r);
+}
+
+static void test_discover(NDhcp4Server *server,
+                          NDhcp4CConnection *connection,
+                          const struct in_addr *addr_server,
+                          const struct in_addr *addr_client,
+                          NDhcp4Incoming **offerp) {
+        _c_cleanup_(n_dhcp4_server_lease_unrefp) NDhcp4ServerLease *lease = NULL;
+        NDhcp4Outgoing *request;
+        struct in_addr requested;
+        int r;
+
+        r = n_dhcp4_c_connection_discover_new(connection, &request);
+        c_assert(!r);
+        test_client_send(connection, request);
+
+        test_server_event(server, N_DHCP4_SERVER_EVENT_DISCOVER, &lease);
+
+        r = n_dhcp4_server_lease_get_requested_ip(lease, &requested);
+        c_assert(r == N_DHCP4_E_UNSET);
+
+        test_server_answer(lease, addr_server, addr_client, false);
+
+        test_client_receive(connection, N_DHCP4_MESSAGE_OFFER, offerp);
+        test_client_verify(*offerp, addr_server, addr_client);
+}
+
+static void test_select(NDhcp4Server *server,
+                        NDhcp4CConnection *connection,
+                        NDhcp4Incoming *offer,
+                        const struct in_addr *addr_server,
+                        const struct in_addr *addr_client,
+                        NDhcp4Incoming **ackp) {
+        _c_cleanup_(n_dhcp4_server_lease_unrefp) NDhcp4ServerLease *lease = NULL;
+        NDhcp4Outgoing *request;
+        struct in_addr requested;
+        int r;
+
+        r = n_dhcp4_c_connection_select_new(connection, &request, offer);
+        c_assert(!r);
+        test_client_send(connection, request);
+
+        test_server_event(server, N_DHCP4_SERVER_EVENT_REQUEST, &lease);
+
+        r = n_dhcp4_server_lease_get_requested_ip(lease, &requested);
+        c_assert(!r);
+        c_assert(requested.s_addr == addr_client->s_addr);
+
+        test_server_answer(lease, addr_server, addr_client, true);
+
+        test_client_receive(connection, N_DHCP4_MESSAGE_ACK, ackp);
+        test_client_verify(*ackp, addr_server, addr_client);
+}
+
+static void test_reboot_nak(NDhcp4Server *server,
+                            NDhcp4CConnection *connection,
+                            const struct in_addr *addr_wrong) {
+        _c_cleanup_(n_dhcp4_server_lease_unrefp) NDhcp4ServerLease *lease = NULL;
+        _c_cleanup_(n_dhcp4_incoming_freep) NDhcp4Incoming *nak = NULL;
+        NDhcp4Outgoing *request;
+        struct in_addr requested;
+        uint8_t *data;
+        size_t n_data;
+        int r;
+
+        r = n_dhcp4_c_connection_reboot_new(connection, &request, addr_wrong);
+        c_assert(!r);
+        test_client_send(connection, request);
+
+        test_server_event(server, N_DHCP4_SERVER_EVENT_REQUEST, &lease);
+
+        r = n_dhcp4_server_lease_get_requested_ip(lease, &requested);
+        c_assert(!r);
+        c_assert(requested.s_addr == addr_wrong->s_addr);
+
+        /* appended options are not sent with a NAK */
+        r = n_dhcp4_server_lease_append(lease, N_DHCP4_OPTION_DOMAIN_NAME_SERVER, (uint8_t *)addr_wrong, sizeof(*addr_wrong));
+        c_assert(!r);
+
+        r = n_dhcp4_server_lease_nack(lease);
+        c_assert(!r);
+
+        test_client_receive(connection, N_DHCP4_MESSAGE_NAK, &nak);
+        c_assert(!n_dhcp4_incoming_get_header(nak)->yiaddr);
+        r = n_dhcp4_incoming_query(nak, N_DHCP4_OPTION_DOMAIN_NAME_SERVER, &data, &n_data);
+        c_assert(r == N_DHCP4_E_UNSET);
+}
+
+static void test_decline(NDhcp4Server *server,
+                         NDhcp4CConnection *connection,
+                         NDhcp4Incoming *ack,
+                         const struct in_addr *addr_client) {
+        _c_cleanup_(n_dhcp4_server_lease_unrefp) NDhcp4ServerLease *lease = NULL;
+        NDhcp4Outgoing *request;
+        struct in_addr requested;
+        int r;
+
+        r = n_dhcp4_c_connection_decline_new(connection, &request, ack, "No thanks.");
+        c_assert(!r);
+        test_client_send(connection, request);
+
+        test_server_event(server, N_DHCP4_SERVER_EVENT_DECLINE, &lease);
+
+        r = n_dhcp4_server_lease_get_requested_ip(lease, &requested);
+        c_assert(!r);
+        c_assert(requested.s_addr == addr_client->s_addr);
+}
+
+static void test_release(NDhcp4Server *server,
+                         NDhcp4CConnection *connection,
+                         const struct in_addr *addr_client) {
+        _c_cleanup_(n_dhcp4_server_lease_unrefp) NDhcp4ServerLease *lease = NULL;
+        NDhcp4Outgoing *request;
+        struct in_addr requested;
+        int r;
+
+        r = n_dhcp4_c_connection_release_new(connection, &request, "Shutting down!");
+        c_assert(!r);
+        test_client_send(connection, request);
+
+        test_server_event(server, N_DHCP4_SERVER_EVENT_RELEASE, &lease);
+
+        /* a releasing client only sets ciaddr */
+        r = n_dhcp4_server_lease_get_requested_ip(lease, &requested);
+        c_assert(!r);
+        c_assert(requested.s_addr == addr_client->s_addr);
+}
+
+static void test_server(void) {
+        const struct in_addr addr_server = (struct in_addr){ htonl(10 << 24 | 1) };
+        const struct in_addr addr_client = (struct in_addr){ htonl(10 << 24 | 2) };
+        const struct in_addr addr_wrong = (struct in_addr){ htonl(192 << 24 | 168 << 16 | 1) };
+        _c_cleanup_(netns_closep) int ns_server = -1, ns_client = -1;
+        _c_cleanup_(link_deinit) Link link_server = LINK_NULL(link_server);
+        _c_cleanup_(link_deinit) Link link_client = LINK_NULL(link_client);
+        _c_cleanup_(c_closep) int efd_client = -1;
+        int r;
+
+        /* setup */
+
+        netns_new(&ns_server);
+        netns_new(&ns_client);
+
+        link_new_veth(&link_server, &link_client, ns_server, ns_client);
+        link_add_ip4(&link_server, &addr_server, 8);
+
+        efd_client = epoll_create1(EPOLL_CLOEXEC);
+        c_assert(efd_client >= 0);
+
+        /* test server */
+        {
+                _c_cleanup_(n_dhcp4_client_config_freep) NDhcp4ClientConfig *client_config = NULL;
+                _c_cleanup_(n_dhcp4_client_probe_config_freep) NDhcp4ClientProbeConfig *probe_config = NULL;
+                NDhcp4CConnection connection = N_DHCP4_C_CONNECTION_NULL(connection);
+                _c_cleanup_(n_dhcp4_incoming_freep) NDhcp4Incoming *offer = NULL;
+                _c_cleanup_(n_dhcp4_incoming_freep) NDhcp4Incoming *ack = NULL;
+                NDhcp4Server *server = NULL;
+                NDhcp4ServerIp *server_ip = NULL;
+
+                test_server_new(ns_server, &server, link_server.ifindex);
+
+                r = n_dhcp4_server_add_ip(server, &server_ip, addr_server);
+                c_assert(!r);
+
+                r = n_dhcp4_client_config_new(&client_config);
+                c_assert(!r);
+
+                n_dhcp4_client_config_set_ifindex(client_config, link_client.ifindex);
+                n_dhcp4_client_config_set_transport(client_config, N_DHCP4_TRANSPORT_ETHERNET);
+                n_dhcp4_client_config_set_request_broadcast(client_config, false);
+                n_dhcp4_client_config_set_mac(client_config, link_client.mac.ether_addr_octet, ETH_ALEN);
+                n_dhcp4_client_config_set_broadcast_mac(client_config,
+                                                        (const uint8_t[]){
+                                                                0xff, 0xff, 0xff,
+                                                                0xff, 0xff, 0xff,
+                                                        },
+                                                        ETH_ALEN);
+                r = n_dhcp4_client_config_set_client_id(client_config,
+                                                        test_client_id,
+                                                        sizeof(test_client_id));
+                c_assert(!r);
+
+                r = n_dhcp4_client_probe_config_new(&probe_config);
+                c_assert(!r);
+
+                r = n_dhcp4_c_connection_init(&connection,
+                                              client_config,
+                                              probe_config,
+                                              efd_client);
+                c_assert(!r);
+                test_c_connection_listen(ns_client, &connection);
+
+                test_discover(server, &connection, &addr_server, &addr_client, &offer);
+                test_select(server, &connection, offer, &addr_server, &addr_client, &ack);
+                test_reboot_nak(server, &connection, &addr_wrong);
+                test_decline(server, &connection, ack, &addr_client);
+
+                link_add_ip4(&link_client, &addr_client, 8);
+                test_c_connection_connect(ns_client, &connection, &addr_client, &addr_server);
+
+                test_release(server, &connection, &addr_client);
+
+                n_dhcp4_c_connection_deinit(&connection);
+                n_dhcp4_server_ip_free(server_ip);
+                n_dhcp4_server_unref(server);
+        }
+
+        /* teardown */
+
+        link_del_ip4(&link_client, &addr_client, 8);
+        link_del_ip4(&link_server, &addr_server, 8);
+}
+
+int main(int argc, char **argv) {
+        if (!test_setup_available()) {
+                fprintf(stderr, "Namespaces not available, skipping.\n");
+                return 77;
+        }
+
+        test_setup();
+
+        test_server();
+
+        return 0;
+}
@@ -193,13 +193,13 @@ static void test_server_client_packet(Link *link_server, Link *link_client) {
 
         test_poll(sk_client);
 
-        r = n_dhcp4_c_socket_packet_recv(sk_client, buf, sizeof(buf), &incoming1);
+        r = n_dhcp4_c_socket_packet_recv(sk_client, buf, sizeof(buf), &incoming1, NULL);
         c_assert(!r);
         c_assert(incoming1);
 
         test_poll(sk_client);
 
-        r = n_dhcp4_c_socket_packet_recv(sk_client, buf, sizeof(buf), &incoming2);
+        r = n_dhcp4_c_socket_packet_recv(sk_client, buf, sizeof(buf), &incoming2, NULL);
         c_assert(!r);
         c_assert(incoming2);
 
@@ -208,6 +208,49 @@ static void test_server_client_packet(Link *link_server, Link *link_client) {
         link_del_ip4(link_server, &addr_server, 8);
 }
 
+static void test_server_client_packet_shared(Link *link_server, Link *link_client) {
+        _c_cleanup_(n_dhcp4_outgoing_freep) NDhcp4Outgoing *outgoing = NULL;
+        _c_cleanup_(n_dhcp4_incoming_freep) NDhcp4Incoming *incoming = NULL;
+        _c_cleanup_(c_closep) int sk_server = -1, sk_client = -1;
+        struct in_addr addr_client = (struct in_addr){ htonl(10 << 24 | 2) };
+        struct in_addr addr_server = (struct in_addr){ htonl(10 << 24 | 1) };
+        uint8_t buf[UINT16_MAX];
+        int r, ifindex = 0;
+
+        /* setup */
+
+        link_add_ip4(link_server, &addr_server, 8);
+
+        /* a socket not bound to an interface reports where packets came in */
+
+        test_server_packet_socket_new(link_server, &sk_server);
+        test_client_packet_socket_new(&(Link){ .netns = link_client->netns }, &sk_client);
+
+        r = n_dhcp4_outgoing_new(&outgoing, 0, 0);
+        c_assert(!r);
+        n_dhcp4_outgoing_get_header(outgoing)->op = N_DHCP4_OP_BOOTREPLY;
+
+        r = n_dhcp4_s_socket_packet_send(sk_server,
+                                         link_server->ifindex,
+                                         &addr_server,
+                                         link_client->mac.ether_addr_octet,
+                                         ETH_ALEN,
+                                         &addr_client,
+                                         outgoing);
+        c_assert(!r);
+
+        test_poll(sk_client);
+
+        r = n_dhcp4_c_socket_packet_recv(sk_client, buf, sizeof(buf), &incoming, &ifindex);
+        c_assert(!r);
+        c_assert(incoming);
+        c_assert(ifindex == link_client->ifindex);
+
+        /* teardown */
+
+        link_del_ip4(link_server, &addr_server, 8);
+}
+
 static void test_server_client_udp(Link *link_server, Link *link_client) {
         _c_cleanup_(n_dhcp4_outgoing_freep) NDhcp4Outgoing *outgoing = NULL;
         _c_cleanup_(n_dhcp4_incoming_freep) NDhcp4Incoming *incoming = NULL;
@@ -265,6 +308,7 @@ static void test_sockets(void) {
         test_client_server_packet(&link_server, &link_client);
         test_client_server_udp(&link_server, &link_client);
         test_server_client_packet(&link_server, &link_client);
+        test_server_client_packet_shared(&link_server, &link_client);
         test_server_client_udp(&link_server, &link_client);
 }
 
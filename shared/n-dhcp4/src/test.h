@@ -20,6 +20,7 @@
 #include <sys/resource.h>
 #include <sys/stat.h>
 #include <sys/types.h>
+#include <sys/wait.h>
 #include <unistd.h>
 
 static inline void test_raise_memlock(void) {
@@ -105,3 +106,27 @@ static inline void test_setup(void) {
         r = mkdir("/run/netns", 0755);
         c_assert(r >= 0);
 }
+
+static inline bool test_setup_available(void) {
+        pid_t pid;
+        int r, status;
+
+        /*
+         * Unprivileged user namespaces might be disabled, in which case
+         * test_setup() fails. Try it in a child first, so the caller can
+         * skip the test instead of aborting.
+         */
+
+        pid = fork();
+        c_assert(pid >= 0);
+
+        if (!pid) {
+                test_setup();
+                _exit(0);
+        }
+
+        r = waitpid(pid, &status, 0);
+        c_assert(r == pid);
+
+        return WIFEXITED(status) && !WEXITSTATUS(status);
+}
@@ -71,11 +71,11 @@ static void link_query(int netns, const char *name, int *ifindexp, struct ether_
         netns_set(oldns);
 }
 
-static void link_move(const char *ifname, int netns) {
+static void link_move(const char *ifname, const char *newname, int netns) {
         char *p;
         int r;
 
-        r = asprintf(&p, "ip link set %s up netns ns-test", ifname);
+        r = asprintf(&p, "ip link set %s name %s up netns ns-test", ifname, newname);
         c_assert(r > 0);
 
         netns_pin(netns, "ns-test");
@@ -96,8 +96,18 @@ static void link_move(const char *ifname, int netns) {
  * This creates a new veth pair in the specified namespaces.
  */
 void link_new_veth(Link *veth_parentp, Link *veth_childp, int netns_parent, int netns_child) {
+        static unsigned int counter;
+        char name_parent[IFNAMSIZ], name_child[IFNAMSIZ];
         int oldns;
 
+        /*
+         * The links are renamed while they are moved, so several pairs can be
+         * created in the same namespaces.
+         */
+        snprintf(name_parent, sizeof(name_parent), "veth-p%u", counter);
+        snprintf(name_child, sizeof(name_child), "veth-c%u", counter);
+        ++counter;
+
         netns_get(&oldns);
         {
                 int r;
@@ -115,25 +125,15 @@ void link_new_veth(Link *veth_parentp, Link *veth_childp, int netns_parent, int
                 r = system("ip link set veth-child up addrgenmode none");
                 c_assert(r == 0);
 
-                link_move("veth-parent", netns_parent);
-                link_move("veth-child", netns_child);
+                link_move("veth-parent", name_parent, netns_parent);
+                link_move("veth-child", name_child, netns_child);
         }
         netns_set(oldns);
 
         netns_new_dup(&veth_parentp->netns, netns_parent);
         netns_new_dup(&veth_childp->netns, netns_child);
-        link_query(netns_parent, "veth-parent", &veth_parentp->ifindex, &veth_parentp->mac);
-        link_query(netns_child, "veth-child", &veth_childp->ifindex, &veth_childp->mac);
-
-        /*
-         * XXX: After moving a link both its name and ifindex might have
-         *      changed. Hence, link_query() might check the wrong interface.
-         *      One way to fix this would be to rename the interfaces after
-         *      they have been moved and queried based on their final ifindex.
-         *      This way, we reserve the internal names for the constructor,
-         *      and guarantee the final names will never conflict (disallowing
-         *      parallel calls to this function).
-         */
+        link_query(netns_parent, name_parent, &veth_parentp->ifindex, &veth_parentp->mac);
+        link_query(netns_child, name_child, &veth_childp->ifindex, &veth_childp->mac);
 }
 
 /**
@@ -43,7 +43,7 @@ NMConnection *nm_utils_match_connection (NMConnection *const*connections,
 int nm_match_spec_device_by_pllink (const NMPlatformLink *pllink,
                                     const char *match_device_type,
                                     const char *match_dhcp_plugin,
-                                    const GSList *specs,
+                                    const NMMatchSpec *spec,
                                     int no_match_value);
 
 
@@ -25,6 +25,11 @@ typedef enum {
 	STATE_ANNOUNCING,
 } State;
 
+/* By default, don't have more than this many probes in flight at the same
+ * time. All probes share the same ARP socket and timer, but probing a large
+ * number of addresses at once would flood the link with ARP requests. */
+#define DEFAULT_MAX_PARALLEL_PROBES 32
+
 typedef struct {
 	in_addr_t address;
 	gboolean duplicate;
@@ -40,6 +45,13 @@ struct _NMAcdManager {
 	NAcd          *acd;
 	GSource       *event_source;
 
+	/* the addresses to probe, in the order in which the probes get started. */
+	GPtrArray     *probe_queue;
+	guint          probe_queue_idx;
+	guint          probe_timeout;
+	guint          n_probing;
+	guint          max_parallel;
+
 	NMAcdCallbacks callbacks;
 	gpointer user_data;
 };
@@ -155,6 +167,27 @@ nm_acd_manager_add_address (NMAcdManager *self, in_addr_t address)
 	return TRUE;
 }
 
+static gboolean acd_probe_add (NMAcdManager *self,
+                               AddressInfo *info,
+                               guint64 timeout);
+
+/* Start queued probes until we reach the limit of parallel probes. Probes
+ * that fail to start count as completed, and their address as unique. */
+static void
+probe_queue_advance (NMAcdManager *self)
+{
+	while (   self->probe_queue_idx < self->probe_queue->len
+	       && (   self->max_parallel == 0
+	           || self->n_probing < self->max_parallel)) {
+		AddressInfo *info = self->probe_queue->pdata[self->probe_queue_idx++];
+
+		if (acd_probe_add (self, info, self->probe_timeout))
+			self->n_probing++;
+		else
+			self->completed++;
+	}
+}
+
 static gboolean
 acd_event (int fd,
            GIOCondition condition,
@@ -220,10 +253,15 @@ acd_event (int fd,
 		}
 
 		if (   check_probing_done
-		    && self->state == STATE_PROBING
-		    && ++self->completed == g_hash_table_size (self->addresses)) {
-			self->state = STATE_PROBE_DONE;
-			emit_probe_terminated = TRUE;
+		    && self->state == STATE_PROBING) {
+			self->completed++;
+			self->n_probing--;
+			probe_queue_advance (self);
+			if (self->completed == self->probe_queue->len) {
+				self->state = STATE_PROBE_DONE;
+				nm_clear_pointer (&self->probe_queue, g_ptr_array_unref);
+				emit_probe_terminated = TRUE;
+			}
 		}
 	}
 
@@ -296,14 +334,35 @@ acd_init (NMAcdManager *self)
 	return r;
 }
 
+/**
+ * nm_acd_manager_set_max_parallel_probes:
+ * @self: a #NMAcdManager
+ * @max_parallel: the maximum number of addresses to probe at the same
+ *   time, or zero for no limit
+ *
+ * Limit the number of concurrent probes started by
+ * nm_acd_manager_start_probe(). Further addresses are probed as soon
+ * as earlier probes complete.
+ */
+void
+nm_acd_manager_set_max_parallel_probes (NMAcdManager *self, guint max_parallel)
+{
+	g_return_if_fail (self);
+	g_return_if_fail (self->state == STATE_INIT);
+
+	self->max_parallel = max_parallel;
+}
+
 /**
  * nm_acd_manager_start_probe:
  * @self: a #NMAcdManager
- * @timeout: maximum probe duration in milliseconds
- * @error: location to store error, or %NULL
+ * @timeout: maximum duration in milliseconds for probing all addresses
  *
- * Start probing IP addresses for duplicates; when the probe terminates a
- * PROBE_TERMINATED signal is emitted.
+ * Start probing IP addresses for duplicates; when all probes terminate
+ * the probe_terminated_callback is invoked. All addresses are probed on
+ * the same ARP socket. If there are more addresses than parallel probes
+ * allowed, @timeout is split between the rounds of probes, so that the
+ * overall duration doesn't depend on the number of addresses.
  *
  * Returns: 0 on success or a negative NetworkManager error code (NME_*).
  */
@@ -312,7 +371,7 @@ nm_acd_manager_start_probe (NMAcdManager *self, guint timeout)
 {
 	GHashTableIter iter;
 	AddressInfo *info;
-	gboolean success = FALSE;
+	guint n_rounds;
 	int fd, r;
 
 	g_return_val_if_fail (self, FALSE);
@@ -327,13 +386,33 @@ nm_acd_manager_start_probe (NMAcdManager *self, guint timeout)
 	}
 
 	self->completed = 0;
+	self->n_probing = 0;
+	self->probe_queue_idx = 0;
+	self->probe_queue = g_ptr_array_sized_new (g_hash_table_size (self->addresses));
 
 	g_hash_table_iter_init (&iter, self->addresses);
 	while (g_hash_table_iter_next (&iter, NULL, (gpointer *) &info))
-		success |= acd_probe_add (self, info, timeout);
+		g_ptr_array_add (self->probe_queue, info);
 
-	if (success)
-		self->state = STATE_PROBING;
+	n_rounds =   self->max_parallel == 0
+	           ? 1
+	           : NM_MAX (1u, (self->probe_queue->len + self->max_parallel - 1) / self->max_parallel);
+	/* a zero timeout would make n-acd skip probing altogether. */
+	self->probe_timeout = NM_MAX (timeout / n_rounds, 1u);
+
+	if (n_rounds > 1) {
+		_LOGD ("probing %u addresses in %u rounds of %u ms",
+		       self->probe_queue->len, n_rounds, self->probe_timeout);
+	}
+
+	probe_queue_advance (self);
+
+	if (self->n_probing == 0) {
+		nm_clear_pointer (&self->probe_queue, g_ptr_array_unref);
+		return -NME_UNSPEC;
+	}
+
+	self->state = STATE_PROBING;
 
 	nm_assert (!self->event_source);
 	n_acd_get_fd (self->acd, &fd);
@@ -345,7 +424,7 @@ nm_acd_manager_start_probe (NMAcdManager *self, guint timeout)
 	                                              NULL);
 	g_source_attach (self->event_source, NULL);
 
-	return success ? 0 : -NME_UNSPEC;
+	return 0;
 }
 
 /**
@@ -474,6 +553,7 @@ nm_acd_manager_new (int ifindex,
 	self->addresses = g_hash_table_new_full (nm_direct_hash, NULL,
 	                                         NULL, destroy_address_info);
 	self->state = STATE_INIT;
+	self->max_parallel = DEFAULT_MAX_PARALLEL_PROBES;
 	self->ifindex = ifindex;
 	memcpy (self->hwaddr, hwaddr, ETH_ALEN);
 	return self;
@@ -487,6 +567,7 @@ nm_acd_manager_free (NMAcdManager *self)
 	if (self->callbacks.user_data_destroy)
 		self->callbacks.user_data_destroy (self->user_data);
 
+	nm_clear_pointer (&self->probe_queue, g_ptr_array_unref);
 	nm_clear_pointer (&self->addresses, g_hash_table_destroy);
 	nm_clear_g_source_inst (&self->event_source);
 	nm_clear_pointer (&self->acd, n_acd_unref);
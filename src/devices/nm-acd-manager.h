@@ -25,6 +25,7 @@ NMAcdManager *nm_acd_manager_new (int ifindex,
 void nm_acd_manager_free (NMAcdManager *self);
 
 gboolean nm_acd_manager_add_address (NMAcdManager *self, in_addr_t address);
+void nm_acd_manager_set_max_parallel_probes (NMAcdManager *self, guint max_parallel);
 int nm_acd_manager_start_probe (NMAcdManager *self, guint timeout);
 gboolean nm_acd_manager_check_address (NMAcdManager *self, in_addr_t address);
 int nm_acd_manager_announce_addresses (NMAcdManager *self);
@@ -43,6 +43,7 @@
 #include "nm-ip6-config.h"
 #include "nm-pacrunner-manager.h"
 #include "dnsmasq/nm-dnsmasq-manager.h"
+#include "dhcp/nm-dhcp-server.h"
 #include "nm-dhcp-config.h"
 #include "nm-rfkill-manager.h"
 #include "nm-firewall-manager.h"
@@ -199,6 +200,7 @@ enum {
 	REMOVED,
 	RECHECK_AUTO_ACTIVATE,
 	RECHECK_ASSUME,
+	IDX_KEYS_CHANGED,
 	LAST_SIGNAL,
 };
 static guint signals[LAST_SIGNAL] = { 0 };
@@ -519,6 +521,12 @@ typedef struct _NMDevicePrivate {
 	NMDnsMasqManager *dnsmasq_manager;
 	gulong            dnsmasq_state_id;
 
+	/* with main.shared-dhcp=internal, instead of dnsmasq */
+	NMDhcpServer     *dhcp_server;
+
+	/* pending insertion of the share rules */
+	NMFirewallShareCallId *share_call_id;
+
 	/* Firewall */
 	FirewallState fw_state:4;
 	NMFirewallManager *fw_mgr;
@@ -549,6 +557,8 @@ typedef struct _NMDevicePrivate {
 	AppliedConfig  ac_ip6_config;  /* config from IPv6 autoconfiguration */
 	NMIP6Config *  ext_ip6_config_captured; /* Configuration captured from platform. */
 	NMIP6Config *  dad6_ip6_config;
+	gint64         dad6_start_msec;
+	guint32        ip6_dad_ifa_flags;
 	struct in6_addr ipv6ll_addr;
 
 	GHashTable *   rt6_temporary_not_available;
@@ -1444,6 +1454,19 @@ _set_ip_state (NMDevice *self, int addr_family, NMDeviceIPState new_state)
 
 /*****************************************************************************/
 
+static void
+_notify_idx_keys (NMDevice *self, _PropertyEnums prop)
+{
+	_notify (self, prop);
+
+	/* property notifications are delayed while notify is frozen, like during
+	 * realize. The manager indexes devices by these properties and must learn
+	 * about changes right away. */
+	g_signal_emit (self, signals[IDX_KEYS_CHANGED], 0);
+}
+
+/*****************************************************************************/
+
 const char *
 nm_device_get_udi (NMDevice *self)
 {
@@ -1495,7 +1518,7 @@ nm_device_take_over_link (NMDevice *self, int ifindex, char **old_name)
 
 	if (success) {
 		priv->ifindex = ifindex;
-		_notify (self, PROP_IFINDEX);
+		_notify_idx_keys (self, PROP_IFINDEX);
 	}
 
 	return success;
@@ -1603,7 +1626,7 @@ _set_ip_ifindex (NMDevice *self,
 	if (!eq_name) {
 		g_free (priv->ip_iface);
 		priv->ip_iface = g_strdup (ifname);
-		_notify (self, PROP_IP_IFACE);
+		_notify_idx_keys (self, PROP_IP_IFACE);
 	}
 
 	if (priv->ip_ifindex > 0) {
@@ -1695,7 +1718,7 @@ _ip_iface_update (NMDevice *self, const char *ip_iface)
 	       priv->ip_iface, ip_iface);
 	g_free (priv->ip_iface);
 	priv->ip_iface = g_strdup (ip_iface);
-	_notify (self, PROP_IP_IFACE);
+	_notify_idx_keys (self, PROP_IP_IFACE);
 	return TRUE;
 }
 
@@ -3983,9 +4006,9 @@ device_link_changed (NMDevice *self)
 		else
 			update_unmanaged_specs = TRUE;
 
-		_notify (self, PROP_IFACE);
+		_notify_idx_keys (self, PROP_IFACE);
 		if (ip_ifname_changed)
-			_notify (self, PROP_IP_IFACE);
+			_notify_idx_keys (self, PROP_IP_IFACE);
 
 		/* Re-match available connections against the new interface name */
 		nm_device_recheck_available_connections (self);
@@ -4342,7 +4365,7 @@ nm_device_update_from_platform_link (NMDevice *self, const NMPlatformLink *plink
 	if (str && g_strcmp0 (str, priv->iface)) {
 		g_free (priv->iface);
 		priv->iface = g_strdup (str);
-		_notify (self, PROP_IFACE);
+		_notify_idx_keys (self, PROP_IFACE);
 	}
 
 	str = plink ? plink->driver : NULL;
@@ -4366,7 +4389,7 @@ nm_device_update_from_platform_link (NMDevice *self, const NMPlatformLink *plink
 	ifindex = plink ? plink->ifindex : 0;
 	if (priv->ifindex != ifindex) {
 		priv->ifindex = ifindex;
-		_notify (self, PROP_IFINDEX);
+		_notify_idx_keys (self, PROP_IFINDEX);
 		NM_DEVICE_GET_CLASS (self)->link_changed (self, plink);
 	}
 
@@ -4848,11 +4871,11 @@ nm_device_unrealize (NMDevice *self, gboolean remove_resources, GError **error)
 
 	if (priv->ifindex > 0) {
 		priv->ifindex = 0;
-		_notify (self, PROP_IFINDEX);
+		_notify_idx_keys (self, PROP_IFINDEX);
 	}
 	priv->ip_ifindex = 0;
 	if (nm_clear_g_free (&priv->ip_iface))
-		_notify (self, PROP_IP_IFACE);
+		_notify_idx_keys (self, PROP_IP_IFACE);
 
 	_set_mtu (self, 0);
 
@@ -4878,10 +4901,10 @@ nm_device_unrealize (NMDevice *self, gboolean remove_resources, GError **error)
 
 	priv->hw_addr_len_ = 0;
 	if (nm_clear_g_free (&priv->hw_addr))
-		_notify (self, PROP_HW_ADDRESS);
+		_notify_idx_keys (self, PROP_HW_ADDRESS);
 	priv->hw_addr_type = HW_ADDR_TYPE_UNSET;
 	if (nm_clear_g_free (&priv->hw_addr_perm))
-		_notify (self, PROP_PERM_HW_ADDRESS);
+		_notify_idx_keys (self, PROP_PERM_HW_ADDRESS);
 	g_clear_pointer (&priv->hw_addr_initial, g_free);
 
 	priv->capabilities = NM_DEVICE_CAP_NM_SUPPORTED;
@@ -7682,6 +7705,8 @@ ip_config_merge_and_apply (NMDevice *self,
 		                           priv->ndisc
 		                             ? priv->ndisc_use_tempaddr
 		                             : NM_SETTING_IP6_CONFIG_PRIVACY_UNKNOWN);
+		nm_ip6_config_set_dad_ifa_flags (NM_IP6_CONFIG (composite),
+		                                 priv->ip6_dad_ifa_flags);
 	}
 
 	init_ip_config_dns_priority (self, composite);
@@ -10271,6 +10296,8 @@ save_ip6_properties (NMDevice *self)
 		"disable_ipv6",
 		"hop_limit",
 		"use_tempaddr",
+		"accept_dad",
+		"optimistic_dad",
 	};
 	NMDevicePrivate *priv = NM_DEVICE_GET_PRIVATE (self);
 	NMPlatform *platform = nm_device_get_platform (self);
@@ -10427,6 +10454,25 @@ _ip6_privacy_get (NMDevice *self)
 	return _ip6_privacy_clamp (ip6_privacy);
 }
 
+static guint32
+_ip6_dad_ifa_flags_get (NMDevice *self)
+{
+	gs_free char *value = NULL;
+
+	value = nm_config_data_get_connection_default (NM_CONFIG_GET_DATA,
+	                                               NM_CON_DEFAULT ("ipv6.dad"),
+	                                               self);
+	if (!value || nm_streq (value, "full"))
+		return 0;
+	if (nm_streq (value, "optimistic"))
+		return IFA_F_OPTIMISTIC;
+	if (nm_streq (value, "skip"))
+		return IFA_F_NODAD;
+
+	_LOGW (LOGD_IP6, "invalid value \"%s\" for \"ipv6.dad\", using \"full\"", value);
+	return 0;
+}
+
 /*****************************************************************************/
 
 static gboolean
@@ -10607,6 +10653,10 @@ act_stage3_ip_config_start (NMDevice *self,
 
 		ip6_privacy = _ip6_privacy_get (self);
 
+		priv->ip6_dad_ifa_flags =   nm_device_sys_iface_state_is_external_or_assume (self)
+		                          ? 0
+		                          : _ip6_dad_ifa_flags_get (self);
+
 		if (NM_IN_STRSET (method, NM_SETTING_IP6_CONFIG_METHOD_AUTO,
 		                          NM_SETTING_IP6_CONFIG_METHOD_SHARED)) {
 			if (!addrconf6_start (self, ip6_privacy)) {
@@ -10645,6 +10695,13 @@ act_stage3_ip_config_start (NMDevice *self,
 				break;
 			}
 			nm_device_sysctl_ip_conf_set (self, AF_INET6, "use_tempaddr", ip6_privacy_str);
+
+			/* The flags only apply to addresses that we add ourself, the sysctls
+			 * take care of those that kernel generates. */
+			if (priv->ip6_dad_ifa_flags == IFA_F_OPTIMISTIC)
+				nm_device_sysctl_ip_conf_set (self, AF_INET6, "optimistic_dad", "1");
+			else if (priv->ip6_dad_ifa_flags == IFA_F_NODAD)
+				nm_device_sysctl_ip_conf_set (self, AF_INET6, "accept_dad", "0");
 		}
 
 		return ret;
@@ -11011,60 +11068,34 @@ share_init (NMDevice *self, GError **error)
 	} G_STMT_END
 
 static gboolean
-start_sharing (NMDevice *self, NMIP4Config *config, GError **error)
+_shared_dhcp_internal (void)
+{
+	gs_free char *value = NULL;
+
+	value = nm_config_data_get_value (NM_CONFIG_GET_DATA,
+	                                  NM_CONFIG_KEYFILE_GROUP_MAIN,
+	                                  NM_CONFIG_KEYFILE_KEY_MAIN_SHARED_DHCP,
+	                                  NM_CONFIG_GET_VALUE_STRIP | NM_CONFIG_GET_VALUE_NO_EMPTY);
+	return nm_streq0 (value, "internal");
+}
+
+static gboolean
+start_sharing_services (NMDevice *self, NMIP4Config *config, GError **error)
 {
 	NMDevicePrivate *priv = NM_DEVICE_GET_PRIVATE (self);
 	NMActRequest *req;
-	char str_addr[INET_ADDRSTRLEN];
-	char str_mask[INET_ADDRSTRLEN];
-	guint32 netmask, network;
-	const NMPlatformIP4Address *ip4_addr = NULL;
 	const char *ip_iface;
 	GError *local = NULL;
 	NMConnection *conn;
 	NMSettingConnection *s_con;
 	gboolean announce_android_metered;
 
-	g_return_val_if_fail (config, FALSE);
-
-	ip_iface = nm_device_get_ip_iface (self);
-	if (!ip_iface) {
-		g_set_error (error, NM_UTILS_ERROR, NM_UTILS_ERROR_UNKNOWN,
-		             "device has no ip interface");
-		return FALSE;
-	}
-
-	ip4_addr = nm_ip4_config_get_first_address (config);
-	if (!ip4_addr || !ip4_addr->address) {
-		g_set_error (error, NM_UTILS_ERROR, NM_UTILS_ERROR_UNKNOWN,
-		             "could not determine IPv4 address");
-		return FALSE;
-	}
-
-	if (!share_init (self, error))
-		return FALSE;
-
 	req = nm_device_get_act_request (self);
-	g_return_val_if_fail (req, FALSE);
-
-	netmask = _nm_utils_ip4_prefix_to_netmask (ip4_addr->plen);
-	_nm_utils_inet4_ntop (netmask, str_mask);
-
-	network = ip4_addr->address & netmask;
-	_nm_utils_inet4_ntop (network, str_addr);
-
-	add_share_rule (req, "nat", "POSTROUTING --source %s/%s ! --destination %s/%s --jump MASQUERADE", str_addr, str_mask, str_addr, str_mask);
-	add_share_rule (req, "filter", "FORWARD --destination %s/%s --out-interface %s --match state --state ESTABLISHED,RELATED --jump ACCEPT", str_addr, str_mask, ip_iface);
-	add_share_rule (req, "filter", "FORWARD --source %s/%s --in-interface %s --jump ACCEPT", str_addr, str_mask, ip_iface);
-	add_share_rule (req, "filter", "FORWARD --in-interface %s --out-interface %s --jump ACCEPT", ip_iface, ip_iface);
-	add_share_rule (req, "filter", "FORWARD --out-interface %s --jump REJECT", ip_iface);
-	add_share_rule (req, "filter", "FORWARD --in-interface %s --jump REJECT", ip_iface);
-	add_share_rule (req, "filter", "INPUT --in-interface %s --protocol udp --destination-port 67 --jump ACCEPT", ip_iface);
-	add_share_rule (req, "filter", "INPUT --in-interface %s --protocol tcp --destination-port 67 --jump ACCEPT", ip_iface);
-	add_share_rule (req, "filter", "INPUT --in-interface %s --protocol udp --destination-port 53 --jump ACCEPT", ip_iface);
-	add_share_rule (req, "filter", "INPUT --in-interface %s --protocol tcp --destination-port 53 --jump ACCEPT", ip_iface);
+	ip_iface = nm_device_get_ip_iface (self);
 
-	nm_act_request_set_shared (req, TRUE);
+	nm_assert (req);
+	nm_assert (config);
+	nm_assert (ip_iface);
 
 	conn = nm_act_request_get_applied_connection (req);
 	s_con = nm_connection_get_setting_connection (conn);
@@ -11090,6 +11121,28 @@ start_sharing (NMDevice *self, NMIP4Config *config, GError **error)
 		break;
 	}
 
+	if (_shared_dhcp_internal ()) {
+		gs_unref_array GArray *upstream_nameservers = NULL;
+
+		/* like the metered flag, the announced name servers are not updated
+		 * when the upstream configuration changes. */
+		upstream_nameservers = nm_dns_manager_get_nameservers4 (nm_dns_manager_get (),
+		                                                        nm_device_get_ip_ifindex (self));
+		priv->dhcp_server = nm_dhcp_server_new (nm_device_get_ip_ifindex (self),
+		                                        ip_iface,
+		                                        config,
+		                                        upstream_nameservers,
+		                                        announce_android_metered,
+		                                        &local);
+		if (!priv->dhcp_server) {
+			g_set_error (error, NM_UTILS_ERROR, NM_UTILS_ERROR_UNKNOWN,
+			             "could not start DHCP server due to %s", local->message);
+			g_error_free (local);
+			nm_act_request_set_shared (req, FALSE, NULL, NULL);
+			return FALSE;
+		}
+		return TRUE;
+	}
 
 	if (!nm_dnsmasq_manager_start (priv->dnsmasq_manager,
 	                               config,
@@ -11098,7 +11151,7 @@ start_sharing (NMDevice *self, NMIP4Config *config, GError **error)
 		g_set_error (error, NM_UTILS_ERROR, NM_UTILS_ERROR_UNKNOWN,
 		             "could not start dnsmasq due to %s", local->message);
 		g_error_free (local);
-		nm_act_request_set_shared (req, FALSE);
+		nm_act_request_set_shared (req, FALSE, NULL, NULL);
 		return FALSE;
 	}
 
@@ -11108,6 +11161,80 @@ start_sharing (NMDevice *self, NMIP4Config *config, GError **error)
 	return TRUE;
 }
 
+static void
+start_sharing_cb (NMFirewallShareCallId *call_id, gpointer user_data)
+{
+	NMDevice *self = user_data;
+	NMDevicePrivate *priv = NM_DEVICE_GET_PRIVATE (self);
+	gs_free_error GError *error = NULL;
+
+	nm_assert (priv->share_call_id == call_id);
+	priv->share_call_id = NULL;
+
+	/* the rules are in place, only now start serving the shared network. */
+	if (!start_sharing_services (self, priv->ip_config_4, &error)) {
+		_LOGW (LOGD_SHARING, "Activation: Stage 5 of 5 (IPv4 Commit) start sharing failed: %s", error->message);
+		nm_device_ip_method_failed (self, AF_INET, NM_DEVICE_STATE_REASON_SHARED_START_FAILED);
+	}
+}
+
+static gboolean
+start_sharing (NMDevice *self, NMIP4Config *config, GError **error)
+{
+	NMDevicePrivate *priv = NM_DEVICE_GET_PRIVATE (self);
+	NMActRequest *req;
+	char str_addr[INET_ADDRSTRLEN];
+	char str_mask[INET_ADDRSTRLEN];
+	guint32 netmask, network;
+	const NMPlatformIP4Address *ip4_addr = NULL;
+	const char *ip_iface;
+
+	g_return_val_if_fail (config, FALSE);
+
+	ip_iface = nm_device_get_ip_iface (self);
+	if (!ip_iface) {
+		g_set_error (error, NM_UTILS_ERROR, NM_UTILS_ERROR_UNKNOWN,
+		             "device has no ip interface");
+		return FALSE;
+	}
+
+	ip4_addr = nm_ip4_config_get_first_address (config);
+	if (!ip4_addr || !ip4_addr->address) {
+		g_set_error (error, NM_UTILS_ERROR, NM_UTILS_ERROR_UNKNOWN,
+		             "could not determine IPv4 address");
+		return FALSE;
+	}
+
+	if (!share_init (self, error))
+		return FALSE;
+
+	req = nm_device_get_act_request (self);
+	g_return_val_if_fail (req, FALSE);
+
+	netmask = _nm_utils_ip4_prefix_to_netmask (ip4_addr->plen);
+	_nm_utils_inet4_ntop (netmask, str_mask);
+
+	network = ip4_addr->address & netmask;
+	_nm_utils_inet4_ntop (network, str_addr);
+
+	add_share_rule (req, "nat", "POSTROUTING --source %s/%s ! --destination %s/%s --jump MASQUERADE", str_addr, str_mask, str_addr, str_mask);
+	add_share_rule (req, "filter", "FORWARD --destination %s/%s --out-interface %s --match state --state ESTABLISHED,RELATED --jump ACCEPT", str_addr, str_mask, ip_iface);
+	add_share_rule (req, "filter", "FORWARD --source %s/%s --in-interface %s --jump ACCEPT", str_addr, str_mask, ip_iface);
+	add_share_rule (req, "filter", "FORWARD --in-interface %s --out-interface %s --jump ACCEPT", ip_iface, ip_iface);
+	add_share_rule (req, "filter", "FORWARD --out-interface %s --jump REJECT", ip_iface);
+	add_share_rule (req, "filter", "FORWARD --in-interface %s --jump REJECT", ip_iface);
+	add_share_rule (req, "filter", "INPUT --in-interface %s --protocol udp --destination-port 67 --jump ACCEPT", ip_iface);
+	add_share_rule (req, "filter", "INPUT --in-interface %s --protocol tcp --destination-port 67 --jump ACCEPT", ip_iface);
+	add_share_rule (req, "filter", "INPUT --in-interface %s --protocol udp --destination-port 53 --jump ACCEPT", ip_iface);
+	add_share_rule (req, "filter", "INPUT --in-interface %s --protocol tcp --destination-port 53 --jump ACCEPT", ip_iface);
+
+	/* dnsmasq, or the internal DHCP server, is started once the
+	 * rules are inserted. */
+	nm_clear_pointer (&priv->share_call_id, nm_firewall_share_rules_cancel);
+	priv->share_call_id = nm_act_request_set_shared (req, TRUE, start_sharing_cb, self);
+	return TRUE;
+}
+
 static void
 arp_cleanup (NMDevice *self)
 {
@@ -11435,6 +11562,7 @@ activate_stage5_ip_config_result_6 (NMDevice *self)
 
 			if (priv->dad6_ip6_config) {
 				_LOGD (LOGD_DEVICE | LOGD_IP6, "IPv6 DAD: awaiting termination");
+				priv->dad6_start_msec = nm_utils_get_monotonic_timestamp_msec ();
 			} else {
 				_set_ip_state (self, AF_INET6, NM_DEVICE_IP_STATE_DONE);
 				check_ip_state (self, FALSE, TRUE);
@@ -11492,6 +11620,9 @@ dnsmasq_cleanup (NMDevice *self)
 {
 	NMDevicePrivate *priv = NM_DEVICE_GET_PRIVATE (self);
 
+	nm_clear_pointer (&priv->share_call_id, nm_firewall_share_rules_cancel);
+	nm_clear_pointer (&priv->dhcp_server, nm_dhcp_server_free);
+
 	if (!priv->dnsmasq_manager)
 		return;
 
@@ -11629,6 +11760,7 @@ _cleanup_ip_pre (NMDevice *self, int addr_family, CleanupType cleanup_type)
 		g_slist_free_full (priv->dad6_failed_addrs, (GDestroyNotify) nmp_object_unref);
 		priv->dad6_failed_addrs = NULL;
 		g_clear_object (&priv->dad6_ip6_config);
+		priv->ip6_dad_ifa_flags = 0;
 		dhcp6_cleanup (self, cleanup_type, FALSE);
 		nm_clear_g_source (&priv->linklocal6_timeout_id);
 		addrconf6_cleanup (self);
@@ -13836,7 +13968,8 @@ queued_ip_config_change (NMDevice *self, int addr_family)
 		    && priv->ext_ip6_config_captured
 		    && !nm_ip6_config_has_any_dad_pending (priv->ext_ip6_config_captured,
 		                                           priv->dad6_ip6_config)) {
-			_LOGD (LOGD_DEVICE | LOGD_IP6, "IPv6 DAD terminated");
+			_LOGD (LOGD_DEVICE | LOGD_IP6, "IPv6 DAD terminated after %"G_GINT64_FORMAT" msec",
+			       nm_utils_get_monotonic_timestamp_msec () - priv->dad6_start_msec);
 			g_clear_object (&priv->dad6_ip6_config);
 			_set_ip_state (self, addr_family, NM_DEVICE_IP_STATE_DONE);
 			check_ip_state (self, FALSE, TRUE);
@@ -14171,8 +14304,8 @@ _set_unmanaged_flags (NMDevice *self,
 		if (!NM_FLAGS_HAS (flags, NM_UNMANAGED_USER_SETTINGS)) {
 			gboolean unmanaged;
 
-			unmanaged = nm_device_spec_match_list (self,
-			                                       nm_settings_get_unmanaged_specs (NM_DEVICE_GET_PRIVATE (self)->settings));
+			unmanaged = nm_device_match_spec (self,
+			                                  nm_settings_get_unmanaged_match_spec (NM_DEVICE_GET_PRIVATE (self)->settings));
 			nm_device_set_unmanaged_flags (self,
 			                               NM_UNMANAGED_USER_SETTINGS,
 			                               !!unmanaged);
@@ -14323,7 +14456,7 @@ nm_device_check_unrealized_device_managed (NMDevice *self)
 	                                               TRUE))
 		return FALSE;
 
-	if (nm_device_spec_match_list (self, nm_settings_get_unmanaged_specs (priv->settings)))
+	if (nm_device_match_spec (self, nm_settings_get_unmanaged_match_spec (priv->settings)))
 		return FALSE;
 
 	return TRUE;
@@ -14348,8 +14481,8 @@ nm_device_set_unmanaged_by_user_settings (NMDevice *self)
 		return;
 	}
 
-	unmanaged = nm_device_spec_match_list (self,
-	                                       nm_settings_get_unmanaged_specs (NM_DEVICE_GET_PRIVATE (self)->settings));
+	unmanaged = nm_device_match_spec (self,
+	                                  nm_settings_get_unmanaged_match_spec (NM_DEVICE_GET_PRIVATE (self)->settings));
 
 	nm_device_set_unmanaged_by_flags (self,
 	                                  NM_UNMANAGED_USER_SETTINGS,
@@ -15515,7 +15648,7 @@ ip_config_valid (NMDeviceState state)
 static void
 notify_ip_properties (NMDevice *self)
 {
-	_notify (self, PROP_IP_IFACE);
+	_notify_idx_keys (self, PROP_IP_IFACE);
 	_notify (self, PROP_IP4_CONFIG);
 	_notify (self, PROP_DHCP4_CONFIG);
 	_notify (self, PROP_IP6_CONFIG);
@@ -16185,7 +16318,7 @@ nm_device_update_hw_address (NMDevice *self)
 	priv->hw_addr = nm_utils_hwaddr_ntoa (hwaddr, hwaddrlen);
 
 	_LOGD (LOGD_PLATFORM | LOGD_DEVICE, "hw-addr: hardware address now %s", priv->hw_addr);
-	_notify (self, PROP_HW_ADDRESS);
+	_notify_idx_keys (self, PROP_HW_ADDRESS);
 
 	if (   !priv->hw_addr_initial
 	    || (   priv->hw_addr_type == HW_ADDR_TYPE_UNSET
@@ -16311,7 +16444,7 @@ nm_device_update_permanent_hw_address (NMDevice *self, gboolean force_freeze)
 	priv->hw_addr_perm = g_strdup (priv->hw_addr);
 
 notify_and_out:
-	_notify (self, PROP_PERM_HW_ADDRESS);
+	_notify_idx_keys (self, PROP_PERM_HW_ADDRESS);
 }
 
 static const char *
@@ -16858,30 +16991,44 @@ nm_device_spec_match_list (NMDevice *self, const GSList *specs)
 	return nm_device_spec_match_list_full (self, specs, FALSE);
 }
 
-int
-nm_device_spec_match_list_full (NMDevice *self, const GSList *specs, int no_match_value)
+/**
+ * nm_device_get_spec_match_data:
+ * @self: an #NMDevice
+ * @data: (out): the attributes of @self that device match specs are
+ *   evaluated against.
+ *
+ * The strings are owned by @self and only valid until the
+ * device changes.
+ */
+void
+nm_device_get_spec_match_data (NMDevice *self, NMDeviceSpecMatchData *data)
 {
 	NMDeviceClass *klass;
-	NMMatchSpecMatchType m;
-	const char *hw_address = NULL;
+	const char *hw_address;
 	gboolean is_fake;
 
-	g_return_val_if_fail (NM_IS_DEVICE (self), FALSE);
+	g_return_if_fail (NM_IS_DEVICE (self));
+	nm_assert (data);
 
 	klass = NM_DEVICE_GET_CLASS (self);
 	hw_address = nm_device_get_permanent_hw_address_full (self,
 	                                                      !nm_device_get_unmanaged_flags (self, NM_UNMANAGED_PLATFORM_INIT),
 	                                                      &is_fake);
 
-	m = nm_match_spec_device (specs,
-	                          nm_device_get_iface (self),
-	                          nm_device_get_type_description (self),
-	                          nm_device_get_driver (self),
-	                          nm_device_get_driver_version (self),
-	                          is_fake ? NULL : hw_address,
-	                          klass->get_s390_subchannels ? klass->get_s390_subchannels (self) : NULL,
-	                          nm_dhcp_manager_get_config (nm_dhcp_manager_get ()));
+	*data = (NMDeviceSpecMatchData) {
+		.interface_name   = nm_device_get_iface (self),
+		.device_type      = nm_device_get_type_description (self),
+		.driver           = nm_device_get_driver (self),
+		.driver_version   = nm_device_get_driver_version (self),
+		.hwaddr           = is_fake ? NULL : hw_address,
+		.s390_subchannels = klass->get_s390_subchannels ? klass->get_s390_subchannels (self) : NULL,
+		.dhcp_plugin      = nm_dhcp_manager_get_config (nm_dhcp_manager_get ()),
+	};
+}
 
+static int
+_spec_match_result (NMMatchSpecMatchType m, int no_match_value)
+{
 	switch (m) {
 	case NM_MATCH_SPEC_MATCH:
 		return TRUE;
@@ -16894,6 +17041,63 @@ nm_device_spec_match_list_full (NMDevice *self, const GSList *specs, int no_matc
 	return no_match_value;
 }
 
+int
+nm_device_spec_match_list_full (NMDevice *self, const GSList *specs, int no_match_value)
+{
+	NMDeviceSpecMatchData data;
+
+	g_return_val_if_fail (NM_IS_DEVICE (self), FALSE);
+
+	nm_device_get_spec_match_data (self, &data);
+	return _spec_match_result (nm_match_spec_device (specs,
+	                                                 data.interface_name,
+	                                                 data.device_type,
+	                                                 data.driver,
+	                                                 data.driver_version,
+	                                                 data.hwaddr,
+	                                                 data.s390_subchannels,
+	                                                 data.dhcp_plugin),
+	                           no_match_value);
+}
+
+/**
+ * nm_device_match_spec:
+ * @self: an #NMDevice
+ * @spec: (allow-none): a compiled match spec from nm_match_spec_new().
+ *
+ * Like nm_device_spec_match_list(), but matches against a spec
+ * that was pre-parsed once.
+ *
+ * Returns: #TRUE if @self matches @spec
+ */
+gboolean
+nm_device_match_spec (NMDevice *self, const NMMatchSpec *spec)
+{
+	return nm_device_match_spec_full (self, spec, FALSE);
+}
+
+int
+nm_device_match_spec_full (NMDevice *self, const NMMatchSpec *spec, int no_match_value)
+{
+	NMDeviceSpecMatchData data;
+
+	g_return_val_if_fail (NM_IS_DEVICE (self), FALSE);
+
+	if (!spec)
+		return no_match_value;
+
+	nm_device_get_spec_match_data (self, &data);
+	return _spec_match_result (nm_match_spec_match_device (spec,
+	                                                       data.interface_name,
+	                                                       data.device_type,
+	                                                       data.driver,
+	                                                       data.driver_version,
+	                                                       data.hwaddr,
+	                                                       data.s390_subchannels,
+	                                                       data.dhcp_plugin),
+	                           no_match_value);
+}
+
 guint
 nm_device_get_supplicant_timeout (NMDevice *self)
 {
@@ -17439,6 +17643,8 @@ dispose (GObject *object)
 
 	arp_cleanup (self);
 
+	nm_clear_pointer (&priv->share_call_id, nm_firewall_share_rules_cancel);
+
 	nm_clear_g_signal_handler (nm_config_get (), &priv->config_changed_id);
 
 	dispatcher_cleanup (self);
@@ -17469,7 +17675,7 @@ dispose (GObject *object)
 
 	if (priv->ifindex > 0) {
 		priv->ifindex = 0;
-		_notify (self, PROP_IFINDEX);
+		_notify_idx_keys (self, PROP_IFINDEX);
 	}
 
 	if (priv->settings) {
@@ -17995,6 +18201,13 @@ nm_device_class_init (NMDeviceClass *klass)
 	                  G_SIGNAL_RUN_FIRST,
 	                  0, NULL, NULL, NULL,
 	                  G_TYPE_NONE, 0);
+
+	signals[IDX_KEYS_CHANGED] =
+	    g_signal_new (NM_DEVICE_IDX_KEYS_CHANGED,
+	                  G_OBJECT_CLASS_TYPE (object_class),
+	                  G_SIGNAL_RUN_FIRST,
+	                  0, NULL, NULL, NULL,
+	                  G_TYPE_NONE, 0);
 }
 
 /* Connection defaults from plugins */
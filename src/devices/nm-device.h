@@ -123,6 +123,7 @@ nm_device_state_reason_check (NMDeviceStateReason reason)
 #define NM_DEVICE_REMOVED               "removed"
 #define NM_DEVICE_RECHECK_AUTO_ACTIVATE "recheck-auto-activate"
 #define NM_DEVICE_RECHECK_ASSUME        "recheck-assume"
+#define NM_DEVICE_IDX_KEYS_CHANGED      "idx-keys-changed"
 #define NM_DEVICE_STATE_CHANGED         "state-changed"
 #define NM_DEVICE_LINK_INITIALIZED      "link-initialized"
 #define NM_DEVICE_AUTOCONNECT_ALLOWED   "autoconnect-allowed"
@@ -580,8 +581,22 @@ gboolean nm_device_check_slave_connection_compatible (NMDevice *device, NMConnec
 
 gboolean nm_device_unmanage_on_quit (NMDevice *self);
 
+typedef struct {
+	const char *interface_name;
+	const char *device_type;
+	const char *driver;
+	const char *driver_version;
+	const char *hwaddr;
+	const char *s390_subchannels;
+	const char *dhcp_plugin;
+} NMDeviceSpecMatchData;
+
+void nm_device_get_spec_match_data (NMDevice *self, NMDeviceSpecMatchData *data);
+
 gboolean nm_device_spec_match_list (NMDevice *device, const GSList *specs);
 int      nm_device_spec_match_list_full (NMDevice *self, const GSList *specs, int no_match_value);
+gboolean nm_device_match_spec (NMDevice *self, const NMMatchSpec *spec);
+int      nm_device_match_spec_full (NMDevice *self, const NMMatchSpec *spec, int no_match_value);
 
 gboolean nm_device_is_activating (NMDevice *dev);
 gboolean nm_device_autoconnect_allowed (NMDevice *self);
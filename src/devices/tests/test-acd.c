@@ -85,6 +85,7 @@ typedef struct {
 	in_addr_t addresses[8];
 	in_addr_t peer_addresses[8];
 	gboolean expected_result[8];
+	guint max_parallel;
 } TestInfo;
 
 static void
@@ -128,6 +129,9 @@ again:
 	                              g_main_loop_ref (loop));
 	g_assert (manager != NULL);
 
+	if (info->max_parallel)
+		nm_acd_manager_set_max_parallel_probes (manager, info->max_parallel);
+
 	for (i = 0; info->addresses[i]; i++)
 		g_assert (nm_acd_manager_add_address (manager, info->addresses[i]));
 
@@ -182,6 +186,17 @@ test_acd_probe_2 (test_fixture *fixture, gconstpointer user_data)
 	test_acd_common (fixture, &info);
 }
 
+static void
+test_acd_probe_parallel (test_fixture *fixture, gconstpointer user_data)
+{
+	TestInfo info = { .addresses       = { ADDR1, ADDR2, ADDR3, ADDR4 },
+	                  .peer_addresses  = { ADDR3, ADDR2 },
+	                  .expected_result = { TRUE, FALSE, FALSE, TRUE },
+	                  .max_parallel    = 1 };
+
+	test_acd_common (fixture, &info);
+}
+
 static void
 test_acd_announce (test_fixture *fixture, gconstpointer user_data)
 {
@@ -228,5 +243,6 @@ _nmtstp_setup_tests (void)
 {
 	g_test_add ("/acd/probe/1", test_fixture, NULL, fixture_setup, test_acd_probe_1, fixture_teardown);
 	g_test_add ("/acd/probe/2", test_fixture, NULL, fixture_setup, test_acd_probe_2, fixture_teardown);
+	g_test_add ("/acd/probe/parallel", test_fixture, NULL, fixture_setup, test_acd_probe_parallel, fixture_teardown);
 	g_test_add ("/acd/announce", test_fixture, NULL, fixture_setup, test_acd_announce, fixture_teardown);
 }
@@ -75,6 +75,12 @@ typedef struct {
 
 	CList             aps_lst_head;
 
+	/* indexes of the APs in aps_lst_head. The SSID and BSSID indexes map to
+	 * arrays of APs, because neither is unique. */
+	GHashTable       *aps_idx_by_supplicant_path;
+	GHashTable       *aps_idx_by_ssid;
+	GHashTable       *aps_idx_by_bssid;
+
 	NMWifiAP *        current_ap;
 	guint32           rate;
 	bool              enabled:1; /* rfkilled or not */
@@ -82,6 +88,8 @@ typedef struct {
 	bool              ssid_found:1;
 	bool              is_scanning:1;
 	bool              hidden_probe_scan_warn:1;
+	bool              link_monitor_active:1;
+	bool              link_monitor_unsupported:1;
 
 	gint64            last_scan; /* milliseconds */
 	gint32            scheduled_scan_time; /* seconds */
@@ -407,22 +415,17 @@ set_current_ap (NMDeviceWifi *self, NMWifiAP *new_ap, gboolean recheck_available
 	_notify (self, PROP_ACTIVE_ACCESS_POINT);
 }
 
-static void
-periodic_update (NMDeviceWifi *self)
+static gboolean
+periodic_update_check (NMDeviceWifi *self)
 {
 	NMDeviceWifiPrivate *priv = NM_DEVICE_WIFI_GET_PRIVATE (self);
-	int ifindex = nm_device_get_ifindex (NM_DEVICE (self));
-	guint32 new_rate;
-	int percent;
-	NMDeviceState state;
 	NMSupplicantInterfaceState supplicant_state;
 
 	/* BSSID and signal strength have meaningful values only if the device
 	 * is activated and not scanning.
 	 */
-	state = nm_device_get_state (NM_DEVICE (self));
-	if (state != NM_DEVICE_STATE_ACTIVATED)
-		return;
+	if (nm_device_get_state (NM_DEVICE (self)) != NM_DEVICE_STATE_ACTIVATED)
+		return FALSE;
 
 	/* Only update current AP if we're actually talking to something, otherwise
 	 * assume the old one (if any) is still valid until we're told otherwise or
@@ -432,15 +435,22 @@ periodic_update (NMDeviceWifi *self)
 	if (   supplicant_state < NM_SUPPLICANT_INTERFACE_STATE_AUTHENTICATING
 	    || supplicant_state > NM_SUPPLICANT_INTERFACE_STATE_COMPLETED
 	    || nm_supplicant_interface_get_scanning (priv->sup_iface))
-		return;
+		return FALSE;
 
 	/* In AP mode we currently have nothing to do. */
 	if (priv->mode == NM_802_11_MODE_AP)
-		return;
+		return FALSE;
+
+	return TRUE;
+}
+
+static void
+periodic_update_set (NMDeviceWifi *self, int percent, guint32 new_rate)
+{
+	NMDeviceWifiPrivate *priv = NM_DEVICE_WIFI_GET_PRIVATE (self);
 
 	if (priv->current_ap) {
 		/* Smooth out the strength to work around crappy drivers */
-		percent = nm_platform_wifi_get_quality (nm_device_get_platform (NM_DEVICE (self)), ifindex);
 		if (percent >= 0 || ++priv->invalid_strength_counter > 3) {
 			if (nm_wifi_ap_set_strength (priv->current_ap, (gint8) percent)) {
 #if NM_MORE_LOGGING
@@ -451,18 +461,245 @@ periodic_update (NMDeviceWifi *self)
 		}
 	}
 
-	new_rate = nm_platform_wifi_get_rate (nm_device_get_platform (NM_DEVICE (self)), ifindex);
 	if (new_rate != priv->rate) {
 		priv->rate = new_rate;
 		_notify (self, PROP_BITRATE);
 	}
 }
 
+static void
+periodic_update (NMDeviceWifi *self)
+{
+	NMDeviceWifiPrivate *priv = NM_DEVICE_WIFI_GET_PRIVATE (self);
+	NMPlatform *platform = nm_device_get_platform (NM_DEVICE (self));
+	int ifindex = nm_device_get_ifindex (NM_DEVICE (self));
+	int percent = -1;
+
+	if (!periodic_update_check (self))
+		return;
+
+	if (priv->current_ap)
+		percent = nm_platform_wifi_get_quality (platform, ifindex);
+
+	periodic_update_set (self,
+	                     percent,
+	                     nm_platform_wifi_get_rate (platform, ifindex));
+}
+
+static void
+link_monitor_cb (int quality, guint32 rate, gpointer user_data)
+{
+	NMDeviceWifi *self = user_data;
+
+	if (periodic_update_check (self))
+		periodic_update_set (self, quality, rate);
+}
+
+static gboolean
+link_monitor_start (NMDeviceWifi *self)
+{
+	NMDeviceWifiPrivate *priv = NM_DEVICE_WIFI_GET_PRIVATE (self);
+	NMConnection *connection;
+	gint64 hysteresis;
+
+	/* Prefer signal updates from driver events over waking up every few
+	 * seconds. The thresholds are armed around the current signal level,
+	 * so wait until we are associated. wpa_supplicant's bgscan uses the
+	 * same (single) CQM RSSI configuration of the interface for roaming,
+	 * so leave it alone while bgscan is on. */
+	if (   priv->link_monitor_active
+	    || priv->link_monitor_unsupported
+	    || !priv->current_ap
+	    || !periodic_update_check (self))
+		return FALSE;
+
+	connection = nm_device_get_applied_connection (NM_DEVICE (self));
+	if (   !connection
+	    || nm_supplicant_config_get_bgscan (connection))
+		return FALSE;
+
+	hysteresis = nm_config_data_get_connection_default_int64 (NM_CONFIG_GET_DATA,
+	                                                          NM_CON_DEFAULT ("wifi.signal-hysteresis"),
+	                                                          NM_DEVICE (self),
+	                                                          0,
+	                                                          100,
+	                                                          4);
+	if (   hysteresis <= 0
+	    || !nm_platform_wifi_set_link_monitor (nm_device_get_platform (NM_DEVICE (self)),
+	                                           nm_device_get_ifindex (NM_DEVICE (self)),
+	                                           hysteresis,
+	                                           link_monitor_cb,
+	                                           self)) {
+		/* Drivers that don't support that still get polled. */
+		priv->link_monitor_unsupported = TRUE;
+		return FALSE;
+	}
+
+	priv->link_monitor_active = TRUE;
+	return TRUE;
+}
+
 static gboolean
 periodic_update_cb (gpointer user_data)
 {
-	periodic_update (NM_DEVICE_WIFI (user_data));
-	return TRUE;
+	NMDeviceWifi *self = user_data;
+	NMDeviceWifiPrivate *priv = NM_DEVICE_WIFI_GET_PRIVATE (self);
+
+	periodic_update (self);
+
+	if (link_monitor_start (self)) {
+		/* The bitrate changes without a notification, so keep polling,
+		 * but at a slower pace. */
+		priv->periodic_source_id = g_timeout_add_seconds (60, periodic_update_cb, self);
+		return G_SOURCE_REMOVE;
+	}
+
+	return G_SOURCE_CONTINUE;
+}
+
+static void
+periodic_update_start (NMDeviceWifi *self)
+{
+	NMDeviceWifiPrivate *priv = NM_DEVICE_WIFI_GET_PRIVATE (self);
+
+	if (priv->periodic_source_id)
+		return;
+
+	priv->periodic_source_id = g_timeout_add_seconds (priv->link_monitor_active ? 60 : 6,
+	                                                  periodic_update_cb,
+	                                                  self);
+}
+
+static void
+periodic_update_stop (NMDeviceWifi *self)
+{
+	NMDeviceWifiPrivate *priv = NM_DEVICE_WIFI_GET_PRIVATE (self);
+	int ifindex;
+
+	nm_clear_g_source (&priv->periodic_source_id);
+	priv->link_monitor_unsupported = FALSE;
+
+	if (priv->link_monitor_active) {
+		priv->link_monitor_active = FALSE;
+		ifindex = nm_device_get_ifindex (NM_DEVICE (self));
+		if (ifindex > 0) {
+			nm_platform_wifi_set_link_monitor (nm_device_get_platform (NM_DEVICE (self)),
+			                                   ifindex,
+			                                   0,
+			                                   NULL,
+			                                   NULL);
+		}
+	}
+}
+
+/*****************************************************************************/
+
+static void
+_aps_idx_bucket_add (GHashTable *idx, gconstpointer key, GBoxedCopyFunc key_copy, NMWifiAP *ap)
+{
+	GPtrArray *aps;
+
+	aps = g_hash_table_lookup (idx, key);
+	if (!aps) {
+		aps = g_ptr_array_new ();
+		g_hash_table_insert (idx, key_copy ((gpointer) key), aps);
+	}
+	g_ptr_array_add (aps, ap);
+}
+
+static void
+_aps_idx_bucket_remove (GHashTable *idx, gconstpointer key, NMWifiAP *ap)
+{
+	GPtrArray *aps;
+
+	aps = g_hash_table_lookup (idx, key);
+	nm_assert (aps);
+	g_ptr_array_remove (aps, ap);
+	if (aps->len == 0)
+		g_hash_table_remove (idx, key);
+}
+
+/* Update the SSID and BSSID indexes after the AP's SSID or address changed,
+ * or drop the AP from the indexes when it gets removed. */
+static void
+_aps_idx_update (NMDeviceWifi *self, NMWifiAP *ap, gboolean is_removing)
+{
+	NMDeviceWifiPrivate *priv = NM_DEVICE_WIFI_GET_PRIVATE (self);
+	GBytes *ssid = NULL;
+	const char *bssid = NULL;
+
+	if (!is_removing) {
+		ssid = nm_wifi_ap_get_ssid (ap);
+		bssid = nm_wifi_ap_get_address (ap);
+	}
+
+	if (   ap->aps_idx_ssid != ssid
+	    && (   !ap->aps_idx_ssid
+	        || !ssid
+	        || !g_bytes_equal (ap->aps_idx_ssid, ssid))) {
+		if (ap->aps_idx_ssid) {
+			_aps_idx_bucket_remove (priv->aps_idx_by_ssid, ap->aps_idx_ssid, ap);
+			nm_clear_pointer (&ap->aps_idx_ssid, g_bytes_unref);
+		}
+		if (ssid) {
+			ap->aps_idx_ssid = g_bytes_ref (ssid);
+			_aps_idx_bucket_add (priv->aps_idx_by_ssid, ssid, (GBoxedCopyFunc) g_bytes_ref, ap);
+		}
+	}
+
+	if (!nm_streq0 (ap->aps_idx_bssid, bssid)) {
+		if (ap->aps_idx_bssid) {
+			_aps_idx_bucket_remove (priv->aps_idx_by_bssid, ap->aps_idx_bssid, ap);
+			nm_clear_g_free (&ap->aps_idx_bssid);
+		}
+		if (bssid) {
+			ap->aps_idx_bssid = g_strdup (bssid);
+			_aps_idx_bucket_add (priv->aps_idx_by_bssid, bssid, (GBoxedCopyFunc) g_strdup, ap);
+		}
+	}
+}
+
+static NMWifiAP *
+_aps_find_by_supplicant_path (NMDeviceWifi *self, const char *path)
+{
+	return g_hash_table_lookup (NM_DEVICE_WIFI_GET_PRIVATE (self)->aps_idx_by_supplicant_path, path);
+}
+
+static NMWifiAP *
+_aps_find_first_compatible (NMDeviceWifi *self, NMConnection *connection)
+{
+	NMDeviceWifiPrivate *priv = NM_DEVICE_WIFI_GET_PRIVATE (self);
+	NMSettingWireless *s_wifi;
+	GPtrArray *aps = NULL;
+	GBytes *ssid;
+	const char *bssid;
+	guint i;
+
+	s_wifi = nm_connection_get_setting_wireless (connection);
+	ssid = s_wifi ? nm_setting_wireless_get_ssid (s_wifi) : NULL;
+	if (!ssid)
+		return nm_wifi_aps_find_first_compatible (&priv->aps_lst_head, connection);
+
+	/* Only APs with the same SSID (and BSSID, if the profile is locked to one)
+	 * can be compatible. Look only at those. */
+	bssid = nm_setting_wireless_get_bssid (s_wifi);
+	if (bssid) {
+		gs_free char *bssid_canonical = NULL;
+
+		bssid_canonical = nm_utils_hwaddr_canonical (bssid, ETH_ALEN);
+		if (bssid_canonical)
+			aps = g_hash_table_lookup (priv->aps_idx_by_bssid, bssid_canonical);
+	} else
+		aps = g_hash_table_lookup (priv->aps_idx_by_ssid, ssid);
+
+	if (!aps)
+		return NULL;
+
+	for (i = 0; i < aps->len; i++) {
+		if (nm_wifi_ap_check_compatible (aps->pdata[i], connection))
+			return aps->pdata[i];
+	}
+	return NULL;
 }
 
 static void
@@ -477,12 +714,23 @@ ap_add_remove (NMDeviceWifi *self,
 		g_object_ref (ap);
 		ap->wifi_device = NM_DEVICE (self);
 		c_list_link_tail (&priv->aps_lst_head, &ap->aps_lst);
+		if (nm_wifi_ap_get_supplicant_path (ap)) {
+			g_hash_table_insert (priv->aps_idx_by_supplicant_path,
+			                     (gpointer) nm_wifi_ap_get_supplicant_path (ap),
+			                     ap);
+		}
+		_aps_idx_update (self, ap, FALSE);
 		nm_dbus_object_export (NM_DBUS_OBJECT (ap));
 		_ap_dump (self, LOGL_DEBUG, ap, "added", 0);
 		nm_device_wifi_emit_signal_access_point (NM_DEVICE (self), ap, TRUE);
 	} else {
 		ap->wifi_device = NULL;
 		c_list_unlink (&ap->aps_lst);
+		if (nm_wifi_ap_get_supplicant_path (ap)) {
+			g_hash_table_remove (priv->aps_idx_by_supplicant_path,
+			                     nm_wifi_ap_get_supplicant_path (ap));
+		}
+		_aps_idx_update (self, ap, TRUE);
 		_ap_dump (self, LOGL_DEBUG, ap, "removed", 0);
 	}
 
@@ -593,7 +841,7 @@ deactivate (NMDevice *device)
 	int ifindex = nm_device_get_ifindex (device);
 	NM80211Mode old_mode = priv->mode;
 
-	nm_clear_g_source (&priv->periodic_source_id);
+	periodic_update_stop (self);
 
 	cleanup_association_attempt (self, TRUE);
 
@@ -731,7 +979,6 @@ check_connection_available (NMDevice *device,
                             GError **error)
 {
 	NMDeviceWifi *self = NM_DEVICE_WIFI (device);
-	NMDeviceWifiPrivate *priv = NM_DEVICE_WIFI_GET_PRIVATE (self);
 	NMSettingWireless *s_wifi;
 	const char *mode;
 
@@ -779,7 +1026,7 @@ check_connection_available (NMDevice *device,
 	    || NM_FLAGS_HAS (flags, _NM_DEVICE_CHECK_CON_AVAILABLE_FOR_USER_REQUEST_IGNORE_AP))
 		return TRUE;
 
-	if (!nm_wifi_aps_find_first_compatible (&priv->aps_lst_head, connection)) {
+	if (!_aps_find_first_compatible (self, connection)) {
 		nm_utils_error_set_literal (error, NM_UTILS_ERROR_CONNECTION_AVAILABLE_TEMPORARY,
 		                            "no compatible access point found");
 		return FALSE;
@@ -796,7 +1043,6 @@ complete_connection (NMDevice *device,
                      GError **error)
 {
 	NMDeviceWifi *self = NM_DEVICE_WIFI (device);
-	NMDeviceWifiPrivate *priv = NM_DEVICE_WIFI_GET_PRIVATE (self);
 	NMSettingWireless *s_wifi;
 	gs_free char *ssid_utf8 = NULL;
 	NMWifiAP *ap;
@@ -830,7 +1076,7 @@ complete_connection (NMDevice *device,
 
 		if (!nm_streq0 (mode, NM_SETTING_WIRELESS_MODE_AP)) {
 			/* Find a compatible AP in the scan list */
-			ap = nm_wifi_aps_find_first_compatible (&priv->aps_lst_head, connection);
+			ap = _aps_find_first_compatible (self, connection);
 
 			/* If we still don't have an AP, then the WiFI settings needs to be
 			 * fully specified by the client.  Might not be able to find an AP
@@ -958,7 +1204,6 @@ can_auto_connect (NMDevice *device,
                   char **specific_object)
 {
 	NMDeviceWifi *self = NM_DEVICE_WIFI (device);
-	NMDeviceWifiPrivate *priv = NM_DEVICE_WIFI_GET_PRIVATE (self);
 	NMConnection *connection;
 	NMSettingWireless *s_wifi;
 	NMWifiAP *ap;
@@ -1001,7 +1246,7 @@ can_auto_connect (NMDevice *device,
 			return FALSE;
 	}
 
-	ap = nm_wifi_aps_find_first_compatible (&priv->aps_lst_head, connection);
+	ap = _aps_find_first_compatible (self, connection);
 	if (ap) {
 		/* All good; connection is usable */
 		NM_SET_OUT (specific_object, g_strdup (nm_dbus_object_get_path (NM_DBUS_OBJECT (ap))));
@@ -1573,10 +1818,11 @@ supplicant_iface_bss_updated_cb (NMSupplicantInterface *iface,
 	if (NM_DEVICE_WIFI_GET_PRIVATE (self)->mode == NM_802_11_MODE_AP)
 		return;
 
-	found_ap = nm_wifi_aps_find_by_supplicant_path (&priv->aps_lst_head, object_path);
+	found_ap = _aps_find_by_supplicant_path (self, object_path);
 	if (found_ap) {
 		if (!nm_wifi_ap_update_from_properties (found_ap, object_path, properties))
 			return;
+		_aps_idx_update (self, found_ap, FALSE);
 		_ap_dump (self, LOGL_DEBUG, found_ap, "updated", 0);
 	} else {
 		gs_unref_object NMWifiAP *ap = NULL;
@@ -1633,7 +1879,7 @@ supplicant_iface_bss_removed_cb (NMSupplicantInterface *iface,
 	g_return_if_fail (object_path != NULL);
 
 	priv = NM_DEVICE_WIFI_GET_PRIVATE (self);
-	ap = nm_wifi_aps_find_by_supplicant_path (&priv->aps_lst_head, object_path);
+	ap = _aps_find_by_supplicant_path (self, object_path);
 	if (!ap)
 		return;
 
@@ -2202,7 +2448,7 @@ supplicant_iface_notify_current_bss (NMSupplicantInterface *iface,
 
 	current_bss = nm_supplicant_interface_get_current_bss (iface);
 	if (current_bss)
-		new_ap = nm_wifi_aps_find_by_supplicant_path (&priv->aps_lst_head, current_bss);
+		new_ap = _aps_find_by_supplicant_path (self, current_bss);
 
 	if (new_ap != priv->current_ap) {
 		const char *new_bssid = NULL;
@@ -2666,7 +2912,7 @@ act_stage1_prepare (NMDevice *device, NMDeviceStateReason *out_failure_reason)
 		     : NULL;
 	}
 	if (!ap)
-		ap = nm_wifi_aps_find_first_compatible (&priv->aps_lst_head, connection);
+		ap = _aps_find_first_compatible (self, connection);
 
 	if (!ap) {
 		/* If the user is trying to connect to an AP that NM doesn't yet know about
@@ -2853,8 +3099,7 @@ act_stage2_config (NMDevice *device, NMDeviceStateReason *out_failure_reason)
 	                                              supplicant_connection_timeout_cb,
 	                                              self);
 
-	if (!priv->periodic_source_id)
-		priv->periodic_source_id = g_timeout_add_seconds (6, periodic_update_cb, self);
+	periodic_update_start (self);
 
 	/* We'll get stage3 started when the supplicant connects */
 	ret = NM_ACT_STAGE_RETURN_POSTPONE;
@@ -3018,6 +3263,7 @@ activation_success_handler (NMDevice *device)
 				    && nm_ethernet_address_is_valid (bssid, ETH_ALEN)) {
 					bssid_str = nm_utils_hwaddr_ntoa (bssid, ETH_ALEN);
 					ap_changed |= nm_wifi_ap_set_address (priv->current_ap, bssid_str);
+					_aps_idx_update (self, priv->current_ap, FALSE);
 				}
 			}
 			if (!nm_wifi_ap_get_freq (priv->current_ap))
@@ -3061,7 +3307,7 @@ device_state_changed (NMDevice *device,
 		if (priv->sup_iface)
 			supplicant_interface_release (self);
 
-		nm_clear_g_source (&priv->periodic_source_id);
+		periodic_update_stop (self);
 
 		cleanup_association_attempt (self, TRUE);
 		cleanup_supplicant_failures (self);
@@ -3296,6 +3542,13 @@ nm_device_wifi_init (NMDeviceWifi *self)
 	NMDeviceWifiPrivate *priv = NM_DEVICE_WIFI_GET_PRIVATE (self);
 
 	c_list_init (&priv->aps_lst_head);
+	priv->aps_idx_by_supplicant_path = g_hash_table_new (nm_str_hash, g_str_equal);
+	priv->aps_idx_by_ssid = g_hash_table_new_full (g_bytes_hash, g_bytes_equal,
+	                                               (GDestroyNotify) g_bytes_unref,
+	                                               (GDestroyNotify) g_ptr_array_unref);
+	priv->aps_idx_by_bssid = g_hash_table_new_full (nm_str_hash, g_str_equal,
+	                                                g_free,
+	                                                (GDestroyNotify) g_ptr_array_unref);
 
 	priv->hidden_probe_scan_warn = TRUE;
 	priv->mode = NM_802_11_MODE_INFRA;
@@ -3336,7 +3589,7 @@ dispose (GObject *object)
 	NMDeviceWifi *self = NM_DEVICE_WIFI (object);
 	NMDeviceWifiPrivate *priv = NM_DEVICE_WIFI_GET_PRIVATE (self);
 
-	nm_clear_g_source (&priv->periodic_source_id);
+	periodic_update_stop (self);
 
 	wifi_secrets_cancel (self);
 
@@ -3364,6 +3617,11 @@ finalize (GObject *object)
 	NMDeviceWifiPrivate *priv = NM_DEVICE_WIFI_GET_PRIVATE (self);
 
 	nm_assert (c_list_is_empty (&priv->aps_lst_head));
+	nm_assert (g_hash_table_size (priv->aps_idx_by_supplicant_path) == 0);
+
+	g_hash_table_unref (priv->aps_idx_by_supplicant_path);
+	g_hash_table_unref (priv->aps_idx_by_ssid);
+	g_hash_table_unref (priv->aps_idx_by_bssid);
 
 	G_OBJECT_CLASS (nm_device_wifi_parent_class)->finalize (object);
 }
@@ -33,6 +33,9 @@ typedef struct {
 	NMDBusObject parent;
 	NMDevice *wifi_device;
 	CList aps_lst;
+	/* the keys under which the wifi device currently indexes the AP. */
+	GBytes *aps_idx_ssid;
+	char *aps_idx_bssid;
 	struct _NMWifiAPPrivate *_priv;
 } NMWifiAP;
 
@@ -94,8 +97,6 @@ const char      **nm_wifi_aps_get_paths        (const CList *aps_lst_head,
 NMWifiAP         *nm_wifi_aps_find_first_compatible (const CList *aps_lst_head,
                                                      NMConnection *connection);
 
-NMWifiAP         *nm_wifi_aps_find_by_supplicant_path (const CList *aps_lst_head, const char *path);
-
 NMWifiAP         *nm_wifi_ap_lookup_for_device (NMDevice *device, const char *exported_path);
 
 #endif /* __NM_WIFI_AP_H__ */
@@ -17,4 +17,26 @@
 
 /*****************************************************************************/
 
+/* Besides D-Bus, the helper can notify NetworkManager via a SOCK_SEQPACKET
+ * socket. It connects and sends a single message, starting with the
+ * version (a guint32) followed by one record per option. A record is a
+ * NMDhcpHelperSocketRecord followed by the name and the value, both without
+ * trailing NUL. All integers are in host byte order.
+ *
+ * After handling the event, NetworkManager replies with a single
+ * NM_DHCP_HELPER_SOCKET_ACK byte and closes the connection. If the socket
+ * does not exist or the message is rejected, the helper falls back to D-Bus.
+ * If the reply does not arrive in time, the event is considered delivered. */
+#define NM_DHCP_HELPER_SOCKET_PATH              NMRUNDIR "/private-dhcp-event"
+#define NM_DHCP_HELPER_SOCKET_VERSION           1
+#define NM_DHCP_HELPER_SOCKET_MSG_MAX           (64 * 1024)
+#define NM_DHCP_HELPER_SOCKET_ACK               'A'
+
+typedef struct {
+	guint32 name_len;
+	guint32 value_len;
+} NMDhcpHelperSocketRecord;
+
+/*****************************************************************************/
+
 #endif /* __NM_DHCP_HELPER_API_H__ */
@@ -8,6 +8,8 @@
 #include <unistd.h>
 #include <stdlib.h>
 #include <signal.h>
+#include <sys/socket.h>
+#include <sys/un.h>
 
 #include "nm-utils/nm-vpn-plugin-macros.h"
 
@@ -48,6 +50,28 @@
 
 static const char * ignore[] = {"PATH", "SHLVL", "_", "PWD", "dhc_dbus", NULL};
 
+static gboolean
+env_split (const char *item, gsize *out_name_len, const char **out_val)
+{
+	const char *val;
+	const char **p;
+
+	/* Split on the = */
+	val = strchr (item, '=');
+	if (!val || val == item)
+		return FALSE;
+
+	/* Ignore non-DCHP-related environment variables */
+	for (p = ignore; *p; p++) {
+		if (strncmp (item, *p, strlen (*p)) == 0)
+			return FALSE;
+	}
+
+	*out_name_len = val - item;
+	*out_val = &val[1];
+	return TRUE;
+}
+
 static GVariant *
 build_signal_parameters (void)
 {
@@ -58,20 +82,14 @@ build_signal_parameters (void)
 
 	/* List environment and format for dbus dict */
 	for (item = environ; *item; item++) {
-		char *name, *val, **p;
-
-		/* Split on the = */
-		name = g_strdup (*item);
-		val = strchr (name, '=');
-		if (!val || val == name)
-			goto next;
-		*val++ = '\0';
-
-		/* Ignore non-DCHP-related environment variables */
-		for (p = (char **) ignore; *p; p++) {
-			if (strncmp (name, *p, strlen (*p)) == 0)
-				goto next;
-		}
+		gs_free char *name = NULL;
+		const char *val;
+		gsize name_len;
+
+		if (!env_split (*item, &name_len, &val))
+			continue;
+
+		name = g_strndup (*item, name_len);
 
 		/* Value passed as a byte array rather than a string, because there are
 		 * no character encoding guarantees with DHCP, and D-Bus requires
@@ -84,14 +102,107 @@ build_signal_parameters (void)
 		                       name,
 		                       g_variant_new_fixed_array (G_VARIANT_TYPE_BYTE,
 		                                                  val, strlen (val), 1));
-
-	next:
-		g_free (name);
 	}
 
 	return g_variant_ref_sink (g_variant_new ("(a{sv})", &builder));
 }
 
+static GByteArray *
+build_socket_message (void)
+{
+	const guint32 version = NM_DHCP_HELPER_SOCKET_VERSION;
+	GByteArray *msg;
+	char **item;
+
+	msg = g_byte_array_sized_new (4096);
+	g_byte_array_append (msg, (const guint8 *) &version, sizeof (version));
+
+	for (item = environ; *item; item++) {
+		NMDhcpHelperSocketRecord rec;
+		const char *val;
+		gsize name_len;
+
+		if (!env_split (*item, &name_len, &val))
+			continue;
+
+		rec.name_len = name_len;
+		rec.value_len = strlen (val);
+		g_byte_array_append (msg, (const guint8 *) &rec, sizeof (rec));
+		g_byte_array_append (msg, (const guint8 *) *item, rec.name_len);
+		g_byte_array_append (msg, (const guint8 *) val, rec.value_len);
+	}
+
+	return msg;
+}
+
+typedef enum {
+	NOTIFY_UNAVAILABLE,
+	NOTIFY_SUCCESS,
+} NotifyResult;
+
+static NotifyResult
+notify_socket (void)
+{
+	const struct sockaddr_un addr = {
+		.sun_family = AF_UNIX,
+		.sun_path   = NM_DHCP_HELPER_SOCKET_PATH,
+	};
+	const struct timeval timeout = { .tv_sec = 1 };
+	nm_auto_unref_bytearray GByteArray *msg = NULL;
+	nm_auto_close int fd = -1;
+	char ack;
+	gssize l;
+
+	msg = build_socket_message ();
+	if (msg->len > NM_DHCP_HELPER_SOCKET_MSG_MAX) {
+		_LOGi ("environment too large for %s (%u bytes)", addr.sun_path, msg->len);
+		return NOTIFY_UNAVAILABLE;
+	}
+
+	fd = socket (AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0);
+	if (fd < 0) {
+		_LOGi ("could not create socket: %s", g_strerror (errno));
+		return NOTIFY_UNAVAILABLE;
+	}
+
+	/* an older NetworkManager doesn't provide the socket. */
+	if (connect (fd, (const struct sockaddr *) &addr, sizeof (addr)) < 0) {
+		_LOGi ("could not connect to %s: %s", addr.sun_path, g_strerror (errno));
+		return NOTIFY_UNAVAILABLE;
+	}
+
+	(void) setsockopt (fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof (timeout));
+	(void) setsockopt (fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof (timeout));
+
+	do {
+		l = send (fd, msg->data, msg->len, MSG_NOSIGNAL);
+	} while (l < 0 && errno == EINTR);
+	if (l != (gssize) msg->len) {
+		_LOGi ("could not send to %s: %s", addr.sun_path, l < 0 ? g_strerror (errno) : "short write");
+		return NOTIFY_UNAVAILABLE;
+	}
+
+	do {
+		l = recv (fd, &ack, 1, 0);
+	} while (l < 0 && errno == EINTR);
+	if (l < 0) {
+		/* the event was delivered, but NetworkManager didn't acknowledge it
+		 * in time (for example, because it is busy). Don't send it a second
+		 * time and don't treat it as a fatal error either: killing dhclient
+		 * would tear down the lease for a merely slow reply. */
+		_LOGW ("no reply from NetworkManager on %s: %s", addr.sun_path, g_strerror (errno));
+		return NOTIFY_SUCCESS;
+	}
+	if (l == 0 || ack != NM_DHCP_HELPER_SOCKET_ACK) {
+		/* NetworkManager closes the connection if it doesn't understand
+		 * the message. */
+		_LOGi ("message rejected on %s", addr.sun_path);
+		return NOTIFY_UNAVAILABLE;
+	}
+
+	return NOTIFY_SUCCESS;
+}
+
 static void
 kill_pid (void)
 {
@@ -107,8 +218,8 @@ kill_pid (void)
 	}
 }
 
-int
-main (int argc, char *argv[])
+static gboolean
+notify_dbus (void)
 {
 	gs_unref_object GDBusConnection *connection = NULL;
 	gs_free_error GError *error = NULL;
@@ -202,6 +313,21 @@ do_notify:
 	}
 
 out:
+	return success;
+}
+
+int
+main (int argc, char *argv[])
+{
+	gboolean success;
+
+	/* Prefer the socket, which is cheaper than setting up a D-Bus
+	 * connection. */
+	if (notify_socket () == NOTIFY_SUCCESS)
+		success = TRUE;
+	else
+		success = notify_dbus ();
+
 	if (!success)
 		kill_pid ();
 	return success ? EXIT_SUCCESS : EXIT_FAILURE;
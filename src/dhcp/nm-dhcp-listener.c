@@ -8,11 +8,13 @@
 #include "nm-dhcp-listener.h"
 
 #include <sys/socket.h>
+#include <sys/un.h>
 #include <sys/wait.h>
 #include <signal.h>
 #include <stdlib.h>
 #include <unistd.h>
 
+#include "c-list/src/c-list.h"
 #include "nm-dhcp-helper-api.h"
 #include "nm-dhcp-client.h"
 #include "nm-dhcp-manager.h"
@@ -45,11 +47,24 @@ const NMDhcpClientFactory *const _nm_dhcp_manager_factories[6] = {
 
 /*****************************************************************************/
 
+typedef struct {
+	CList           sock_conns_lst;
+	NMDhcpListener *self;
+	GSource        *source;
+	int             fd;
+} SockConn;
+
 typedef struct {
 	NMDBusManager *dbus_mgr;
 	gulong         new_conn_id;
 	gulong         dis_conn_id;
 	GHashTable    *connections;
+
+	/* the SOCK_SEQPACKET socket of the helper. */
+	int            sock_fd;
+	GSource       *sock_source;
+	CList          sock_conns_lst_head;
+	guint8        *sock_buf;
 } NMDhcpListenerPrivate;
 
 struct _NMDhcpListener {
@@ -125,18 +140,15 @@ get_option (GVariant *options, const char *key)
 }
 
 static void
-_method_call_handle (NMDhcpListener *self,
-                     GVariant *parameters)
+_event_handle (NMDhcpListener *self,
+               GVariant *options)
 {
 	gs_free char *iface = NULL;
 	gs_free char *pid_str = NULL;
 	gs_free char *reason = NULL;
-	gs_unref_variant GVariant *options = NULL;
 	int pid;
 	gboolean handled = FALSE;
 
-	g_variant_get (parameters, "(@a{sv})", &options);
-
 	iface = get_option (options, "interface");
 	if (iface == NULL) {
 		_LOGW ("dhcp-event: didn't have associated interface.");
@@ -177,6 +189,7 @@ _method_call (GDBusConnection *connection,
               gpointer user_data)
 {
 	NMDhcpListener *self = NM_DHCP_LISTENER (user_data);
+	gs_unref_variant GVariant *options = NULL;
 
 	if (   !nm_streq (interface_name, NM_DHCP_HELPER_SERVER_INTERFACE_NAME)
 	    || !nm_streq (method_name, NM_DHCP_HELPER_SERVER_METHOD_NOTIFY)) {
@@ -188,7 +201,8 @@ _method_call (GDBusConnection *connection,
 		return;
 	}
 
-	_method_call_handle (self, parameters);
+	g_variant_get (parameters, "(@a{sv})", &options);
+	_event_handle (self, options);
 	g_dbus_method_invocation_return_value (invocation, NULL);
 }
 
@@ -262,6 +276,184 @@ dis_connection_cb (NMDBusManager *mgr,
 
 /*****************************************************************************/
 
+static GVariant *
+_sock_parse_message (const guint8 *buf, gsize len)
+{
+	GVariantBuilder builder;
+	guint32 version;
+	gsize offset;
+
+	if (len < sizeof (version))
+		return NULL;
+	memcpy (&version, buf, sizeof (version));
+	if (version != NM_DHCP_HELPER_SOCKET_VERSION)
+		return NULL;
+
+	g_variant_builder_init (&builder, G_VARIANT_TYPE_VARDICT);
+
+	offset = sizeof (version);
+	while (offset < len) {
+		NMDhcpHelperSocketRecord rec;
+		gs_free char *name = NULL;
+
+		if (len - offset < sizeof (rec))
+			goto fail;
+		memcpy (&rec, &buf[offset], sizeof (rec));
+		offset += sizeof (rec);
+
+		if (   rec.name_len == 0
+		    || rec.name_len > len - offset
+		    || rec.value_len > len - offset - rec.name_len
+		    || !g_utf8_validate ((const char *) &buf[offset], rec.name_len, NULL))
+			goto fail;
+
+		name = g_strndup ((const char *) &buf[offset], rec.name_len);
+		offset += rec.name_len;
+
+		/* the same representation as the helper uses on D-Bus. */
+		g_variant_builder_add (&builder, "{sv}",
+		                       name,
+		                       g_variant_new_fixed_array (G_VARIANT_TYPE_BYTE,
+		                                                  &buf[offset], rec.value_len, 1));
+		offset += rec.value_len;
+	}
+
+	return g_variant_ref_sink (g_variant_builder_end (&builder));
+
+fail:
+	g_variant_builder_clear (&builder);
+	return NULL;
+}
+
+GVariant *
+nmtst_dhcp_listener_parse_helper_message (const guint8 *buf, gsize len)
+{
+	return _sock_parse_message (buf, len);
+}
+
+static void
+_sock_conn_free (SockConn *conn)
+{
+	c_list_unlink_stale (&conn->sock_conns_lst);
+	nm_clear_g_source_inst (&conn->source);
+	nm_close (conn->fd);
+	g_slice_free (SockConn, conn);
+}
+
+static gboolean
+_sock_conn_cb (int fd,
+               GIOCondition condition,
+               gpointer user_data)
+{
+	SockConn *conn = user_data;
+	NMDhcpListener *self = conn->self;
+	NMDhcpListenerPrivate *priv = NM_DHCP_LISTENER_GET_PRIVATE (self);
+	gs_unref_variant GVariant *options = NULL;
+	gssize l;
+
+	l = recv (fd, priv->sock_buf, NM_DHCP_HELPER_SOCKET_MSG_MAX, MSG_TRUNC);
+	if (l < 0) {
+		if (NM_IN_SET (errno, EAGAIN, EINTR))
+			return G_SOURCE_CONTINUE;
+		_LOGD ("dhcp-event: failure to receive from helper: %s", nm_strerror_native (errno));
+	} else if (l > NM_DHCP_HELPER_SOCKET_MSG_MAX)
+		_LOGW ("dhcp-event: message from helper too large (%zd bytes)", l);
+	else if (l > 0) {
+		options = _sock_parse_message (priv->sock_buf, l);
+		if (options) {
+			const char ack = NM_DHCP_HELPER_SOCKET_ACK;
+
+			_event_handle (self, options);
+			(void) send (fd, &ack, sizeof (ack), MSG_NOSIGNAL | MSG_DONTWAIT);
+		} else
+			_LOGW ("dhcp-event: invalid message from helper");
+	}
+
+	/* the helper sends only one message per connection. Closing without
+	 * an acknowledgement makes it fall back to D-Bus. */
+	_sock_conn_free (conn);
+	return G_SOURCE_REMOVE;
+}
+
+static gboolean
+_sock_accept_cb (int fd,
+                 GIOCondition condition,
+                 gpointer user_data)
+{
+	NMDhcpListener *self = user_data;
+	NMDhcpListenerPrivate *priv = NM_DHCP_LISTENER_GET_PRIVATE (self);
+	struct ucred ucred;
+	socklen_t ucred_len = sizeof (ucred);
+	SockConn *conn;
+	int conn_fd;
+
+	conn_fd = accept4 (fd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC);
+	if (conn_fd < 0) {
+		if (!NM_IN_SET (errno, EAGAIN, EINTR, ECONNABORTED))
+			_LOGW ("failure to accept helper connection: %s", nm_strerror_native (errno));
+		return G_SOURCE_CONTINUE;
+	}
+
+	/* like on the private D-Bus socket, only root is allowed. */
+	if (   getsockopt (conn_fd, SOL_SOCKET, SO_PEERCRED, &ucred, &ucred_len) < 0
+	    || ucred.uid != 0) {
+		_LOGD ("reject helper connection from unprivileged peer");
+		nm_close (conn_fd);
+		return G_SOURCE_CONTINUE;
+	}
+
+	conn = g_slice_new (SockConn);
+	*conn = (SockConn) {
+		.self = self,
+		.fd   = conn_fd,
+	};
+	conn->source = nm_g_unix_fd_source_new (conn_fd,
+	                                        G_IO_IN,
+	                                        G_PRIORITY_DEFAULT,
+	                                        _sock_conn_cb,
+	                                        conn,
+	                                        NULL);
+	g_source_attach (conn->source, NULL);
+	c_list_link_tail (&priv->sock_conns_lst_head, &conn->sock_conns_lst);
+	return G_SOURCE_CONTINUE;
+}
+
+static void
+_sock_listen (NMDhcpListener *self)
+{
+	NMDhcpListenerPrivate *priv = NM_DHCP_LISTENER_GET_PRIVATE (self);
+	const struct sockaddr_un addr = {
+		.sun_family = AF_UNIX,
+		.sun_path   = NM_DHCP_HELPER_SOCKET_PATH,
+	};
+	nm_auto_close int fd = -1;
+
+	fd = socket (AF_UNIX, SOCK_SEQPACKET | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+	if (fd < 0) {
+		_LOGW ("failure to create helper socket: %s", nm_strerror_native (errno));
+		return;
+	}
+
+	unlink (addr.sun_path);
+	if (   bind (fd, (const struct sockaddr *) &addr, sizeof (addr)) < 0
+	    || listen (fd, SOMAXCONN) < 0) {
+		_LOGW ("failure to listen on %s: %s", addr.sun_path, nm_strerror_native (errno));
+		return;
+	}
+
+	priv->sock_fd = nm_steal_fd (&fd);
+	priv->sock_buf = g_malloc (NM_DHCP_HELPER_SOCKET_MSG_MAX);
+	priv->sock_source = nm_g_unix_fd_source_new (priv->sock_fd,
+	                                             G_IO_IN,
+	                                             G_PRIORITY_DEFAULT,
+	                                             _sock_accept_cb,
+	                                             self,
+	                                             NULL);
+	g_source_attach (priv->sock_source, NULL);
+}
+
+/*****************************************************************************/
+
 static void
 nm_dhcp_listener_init (NMDhcpListener *self)
 {
@@ -282,12 +474,28 @@ nm_dhcp_listener_init (NMDhcpListener *self)
 	                                      NM_DBUS_MANAGER_PRIVATE_CONNECTION_DISCONNECTED "::" PRIV_SOCK_TAG,
 	                                      G_CALLBACK (dis_connection_cb),
 	                                      self);
+
+	/* The helper prefers this socket over D-Bus. */
+	priv->sock_fd = -1;
+	c_list_init (&priv->sock_conns_lst_head);
+	_sock_listen (self);
 }
 
 static void
 dispose (GObject *object)
 {
 	NMDhcpListenerPrivate *priv = NM_DHCP_LISTENER_GET_PRIVATE (object);
+	SockConn *conn, *conn_safe;
+
+	c_list_for_each_entry_safe (conn, conn_safe, &priv->sock_conns_lst_head, sock_conns_lst)
+		_sock_conn_free (conn);
+	nm_clear_g_source_inst (&priv->sock_source);
+	if (priv->sock_fd >= 0) {
+		unlink (NM_DHCP_HELPER_SOCKET_PATH);
+		nm_close (priv->sock_fd);
+		priv->sock_fd = -1;
+	}
+	nm_clear_g_free (&priv->sock_buf);
 
 	nm_clear_g_signal_handler (priv->dbus_mgr, &priv->new_conn_id);
 	nm_clear_g_signal_handler (priv->dbus_mgr, &priv->dis_conn_id);
@@ -20,4 +20,8 @@ GType nm_dhcp_listener_get_type (void);
 
 NMDhcpListener *nm_dhcp_listener_get (void);
 
+/*****************************************************************************/
+
+GVariant *nmtst_dhcp_listener_parse_helper_message (const guint8 *buf, gsize len);
+
 #endif /* __NETWORKMANAGER_DHCP_LISTENER_H__ */
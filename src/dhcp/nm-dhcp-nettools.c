@@ -51,6 +51,9 @@ typedef struct {
 	NDhcp4ClientLease *lease;
 	GSource *event_source;
 	char *lease_file;
+	GBytes *client_id;
+	gint64 start_msec;
+	bool init_reboot:1;
 } NMDhcpNettoolsPrivate;
 
 struct _NMDhcpNettools {
@@ -951,10 +954,12 @@ lease_to_ip4_config (NMDedupMultiIndex *multi_idx,
 static void
 lease_save (NMDhcpNettools *self, NDhcp4ClientLease *lease, const char *lease_file)
 {
+	NMDhcpNettoolsPrivate *priv = NM_DHCP_NETTOOLS_GET_PRIVATE (self);
 	struct in_addr a_address;
 	nm_auto_free_gstring GString *new_contents = NULL;
 	char sbuf[NM_UTILS_INET_ADDRSTRLEN];
 	gs_free_error GError *error = NULL;
+	guint64 nettools_lifetime;
 
 	nm_assert (lease);
 	nm_assert (lease_file);
@@ -968,6 +973,28 @@ lease_save (NMDhcpNettools *self, NDhcp4ClientLease *lease, const char *lease_fi
 	g_string_append_printf (new_contents,
 	                        "ADDRESS=%s\n", _nm_utils_inet4_ntop (a_address.s_addr, sbuf));
 
+	if (priv->client_id) {
+		gs_free char *client_id_hex = NULL;
+		gconstpointer client_id_arr;
+		gsize client_id_len;
+
+		client_id_arr = g_bytes_get_data (priv->client_id, &client_id_len);
+		client_id_hex = nm_utils_bin2hexstr_full (client_id_arr, client_id_len, '\0', FALSE, NULL);
+		g_string_append_printf (new_contents, "CLIENTID=%s\n", client_id_hex);
+	}
+
+	n_dhcp4_client_lease_get_lifetime (lease, &nettools_lifetime);
+	if (nettools_lifetime != G_MAXUINT64) {
+		gint64 now_ns = nm_utils_clock_gettime_nsec (CLOCK_BOOTTIME);
+		gint64 remaining = 0;
+
+		if (nettools_lifetime > (guint64) now_ns)
+			remaining = (nettools_lifetime - now_ns) / NM_UTILS_NSEC_PER_SEC;
+		g_string_append_printf (new_contents,
+		                        "EXPIRES=%"G_GINT64_FORMAT"\n",
+		                        (gint64) time (NULL) + remaining);
+	}
+
 	if (!g_file_set_contents (lease_file,
 	                          new_contents->str,
 	                          -1,
@@ -975,6 +1002,62 @@ lease_save (NMDhcpNettools *self, NDhcp4ClientLease *lease, const char *lease_fi
 		_LOGW ("error saving lease to %s: %s", lease_file, error->message);
 }
 
+/* Reads back the address of a lease written by lease_save(). The address is
+ * only good for INIT-REBOOT if the lease was obtained with the same client-id
+ * and didn't expire yet. Otherwise the server is not going to ACK it, but it
+ * can still be requested in the DISCOVER. */
+static gboolean
+lease_load (const char *lease_file,
+            GBytes *client_id,
+            struct in_addr *out_address,
+            gboolean *out_init_reboot)
+{
+	gs_free char *contents = NULL;
+	gs_free const char **lines = NULL;
+	gs_free char *client_id_hex = NULL;
+	const char *lease_client_id = NULL;
+	struct in_addr address = { 0 };
+	gint64 expires = 0;
+	gsize i;
+
+	if (!g_file_get_contents (lease_file, &contents, NULL, NULL))
+		return FALSE;
+
+	lines = nm_utils_strsplit_set (contents, "\n");
+	for (i = 0; lines && lines[i]; i++) {
+		const char *line = lines[i];
+
+		if (NM_STR_HAS_PREFIX (line, "ADDRESS=")) {
+			if (inet_pton (AF_INET, &line[NM_STRLEN ("ADDRESS=")], &address) != 1)
+				address.s_addr = INADDR_ANY;
+		} else if (NM_STR_HAS_PREFIX (line, "CLIENTID="))
+			lease_client_id = &line[NM_STRLEN ("CLIENTID=")];
+		else if (NM_STR_HAS_PREFIX (line, "EXPIRES="))
+			expires = _nm_utils_ascii_str_to_int64 (&line[NM_STRLEN ("EXPIRES=")], 10, 0, G_MAXINT64, 0);
+	}
+
+	if (address.s_addr == INADDR_ANY)
+		return FALSE;
+
+	*out_address = address;
+	*out_init_reboot = TRUE;
+
+	if (   expires
+	    && expires <= (gint64) time (NULL))
+		*out_init_reboot = FALSE;
+	else if (lease_client_id && client_id) {
+		gconstpointer client_id_arr;
+		gsize client_id_len;
+
+		client_id_arr = g_bytes_get_data (client_id, &client_id_len);
+		client_id_hex = nm_utils_bin2hexstr_full (client_id_arr, client_id_len, '\0', FALSE, NULL);
+		if (g_ascii_strcasecmp (lease_client_id, client_id_hex) != 0)
+			*out_init_reboot = FALSE;
+	}
+
+	return TRUE;
+}
+
 static void
 bound4_handle (NMDhcpNettools *self, NDhcp4ClientLease *lease, gboolean extended)
 {
@@ -1004,6 +1087,12 @@ bound4_handle (NMDhcpNettools *self, NDhcp4ClientLease *lease, gboolean extended
 	nm_dhcp_option_add_requests_to_options (options, _nm_dhcp_option_dhcp4_options);
 	lease_save (self, lease, priv->lease_file);
 
+	if (!extended) {
+		_LOGD ("lease obtained in %"G_GINT64_FORMAT" msec (%s)",
+		       nm_utils_get_monotonic_timestamp_msec () - priv->start_msec,
+		       priv->init_reboot ? "init-reboot" : "discover");
+	}
+
 	nm_dhcp_client_set_state (NM_DHCP_CLIENT (self),
 	                          extended ? NM_DHCP_STATE_EXTENDED : NM_DHCP_STATE_BOUND,
 	                          NM_IP_CONFIG_CAST (ip4_config),
@@ -1196,6 +1285,9 @@ nettools_create (NMDhcpNettools *self,
 	priv->client = client;
 	client = NULL;
 
+	nm_clear_pointer (&priv->client_id, g_bytes_unref);
+	priv->client_id = client_id_new ? g_steal_pointer (&client_id_new) : g_bytes_ref (client_id);
+
 	n_dhcp4_client_get_fd (priv->client, &fd);
 
 	priv->event_source = nm_g_unix_fd_source_new (fd,
@@ -1283,6 +1375,7 @@ ip4_start (NMDhcpClient *client,
 	NMDhcpNettoolsPrivate *priv = NM_DHCP_NETTOOLS_GET_PRIVATE (self);
 	gs_free char *lease_file = NULL;
 	struct in_addr last_addr = { 0 };
+	gboolean init_reboot = TRUE;
 	const char *hostname;
 	int r, i;
 
@@ -1311,24 +1404,16 @@ ip4_start (NMDhcpClient *client,
 
 	if (last_ip4_address)
 		inet_pton (AF_INET, last_ip4_address, &last_addr);
-	else {
-		/*
-		 * TODO: we stick to the systemd-networkd lease file format. Quite easy for now to
-		 * just use the functions in systemd code. Anyway, as in the end we just use the
-		 * ip address from all the options found in the lease, write a function that parses
-		 * the lease file just for the assigned address and returns it in &last_address.
-		 * Then drop reference to systemd-networkd structures and functions.
-		 */
-		nm_auto (sd_dhcp_lease_unrefp) sd_dhcp_lease *lease = NULL;
-
-		dhcp_lease_load (&lease, lease_file);
-		if (lease)
-			sd_dhcp_lease_get_address (lease, &last_addr);
-	}
+	else
+		lease_load (lease_file, priv->client_id, &last_addr, &init_reboot);
 
+	priv->init_reboot = FALSE;
 	if (last_addr.s_addr) {
+		/* With INIT-REBOOT the REQUEST for the cached address goes out right
+		 * away, without waiting for the DISCOVER/OFFER round trip. */
 		n_dhcp4_client_probe_config_set_requested_ip (config, last_addr);
-		n_dhcp4_client_probe_config_set_init_reboot (config, TRUE);
+		n_dhcp4_client_probe_config_set_init_reboot (config, init_reboot);
+		priv->init_reboot = init_reboot;
 	}
 
 	/* Add requested options */
@@ -1394,6 +1479,8 @@ ip4_start (NMDhcpClient *client,
 	g_free (priv->lease_file);
 	priv->lease_file = g_steal_pointer (&lease_file);
 
+	priv->start_msec = nm_utils_get_monotonic_timestamp_msec ();
+
 	r = n_dhcp4_client_probe (priv->client, &priv->probe, config);
 	if (r) {
 		nm_utils_error_set_errno (error, r, "failed to start DHCP client: %s");
@@ -1434,6 +1521,7 @@ dispose (GObject *object)
 	NMDhcpNettoolsPrivate *priv = NM_DHCP_NETTOOLS_GET_PRIVATE (object);
 
 	nm_clear_pointer (&priv->lease_file, g_free);
+	nm_clear_pointer (&priv->client_id, g_bytes_unref);
 	nm_clear_g_source_inst (&priv->event_source);
 	nm_clear_pointer (&priv->lease, n_dhcp4_client_lease_unref);
 	nm_clear_pointer (&priv->probe, n_dhcp4_client_probe_free);
@@ -0,0 +1,1128 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Copyright (C) 2020 Red Hat, Inc.
+ */
+
+#include "nm-default.h"
+
+#include "nm-dhcp-server.h"
+
+#include <arpa/inet.h>
+
+#include "nm-glib-aux/nm-io-utils.h"
+#include "nm-utils.h"
+#include "NetworkManagerUtils.h"
+#include "n-dhcp4/src/n-dhcp4.h"
+
+/*****************************************************************************/
+
+/* like the 60m that we pass to dnsmasq. */
+#define LEASE_TIME_SEC          3600
+
+/* how long an offered address is reserved for the client. */
+#define OFFER_TIME_SEC          30
+
+/* for larger subnets, only the /16 around our address is handed out. */
+#define POOL_MAX_PREFIX         16
+
+/* the lease file is written at most this often. */
+#define LEASE_FILE_DELAY_MSEC   1000
+
+#define OPTION_SUBNET_MASK       1
+#define OPTION_ROUTER            3
+#define OPTION_DNS_SERVER        6
+#define OPTION_BROADCAST         28
+#define OPTION_VENDOR_SPECIFIC   43
+#define OPTION_DOMAIN_SEARCH     119
+
+/*****************************************************************************/
+
+typedef struct {
+	guint8 *client_id;
+	gsize client_id_len;
+
+	/* in seconds of nm_utils_get_monotonic_timestamp_sec(). The lease
+	 * file uses seconds since the epoch instead. */
+	gint64 expiry;
+
+	in_addr_t address;
+	guint heap_idx;
+
+	bool bound:1;
+
+	/* the client declined the address, because it is in use by somebody
+	 * else. The entry only keeps the address reserved until it expires,
+	 * it is not in the leases hash. */
+	bool declined:1;
+} Lease;
+
+struct _NMDhcpServer {
+	char *iface;
+	char *lease_file;
+
+	NDhcp4Server *server;
+	NDhcp4ServerIp *server_ip;
+	GSource *event_source;
+
+	/* the options sent with every offer and acknowledgement, as
+	 * consecutive code/length/data. */
+	GByteArray *options;
+
+	/* the pool, in host byte order. One bit per address, set if the
+	 * address is leased, offered or otherwise not available. */
+	guint32 pool_first;
+	guint32 pool_size;
+	guint32 pool_next;
+	guint64 *pool_bits;
+
+	/* Lease, by client identifier. */
+	GHashTable *leases;
+
+	/* all Lease, as a binary min-heap by expiry. */
+	GPtrArray *expiry_heap;
+	guint expiry_id;
+	gint64 expiry_id_at;
+
+	guint save_id;
+};
+
+/*****************************************************************************/
+
+#define _NMLOG_DOMAIN         LOGD_SHARING
+#define _NMLOG_PREFIX_NAME    "dhcp-server"
+#define _NMLOG(level, ...) \
+    G_STMT_START { \
+        nm_log ((level), _NMLOG_DOMAIN, self->iface, NULL, \
+                "%s[%s]: " _NM_UTILS_MACRO_FIRST (__VA_ARGS__), \
+                _NMLOG_PREFIX_NAME, \
+                self->iface \
+                _NM_UTILS_MACRO_REST (__VA_ARGS__)); \
+    } G_STMT_END
+
+/*****************************************************************************/
+
+static gint64
+_now_sec (void)
+{
+	return nm_utils_get_monotonic_timestamp_sec ();
+}
+
+static gint64
+_realtime_offset_sec (void)
+{
+	/* the wall clock may jump, so it is only used to convert the expiry
+	 * for the lease file. */
+	return (g_get_real_time () / G_USEC_PER_SEC) - _now_sec ();
+}
+
+static const char *
+_client_id_to_string (const Lease *lease, char *buf, gsize len)
+{
+	if (lease->client_id_len * 3 > len)
+		return "(long)";
+	return nm_utils_bin2hexstr_full (lease->client_id, lease->client_id_len, ':', FALSE, buf);
+}
+
+/*****************************************************************************/
+
+static gboolean
+_pool_offset (NMDhcpServer *self, in_addr_t address, guint32 *out_offset)
+{
+	guint32 offset = ntohl (address) - self->pool_first;
+
+	if (offset >= self->pool_size)
+		return FALSE;
+	*out_offset = offset;
+	return TRUE;
+}
+
+static gboolean
+_pool_test (NMDhcpServer *self, guint32 offset)
+{
+	return !!(self->pool_bits[offset / 64] & (((guint64) 1) << (offset % 64)));
+}
+
+static void
+_pool_set (NMDhcpServer *self, guint32 offset, gboolean used)
+{
+	if (used)
+		self->pool_bits[offset / 64] |= (((guint64) 1) << (offset % 64));
+	else
+		self->pool_bits[offset / 64] &= ~(((guint64) 1) << (offset % 64));
+}
+
+static gboolean
+_pool_address_free (NMDhcpServer *self, in_addr_t address)
+{
+	guint32 offset;
+
+	return    _pool_offset (self, address, &offset)
+	       && !_pool_test (self, offset);
+}
+
+static gboolean
+_pool_alloc (NMDhcpServer *self, in_addr_t *out_address)
+{
+	const guint32 n_words = (self->pool_size + 63) / 64;
+	guint32 word;
+	guint32 i;
+
+	/* next-fit, starting after the last allocated address. That way, a
+	 * released address is not immediately handed out to another client.
+	 * Full words are skipped at once. */
+	word = self->pool_next / 64;
+	for (i = 0; i <= n_words; i++, word = (word + 1) % n_words) {
+		guint64 bits = self->pool_bits[word];
+		guint32 offset;
+
+		if (i == 0) {
+			/* on the first word, ignore the addresses before pool_next. */
+			bits |= (((guint64) 1) << (self->pool_next % 64)) - 1;
+		}
+		if (bits == G_MAXUINT64)
+			continue;
+
+		offset = word * 64 + __builtin_ctzll (~bits);
+		nm_assert (offset < self->pool_size);
+
+		self->pool_next = (offset + 1) % self->pool_size;
+		*out_address = htonl (self->pool_first + offset);
+		return TRUE;
+	}
+
+	return FALSE;
+}
+
+/*****************************************************************************/
+
+static void
+_heap_swap (GPtrArray *heap, guint a, guint b)
+{
+	Lease *lease_a = heap->pdata[a];
+	Lease *lease_b = heap->pdata[b];
+
+	heap->pdata[a] = lease_b;
+	heap->pdata[b] = lease_a;
+	lease_a->heap_idx = b;
+	lease_b->heap_idx = a;
+}
+
+static void
+_heap_sift_up (GPtrArray *heap, guint idx)
+{
+	while (idx > 0) {
+		guint parent = (idx - 1) / 2;
+
+		if (((Lease *) heap->pdata[parent])->expiry <= ((Lease *) heap->pdata[idx])->expiry)
+			return;
+		_heap_swap (heap, parent, idx);
+		idx = parent;
+	}
+}
+
+static void
+_heap_sift_down (GPtrArray *heap, guint idx)
+{
+	for (;;) {
+		guint smallest = idx;
+		guint child;
+
+		child = 2 * idx + 1;
+		if (   child < heap->len
+		    && ((Lease *) heap->pdata[child])->expiry < ((Lease *) heap->pdata[smallest])->expiry)
+			smallest = child;
+		child++;
+		if (   child < heap->len
+		    && ((Lease *) heap->pdata[child])->expiry < ((Lease *) heap->pdata[smallest])->expiry)
+			smallest = child;
+
+		if (smallest == idx)
+			return;
+		_heap_swap (heap, idx, smallest);
+		idx = smallest;
+	}
+}
+
+static void
+_heap_remove (GPtrArray *heap, Lease *lease)
+{
+	guint idx = lease->heap_idx;
+	guint last = heap->len - 1;
+
+	nm_assert (idx < heap->len && heap->pdata[idx] == lease);
+
+	if (idx != last) {
+		_heap_swap (heap, idx, last);
+		g_ptr_array_set_size (heap, last);
+		_heap_sift_up (heap, idx);
+		_heap_sift_down (heap, idx);
+	} else
+		g_ptr_array_set_size (heap, last);
+
+	lease->heap_idx = G_MAXUINT;
+}
+
+/*****************************************************************************/
+
+static guint
+_lease_hash (gconstpointer ptr)
+{
+	const Lease *lease = ptr;
+	NMHashState h;
+
+	nm_hash_init (&h, 2042151127u);
+	nm_hash_update_mem (&h, lease->client_id, lease->client_id_len);
+	return nm_hash_complete (&h);
+}
+
+static gboolean
+_lease_equal (gconstpointer a, gconstpointer b)
+{
+	const Lease *lease_a = a;
+	const Lease *lease_b = b;
+
+	return    lease_a->client_id_len == lease_b->client_id_len
+	       && memcmp (lease_a->client_id, lease_b->client_id, lease_a->client_id_len) == 0;
+}
+
+static void _expiry_schedule (NMDhcpServer *self);
+static void _leases_save_schedule (NMDhcpServer *self);
+
+static Lease *
+_lease_lookup (NMDhcpServer *self, const guint8 *client_id, gsize client_id_len)
+{
+	const Lease needle = {
+		.client_id     = (guint8 *) client_id,
+		.client_id_len = client_id_len,
+	};
+
+	return g_hash_table_lookup (self->leases, &needle);
+}
+
+static void
+_lease_set_expiry (NMDhcpServer *self, Lease *lease, gint64 expiry)
+{
+	lease->expiry = expiry;
+	_heap_sift_up (self->expiry_heap, lease->heap_idx);
+	_heap_sift_down (self->expiry_heap, lease->heap_idx);
+	_expiry_schedule (self);
+}
+
+static Lease *
+_lease_new (NMDhcpServer *self,
+            const guint8 *client_id,
+            gsize client_id_len,
+            in_addr_t address,
+            gint64 expiry)
+{
+	Lease *lease;
+	guint32 offset;
+
+	if (!_pool_offset (self, address, &offset))
+		g_return_val_if_reached (NULL);
+
+	nm_assert (!_pool_test (self, offset));
+	nm_assert (!_lease_lookup (self, client_id, client_id_len));
+
+	lease = g_slice_new0 (Lease);
+	lease->client_id = nm_memdup (client_id, client_id_len);
+	lease->client_id_len = client_id_len;
+	lease->address = address;
+	lease->expiry = expiry;
+
+	_pool_set (self, offset, TRUE);
+	g_hash_table_add (self->leases, lease);
+
+	lease->heap_idx = self->expiry_heap->len;
+	g_ptr_array_add (self->expiry_heap, lease);
+	_heap_sift_up (self->expiry_heap, lease->heap_idx);
+	_expiry_schedule (self);
+
+	return lease;
+}
+
+static void
+_lease_free (Lease *lease)
+{
+	g_free (lease->client_id);
+	g_slice_free (Lease, lease);
+}
+
+static void
+_lease_remove (NMDhcpServer *self, Lease *lease)
+{
+	guint32 offset;
+
+	_heap_remove (self->expiry_heap, lease);
+
+	if (!lease->declined) {
+		g_hash_table_remove (self->leases, lease);
+		if (lease->bound)
+			_leases_save_schedule (self);
+	}
+
+	if (_pool_offset (self, lease->address, &offset))
+		_pool_set (self, offset, FALSE);
+
+	_lease_free (lease);
+}
+
+/*****************************************************************************/
+
+static void
+_leases_expire (NMDhcpServer *self, gint64 now)
+{
+	while (self->expiry_heap->len > 0) {
+		Lease *lease = self->expiry_heap->pdata[0];
+
+		if (lease->expiry > now)
+			break;
+		_lease_remove (self, lease);
+	}
+
+	_expiry_schedule (self);
+}
+
+static gboolean
+_expiry_cb (gpointer user_data)
+{
+	NMDhcpServer *self = user_data;
+
+	self->expiry_id = 0;
+	_leases_expire (self, _now_sec ());
+	return G_SOURCE_REMOVE;
+}
+
+static void
+_expiry_schedule (NMDhcpServer *self)
+{
+	gint64 expiry;
+
+	if (self->expiry_heap->len == 0) {
+		nm_clear_g_source (&self->expiry_id);
+		return;
+	}
+
+	expiry = ((Lease *) self->expiry_heap->pdata[0])->expiry;
+
+	/* a timer that fires too early just re-arms itself. */
+	if (   self->expiry_id
+	    && self->expiry_id_at <= expiry)
+		return;
+
+	nm_clear_g_source (&self->expiry_id);
+	self->expiry_id_at = expiry;
+	self->expiry_id = g_timeout_add_seconds (CLAMP (expiry - _now_sec (), 0, G_MAXINT32),
+	                                         _expiry_cb,
+	                                         self);
+}
+
+/*****************************************************************************/
+
+static void
+_leases_save (NMDhcpServer *self)
+{
+	nm_auto_free_gstring GString *s = NULL;
+	gs_free_error GError *error = NULL;
+	char buf_addr[INET_ADDRSTRLEN];
+	char buf_id[256 * 3];
+	gint64 offset = _realtime_offset_sec ();
+	guint i;
+
+	nm_clear_g_source (&self->save_id);
+
+	s = g_string_new ("# Generated by NetworkManager\n");
+	for (i = 0; i < self->expiry_heap->len; i++) {
+		const Lease *lease = self->expiry_heap->pdata[i];
+
+		if (   !lease->bound
+		    || lease->declined)
+			continue;
+		g_string_append_printf (s,
+		                        "%" G_GINT64_FORMAT " %s %s\n",
+		                        lease->expiry + offset,
+		                        _nm_utils_inet4_ntop (lease->address, buf_addr),
+		                        nm_utils_bin2hexstr_full (lease->client_id, lease->client_id_len, ':', FALSE, buf_id));
+	}
+
+	if (!nm_utils_file_set_contents (self->lease_file, s->str, s->len, 0644, NULL, &error))
+		_LOGW ("failed to save leases to %s: %s", self->lease_file, error->message);
+}
+
+static gboolean
+_leases_save_cb (gpointer user_data)
+{
+	NMDhcpServer *self = user_data;
+
+	self->save_id = 0;
+	_leases_save (self);
+	return G_SOURCE_REMOVE;
+}
+
+static void
+_leases_save_schedule (NMDhcpServer *self)
+{
+	if (!self->save_id)
+		self->save_id = g_timeout_add (LEASE_FILE_DELAY_MSEC, _leases_save_cb, self);
+}
+
+static void
+_leases_load (NMDhcpServer *self)
+{
+	gs_free char *contents = NULL;
+	gs_free const char **lines = NULL;
+	gint64 offset = _realtime_offset_sec ();
+	gint64 now = _now_sec ();
+	guint n_loaded = 0;
+	gsize i;
+
+	if (!g_file_get_contents (self->lease_file, &contents, NULL, NULL))
+		return;
+
+	lines = nm_utils_strsplit_set (contents, "\n");
+	for (i = 0; lines && lines[i]; i++) {
+		gs_free const char **words = NULL;
+		gs_free guint8 *client_id = NULL;
+		gsize client_id_len;
+		in_addr_t address;
+		gint64 expiry;
+		Lease *lease;
+
+		if (lines[i][0] == '#')
+			continue;
+
+		words = nm_utils_strsplit_set (lines[i], " ");
+		if (NM_PTRARRAY_LEN (words) != 3)
+			continue;
+
+		expiry = _nm_utils_ascii_str_to_int64 (words[0], 10, 0, G_MAXINT64, -1);
+		if (expiry == -1)
+			continue;
+		expiry -= offset;
+		if (expiry <= now)
+			continue;
+		if (!nm_utils_parse_inaddr_bin (AF_INET, words[1], NULL, &address))
+			continue;
+		if (!_pool_address_free (self, address))
+			continue;
+		client_id = nm_utils_hexstr2bin_alloc (words[2], FALSE, TRUE, ":", 0, &client_id_len);
+		if (!client_id)
+			continue;
+		if (_lease_lookup (self, client_id, client_id_len))
+			continue;
+
+		lease = _lease_new (self, client_id, client_id_len, address, expiry);
+		lease->bound = TRUE;
+		n_loaded++;
+	}
+
+	_LOGD ("loaded %u leases from %s", n_loaded, self->lease_file);
+}
+
+/*****************************************************************************/
+
+static void
+_options_append (GByteArray *options, guint8 code, gconstpointer data, gsize len)
+{
+	guint8 header[2] = { code, len };
+
+	nm_assert (len <= G_MAXUINT8);
+
+	g_byte_array_append (options, header, sizeof (header));
+	g_byte_array_append (options, data, len);
+}
+
+static void
+_options_append_domain_search (GByteArray *options, const NMIP4Config *ip4_config)
+{
+	guint8 buf[G_MAXUINT8];
+	gsize len = 0;
+	guint i, n;
+
+	/* RFC 3397 encoding, without compression. Domains that don't fit
+	 * into a single option are dropped. */
+	n = nm_ip4_config_get_num_searches (ip4_config);
+	for (i = 0; i < n; i++) {
+		const char *domain = nm_ip4_config_get_search (ip4_config, i);
+		guint8 encoded[G_MAXUINT8];
+		gsize encoded_len = 0;
+		gboolean valid = TRUE;
+
+		while (domain[0]) {
+			const char *dot = strchr (domain, '.');
+			gsize label_len = dot ? (gsize) (dot - domain) : strlen (domain);
+
+			if (   label_len == 0
+			    || label_len > 63
+			    || encoded_len + 1 + label_len + 1 > sizeof (encoded)) {
+				valid = FALSE;
+				break;
+			}
+			encoded[encoded_len++] = label_len;
+			memcpy (&encoded[encoded_len], domain, label_len);
+			encoded_len += label_len;
+			domain += label_len + (dot ? 1 : 0);
+		}
+		if (   !valid
+		    || encoded_len == 0
+		    || len + encoded_len + 1 > sizeof (buf))
+			continue;
+
+		encoded[encoded_len++] = 0;
+		memcpy (&buf[len], encoded, encoded_len);
+		len += encoded_len;
+	}
+
+	if (len > 0)
+		_options_append (options, OPTION_DOMAIN_SEARCH, buf, len);
+}
+
+static void
+_options_append_nameservers (GByteArray *options, const in_addr_t *nameservers, guint n)
+{
+	n = MIN (n, G_MAXUINT8 / sizeof (in_addr_t));
+	if (n > 0)
+		_options_append (options, OPTION_DNS_SERVER, nameservers, n * sizeof (in_addr_t));
+}
+
+static GByteArray *
+_options_build (const NMIP4Config *ip4_config,
+                const NMPlatformIP4Address *listen_address,
+                const GArray *upstream_nameservers,
+                gboolean announce_android_metered)
+{
+	GByteArray *options;
+	in_addr_t netmask;
+	in_addr_t broadcast;
+	guint i, n;
+
+	options = g_byte_array_new ();
+
+	netmask = _nm_utils_ip4_prefix_to_netmask (listen_address->plen);
+	_options_append (options, OPTION_SUBNET_MASK, &netmask, sizeof (netmask));
+
+	broadcast = listen_address->address | ~netmask;
+	_options_append (options, OPTION_BROADCAST, &broadcast, sizeof (broadcast));
+
+	if (nm_ip4_config_best_default_route_get (ip4_config))
+		_options_append (options, OPTION_ROUTER, &listen_address->address, sizeof (in_addr_t));
+
+	n = nm_ip4_config_get_num_nameservers (ip4_config);
+	if (n > 0) {
+		gs_free in_addr_t *nameservers = NULL;
+
+		nameservers = g_new (in_addr_t, n);
+		for (i = 0; i < n; i++)
+			nameservers[i] = nm_ip4_config_get_nameserver (ip4_config, i);
+		_options_append_nameservers (options, nameservers, n);
+	} else if (upstream_nameservers) {
+		/* dnsmasq announces itself and forwards the queries. Nothing
+		 * listens on port 53 here, so tell the clients to use the
+		 * upstream name servers directly. */
+		_options_append_nameservers (options,
+		                             &g_array_index (upstream_nameservers, in_addr_t, 0),
+		                             upstream_nameservers->len);
+	}
+
+	_options_append_domain_search (options, ip4_config);
+
+	if (announce_android_metered) {
+		/* See https://www.lorier.net/docs/android-metered.html */
+		_options_append (options, OPTION_VENDOR_SPECIFIC, "ANDROID_METERED", NM_STRLEN ("ANDROID_METERED"));
+	}
+
+	return options;
+}
+
+/*****************************************************************************/
+
+static void
+_reply (NMDhcpServer *self,
+        NDhcp4ServerLease *request,
+        const Lease *lease,
+        gboolean ack)
+{
+	char buf_addr[INET_ADDRSTRLEN];
+	char buf_id[256 * 3];
+	guint i;
+	int r;
+
+	n_dhcp4_server_lease_set_yiaddr (request,
+	                                 (struct in_addr) { .s_addr = lease->address },
+	                                 LEASE_TIME_SEC);
+
+	for (i = 0; i < self->options->len; i += 2 + self->options->data[i + 1]) {
+		r = n_dhcp4_server_lease_append (request,
+		                                 self->options->data[i],
+		                                 &self->options->data[i + 2],
+		                                 self->options->data[i + 1]);
+		if (r) {
+			_LOGW ("failed to append option %u: error %d", self->options->data[i], r);
+			return;
+		}
+	}
+
+	r = ack
+	    ? n_dhcp4_server_lease_ack (request)
+	    : n_dhcp4_server_lease_offer (request);
+	if (r) {
+		_LOGD ("failed to send %s for %s: error %d",
+		       ack ? "DHCPACK" : "DHCPOFFER",
+		       _nm_utils_inet4_ntop (lease->address, buf_addr),
+		       r);
+		return;
+	}
+
+	_LOGD ("%s %s to %s",
+	       ack ? "DHCPACK" : "DHCPOFFER",
+	       _nm_utils_inet4_ntop (lease->address, buf_addr),
+	       _client_id_to_string (lease, buf_id, sizeof (buf_id)));
+}
+
+static void
+_nack (NMDhcpServer *self,
+       NDhcp4ServerLease *request,
+       in_addr_t address)
+{
+	char buf_addr[INET_ADDRSTRLEN];
+	int r;
+
+	r = n_dhcp4_server_lease_nack (request);
+	if (r) {
+		_LOGD ("failed to send DHCPNAK: error %d", r);
+		return;
+	}
+
+	_LOGD ("DHCPNAK for %s", _nm_utils_inet4_ntop (address, buf_addr));
+}
+
+static Lease *
+_lease_discover (NMDhcpServer *self,
+                 const guint8 *client_id,
+                 gsize client_id_len,
+                 in_addr_t requested)
+{
+	in_addr_t address;
+	Lease *lease;
+
+	lease = _lease_lookup (self, client_id, client_id_len);
+	if (lease) {
+		if (!lease->bound)
+			_lease_set_expiry (self, lease, _now_sec () + OFFER_TIME_SEC);
+		return lease;
+	}
+
+	if (   requested != INADDR_ANY
+	    && _pool_address_free (self, requested))
+		address = requested;
+	else if (!_pool_alloc (self, &address))
+		return NULL;
+
+	return _lease_new (self, client_id, client_id_len, address, _now_sec () + OFFER_TIME_SEC);
+}
+
+static Lease *
+_lease_request (NMDhcpServer *self,
+                const guint8 *client_id,
+                gsize client_id_len,
+                in_addr_t requested)
+{
+	gint64 expiry = _now_sec () + LEASE_TIME_SEC;
+	Lease *lease;
+
+	lease = _lease_lookup (self, client_id, client_id_len);
+	if (   lease
+	    && lease->address != requested) {
+		/* the client wants another address than the one we have for it. */
+		_lease_remove (self, lease);
+		lease = NULL;
+	}
+
+	if (!lease) {
+		if (!_pool_address_free (self, requested)) {
+			/* not in our subnet, or in use by another client. */
+			return NULL;
+		}
+		lease = _lease_new (self, client_id, client_id_len, requested, expiry);
+	} else
+		_lease_set_expiry (self, lease, expiry);
+
+	lease->bound = TRUE;
+	_leases_save_schedule (self);
+	return lease;
+}
+
+static void
+_lease_release (NMDhcpServer *self,
+                const guint8 *client_id,
+                gsize client_id_len,
+                in_addr_t requested,
+                gboolean decline)
+{
+	char buf_addr[INET_ADDRSTRLEN];
+	Lease *lease;
+
+	lease = _lease_lookup (self, client_id, client_id_len);
+	if (!lease)
+		return;
+
+	if (   requested != INADDR_ANY
+	    && lease->address != requested)
+		return;
+
+	if (!decline) {
+		_LOGD ("DHCPRELEASE of %s", _nm_utils_inet4_ntop (lease->address, buf_addr));
+		_lease_remove (self, lease);
+		return;
+	}
+
+	/* the address is in use by somebody else. Don't hand it out again
+	 * for a while. */
+	_LOGD ("DHCPDECLINE of %s", _nm_utils_inet4_ntop (lease->address, buf_addr));
+	g_hash_table_remove (self->leases, lease);
+	if (lease->bound)
+		_leases_save_schedule (self);
+	lease->declined = TRUE;
+	lease->bound = FALSE;
+	_lease_set_expiry (self, lease, _now_sec () + LEASE_TIME_SEC);
+}
+
+static in_addr_t
+_request_get_requested_ip (NDhcp4ServerLease *request)
+{
+	struct in_addr requested;
+
+	if (n_dhcp4_server_lease_get_requested_ip (request, &requested) != 0)
+		return INADDR_ANY;
+	return requested.s_addr;
+}
+
+static void
+_handle_discover (NMDhcpServer *self,
+                  NDhcp4ServerLease *request,
+                  const guint8 *client_id,
+                  gsize client_id_len)
+{
+	Lease *lease;
+
+	lease = _lease_discover (self,
+	                         client_id,
+	                         client_id_len,
+	                         _request_get_requested_ip (request));
+	if (!lease) {
+		_LOGW ("no free address left to offer");
+		return;
+	}
+
+	_reply (self, request, lease, FALSE);
+}
+
+static void
+_handle_request (NMDhcpServer *self,
+                 NDhcp4ServerLease *request,
+                 const guint8 *client_id,
+                 gsize client_id_len)
+{
+	in_addr_t requested;
+	Lease *lease;
+
+	requested = _request_get_requested_ip (request);
+	if (requested == INADDR_ANY) {
+		_nack (self, request, requested);
+		return;
+	}
+
+	lease = _lease_request (self, client_id, client_id_len, requested);
+	if (!lease) {
+		_nack (self, request, requested);
+		return;
+	}
+
+	_reply (self, request, lease, TRUE);
+}
+
+static void
+_event_handle (NMDhcpServer *self, NDhcp4ServerEvent *event)
+{
+	NDhcp4ServerLease *request;
+	const guint8 *client_id;
+	size_t client_id_len;
+
+	switch (event->event) {
+	case N_DHCP4_SERVER_EVENT_DISCOVER:
+	case N_DHCP4_SERVER_EVENT_REQUEST:
+	case N_DHCP4_SERVER_EVENT_RENEW:
+	case N_DHCP4_SERVER_EVENT_DECLINE:
+	case N_DHCP4_SERVER_EVENT_RELEASE:
+		/* all these events carry the lease at the same place. */
+		request = event->discover.lease;
+		break;
+	default:
+		return;
+	}
+
+	if (n_dhcp4_server_lease_get_client_id (request, &client_id, &client_id_len) != 0)
+		return;
+
+	switch (event->event) {
+	case N_DHCP4_SERVER_EVENT_DISCOVER:
+		_handle_discover (self, request, client_id, client_id_len);
+		break;
+	case N_DHCP4_SERVER_EVENT_REQUEST:
+	case N_DHCP4_SERVER_EVENT_RENEW:
+		_handle_request (self, request, client_id, client_id_len);
+		break;
+	case N_DHCP4_SERVER_EVENT_DECLINE:
+		_lease_release (self, client_id, client_id_len, _request_get_requested_ip (request), TRUE);
+		break;
+	case N_DHCP4_SERVER_EVENT_RELEASE:
+		_lease_release (self, client_id, client_id_len, _request_get_requested_ip (request), FALSE);
+		break;
+	}
+}
+
+static gboolean
+_event_cb (int fd,
+           GIOCondition condition,
+           gpointer user_data)
+{
+	NMDhcpServer *self = user_data;
+	NDhcp4ServerEvent *event;
+	int r;
+
+	r = n_dhcp4_server_dispatch (self->server);
+	if (r && r != N_DHCP4_E_PREEMPTED) {
+		/* requests that were read until now are handled below, the
+		 * others on the next wakeup. */
+		_LOGD ("error %d dispatching requests", r);
+	}
+
+	while (!n_dhcp4_server_pop_event (self->server, &event) && event)
+		_event_handle (self, event);
+
+	return G_SOURCE_CONTINUE;
+}
+
+/*****************************************************************************/
+
+static NMDhcpServer *
+_dhcp_server_new (const char *iface,
+                  in_addr_t address,
+                  guint8 plen,
+                  const char *lease_file)
+{
+	NMDhcpServer *self;
+	guint32 host, netmask;
+	guint8 prefix;
+	guint32 offset;
+
+	nm_assert (plen <= 30);
+
+	self = g_slice_new0 (NMDhcpServer);
+	self->iface = g_strdup (iface);
+	self->lease_file = g_strdup (lease_file);
+	self->leases = g_hash_table_new (_lease_hash, _lease_equal);
+	self->expiry_heap = g_ptr_array_new ();
+
+	/* the pool are all addresses of the subnet, except network, broadcast
+	 * and our own address. */
+	prefix = MAX (plen, POOL_MAX_PREFIX);
+	netmask = ntohl (_nm_utils_ip4_prefix_to_netmask (prefix));
+	host = ntohl (address);
+	self->pool_first = (host & netmask) + 1;
+	self->pool_size = (host | ~netmask) - self->pool_first;
+	self->pool_bits = g_new0 (guint64, (self->pool_size + 63) / 64);
+	for (offset = self->pool_size; offset % 64; offset++)
+		_pool_set (self, offset, TRUE);
+	if (_pool_offset (self, address, &offset)) {
+		_pool_set (self, offset, TRUE);
+		self->pool_next = (offset + 1) % self->pool_size;
+	}
+
+	return self;
+}
+
+NMDhcpServer *
+nm_dhcp_server_new (int ifindex,
+                    const char *iface,
+                    const NMIP4Config *ip4_config,
+                    const GArray *upstream_nameservers,
+                    gboolean announce_android_metered,
+                    GError **error)
+{
+	nm_auto_free_dhcp_server NMDhcpServer *self = NULL;
+	nm_auto (n_dhcp4_server_config_freep) NDhcp4ServerConfig *config = NULL;
+	gs_free char *lease_file = NULL;
+	const NMPlatformIP4Address *listen_address;
+	int fd;
+	int r;
+
+	g_return_val_if_fail (ifindex > 0, NULL);
+	g_return_val_if_fail (iface, NULL);
+
+	listen_address = nm_ip4_config_get_first_address (ip4_config);
+	g_return_val_if_fail (listen_address, NULL);
+
+	if (listen_address->plen > 30) {
+		nm_utils_error_set (error, NM_UTILS_ERROR_UNKNOWN,
+		                    "Address prefix %d is too small for DHCP.", listen_address->plen);
+		return NULL;
+	}
+
+	lease_file = g_strdup_printf (NMSTATEDIR "/dhcp-server-%s.leases", iface);
+	self = _dhcp_server_new (iface, listen_address->address, listen_address->plen, lease_file);
+	self->options = _options_build (ip4_config, listen_address, upstream_nameservers, announce_android_metered);
+
+	r = n_dhcp4_server_config_new (&config);
+	if (r) {
+		nm_utils_error_set (error, NM_UTILS_ERROR_UNKNOWN, "failed to create DHCP server config: error %d", r);
+		return NULL;
+	}
+	n_dhcp4_server_config_set_ifindex (config, ifindex);
+
+	r = n_dhcp4_server_new (&self->server, config);
+	if (r) {
+		nm_utils_error_set (error, NM_UTILS_ERROR_UNKNOWN, "failed to create DHCP server: error %d", r);
+		return NULL;
+	}
+
+	r = n_dhcp4_server_add_ip (self->server,
+	                           &self->server_ip,
+	                           (struct in_addr) { .s_addr = listen_address->address });
+	if (r) {
+		nm_utils_error_set (error, NM_UTILS_ERROR_UNKNOWN, "failed to add DHCP server address: error %d", r);
+		return NULL;
+	}
+
+	_leases_load (self);
+
+	n_dhcp4_server_get_fd (self->server, &fd);
+	self->event_source = nm_g_unix_fd_source_new (fd,
+	                                              G_IO_IN,
+	                                              G_PRIORITY_DEFAULT,
+	                                              _event_cb,
+	                                              self,
+	                                              NULL);
+	g_source_attach (self->event_source, NULL);
+
+	if (   nm_ip4_config_get_num_nameservers (ip4_config) == 0
+	    && (!upstream_nameservers || upstream_nameservers->len == 0))
+		_LOGW ("no DNS servers to announce");
+
+	_LOGI ("serving %u addresses", (guint) (self->pool_size - 1));
+
+	return g_steal_pointer (&self);
+}
+
+void
+nm_dhcp_server_free (NMDhcpServer *self)
+{
+	guint i;
+
+	if (!self)
+		return;
+
+	if (self->save_id)
+		_leases_save (self);
+
+	nm_clear_g_source (&self->expiry_id);
+	nm_clear_g_source_inst (&self->event_source);
+
+	for (i = 0; i < self->expiry_heap->len; i++)
+		_lease_free (self->expiry_heap->pdata[i]);
+	g_ptr_array_unref (self->expiry_heap);
+	g_hash_table_unref (self->leases);
+
+	n_dhcp4_server_ip_free (self->server_ip);
+	n_dhcp4_server_unref (self->server);
+
+	nm_clear_pointer (&self->options, g_byte_array_unref);
+	g_free (self->pool_bits);
+	g_free (self->iface);
+	g_free (self->lease_file);
+	g_slice_free (NMDhcpServer, self);
+}
+
+/*****************************************************************************/
+
+NMDhcpServer *
+nmtst_dhcp_server_new (in_addr_t address, guint8 plen, const char *lease_file)
+{
+	NMDhcpServer *self;
+
+	self = _dhcp_server_new ("nmtst", address, plen, lease_file);
+	_leases_load (self);
+	return self;
+}
+
+gboolean
+nmtst_dhcp_server_discover (NMDhcpServer *self,
+                            const guint8 *client_id,
+                            gsize client_id_len,
+                            in_addr_t requested,
+                            in_addr_t *out_address)
+{
+	Lease *lease;
+
+	lease = _lease_discover (self, client_id, client_id_len, requested);
+	if (!lease)
+		return FALSE;
+	*out_address = lease->address;
+	return TRUE;
+}
+
+gboolean
+nmtst_dhcp_server_request (NMDhcpServer *self,
+                           const guint8 *client_id,
+                           gsize client_id_len,
+                           in_addr_t requested)
+{
+	return !!_lease_request (self, client_id, client_id_len, requested);
+}
+
+void
+nmtst_dhcp_server_release (NMDhcpServer *self,
+                           const guint8 *client_id,
+                           gsize client_id_len,
+                           in_addr_t requested,
+                           gboolean decline)
+{
+	_lease_release (self, client_id, client_id_len, requested, decline);
+}
+
+void
+nmtst_dhcp_server_expire (NMDhcpServer *self, gint64 now_sec)
+{
+	_leases_expire (self, now_sec);
+}
+
+gboolean
+nmtst_dhcp_server_get_lease (NMDhcpServer *self,
+                             const guint8 *client_id,
+                             gsize client_id_len,
+                             in_addr_t *out_address,
+                             gint64 *out_expiry,
+                             gboolean *out_bound)
+{
+	Lease *lease;
+
+	lease = _lease_lookup (self, client_id, client_id_len);
+	if (!lease)
+		return FALSE;
+	NM_SET_OUT (out_address, lease->address);
+	NM_SET_OUT (out_expiry, lease->expiry);
+	NM_SET_OUT (out_bound, lease->bound);
+	return TRUE;
+}
+
+gboolean
+nmtst_dhcp_server_address_is_free (NMDhcpServer *self, in_addr_t address)
+{
+	return _pool_address_free (self, address);
+}
+
+void
+nmtst_dhcp_server_save_leases (NMDhcpServer *self)
+{
+	_leases_save (self);
+}
@@ -0,0 +1,59 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Copyright (C) 2020 Red Hat, Inc.
+ */
+
+#ifndef __NM_DHCP_SERVER_H__
+#define __NM_DHCP_SERVER_H__
+
+#include "nm-ip4-config.h"
+
+typedef struct _NMDhcpServer NMDhcpServer;
+
+NMDhcpServer *nm_dhcp_server_new (int ifindex,
+                                  const char *iface,
+                                  const NMIP4Config *ip4_config,
+                                  const GArray *upstream_nameservers,
+                                  gboolean announce_android_metered,
+                                  GError **error);
+
+void nm_dhcp_server_free (NMDhcpServer *self);
+
+NM_AUTO_DEFINE_FCN0 (NMDhcpServer *, _nm_auto_free_dhcp_server, nm_dhcp_server_free);
+#define nm_auto_free_dhcp_server nm_auto (_nm_auto_free_dhcp_server)
+
+/*****************************************************************************/
+
+NMDhcpServer *nmtst_dhcp_server_new (in_addr_t address, guint8 plen, const char *lease_file);
+
+gboolean nmtst_dhcp_server_discover (NMDhcpServer *self,
+                                     const guint8 *client_id,
+                                     gsize client_id_len,
+                                     in_addr_t requested,
+                                     in_addr_t *out_address);
+
+gboolean nmtst_dhcp_server_request (NMDhcpServer *self,
+                                    const guint8 *client_id,
+                                    gsize client_id_len,
+                                    in_addr_t requested);
+
+void nmtst_dhcp_server_release (NMDhcpServer *self,
+                                const guint8 *client_id,
+                                gsize client_id_len,
+                                in_addr_t requested,
+                                gboolean decline);
+
+void nmtst_dhcp_server_expire (NMDhcpServer *self, gint64 now_sec);
+
+gboolean nmtst_dhcp_server_get_lease (NMDhcpServer *self,
+                                      const guint8 *client_id,
+                                      gsize client_id_len,
+                                      in_addr_t *out_address,
+                                      gint64 *out_expiry,
+                                      gboolean *out_bound);
+
+gboolean nmtst_dhcp_server_address_is_free (NMDhcpServer *self, in_addr_t address);
+
+void nmtst_dhcp_server_save_leases (NMDhcpServer *self);
+
+#endif /* __NM_DHCP_SERVER_H__ */
@@ -0,0 +1,355 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Copyright (C) 2020 Red Hat, Inc.
+ */
+
+#include "nm-default.h"
+
+#include <unistd.h>
+#include <arpa/inet.h>
+
+#include "nm-glib-aux/nm-io-utils.h"
+#include "dhcp/nm-dhcp-server.h"
+
+#include "nm-test-utils-core.h"
+
+/*****************************************************************************/
+
+#define LEASE_TIME_SEC 3600
+#define OFFER_TIME_SEC 30
+
+#define CLIENT_ID(n) ((const guint8 [7]) { 1, 0x52, 0x54, 0x00, 0x12, 0x34, (n) })
+
+static in_addr_t
+_addr (const char *str)
+{
+	return nmtst_inet4_from_string (str);
+}
+
+#define _assert_lease(server, n, expected_address, expected_bound) \
+	G_STMT_START { \
+		in_addr_t _address; \
+		gboolean _bound; \
+		\
+		g_assert (nmtst_dhcp_server_get_lease ((server), CLIENT_ID (n), 7, &_address, NULL, &_bound)); \
+		nmtst_assert_ip4_address (_address, (expected_address)); \
+		g_assert_cmpint (_bound, ==, (expected_bound)); \
+	} G_STMT_END
+
+#define _assert_discover(server, n, requested, expected_address) \
+	G_STMT_START { \
+		in_addr_t _address; \
+		\
+		g_assert (nmtst_dhcp_server_discover ((server), CLIENT_ID (n), 7, (requested), &_address)); \
+		nmtst_assert_ip4_address (_address, (expected_address)); \
+	} G_STMT_END
+
+static char *
+_lease_file_new (char **out_dir)
+{
+	gs_free_error GError *error = NULL;
+
+	*out_dir = g_dir_make_tmp ("nm-test-dhcp-server-XXXXXX", &error);
+	nmtst_assert_success (*out_dir, error);
+	return g_build_filename (*out_dir, "leases", NULL);
+}
+
+static void
+_lease_file_free (char *dir, char *lease_file)
+{
+	(void) unlink (lease_file);
+	g_assert_cmpint (rmdir (dir), ==, 0);
+	g_free (lease_file);
+	g_free (dir);
+}
+
+/*****************************************************************************/
+
+static void
+test_pool (void)
+{
+	nm_auto_free_dhcp_server NMDhcpServer *server = NULL;
+	char *dir;
+	char *lease_file = _lease_file_new (&dir);
+	in_addr_t address;
+
+	/* the pool of 192.168.5.1/29 is .2 to .6. */
+	server = nmtst_dhcp_server_new (_addr ("192.168.5.1"), 29, lease_file);
+
+	g_assert (!nmtst_dhcp_server_address_is_free (server, _addr ("192.168.5.0")));
+	g_assert (!nmtst_dhcp_server_address_is_free (server, _addr ("192.168.5.1")));
+	g_assert (nmtst_dhcp_server_address_is_free (server, _addr ("192.168.5.2")));
+	g_assert (nmtst_dhcp_server_address_is_free (server, _addr ("192.168.5.6")));
+	g_assert (!nmtst_dhcp_server_address_is_free (server, _addr ("192.168.5.7")));
+	g_assert (!nmtst_dhcp_server_address_is_free (server, _addr ("192.168.6.2")));
+
+	_assert_discover (server, 1, INADDR_ANY, "192.168.5.2");
+	_assert_discover (server, 2, INADDR_ANY, "192.168.5.3");
+
+	/* next-fit: a released address is not handed out again right away. */
+	nmtst_dhcp_server_release (server, CLIENT_ID (2), 7, INADDR_ANY, FALSE);
+	g_assert (nmtst_dhcp_server_address_is_free (server, _addr ("192.168.5.3")));
+	_assert_discover (server, 3, INADDR_ANY, "192.168.5.4");
+
+	/* unless the client asks for it. */
+	_assert_discover (server, 4, _addr ("192.168.5.3"), "192.168.5.3");
+
+	/* a requested address that is taken is ignored. */
+	_assert_discover (server, 5, _addr ("192.168.5.2"), "192.168.5.5");
+	_assert_discover (server, 6, INADDR_ANY, "192.168.5.6");
+
+	g_assert (!nmtst_dhcp_server_discover (server, CLIENT_ID (7), 7, INADDR_ANY, &address));
+
+	/* a known client gets its address again. */
+	_assert_discover (server, 1, INADDR_ANY, "192.168.5.2");
+	_assert_lease (server, 1, "192.168.5.2", FALSE);
+
+	/* after freeing an address, allocation wraps around. */
+	nmtst_dhcp_server_release (server, CLIENT_ID (1), 7, INADDR_ANY, FALSE);
+	_assert_discover (server, 7, INADDR_ANY, "192.168.5.2");
+
+	nm_clear_pointer (&server, nm_dhcp_server_free);
+	_lease_file_free (dir, lease_file);
+}
+
+/*****************************************************************************/
+
+static void
+test_request (void)
+{
+	nm_auto_free_dhcp_server NMDhcpServer *server = NULL;
+	char *dir;
+	char *lease_file = _lease_file_new (&dir);
+	gint64 now = nm_utils_get_monotonic_timestamp_sec ();
+	gint64 expiry;
+
+	server = nmtst_dhcp_server_new (_addr ("10.42.0.1"), 24, lease_file);
+
+	_assert_discover (server, 1, INADDR_ANY, "10.42.0.2");
+	g_assert (nmtst_dhcp_server_get_lease (server, CLIENT_ID (1), 7, NULL, &expiry, NULL));
+	g_assert_cmpint (expiry, >=, now + OFFER_TIME_SEC);
+	g_assert_cmpint (expiry, <=, now + OFFER_TIME_SEC + 2);
+
+	g_assert (nmtst_dhcp_server_request (server, CLIENT_ID (1), 7, _addr ("10.42.0.2")));
+	_assert_lease (server, 1, "10.42.0.2", TRUE);
+	g_assert (nmtst_dhcp_server_get_lease (server, CLIENT_ID (1), 7, NULL, &expiry, NULL));
+	g_assert_cmpint (expiry, >=, now + LEASE_TIME_SEC);
+	g_assert_cmpint (expiry, <=, now + LEASE_TIME_SEC + 2);
+
+	/* the address is taken. */
+	g_assert (!nmtst_dhcp_server_request (server, CLIENT_ID (2), 7, _addr ("10.42.0.2")));
+	g_assert (!nmtst_dhcp_server_get_lease (server, CLIENT_ID (2), 7, NULL, NULL, NULL));
+
+	/* requesting a free address without DISCOVER (INIT-REBOOT) works. */
+	g_assert (nmtst_dhcp_server_request (server, CLIENT_ID (2), 7, _addr ("10.42.0.77")));
+	_assert_lease (server, 2, "10.42.0.77", TRUE);
+
+	/* a client asking for an address outside the subnet loses its lease. */
+	g_assert (!nmtst_dhcp_server_request (server, CLIENT_ID (1), 7, _addr ("10.43.0.2")));
+	g_assert (!nmtst_dhcp_server_get_lease (server, CLIENT_ID (1), 7, NULL, NULL, NULL));
+	g_assert (nmtst_dhcp_server_address_is_free (server, _addr ("10.42.0.2")));
+
+	/* the server address is never handed out. */
+	g_assert (!nmtst_dhcp_server_request (server, CLIENT_ID (3), 7, _addr ("10.42.0.1")));
+	g_assert (!nmtst_dhcp_server_request (server, CLIENT_ID (3), 7, _addr ("10.42.0.255")));
+
+	nm_clear_pointer (&server, nm_dhcp_server_free);
+	_lease_file_free (dir, lease_file);
+}
+
+/*****************************************************************************/
+
+static void
+test_expiry (void)
+{
+	nm_auto_free_dhcp_server NMDhcpServer *server = NULL;
+	char *dir;
+	char *lease_file = _lease_file_new (&dir);
+	gint64 now;
+	guint i;
+
+	server = nmtst_dhcp_server_new (_addr ("10.42.0.1"), 24, lease_file);
+
+	/* offer 60 addresses, bind every third and release every fifth. That
+	 * removes entries from the middle of the expiry heap. */
+	for (i = 0; i < 60; i++) {
+		in_addr_t address;
+
+		g_assert (nmtst_dhcp_server_discover (server, CLIENT_ID (i), 7, INADDR_ANY, &address));
+		if (i % 3 == 0)
+			g_assert (nmtst_dhcp_server_request (server, CLIENT_ID (i), 7, address));
+	}
+	for (i = 0; i < 60; i += 5)
+		nmtst_dhcp_server_release (server, CLIENT_ID (i), 7, INADDR_ANY, FALSE);
+
+	now = nm_utils_get_monotonic_timestamp_sec ();
+
+	nmtst_dhcp_server_expire (server, now);
+	for (i = 0; i < 60; i++) {
+		g_assert_cmpint (nmtst_dhcp_server_get_lease (server, CLIENT_ID (i), 7, NULL, NULL, NULL),
+		                 ==,
+		                 (i % 5 != 0));
+	}
+
+	/* the offers expire, the bound leases stay. */
+	nmtst_dhcp_server_expire (server, now + OFFER_TIME_SEC + 5);
+	for (i = 0; i < 60; i++) {
+		g_assert_cmpint (nmtst_dhcp_server_get_lease (server, CLIENT_ID (i), 7, NULL, NULL, NULL),
+		                 ==,
+		                 (i % 5 != 0 && i % 3 == 0));
+	}
+	g_assert (nmtst_dhcp_server_address_is_free (server, _addr ("10.42.0.3")));
+
+	nmtst_dhcp_server_expire (server, now + LEASE_TIME_SEC + 5);
+	for (i = 0; i < 60; i++)
+		g_assert (!nmtst_dhcp_server_get_lease (server, CLIENT_ID (i), 7, NULL, NULL, NULL));
+	for (i = 2; i < 62; i++)
+		g_assert (nmtst_dhcp_server_address_is_free (server, htonl (ntohl (_addr ("10.42.0.0")) + i)));
+
+	nm_clear_pointer (&server, nm_dhcp_server_free);
+	_lease_file_free (dir, lease_file);
+}
+
+/*****************************************************************************/
+
+static void
+test_decline (void)
+{
+	nm_auto_free_dhcp_server NMDhcpServer *server = NULL;
+	char *dir;
+	char *lease_file = _lease_file_new (&dir);
+	gint64 now = nm_utils_get_monotonic_timestamp_sec ();
+
+	server = nmtst_dhcp_server_new (_addr ("10.42.0.1"), 24, lease_file);
+
+	_assert_discover (server, 1, INADDR_ANY, "10.42.0.2");
+	g_assert (nmtst_dhcp_server_request (server, CLIENT_ID (1), 7, _addr ("10.42.0.2")));
+
+	/* a decline for another address is ignored. */
+	nmtst_dhcp_server_release (server, CLIENT_ID (1), 7, _addr ("10.42.0.3"), TRUE);
+	_assert_lease (server, 1, "10.42.0.2", TRUE);
+
+	/* after a decline, the address stays reserved, but the client gets
+	 * a new one. */
+	nmtst_dhcp_server_release (server, CLIENT_ID (1), 7, _addr ("10.42.0.2"), TRUE);
+	g_assert (!nmtst_dhcp_server_get_lease (server, CLIENT_ID (1), 7, NULL, NULL, NULL));
+	g_assert (!nmtst_dhcp_server_address_is_free (server, _addr ("10.42.0.2")));
+	_assert_discover (server, 1, _addr ("10.42.0.2"), "10.42.0.3");
+	g_assert (!nmtst_dhcp_server_request (server, CLIENT_ID (2), 7, _addr ("10.42.0.2")));
+
+	/* the reservation ends like a lease. */
+	nmtst_dhcp_server_expire (server, now + LEASE_TIME_SEC + 5);
+	g_assert (nmtst_dhcp_server_address_is_free (server, _addr ("10.42.0.2")));
+	g_assert (nmtst_dhcp_server_request (server, CLIENT_ID (2), 7, _addr ("10.42.0.2")));
+
+	nm_clear_pointer (&server, nm_dhcp_server_free);
+	_lease_file_free (dir, lease_file);
+}
+
+/*****************************************************************************/
+
+static void
+test_lease_file (void)
+{
+	nm_auto_free_dhcp_server NMDhcpServer *server = NULL;
+	gs_free_error GError *error = NULL;
+	gs_free char *contents = NULL;
+	gs_free const char **lines = NULL;
+	gs_free const char **words = NULL;
+	char *dir;
+	char *lease_file = _lease_file_new (&dir);
+	gint64 now_real;
+	gint64 now;
+	gint64 expiry;
+
+	server = nmtst_dhcp_server_new (_addr ("10.42.0.1"), 24, lease_file);
+
+	_assert_discover (server, 1, INADDR_ANY, "10.42.0.2");
+	g_assert (nmtst_dhcp_server_request (server, CLIENT_ID (1), 7, _addr ("10.42.0.2")));
+	g_assert (nmtst_dhcp_server_request (server, CLIENT_ID (2), 7, _addr ("10.42.0.20")));
+	_assert_discover (server, 3, INADDR_ANY, "10.42.0.3");
+	_assert_discover (server, 4, INADDR_ANY, "10.42.0.4");
+	g_assert (nmtst_dhcp_server_request (server, CLIENT_ID (4), 7, _addr ("10.42.0.4")));
+	nmtst_dhcp_server_release (server, CLIENT_ID (4), 7, INADDR_ANY, TRUE);
+
+	nmtst_dhcp_server_save_leases (server);
+	nm_clear_pointer (&server, nm_dhcp_server_free);
+
+	/* only bound leases are saved, the expiry as seconds since the epoch. */
+	now_real = g_get_real_time () / G_USEC_PER_SEC;
+	g_assert (g_file_get_contents (lease_file, &contents, NULL, &error));
+	g_assert_no_error (error);
+	lines = nm_utils_strsplit_set (contents, "\n");
+	g_assert_cmpint (NM_PTRARRAY_LEN (lines), ==, 3);
+	g_assert (lines[0][0] == '#');
+	words = nm_utils_strsplit_set (lines[1], " ");
+	g_assert_cmpint (NM_PTRARRAY_LEN (words), ==, 3);
+	expiry = _nm_utils_ascii_str_to_int64 (words[0], 10, 0, G_MAXINT64, -1);
+	g_assert_cmpint (expiry, >=, now_real + LEASE_TIME_SEC - 5);
+	g_assert_cmpint (expiry, <=, now_real + LEASE_TIME_SEC + 5);
+
+	/* loading converts the expiry back to monotonic time. */
+	now = nm_utils_get_monotonic_timestamp_sec ();
+	server = nmtst_dhcp_server_new (_addr ("10.42.0.1"), 24, lease_file);
+	_assert_lease (server, 1, "10.42.0.2", TRUE);
+	_assert_lease (server, 2, "10.42.0.20", TRUE);
+	g_assert (!nmtst_dhcp_server_get_lease (server, CLIENT_ID (3), 7, NULL, NULL, NULL));
+	g_assert (!nmtst_dhcp_server_get_lease (server, CLIENT_ID (4), 7, NULL, NULL, NULL));
+	g_assert (nmtst_dhcp_server_get_lease (server, CLIENT_ID (1), 7, NULL, &expiry, NULL));
+	g_assert_cmpint (expiry, >=, now + LEASE_TIME_SEC - 5);
+	g_assert_cmpint (expiry, <=, now + LEASE_TIME_SEC + 5);
+	g_assert (!nmtst_dhcp_server_address_is_free (server, _addr ("10.42.0.20")));
+	nm_clear_pointer (&server, nm_dhcp_server_free);
+
+	/* invalid, expired, foreign and duplicate entries are skipped. */
+	nm_clear_g_free (&contents);
+	contents = g_strdup_printf ("# comment\n"
+	                            "%" G_GINT64_FORMAT " 10.42.0.10 01:52:54:00:12:34:01\n"
+	                            "%" G_GINT64_FORMAT " 10.42.0.11 01:52:54:00:12:34:02\n"
+	                            "%" G_GINT64_FORMAT " 10.43.0.12 01:52:54:00:12:34:03\n"
+	                            "%" G_GINT64_FORMAT " 10.42.0.13 01:52:54:00:12:34:01\n"
+	                            "%" G_GINT64_FORMAT " 10.42.0.10 01:52:54:00:12:34:04\n"
+	                            "%" G_GINT64_FORMAT " 10.42.0.14 01:52:54:00:12:34:05 extra\n"
+	                            "foo 10.42.0.15 01:52:54:00:12:34:06\n"
+	                            "%" G_GINT64_FORMAT " 10.42.0.16 xx:yy\n",
+	                            now_real + 100,
+	                            now_real - 100,
+	                            now_real + 100,
+	                            now_real + 100,
+	                            now_real + 100,
+	                            now_real + 100,
+	                            now_real + 100);
+	g_assert (nm_utils_file_set_contents (lease_file, contents, -1, 0644, NULL, &error));
+	g_assert_no_error (error);
+
+	server = nmtst_dhcp_server_new (_addr ("10.42.0.1"), 24, lease_file);
+	_assert_lease (server, 1, "10.42.0.10", TRUE);
+	g_assert (!nmtst_dhcp_server_get_lease (server, CLIENT_ID (2), 7, NULL, NULL, NULL));
+	g_assert (!nmtst_dhcp_server_get_lease (server, CLIENT_ID (3), 7, NULL, NULL, NULL));
+	g_assert (!nmtst_dhcp_server_get_lease (server, CLIENT_ID (4), 7, NULL, NULL, NULL));
+	g_assert (!nmtst_dhcp_server_get_lease (server, CLIENT_ID (5), 7, NULL, NULL, NULL));
+	g_assert (!nmtst_dhcp_server_get_lease (server, CLIENT_ID (6), 7, NULL, NULL, NULL));
+	g_assert (nmtst_dhcp_server_address_is_free (server, _addr ("10.42.0.11")));
+	g_assert (nmtst_dhcp_server_address_is_free (server, _addr ("10.42.0.13")));
+	nm_clear_pointer (&server, nm_dhcp_server_free);
+
+	_lease_file_free (dir, lease_file);
+}
+
+/*****************************************************************************/
+
+NMTST_DEFINE ();
+
+int
+main (int argc, char **argv)
+{
+	nmtst_init_assert_logging (&argc, &argv, "WARN", "DEFAULT");
+
+	g_test_add_func ("/dhcp/server/pool", test_pool);
+	g_test_add_func ("/dhcp/server/request", test_request);
+	g_test_add_func ("/dhcp/server/expiry", test_expiry);
+	g_test_add_func ("/dhcp/server/decline", test_decline);
+	g_test_add_func ("/dhcp/server/lease-file", test_lease_file);
+
+	return g_test_run ();
+}
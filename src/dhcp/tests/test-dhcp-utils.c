@@ -13,6 +13,8 @@
 #include "nm-utils.h"
 
 #include "dhcp/nm-dhcp-utils.h"
+#include "dhcp/nm-dhcp-listener.h"
+#include "dhcp/nm-dhcp-helper-api.h"
 #include "platform/nm-platform.h"
 
 #include "nm-test-utils-core.h"
@@ -759,6 +761,138 @@ test_client_id_from_string (void)
 	COMPARE_ID (endcolon, TRUE, endcolon, strlen (endcolon));
 }
 
+static void
+_helper_msg_add (GByteArray *msg,
+                 guint32 name_len,
+                 guint32 value_len,
+                 const char *name,
+                 const char *value)
+{
+	const NMDhcpHelperSocketRecord rec = {
+		.name_len = name_len,
+		.value_len = value_len,
+	};
+
+	g_byte_array_append (msg, (const guint8 *) &rec, sizeof (rec));
+	if (name)
+		g_byte_array_append (msg, (const guint8 *) name, strlen (name));
+	if (value)
+		g_byte_array_append (msg, (const guint8 *) value, strlen (value));
+}
+
+static GByteArray *
+_helper_msg_new (guint32 version)
+{
+	GByteArray *msg;
+
+	msg = g_byte_array_new ();
+	g_byte_array_append (msg, (const guint8 *) &version, sizeof (version));
+	return msg;
+}
+
+static void
+_helper_msg_assert_option (GVariant *options, const char *name, const char *expected)
+{
+	gs_unref_variant GVariant *value = NULL;
+	gconstpointer data;
+	gsize len;
+
+	value = g_variant_lookup_value (options, name, G_VARIANT_TYPE_BYTESTRING);
+	g_assert (value);
+	data = g_variant_get_fixed_array (value, &len, 1);
+	g_assert_cmpint (len, ==, strlen (expected));
+	g_assert (len == 0 || memcmp (data, expected, len) == 0);
+}
+
+#define _helper_msg_assert_invalid(msg, len) \
+	g_assert (!nmtst_dhcp_listener_parse_helper_message ((msg)->data, (len)))
+
+static void
+test_helper_socket_message (void)
+{
+	nm_auto_unref_bytearray GByteArray *msg = NULL;
+	gs_unref_variant GVariant *options = NULL;
+	guint len;
+
+	/* a valid message */
+	msg = _helper_msg_new (NM_DHCP_HELPER_SOCKET_VERSION);
+	_helper_msg_add (msg, 6, 5, "reason", "BOUND");
+	_helper_msg_add (msg, 10, 0, "new_domain", "");
+	_helper_msg_add (msg, 9, 4, "interface", "eth0");
+	len = msg->len;
+	options = nmtst_dhcp_listener_parse_helper_message (msg->data, msg->len);
+	g_assert (options);
+	g_assert (g_variant_is_of_type (options, G_VARIANT_TYPE_VARDICT));
+	g_assert_cmpint (g_variant_n_children (options), ==, 3);
+	_helper_msg_assert_option (options, "reason", "BOUND");
+	_helper_msg_assert_option (options, "new_domain", "");
+	g_clear_pointer (&options, g_variant_unref);
+
+	/* every truncation of it is invalid, except at a record boundary */
+	while (--len > sizeof (guint32)) {
+		if (NM_IN_SET (len,
+		               sizeof (guint32) + sizeof (NMDhcpHelperSocketRecord) + 11,
+		               sizeof (guint32) + 2 * sizeof (NMDhcpHelperSocketRecord) + 21))
+			continue;
+		_helper_msg_assert_invalid (msg, len);
+	}
+	g_clear_pointer (&msg, g_byte_array_unref);
+
+	/* only the version */
+	msg = _helper_msg_new (NM_DHCP_HELPER_SOCKET_VERSION);
+	options = nmtst_dhcp_listener_parse_helper_message (msg->data, msg->len);
+	g_assert (options);
+	g_assert_cmpint (g_variant_n_children (options), ==, 0);
+	g_clear_pointer (&options, g_variant_unref);
+
+	/* shorter than the version */
+	_helper_msg_assert_invalid (msg, 0);
+	_helper_msg_assert_invalid (msg, sizeof (guint32) - 1);
+	g_clear_pointer (&msg, g_byte_array_unref);
+
+	/* unknown version */
+	msg = _helper_msg_new (NM_DHCP_HELPER_SOCKET_VERSION + 1);
+	_helper_msg_add (msg, 6, 5, "reason", "BOUND");
+	_helper_msg_assert_invalid (msg, msg->len);
+	g_clear_pointer (&msg, g_byte_array_unref);
+
+	/* oversized name length */
+	msg = _helper_msg_new (NM_DHCP_HELPER_SOCKET_VERSION);
+	_helper_msg_add (msg, G_MAXUINT32, 5, "reason", "BOUND");
+	_helper_msg_assert_invalid (msg, msg->len);
+	g_clear_pointer (&msg, g_byte_array_unref);
+
+	/* oversized value length */
+	msg = _helper_msg_new (NM_DHCP_HELPER_SOCKET_VERSION);
+	_helper_msg_add (msg, 6, G_MAXUINT32, "reason", "BOUND");
+	_helper_msg_assert_invalid (msg, msg->len);
+	g_clear_pointer (&msg, g_byte_array_unref);
+
+	/* both lengths oversized, so that their sum wraps around */
+	msg = _helper_msg_new (NM_DHCP_HELPER_SOCKET_VERSION);
+	_helper_msg_add (msg, G_MAXUINT32, G_MAXUINT32, "reason", "BOUND");
+	_helper_msg_assert_invalid (msg, msg->len);
+	g_clear_pointer (&msg, g_byte_array_unref);
+
+	/* a value that swallows the following record and one byte more */
+	msg = _helper_msg_new (NM_DHCP_HELPER_SOCKET_VERSION);
+	_helper_msg_add (msg, 6, 5 + sizeof (NMDhcpHelperSocketRecord) + 2, "reason", "BOUND");
+	_helper_msg_add (msg, 1, 0, "x", NULL);
+	_helper_msg_assert_invalid (msg, msg->len);
+	g_clear_pointer (&msg, g_byte_array_unref);
+
+	/* empty name */
+	msg = _helper_msg_new (NM_DHCP_HELPER_SOCKET_VERSION);
+	_helper_msg_add (msg, 0, 5, NULL, "BOUND");
+	_helper_msg_assert_invalid (msg, msg->len);
+	g_clear_pointer (&msg, g_byte_array_unref);
+
+	/* name is not UTF-8 */
+	msg = _helper_msg_new (NM_DHCP_HELPER_SOCKET_VERSION);
+	_helper_msg_add (msg, 2, 5, "\xc3\x28", "BOUND");
+	_helper_msg_assert_invalid (msg, msg->len);
+}
+
 NMTST_DEFINE ();
 
 int main (int argc, char **argv)
@@ -787,6 +921,7 @@ int main (int argc, char **argv)
 	g_test_add_func ("/dhcp/client-id-from-string", test_client_id_from_string);
 	g_test_add_func ("/dhcp/vendor-option-metered", test_vendor_option_metered);
 	g_test_add_func ("/dhcp/parse-search-list", test_parse_search_list);
+	g_test_add_func ("/dhcp/helper-socket-message", test_helper_socket_message);
 
 	return g_test_run ();
 }
@@ -1100,6 +1100,7 @@ static gboolean
 update (NMDnsPlugin *plugin,
         const NMGlobalDnsConfig *global_config,
         const CList *ip_config_lst_head,
+        const NMDnsUpdateDelta *delta,
         const char *hostname,
         GError **error)
 {
@@ -40,6 +40,10 @@
 
 #define HASH_LEN   NM_UTILS_CHECKSUM_LENGTH_SHA1
 
+/* Changes that are not part of a begin/end_updates() batch are committed
+ * at most once per this interval. */
+#define COMMIT_RATELIMIT_MSEC 200
+
 #ifndef RESOLVCONF_PATH
 #define RESOLVCONF_PATH "/sbin/resolvconf"
 #endif
@@ -93,6 +97,20 @@ typedef struct {
 	bool dns_touched:1;
 	bool is_stopped:1;
 
+	/* whether the domain lists of the NMDnsIPConfigData are up to date
+	 * for @domains_hash. */
+	bool domains_hash_valid:1;
+
+	/* the plugins must reconfigure everything on the next update. */
+	bool plugin_need_full:1;
+	bool sd_resolve_plugin_need_full:1;
+
+	/* interfaces that lost all their configurations since the plugins
+	 * were updated the last time. */
+	GArray *removed_ifindexes;
+
+	guint64 domains_hash;
+
 	char *hostname;
 	guint updates_queue;
 
@@ -111,6 +129,12 @@ typedef struct {
 		guint num_restarts;
 		guint timer;
 	} plugin_ratelimit;
+
+	struct {
+		gint64 ts;
+		guint timer;
+		bool pending:1;
+	} commit_ratelimit;
 } NMDnsManagerPrivate;
 
 struct _NMDnsManager {
@@ -255,7 +279,7 @@ _ip_config_data_free (NMDnsIPConfigData *ip_data)
 	c_list_unlink_stale (&ip_data->data_lst);
 	c_list_unlink_stale (&ip_data->ip_config_lst);
 
-	g_free (ip_data->domains.search);
+	g_strfreev (ip_data->domains.search);
 	g_strfreev (ip_data->domains.reverse);
 
 	g_signal_handlers_disconnect_by_func (ip_data->ip_config,
@@ -345,6 +369,80 @@ nm_dns_manager_has_systemd_resolved (NMDnsManager *self)
 	       && nm_dns_systemd_resolved_is_running (plugin);
 }
 
+static void
+_nameservers4_add (GArray *nameservers, in_addr_t nameserver)
+{
+	guint i;
+
+	/* other hosts cannot reach our loopback resolvers. */
+	if (   nameserver == INADDR_ANY
+	    || (ntohl (nameserver) >> 24) == 127)
+		return;
+
+	for (i = 0; i < nameservers->len; i++) {
+		if (g_array_index (nameservers, in_addr_t, i) == nameserver)
+			return;
+	}
+	g_array_append_val (nameservers, nameserver);
+}
+
+/**
+ * nm_dns_manager_get_nameservers4:
+ * @self: the #NMDnsManager
+ * @exclude_ifindex: ignore the configuration of this interface
+ *
+ * Returns: (transfer full): the upstream IPv4 name servers, in order of
+ *   priority and without duplicates. Loopback addresses are skipped, so
+ *   that the result can be announced to other hosts.
+ */
+GArray *
+nm_dns_manager_get_nameservers4 (NMDnsManager *self, int exclude_ifindex)
+{
+	NMDnsManagerPrivate *priv;
+	NMGlobalDnsConfig *global_config;
+	NMDnsIPConfigData *ip_data;
+	GArray *nameservers;
+	const CList *head;
+	guint i, n;
+
+	g_return_val_if_fail (NM_IS_DNS_MANAGER (self), NULL);
+
+	priv = NM_DNS_MANAGER_GET_PRIVATE (self);
+
+	nameservers = g_array_new (FALSE, FALSE, sizeof (in_addr_t));
+
+	global_config = nm_config_data_get_global_dns_config (nm_config_get_data (priv->config));
+	if (global_config) {
+		NMGlobalDnsDomain *default_domain;
+		const char *const *servers;
+		in_addr_t addr;
+
+		default_domain = nm_global_dns_config_lookup_domain (global_config, "*");
+		servers = default_domain ? nm_global_dns_domain_get_servers (default_domain) : NULL;
+		for (i = 0; servers && servers[i]; i++) {
+			if (nm_utils_parse_inaddr_bin (AF_INET, servers[i], NULL, &addr))
+				_nameservers4_add (nameservers, addr);
+		}
+		return nameservers;
+	}
+
+	head = _ip_config_lst_head (self);
+	c_list_for_each_entry (ip_data, head, ip_config_lst) {
+		const NMIP4Config *ip4_config;
+
+		if (   ip_data->data->ifindex == exclude_ifindex
+		    || nm_ip_config_get_addr_family (ip_data->ip_config) != AF_INET)
+			continue;
+
+		ip4_config = NM_IP4_CONFIG (ip_data->ip_config);
+		n = nm_ip4_config_get_num_nameservers (ip4_config);
+		for (i = 0; i < n; i++)
+			_nameservers4_add (nameservers, nm_ip4_config_get_nameserver (ip4_config, i));
+	}
+
+	return nameservers;
+}
+
 /*****************************************************************************/
 
 static void
@@ -994,25 +1092,60 @@ update_resolv_conf (NMDnsManager *self,
 	return SR_SUCCESS;
 }
 
+static const guint8 *
+_hash_empty (void)
+{
+	static guint8 hash[HASH_LEN];
+	static gsize initialized = 0;
+
+	if (g_once_init_enter (&initialized)) {
+		nm_auto_free_checksum GChecksum *sum = NULL;
+
+		sum = g_checksum_new (G_CHECKSUM_SHA1);
+		nm_utils_checksum_get_digest_len (sum, hash, HASH_LEN);
+		g_once_init_leave (&initialized, 1);
+	}
+	return hash;
+}
+
+static void
+_ip_config_data_update_hash (NMDnsIPConfigData *ip_data)
+{
+	nm_auto_free_checksum GChecksum *sum = NULL;
+
+	sum = g_checksum_new (G_CHECKSUM_SHA1);
+	nm_ip_config_hash (ip_data->ip_config, sum, TRUE);
+	nm_utils_checksum_get_digest_len (sum, ip_data->hash, HASH_LEN);
+}
+
 static void
 compute_hash (NMDnsManager *self, const NMGlobalDnsConfig *global, guint8 buffer[HASH_LEN])
 {
 	nm_auto_free_checksum GChecksum *sum = NULL;
 	NMDnsIPConfigData *ip_data;
+	const CList *head;
 
 	sum = g_checksum_new (G_CHECKSUM_SHA1);
 	nm_assert (HASH_LEN == g_checksum_type_get_length (G_CHECKSUM_SHA1));
 
+	/* Always refresh the per-configuration hashes, they are also used to
+	 * detect which interfaces changed since the previous commit. */
+	head = _ip_config_lst_head (self);
+	c_list_for_each_entry (ip_data, head, ip_config_lst)
+		_ip_config_data_update_hash (ip_data);
+
 	if (global)
 		nm_global_dns_config_update_checksum (global, sum);
 	else {
-		const CList *head;
-
 		/* FIXME(ip-config-checksum): this relies on the fact that an IP
-		 * configuration without DNS parameters gives a zero checksum. */
-		head = _ip_config_lst_head (self);
-		c_list_for_each_entry (ip_data, head, ip_config_lst)
-			nm_ip_config_hash (ip_data->ip_config, sum, TRUE);
+		 * configuration without DNS parameters gives the checksum of
+		 * no data. Such configurations are skipped, so that they don't
+		 * change the overall hash. */
+		c_list_for_each_entry (ip_data, head, ip_config_lst) {
+			if (memcmp (ip_data->hash, _hash_empty (), HASH_LEN) == 0)
+				continue;
+			g_checksum_update (sum, ip_data->hash, HASH_LEN);
+		}
 	}
 
 	nm_utils_checksum_get_digest_len (sum, buffer, HASH_LEN);
@@ -1226,50 +1359,300 @@ get_ip_rdns_domains (NMIPConfig *ip_config)
 	return _nm_utils_strv_cleanup (strv, FALSE, FALSE, TRUE);
 }
 
-/* Check if the domain is shadowed by a parent domain with more negative priority */
+/*****************************************************************************/
+
+/* The domains of all configurations are tracked in a trie of labels,
+ * starting from the top level label. Walking down the trie to the node of a
+ * domain visits all its parent domains, so that detecting whether a
+ * domain is shadowed costs one lookup per label (instead of hashing every
+ * suffix of the name). A trailing dot is ignored, "example.com." and
+ * "example.com" are the same domain. */
+
+typedef struct _DomainTrieNode {
+	const struct _DomainTrieNode *parent;
+	const char *label;
+	gsize label_len;
+	int priority;
+} DomainTrieNode;
+
+typedef struct {
+	GHashTable *nodes;
+	DomainTrieNode root;
+} DomainTrie;
+
+static guint
+_domain_trie_node_hash (gconstpointer ptr)
+{
+	const DomainTrieNode *node = ptr;
+	NMHashState h;
+
+	nm_hash_init (&h, 1130212897u);
+	nm_hash_update_val (&h, node->parent);
+	nm_hash_update_mem (&h, node->label, node->label_len);
+	return nm_hash_complete (&h);
+}
+
 static gboolean
-domain_is_shadowed (GHashTable *ht,
-                    const char *domain, int priority,
-                    const char **out_parent, int *out_parent_priority)
+_domain_trie_node_equal (gconstpointer a, gconstpointer b)
+{
+	const DomainTrieNode *node_a = a;
+	const DomainTrieNode *node_b = b;
+
+	return    node_a->parent == node_b->parent
+	       && node_a->label_len == node_b->label_len
+	       && memcmp (node_a->label, node_b->label, node_a->label_len) == 0;
+}
+
+static void
+_domain_trie_node_free (gpointer ptr)
 {
-	char *parent;
-	int parent_priority;
+	g_slice_free (DomainTrieNode, ptr);
+}
+
+static void
+_domain_trie_init (DomainTrie *trie)
+{
+	trie->nodes = g_hash_table_new_full (_domain_trie_node_hash,
+	                                     _domain_trie_node_equal,
+	                                     _domain_trie_node_free,
+	                                     NULL);
+	trie->root = (DomainTrieNode) { };
+}
+
+static void
+_domain_trie_clear (DomainTrie *trie)
+{
+	nm_clear_pointer (&trie->nodes, g_hash_table_destroy);
+}
 
-	nm_assert (!g_hash_table_contains (ht, domain));
+static DomainTrieNode *
+_domain_trie_child (DomainTrie *trie,
+                    const DomainTrieNode *parent,
+                    const char *label,
+                    gsize label_len)
+{
+	DomainTrieNode needle = {
+		.parent    = parent,
+		.label     = label,
+		.label_len = label_len,
+	};
+	DomainTrieNode *node;
+
+	node = g_hash_table_lookup (trie->nodes, &needle);
+	if (!node) {
+		node = g_slice_new (DomainTrieNode);
+		*node = needle;
+		g_hash_table_add (trie->nodes, node);
+	}
+	return node;
+}
 
-	parent_priority = GPOINTER_TO_INT (g_hash_table_lookup (ht, ""));
-	if (parent_priority < 0 && parent_priority < priority) {
+/* Looks up (or creates) the node of @domain. If one of the parent domains
+ * has a negative priority that wins over @priority, the closest one to the
+ * top level is returned in @out_parent/@out_parent_priority. The labels
+ * of the nodes point into @domain, which must stay alive as long as the trie. */
+static DomainTrieNode *
+_domain_trie_lookup (DomainTrie *trie,
+                     const char *domain,
+                     int priority,
+                     const char **out_parent,
+                     int *out_parent_priority)
+{
+	DomainTrieNode *node = &trie->root;
+	gsize start, end;
+
+	*out_parent = NULL;
+	*out_parent_priority = 0;
+
+	end = strlen (domain);
+	if (end > 0 && domain[end - 1] == '.')
+		end--;
+	if (end == 0)
+		return node;
+
+	if (node->priority < 0 && node->priority < priority) {
 		*out_parent = "";
-		*out_parent_priority = parent_priority;
-		return TRUE;
+		*out_parent_priority = node->priority;
 	}
 
-	parent = strchr (domain, '.');
-	while (parent && parent[1]) {
-		parent++;
-		parent_priority = GPOINTER_TO_INT (g_hash_table_lookup (ht, parent));
-		if (parent_priority < 0 && parent_priority < priority) {
-			*out_parent = parent;
-			*out_parent_priority = parent_priority;
-			return TRUE;
+	for (;;) {
+		start = end;
+		while (start > 0 && domain[start - 1] != '.')
+			start--;
+
+		node = _domain_trie_child (trie, node, &domain[start], end - start);
+		if (start == 0)
+			return node;
+
+		if (   !*out_parent
+		    && node->priority < 0
+		    && node->priority < priority) {
+			*out_parent = &domain[start];
+			*out_parent_priority = node->priority;
 		}
-		parent = strchr (parent, '.');
+		end = start - 1;
 	}
+}
 
-	return FALSE;
+/* Drops from @domains those that exist with a better priority or that are
+ * shadowed by a parent domain with a more negative priority. Configurations
+ * must be passed in order of priority. Returns the number of domains left. */
+static guint
+_domain_trie_filter (NMDnsManager *self,
+                     DomainTrie *trie,
+                     int ifindex,
+                     int priority,
+                     const char **domains,
+                     guint n_domains)
+{
+	guint i, n;
+
+	n = 0;
+	for (i = 0; i < n_domains; i++) {
+		DomainTrieNode *node;
+		const char *parent;
+		int parent_priority;
+
+		node = _domain_trie_lookup (trie,
+		                            nm_utils_parse_dns_domain (domains[i], NULL),
+		                            priority,
+		                            &parent,
+		                            &parent_priority);
+
+		/* Remove domains with lower priority */
+		if (node->priority) {
+			if (node->priority < priority) {
+				_LOGT ("plugin: drop domain '%s' (i=%d, p=%d) because it already exists with p=%d",
+				       domains[i], ifindex,
+				       priority, node->priority);
+				continue;
+			}
+		} else if (parent) {
+			_LOGT ("plugin: drop domain '%s' (i=%d, p=%d) shadowed by '%s' (p=%d)",
+			       domains[i],
+			       ifindex, priority,
+			       parent, parent_priority);
+			continue;
+		}
+
+		_LOGT ("plugin: add domain '%s' (i=%d, p=%d)", domains[i], ifindex, priority);
+		node->priority = priority;
+		domains[n++] = domains[i];
+	}
+	domains[n] = NULL;
+
+	return n;
+}
+
+char ***
+nmtst_dns_filter_domains (const int *priorities,
+                          const char *const*const*domains,
+                          guint n)
+{
+	DomainTrie trie;
+	char ***result;
+	guint i;
+
+	_domain_trie_init (&trie);
+
+	result = g_new0 (char **, n + 1);
+	for (i = 0; i < n; i++) {
+		gs_free const char **d = NULL;
+		guint len;
+
+		len = NM_PTRARRAY_LEN (domains[i]);
+		d = nm_memdup (domains[i], sizeof (const char *) * (len + 1));
+		_domain_trie_filter (NULL, &trie, 0, priorities[i], d, len);
+		result[i] = g_strdupv ((char **) d);
+	}
+
+	_domain_trie_clear (&trie);
+	return result;
+}
+
+static guint64
+_domain_lists_hash (NMDnsManager *self, gboolean *out_lists_missing)
+{
+	NMDnsIPConfigData *ip_data;
+	NMHashState h;
+	CList *head;
+	gboolean lists_missing = FALSE;
+
+	nm_hash_init (&h, 1559951707u);
+
+	head = _ip_config_lst_head (self);
+	c_list_for_each_entry (ip_data, head, ip_config_lst) {
+		NMIPConfig *ip_config = ip_data->ip_config;
+		gboolean has_nameservers;
+		guint i, n;
+
+		has_nameservers = (nm_ip_config_get_num_nameservers (ip_config) > 0);
+
+		nm_hash_update_val (&h, ip_data);
+		nm_hash_update_vals (&h,
+		                     nm_ip_config_get_dns_priority (ip_config),
+		                     ip_data->ip_config_type,
+		                     NM_HASH_COMBINE_BOOLS (guint8,
+		                                            has_nameservers,
+		                                            !!nm_ip_config_best_default_route_get (ip_config)));
+		if (!has_nameservers)
+			continue;
+
+		if (!ip_data->domains.search)
+			lists_missing = TRUE;
+
+		n = nm_ip_config_get_num_searches (ip_config);
+		nm_hash_update_val (&h, n);
+		for (i = 0; i < n; i++)
+			nm_hash_update_str (&h, nm_ip_config_get_search (ip_config, i));
+		n = nm_ip_config_get_num_domains (ip_config);
+		nm_hash_update_val (&h, n);
+		for (i = 0; i < n; i++)
+			nm_hash_update_str (&h, nm_ip_config_get_domain (ip_config, i));
+	}
+
+	*out_lists_missing = lists_missing;
+	return nm_hash_complete_u64 (&h);
 }
 
 static void
 rebuild_domain_lists (NMDnsManager *self)
 {
+	NMDnsManagerPrivate *priv = NM_DNS_MANAGER_GET_PRIVATE (self);
 	NMDnsIPConfigData *ip_data;
-	gs_unref_hashtable GHashTable *ht = NULL;
+	DomainTrie trie;
 	gboolean default_route_found = FALSE;
+	gboolean lists_missing;
+	guint64 domains_hash;
 	CList *head;
 
-	ht = g_hash_table_new (nm_str_hash, g_str_equal);
-
 	head = _ip_config_lst_head (self);
+
+	/* The reverse domains depend on the addresses and routes, which are
+	 * not covered by the hash below. They are cheap and per-interface,
+	 * so always regenerate them. */
+	c_list_for_each_entry (ip_data, head, ip_config_lst) {
+		g_strfreev (ip_data->domains.reverse);
+		ip_data->domains.reverse = nm_ip_config_get_num_nameservers (ip_data->ip_config)
+		                           ? get_ip_rdns_domains (ip_data->ip_config)
+		                           : NULL;
+	}
+
+	/* Whether a domain is shadowed depends on all the other configurations.
+	 * Only when none of the inputs changed, we can keep the lists from the
+	 * previous commit. */
+	domains_hash = _domain_lists_hash (self, &lists_missing);
+	if (   priv->domains_hash_valid
+	    && priv->domains_hash == domains_hash
+	    && !lists_missing) {
+		_LOGT ("plugin: domain lists unchanged");
+		return;
+	}
+	priv->domains_hash = domains_hash;
+	priv->domains_hash_valid = TRUE;
+
+	_domain_trie_init (&trie);
+
 	c_list_for_each_entry (ip_data, head, ip_config_lst) {
 		NMIPConfig *ip_config = ip_data->ip_config;
 
@@ -1283,20 +1666,20 @@ rebuild_domain_lists (NMDnsManager *self)
 
 	c_list_for_each_entry (ip_data, head, ip_config_lst) {
 		NMIPConfig *ip_config = ip_data->ip_config;
-		int priority, old_priority;
+		int priority;
 		guint i, n, n_domains = 0;
-		const char **domains;
+		gs_free const char **domains = NULL;
+
+		g_clear_pointer (&ip_data->domains.search, g_strfreev);
 
 		if (!nm_ip_config_get_num_nameservers (ip_config))
 			continue;
 
 		priority = nm_ip_config_get_dns_priority (ip_config);
 		nm_assert (priority != 0);
-		g_free (ip_data->domains.search);
 		domains = g_new0 (const char *,
 		                  2 + NM_MAX (nm_ip_config_get_num_searches (ip_config),
 		                              nm_ip_config_get_num_domains (ip_config)));
-		ip_data->domains.search = domains;
 
 		/* Add wildcard lookup domain to connections with the default route.
 		 * If there is no default route, add the wildcard domain to all non-VPN
@@ -1321,55 +1704,76 @@ rebuild_domain_lists (NMDnsManager *self)
 				domains[n_domains++] = nm_ip_config_get_domain (ip_config, i);
 		}
 
-		n = 0;
-		for (i = 0; i < n_domains; i++) {
-			const char *domain_clean;
-			const char *parent;
-			int parent_priority;
-
-			domain_clean = nm_utils_parse_dns_domain (domains[i], NULL);
-
-			/* Remove domains with lower priority */
-			old_priority = GPOINTER_TO_INT (g_hash_table_lookup (ht, domain_clean));
-			if (old_priority) {
-				if (old_priority < priority) {
-					_LOGT ("plugin: drop domain '%s' (i=%d, p=%d) because it already exists with p=%d",
-					       domains[i], ip_data->data->ifindex,
-					       priority, old_priority);
-					continue;
-				}
-			} else if (domain_is_shadowed (ht, domain_clean, priority, &parent, &parent_priority)) {
-				_LOGT ("plugin: drop domain '%s' (i=%d, p=%d) shadowed by '%s' (p=%d)",
-				       domains[i],
-				       ip_data->data->ifindex, priority,
-				       parent, parent_priority);
-				continue;
-			}
-
-			_LOGT ("plugin: add domain '%s' (i=%d, p=%d)", domains[i], ip_data->data->ifindex, priority);
-			g_hash_table_insert (ht, (gpointer) domain_clean, GINT_TO_POINTER (priority));
-			domains[n++] = domains[i];
-		}
-		domains[n] = NULL;
+		_domain_trie_filter (self,
+		                     &trie,
+		                     ip_data->data->ifindex,
+		                     priority,
+		                     domains,
+		                     n_domains);
 
-		g_strfreev (ip_data->domains.reverse);
-		ip_data->domains.reverse = get_ip_rdns_domains (ip_config);
+		/* the lists outlive this commit, so they cannot point to strings
+		 * owned by the IP configurations. */
+		ip_data->domains.search = g_strdupv ((char **) domains);
 	}
+
+	_domain_trie_clear (&trie);
 }
 
 static void
-clear_domain_lists (NMDnsManager *self)
+_hash_update_strv (NMHashState *h, char **strv)
+{
+	gsize i, n;
+
+	n = NM_PTRARRAY_LEN (strv);
+	nm_hash_update_val (h, n);
+	for (i = 0; i < n; i++)
+		nm_hash_update_str (h, strv[i]);
+}
+
+static void
+_update_delta_prepare (NMDnsManager *self)
 {
 	NMDnsIPConfigData *ip_data;
 	CList *head;
 
 	head = _ip_config_lst_head (self);
 	c_list_for_each_entry (ip_data, head, ip_config_lst) {
-		g_clear_pointer (&ip_data->domains.search, g_free);
-		g_clear_pointer (&ip_data->domains.reverse, g_strfreev);
+		NMHashState h;
+		guint64 fingerprint;
+
+		nm_hash_init (&h, 1867023649u);
+		nm_hash_update (&h, ip_data->hash, HASH_LEN);
+		nm_hash_update_vals (&h,
+		                     nm_ip_config_get_dns_priority (ip_data->ip_config),
+		                     ip_data->ip_config_type);
+		_hash_update_strv (&h, ip_data->domains.search);
+		_hash_update_strv (&h, ip_data->domains.reverse);
+		fingerprint = nm_hash_complete_u64 (&h);
+
+		if (   ip_data->fingerprint_valid
+		    && ip_data->fingerprint == fingerprint)
+			continue;
+
+		ip_data->fingerprint = fingerprint;
+		ip_data->fingerprint_valid = TRUE;
+		ip_data->data->changed = TRUE;
 	}
 }
 
+static void
+_update_delta_complete (NMDnsManager *self)
+{
+	NMDnsManagerPrivate *priv = NM_DNS_MANAGER_GET_PRIVATE (self);
+	NMDnsConfigData *data;
+	GHashTableIter iter;
+
+	g_hash_table_iter_init (&iter, priv->configs);
+	while (g_hash_table_iter_next (&iter, NULL, (gpointer *) &data))
+		data->changed = FALSE;
+
+	g_array_set_size (priv->removed_ifindexes, 0);
+}
+
 static gboolean
 update_dns (NMDnsManager *self,
             gboolean no_caching,
@@ -1391,11 +1795,16 @@ update_dns (NMDnsManager *self,
 
 	priv = NM_DNS_MANAGER_GET_PRIVATE (self);
 
+	nm_clear_g_source (&priv->commit_ratelimit.timer);
+	priv->commit_ratelimit.pending = FALSE;
+
 	if (priv->is_stopped) {
 		_LOGD ("update-dns: not updating resolv.conf (is stopped)");
 		return TRUE;
 	}
 
+	priv->commit_ratelimit.ts = nm_utils_get_monotonic_timestamp_msec ();
+
 	nm_clear_g_source (&priv->plugin_ratelimit.timer);
 
 	if (NM_IN_SET (priv->rc_manager, NM_DNS_MANAGER_RESOLV_CONF_MAN_UNMANAGED,
@@ -1417,15 +1826,25 @@ update_dns (NMDnsManager *self,
 	                           &searches, &options, &nameservers,
 	                           &nis_servers, &nis_domain);
 
-	if (priv->plugin || priv->sd_resolve_plugin)
+	if (priv->plugin || priv->sd_resolve_plugin) {
 		rebuild_domain_lists (self);
+		_update_delta_prepare (self);
+	}
 
 	if (priv->sd_resolve_plugin) {
+		const NMDnsUpdateDelta delta = {
+			.removed_ifindexes = &g_array_index (priv->removed_ifindexes, int, 0),
+			.removed_len       = priv->removed_ifindexes->len,
+			.full              = priv->sd_resolve_plugin_need_full,
+		};
+
 		nm_dns_plugin_update (priv->sd_resolve_plugin,
 		                      global_config,
 		                      _ip_config_lst_head (self),
+		                      &delta,
 		                      priv->hostname,
 		                      NULL);
+		priv->sd_resolve_plugin_need_full = FALSE;
 	}
 
 	/* Let any plugins do their thing first */
@@ -1433,11 +1852,17 @@ update_dns (NMDnsManager *self,
 		NMDnsPlugin *plugin = priv->plugin;
 		const char *plugin_name = nm_dns_plugin_get_name (plugin);
 		gs_free_error GError *plugin_error = NULL;
+		const NMDnsUpdateDelta delta = {
+			.removed_ifindexes = &g_array_index (priv->removed_ifindexes, int, 0),
+			.removed_len       = priv->removed_ifindexes->len,
+			.full              = priv->plugin_need_full,
+		};
 
 		if (nm_dns_plugin_is_caching (plugin)) {
 			if (no_caching) {
 				_LOGD ("update-dns: plugin %s ignored (caching disabled)",
 				       plugin_name);
+				priv->plugin_need_full = TRUE;
 				goto skip;
 			}
 			caching = TRUE;
@@ -1447,6 +1872,7 @@ update_dns (NMDnsManager *self,
 		if (!nm_dns_plugin_update (plugin,
 		                           global_config,
 		                           _ip_config_lst_head (self),
+		                           &delta,
 		                           priv->hostname,
 		                           &plugin_error)) {
 			_LOGW ("update-dns: plugin %s update failed: %s", plugin_name, plugin_error->message);
@@ -1455,16 +1881,16 @@ update_dns (NMDnsManager *self,
 			 * caching DNS configuration to resolv.conf.
 			 */
 			caching = FALSE;
-		}
+			priv->plugin_need_full = TRUE;
+		} else
+			priv->plugin_need_full = FALSE;
 
 	skip:
 		;
 	}
 
-	/* Clear the generated search list as it points to
-	 * strings owned by IP configurations and we can't
-	 * guarantee they stay alive. */
-	clear_domain_lists (self);
+	/* The next plugin update only gets the changes from now on. */
+	_update_delta_complete (self);
 
 	update_resolv_conf_no_stub (self,
 	                            NM_CAST_STRV_CC (searches),
@@ -1555,6 +1981,58 @@ update_dns (NMDnsManager *self,
 
 /*****************************************************************************/
 
+static gboolean
+_commit_ratelimit_cb (gpointer user_data)
+{
+	NMDnsManager *self = user_data;
+	NMDnsManagerPrivate *priv = NM_DNS_MANAGER_GET_PRIVATE (self);
+	gs_free_error GError *error = NULL;
+
+	priv->commit_ratelimit.timer = 0;
+
+	if (priv->updates_queue) {
+		/* nm_dns_manager_end_updates() will commit. */
+		return G_SOURCE_REMOVE;
+	}
+
+	_LOGD ("committing rate limited DNS changes");
+	if (!update_dns (self, FALSE, &error))
+		_LOGW ("could not commit DNS changes: %s", error->message);
+	return G_SOURCE_REMOVE;
+}
+
+static void
+_commit_schedule (NMDnsManager *self)
+{
+	NMDnsManagerPrivate *priv = NM_DNS_MANAGER_GET_PRIVATE (self);
+	gs_free_error GError *error = NULL;
+	gint64 now;
+
+	if (priv->commit_ratelimit.timer) {
+		/* already scheduled. The change will be picked up. */
+		return;
+	}
+
+	now = nm_utils_get_monotonic_timestamp_msec ();
+	if (   priv->commit_ratelimit.ts == 0
+	    || now >= priv->commit_ratelimit.ts + COMMIT_RATELIMIT_MSEC) {
+		if (!update_dns (self, FALSE, &error))
+			_LOGW ("could not commit DNS changes: %s", error->message);
+		return;
+	}
+
+	/* We committed only recently. Coalesce the changes that arrive within
+	 * the window into one commit. */
+	_LOGD ("rate limit DNS commit for %u msec",
+	       (guint) (priv->commit_ratelimit.ts + COMMIT_RATELIMIT_MSEC - now));
+	priv->commit_ratelimit.pending = TRUE;
+	priv->commit_ratelimit.timer = g_timeout_add (priv->commit_ratelimit.ts + COMMIT_RATELIMIT_MSEC - now,
+	                                              _commit_ratelimit_cb,
+	                                              self);
+}
+
+/*****************************************************************************/
+
 static void
 _ip_config_dns_priority_changed (gpointer config,
                                  GParamSpec *pspec,
@@ -1571,7 +2049,6 @@ nm_dns_manager_set_ip_config (NMDnsManager *self,
                               NMDnsIPConfigType ip_config_type)
 {
 	NMDnsManagerPrivate *priv;
-	GError *error = NULL;
 	NMDnsIPConfigData *ip_data;
 	NMDnsConfigData *data;
 	int ifindex;
@@ -1600,8 +2077,11 @@ nm_dns_manager_set_ip_config (NMDnsManager *self,
 			priv->best_ip_config_6 = NULL;
 		/* deleting a config doesn't invalidate the configs' sort order. */
 		_ip_config_data_free (ip_data);
-		if (c_list_is_empty (&data->data_lst_head))
+		if (c_list_is_empty (&data->data_lst_head)) {
 			g_hash_table_remove (priv->configs, GINT_TO_POINTER (ifindex));
+			g_array_append_val (priv->removed_ifindexes, ifindex);
+		} else
+			data->changed = TRUE;
 		goto changed;
 	}
 
@@ -1644,11 +2124,8 @@ nm_dns_manager_set_ip_config (NMDnsManager *self,
 	}
 
 changed:
-	if (   !priv->updates_queue
-	    && !update_dns (self, FALSE, &error)) {
-		_LOGW ("could not commit DNS changes: %s", error->message);
-		g_clear_error (&error);
-	}
+	if (!priv->updates_queue)
+		_commit_schedule (self);
 
 	return TRUE;
 }
@@ -1669,7 +2146,6 @@ nm_dns_manager_set_hostname (NMDnsManager *self,
                              gboolean skip_update)
 {
 	NMDnsManagerPrivate *priv = NM_DNS_MANAGER_GET_PRIVATE (self);
-	GError *error = NULL;
 	const char *filtered = NULL;
 
 	/* Certain hostnames we don't want to include in resolv.conf 'searches' */
@@ -1687,12 +2163,14 @@ nm_dns_manager_set_hostname (NMDnsManager *self,
 	g_free (priv->hostname);
 	priv->hostname = g_strdup (filtered);
 
+	/* the hostname is not part of the per-interface data. */
+	priv->plugin_need_full = TRUE;
+	priv->sd_resolve_plugin_need_full = TRUE;
+
 	if (skip_update)
 		return;
-	if (!priv->updates_queue && !update_dns (self, FALSE, &error)) {
-		_LOGW ("could not commit DNS changes: %s", error->message);
-		g_clear_error (&error);
-	}
+	if (!priv->updates_queue)
+		_commit_schedule (self);
 }
 
 void
@@ -1726,7 +2204,8 @@ nm_dns_manager_end_updates (NMDnsManager *self, const char *func)
 	g_return_if_fail (priv->updates_queue > 0);
 
 	compute_hash (self, nm_config_data_get_global_dns_config (nm_config_get_data (priv->config)), new);
-	changed = (memcmp (new, priv->prev_hash, sizeof (new)) != 0) ? TRUE : FALSE;
+	changed =    memcmp (new, priv->prev_hash, sizeof (new)) != 0
+	          || priv->commit_ratelimit.pending;
 	_LOGD ("(%s): DNS configuration %s", func, changed ? "changed" : "did not change");
 
 	priv->updates_queue--;
@@ -2024,6 +2503,11 @@ again:
 		_notify (self, PROP_RC_MANAGER);
 	}
 
+	if (plugin_changed)
+		priv->plugin_need_full = TRUE;
+	if (systemd_resolved_changed)
+		priv->sd_resolve_plugin_need_full = TRUE;
+
 	if (param_changed || plugin_changed || systemd_resolved_changed) {
 		_LOGI ("init: dns=%s%s rc-manager=%s%s%s%s",
 		       mode,
@@ -2043,6 +2527,7 @@ config_changed_cb (NMConfig *config,
                    NMConfigData *old_data,
                    NMDnsManager *self)
 {
+	NMDnsManagerPrivate *priv = NM_DNS_MANAGER_GET_PRIVATE (self);
 	GError *error = NULL;
 
 	if (NM_FLAGS_ANY (changes, NM_CONFIG_CHANGE_DNS_MODE |
@@ -2065,6 +2550,8 @@ config_changed_cb (NMConfig *config,
 	                           NM_CONFIG_CHANGE_DNS_MODE |
 	                           NM_CONFIG_CHANGE_RC_MANAGER |
 	                           NM_CONFIG_CHANGE_GLOBAL_DNS_CONFIG)) {
+		priv->plugin_need_full = TRUE;
+		priv->sd_resolve_plugin_need_full = TRUE;
 		if (!update_dns (self, FALSE, &error)) {
 			_LOGW ("could not commit DNS changes: %s", error->message);
 			g_clear_error (&error);
@@ -2264,6 +2751,8 @@ nm_dns_manager_init (NMDnsManager *self)
 	priv->configs = g_hash_table_new_full (nm_direct_hash, NULL,
 	                                       NULL, (GDestroyNotify) _config_data_free);
 
+	priv->removed_ifindexes = g_array_new (FALSE, FALSE, sizeof (int));
+
 	/* Set the initial hash */
 	compute_hash (self, NULL, NM_DNS_MANAGER_GET_PRIVATE (self)->hash);
 
@@ -2301,6 +2790,7 @@ dispose (GObject *object)
 	g_clear_pointer (&priv->configs, g_hash_table_destroy);
 
 	nm_clear_g_source (&priv->plugin_ratelimit.timer);
+	nm_clear_g_source (&priv->commit_ratelimit.timer);
 
 	g_clear_object (&priv->config);
 
@@ -2317,6 +2807,7 @@ finalize (GObject *object)
 
 	g_free (priv->hostname);
 	g_free (priv->mode);
+	g_array_unref (priv->removed_ifindexes);
 
 	G_OBJECT_CLASS (nm_dns_manager_parent_class)->finalize (object);
 }
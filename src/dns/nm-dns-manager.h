@@ -35,17 +35,47 @@ typedef struct {
 	CList ip_config_lst;
 	NMDnsIPConfigType ip_config_type;
 	struct {
-		const char **search;
+		char **search;
 		char **reverse;
 	} domains;
+
+	/* SHA1 of the DNS related parts of @ip_config, updated on each commit. */
+	guint8 hash[NM_UTILS_CHECKSUM_LENGTH_SHA1];
+
+	/* fingerprint of what the plugins got to see during the last
+	 * commit (the hash above, the type, the priority and the domain lists). */
+	guint64 fingerprint;
+	bool fingerprint_valid:1;
 } NMDnsIPConfigData;
 
 typedef struct _NMDnsConfigData {
 	struct _NMDnsManager *self;
 	CList data_lst_head;
 	int ifindex;
+
+	/* whether any of the configurations of the interface was added,
+	 * removed or changed since the plugins were updated the last time. */
+	bool changed:1;
 } NMDnsConfigData;
 
+/**
+ * NMDnsUpdateDelta:
+ * @removed_ifindexes: the interfaces that no longer have any DNS
+ *   configuration since the previous update.
+ * @removed_len: the number of entries in @removed_ifindexes.
+ * @full: if %TRUE, the plugin must not rely on the previous update
+ *   and reconfigure all interfaces. Otherwise, only interfaces that have
+ *   NMDnsConfigData.changed set or that are in @removed_ifindexes
+ *   differ from the previous update.
+ *
+ * The changes since the previous update of a plugin.
+ */
+typedef struct {
+	const int *removed_ifindexes;
+	guint removed_len;
+	bool full:1;
+} NMDnsUpdateDelta;
+
 #define NM_TYPE_DNS_MANAGER (nm_dns_manager_get_type ())
 #define NM_DNS_MANAGER(o) (G_TYPE_CHECK_INSTANCE_CAST ((o), NM_TYPE_DNS_MANAGER, NMDnsManager))
 #define NM_DNS_MANAGER_CLASS(k) (G_TYPE_CHECK_CLASS_CAST((k), NM_TYPE_DNS_MANAGER, NMDnsManagerClass))
@@ -115,10 +145,16 @@ void nm_dns_manager_stop (NMDnsManager *self);
 
 gboolean nm_dns_manager_has_systemd_resolved (NMDnsManager *self);
 
+GArray *nm_dns_manager_get_nameservers4 (NMDnsManager *self, int exclude_ifindex);
+
 /*****************************************************************************/
 
 char *nmtst_dns_create_resolv_conf (const char *const*searches,
                                     const char *const*nameservers,
                                     const char *const*options);
 
+char ***nmtst_dns_filter_domains (const int *priorities,
+                                  const char *const*const*domains,
+                                  guint n);
+
 #endif /* __NETWORKMANAGER_DNS_MANAGER_H__ */
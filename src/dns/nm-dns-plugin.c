@@ -56,14 +56,17 @@ gboolean
 nm_dns_plugin_update (NMDnsPlugin *self,
                       const NMGlobalDnsConfig *global_config,
                       const CList *ip_config_lst_head,
+                      const NMDnsUpdateDelta *delta,
                       const char *hostname,
                       GError **error)
 {
 	g_return_val_if_fail (NM_DNS_PLUGIN_GET_CLASS (self)->update != NULL, FALSE);
+	nm_assert (delta);
 
 	return NM_DNS_PLUGIN_GET_CLASS (self)->update (self,
 	                                               global_config,
 	                                               ip_config_lst_head,
+	                                               delta,
 	                                               hostname,
 	                                               error);
 }
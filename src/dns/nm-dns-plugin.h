@@ -26,11 +26,14 @@ typedef struct {
 	/* Called when DNS information is changed.  'configs' is an array
 	 * of pointers to NMDnsIPConfigData sorted by priority.
 	 * 'global_config' is the optional global DNS
-	 * configuration.
+	 * configuration. 'delta' tells which interfaces changed since
+	 * the previous update; plugins that always reconfigure everything
+	 * can ignore it.
 	 */
 	gboolean (*update) (NMDnsPlugin *self,
 	                    const NMGlobalDnsConfig *global_config,
 	                    const CList *ip_config_lst_head,
+	                    const NMDnsUpdateDelta *delta,
 	                    const char *hostname,
 	                    GError **error);
 
@@ -55,6 +58,7 @@ const char *nm_dns_plugin_get_name (NMDnsPlugin *self);
 gboolean nm_dns_plugin_update (NMDnsPlugin *self,
                                const NMGlobalDnsConfig *global_config,
                                const CList *ip_config_lst_head,
+                               const NMDnsUpdateDelta *delta,
                                const char *hostname,
                                GError **error);
 
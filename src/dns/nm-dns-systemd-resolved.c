@@ -34,26 +34,81 @@
 #define SYSTEMD_RESOLVED_MANAGER_IFACE  "org.freedesktop.resolve1.Manager"
 #define SYSTEMD_RESOLVED_DBUS_PATH      "/org/freedesktop/resolve1"
 
+/* The maximum number of calls to systemd-resolved that we have pending
+ * at the same time. */
+#define CALLS_IN_FLIGHT_MAX 16
+
+/* Failed calls are retried after a delay, which doubles with each failure
+ * up to the maximum. */
+#define RETRY_DELAY_MIN_SEC 1
+#define RETRY_DELAY_MAX_SEC 60
+
 /*****************************************************************************/
 
+typedef enum {
+	REQUEST_OP_SET_LINK_DNS,
+	REQUEST_OP_SET_LINK_DOMAINS,
+	REQUEST_OP_SET_LINK_MULTICAST_DNS,
+	REQUEST_OP_SET_LINK_LLMNR,
+	_REQUEST_OP_NUM,
+} RequestOp;
+
+static const char *const _request_op_names[_REQUEST_OP_NUM] = {
+	[REQUEST_OP_SET_LINK_DNS]           = "SetLinkDNS",
+	[REQUEST_OP_SET_LINK_DOMAINS]       = "SetLinkDomains",
+	[REQUEST_OP_SET_LINK_MULTICAST_DNS] = "SetLinkMulticastDNS",
+	[REQUEST_OP_SET_LINK_LLMNR]         = "SetLinkLLMNR",
+};
+
 typedef struct {
 	int ifindex;
 	CList configs_lst_head;
 } InterfaceConfig;
 
+typedef struct _RequestItem RequestItem;
+
 typedef struct {
+	int ifindex;
+
+	/* The argument of the last request per operation, that is, the setting
+	 * that systemd-resolved should have. It is pushed again when
+	 * systemd-resolved restarts. */
+	GVariant *desired[_REQUEST_OP_NUM];
+
+	/* The argument of the last call per operation that systemd-resolved
+	 * acknowledged. As long as the setting doesn't change, there is no
+	 * need to call systemd-resolved again. */
+	GVariant *sent[_REQUEST_OP_NUM];
+
+	/* the request per operation that is still waiting in the queue. */
+	RequestItem *queued[_REQUEST_OP_NUM];
+
+	/* the last request per operation that was sent but did not yet complete. */
+	RequestItem *in_flight[_REQUEST_OP_NUM];
+} LinkState;
+
+struct _RequestItem {
 	CList request_queue_lst;
-	const char *operation;
+	NMDnsSystemdResolved *self;
 	GVariant *argument;
-} RequestItem;
+	int ifindex;
+	RequestOp op;
+	bool is_retry:1;
+};
 
 /*****************************************************************************/
 
 typedef struct {
 	GDBusConnection *dbus_connection;
 	GCancellable *cancellable;
+	GCancellable *calls_cancellable;
+	GHashTable *links;
 	CList request_queue_lst_head;
+	CList request_in_flight_lst_head;
+	guint request_in_flight_num;
 	guint name_owner_changed_id;
+	guint retry_id;
+	guint retry_delay_sec;
 	bool send_updates_warn_ratelimited:1;
 	bool try_start_blocked:1;
 	bool dbus_has_owner:1;
@@ -89,16 +144,80 @@ _request_item_free (RequestItem *request_item)
 }
 
 static void
-_request_item_append (CList *request_queue_lst_head,
-                      const char *operation,
-                      GVariant *argument)
+_link_state_free (LinkState *link_state)
 {
+	RequestOp op;
+
+	/* queued requests stay in the queue and are still sent. */
+	for (op = 0; op < _REQUEST_OP_NUM; op++) {
+		nm_clear_pointer (&link_state->desired[op], g_variant_unref);
+		nm_clear_pointer (&link_state->sent[op], g_variant_unref);
+	}
+	g_slice_free (LinkState, link_state);
+}
+
+static LinkState *
+_link_state_get (NMDnsSystemdResolved *self, int ifindex)
+{
+	NMDnsSystemdResolvedPrivate *priv = NM_DNS_SYSTEMD_RESOLVED_GET_PRIVATE (self);
+	LinkState *link_state;
+
+	link_state = g_hash_table_lookup (priv->links, GINT_TO_POINTER (ifindex));
+	if (!link_state) {
+		link_state = g_slice_new0 (LinkState);
+		link_state->ifindex = ifindex;
+		g_hash_table_insert (priv->links, GINT_TO_POINTER (ifindex), link_state);
+	}
+	return link_state;
+}
+
+static void
+_request_enqueue (NMDnsSystemdResolved *self,
+                  LinkState *link_state,
+                  RequestOp op)
+{
+	NMDnsSystemdResolvedPrivate *priv = NM_DNS_SYSTEMD_RESOLVED_GET_PRIVATE (self);
 	RequestItem *request_item;
 
+	nm_assert (link_state->desired[op]);
+
+	/* a request for the same setting that was not yet sent is obsolete. */
+	if (link_state->queued[op])
+		_request_item_free (g_steal_pointer (&link_state->queued[op]));
+
 	request_item = g_slice_new (RequestItem);
-	request_item->operation = operation;
-	request_item->argument = g_variant_ref_sink (argument);
-	c_list_link_tail (request_queue_lst_head, &request_item->request_queue_lst);
+	request_item->self = self;
+	request_item->op = op;
+	request_item->ifindex = link_state->ifindex;
+	request_item->is_retry = FALSE;
+	request_item->argument = g_variant_ref (link_state->desired[op]);
+	c_list_link_tail (&priv->request_queue_lst_head, &request_item->request_queue_lst);
+	link_state->queued[op] = request_item;
+}
+
+static void
+_request_queue (NMDnsSystemdResolved *self,
+                int ifindex,
+                RequestOp op,
+                GVariant *argument)
+{
+	gs_unref_variant GVariant *argument_sunk = g_variant_ref_sink (argument);
+	LinkState *link_state;
+
+	link_state = _link_state_get (self, ifindex);
+
+	if (   link_state->desired[op]
+	    && g_variant_equal (link_state->desired[op], argument_sunk)
+	    && (   link_state->queued[op]
+	        || link_state->in_flight[op]
+	        || link_state->sent[op] == link_state->desired[op])) {
+		/* unchanged, and either acknowledged or on its way. */
+		return;
+	}
+
+	nm_clear_pointer (&link_state->desired[op], g_variant_unref);
+	link_state->desired[op] = g_steal_pointer (&argument_sunk);
+	_request_enqueue (self, link_state, op);
 }
 
 /*****************************************************************************/
@@ -110,29 +229,114 @@ _interface_config_free (InterfaceConfig *config)
 	g_slice_free (InterfaceConfig, config);
 }
 
+static void send_updates (NMDnsSystemdResolved *self);
+
+static gboolean
+_retry_cb (gpointer user_data)
+{
+	NMDnsSystemdResolved *self = user_data;
+	NMDnsSystemdResolvedPrivate *priv = NM_DNS_SYSTEMD_RESOLVED_GET_PRIVATE (self);
+	GHashTableIter iter;
+	LinkState *link_state;
+	RequestOp op;
+
+	priv->retry_id = 0;
+
+	/* queue again the settings that systemd-resolved didn't acknowledge
+	 * and for which no newer request is pending. */
+	g_hash_table_iter_init (&iter, priv->links);
+	while (g_hash_table_iter_next (&iter, NULL, (gpointer *) &link_state)) {
+		for (op = 0; op < _REQUEST_OP_NUM; op++) {
+			if (   link_state->desired[op]
+			    && link_state->sent[op] != link_state->desired[op]
+			    && !link_state->queued[op]
+			    && !link_state->in_flight[op]) {
+				_request_enqueue (self, link_state, op);
+				link_state->queued[op]->is_retry = TRUE;
+			}
+		}
+	}
+
+	_LOGT ("send-updates: retry failed requests");
+	send_updates (self);
+	return G_SOURCE_REMOVE;
+}
+
+static void
+_retry_schedule (NMDnsSystemdResolved *self)
+{
+	NMDnsSystemdResolvedPrivate *priv = NM_DNS_SYSTEMD_RESOLVED_GET_PRIVATE (self);
+
+	if (priv->retry_id)
+		return;
+
+	priv->retry_delay_sec =   priv->retry_delay_sec
+	                        ? NM_MIN (priv->retry_delay_sec * 2, (guint) RETRY_DELAY_MAX_SEC)
+	                        : (guint) RETRY_DELAY_MIN_SEC;
+	_LOGT ("send-updates: retry failed requests in %u seconds", priv->retry_delay_sec);
+	priv->retry_id = g_timeout_add_seconds (priv->retry_delay_sec, _retry_cb, self);
+}
+
 static void
 call_done (GObject *source, GAsyncResult *r, gpointer user_data)
 {
 	gs_unref_variant GVariant *v = NULL;
 	gs_free_error GError *error = NULL;
-	NMDnsSystemdResolved *self = (NMDnsSystemdResolved *) user_data;
+	RequestItem *request_item = user_data;
+	NMDnsSystemdResolved *self;
 	NMDnsSystemdResolvedPrivate *priv;
+	LinkState *link_state;
 
 	v = g_dbus_connection_call_finish (G_DBUS_CONNECTION (source), r, &error);
 	if (   !v
-	    && g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+	    && g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED)) {
+		_request_item_free (request_item);
 		return;
+	}
 
+	self = request_item->self;
 	priv = NM_DNS_SYSTEMD_RESOLVED_GET_PRIVATE (self);
 
+	nm_assert (priv->request_in_flight_num > 0);
+	priv->request_in_flight_num--;
+
+	link_state = g_hash_table_lookup (priv->links, GINT_TO_POINTER (request_item->ifindex));
+	if (   link_state
+	    && link_state->in_flight[request_item->op] == request_item)
+		link_state->in_flight[request_item->op] = NULL;
+
 	if (!v) {
 		if (!priv->send_updates_warn_ratelimited) {
 			priv->send_updates_warn_ratelimited = TRUE;
 			_LOGW ("send-updates failed to update systemd-resolved: %s", error->message);
 		} else
 			_LOGD ("send-updates failed: %s", error->message);
-	} else
+
+		/* we don't know the state of the setting. Forget about it and
+		 * send it again later. Unchanged links are not looked at by the
+		 * next update(), so that won't do it. */
+		if (link_state) {
+			nm_clear_pointer (&link_state->sent[request_item->op], g_variant_unref);
+			_retry_schedule (self);
+		}
+	} else {
 		priv->send_updates_warn_ratelimited = FALSE;
+
+		/* a retry succeeded, start again with the shortest delay on the
+		 * next failure. */
+		if (request_item->is_retry)
+			priv->retry_delay_sec = 0;
+
+		/* only now we know that systemd-resolved has the setting. */
+		if (link_state) {
+			nm_clear_pointer (&link_state->sent[request_item->op], g_variant_unref);
+			link_state->sent[request_item->op] = g_variant_ref (request_item->argument);
+		}
+	}
+
+	_request_item_free (request_item);
+
+	send_updates (self);
 }
 
 static void
@@ -145,7 +349,7 @@ update_add_ip_config (NMDnsSystemdResolved *self,
 	gsize addr_size;
 	guint i, n;
 	gboolean is_routing;
-	const char **iter;
+	char **iter;
 	const char *domain;
 
 	addr_family = nm_ip_config_get_addr_family (data->ip_config);
@@ -177,17 +381,22 @@ free_pending_updates (NMDnsSystemdResolved *self)
 {
 	NMDnsSystemdResolvedPrivate *priv = NM_DNS_SYSTEMD_RESOLVED_GET_PRIVATE (self);
 	RequestItem *request_item;
+	LinkState *link_state;
 
 	while ((request_item = c_list_first_entry (&priv->request_queue_lst_head,
 	                                           RequestItem,
-	                                           request_queue_lst)))
+	                                           request_queue_lst))) {
+		link_state = g_hash_table_lookup (priv->links, GINT_TO_POINTER (request_item->ifindex));
+		if (   link_state
+		    && link_state->queued[request_item->op] == request_item)
+			link_state->queued[request_item->op] = NULL;
 		_request_item_free (request_item);
+	}
 }
 
 static void
 prepare_one_interface (NMDnsSystemdResolved *self, InterfaceConfig *ic)
 {
-	NMDnsSystemdResolvedPrivate *priv = NM_DNS_SYSTEMD_RESOLVED_GET_PRIVATE (self);
 	GVariantBuilder dns, domains;
 	NMCListElem *elem;
 	NMSettingConnectionMdns mdns = NM_SETTING_CONNECTION_MDNS_DEFAULT;
@@ -249,18 +458,22 @@ prepare_one_interface (NMDnsSystemdResolved *self, InterfaceConfig *ic)
 	}
 	nm_assert (llmnr_arg);
 
-	_request_item_append (&priv->request_queue_lst_head,
-	                      "SetLinkDNS",
-	                      g_variant_builder_end (&dns));
-	_request_item_append (&priv->request_queue_lst_head,
-	                      "SetLinkDomains",
-	                      g_variant_builder_end (&domains));
-	_request_item_append (&priv->request_queue_lst_head,
-	                      "SetLinkMulticastDNS",
-	                      g_variant_new ("(is)", ic->ifindex, mdns_arg ?: ""));
-	_request_item_append (&priv->request_queue_lst_head,
-	                      "SetLinkLLMNR",
-	                      g_variant_new ("(is)", ic->ifindex, llmnr_arg ?: ""));
+	_request_queue (self,
+	                ic->ifindex,
+	                REQUEST_OP_SET_LINK_DNS,
+	                g_variant_builder_end (&dns));
+	_request_queue (self,
+	                ic->ifindex,
+	                REQUEST_OP_SET_LINK_DOMAINS,
+	                g_variant_builder_end (&domains));
+	_request_queue (self,
+	                ic->ifindex,
+	                REQUEST_OP_SET_LINK_MULTICAST_DNS,
+	                g_variant_new ("(is)", ic->ifindex, mdns_arg ?: ""));
+	_request_queue (self,
+	                ic->ifindex,
+	                REQUEST_OP_SET_LINK_LLMNR,
+	                g_variant_new ("(is)", ic->ifindex, llmnr_arg ?: ""));
 }
 
 static void
@@ -299,16 +512,35 @@ send_updates (NMDnsSystemdResolved *self)
 		return;
 	}
 
-	_LOGT ("send-updates: start %lu requests",
-	       c_list_length (&priv->request_queue_lst_head));
+	if (priv->request_in_flight_num >= CALLS_IN_FLIGHT_MAX) {
+		/* call_done() continues when one of the calls completes. */
+		return;
+	}
 
-	nm_clear_g_cancellable (&priv->cancellable);
+	if (!priv->calls_cancellable)
+		priv->calls_cancellable = g_cancellable_new ();
 
-	priv->cancellable = g_cancellable_new ();
+	_LOGT ("send-updates: start requests (%lu queued, %u in flight)",
+	       c_list_length (&priv->request_queue_lst_head),
+	       priv->request_in_flight_num);
+
+	while (   priv->request_in_flight_num < CALLS_IN_FLIGHT_MAX
+	       && (request_item = c_list_first_entry (&priv->request_queue_lst_head,
+	                                              RequestItem,
+	                                              request_queue_lst))) {
+		LinkState *link_state;
+
+		link_state = g_hash_table_lookup (priv->links, GINT_TO_POINTER (request_item->ifindex));
+		if (   link_state
+		    && link_state->queued[request_item->op] == request_item) {
+			link_state->queued[request_item->op] = NULL;
+			link_state->in_flight[request_item->op] = request_item;
+		}
+
+		c_list_unlink (&request_item->request_queue_lst);
+		c_list_link_tail (&priv->request_in_flight_lst_head, &request_item->request_queue_lst);
+		priv->request_in_flight_num++;
 
-	while ((request_item = c_list_first_entry (&priv->request_queue_lst_head,
-	                                           RequestItem,
-	                                           request_queue_lst))) {
 		/* Above we explicitly call "StartServiceByName" trying to avoid D-Bus activating systmd-resolved
 		 * multiple times. There is still a race, were we might hit this line although actually
 		 * the service just quit this very moment. In that case, we would try to D-Bus activate the
@@ -321,31 +553,54 @@ send_updates (NMDnsSystemdResolved *self)
 		                        SYSTEMD_RESOLVED_DBUS_SERVICE,
 		                        SYSTEMD_RESOLVED_DBUS_PATH,
 		                        SYSTEMD_RESOLVED_MANAGER_IFACE,
-		                        request_item->operation,
+		                        _request_op_names[request_item->op],
 		                        request_item->argument,
 		                        NULL,
 		                        G_DBUS_CALL_FLAGS_NONE,
 		                        -1,
-		                        priv->cancellable,
+		                        priv->calls_cancellable,
 		                        call_done,
-		                        self);
-		_request_item_free (request_item);
+		                        request_item);
 	}
 }
 
+static void
+_interfaces_add_empty (GHashTable *interfaces, int ifindex)
+{
+	InterfaceConfig *ic;
+
+	if (g_hash_table_contains (interfaces, GINT_TO_POINTER (ifindex)))
+		return;
+
+	ic = g_slice_new (InterfaceConfig);
+	ic->ifindex = ifindex;
+	c_list_init (&ic->configs_lst_head);
+	g_hash_table_insert (interfaces, GINT_TO_POINTER (ifindex), ic);
+}
+
 static gboolean
 update (NMDnsPlugin *plugin,
         const NMGlobalDnsConfig *global_config,
         const CList *ip_config_lst_head,
+        const NMDnsUpdateDelta *delta,
         const char *hostname,
         GError **error)
 {
 	NMDnsSystemdResolved *self = NM_DNS_SYSTEMD_RESOLVED (plugin);
+	NMDnsSystemdResolvedPrivate *priv = NM_DNS_SYSTEMD_RESOLVED_GET_PRIVATE (self);
 	gs_unref_hashtable GHashTable *interfaces = NULL;
 	gs_free gpointer *interfaces_keys = NULL;
 	guint interfaces_len;
 	guint i;
 	NMDnsIPConfigData *ip_data;
+	GHashTableIter iter;
+	LinkState *link_state;
+	gboolean full;
+
+	/* With a full update we look at all interfaces. Otherwise, only at the
+	 * ones that changed. Either way, only the settings that differ from
+	 * what we sent before result in a call to systemd-resolved. */
+	full = delta->full;
 
 	interfaces = g_hash_table_new_full (nm_direct_hash, NULL,
 	                                    NULL, (GDestroyNotify) _interface_config_free);
@@ -357,6 +612,11 @@ update (NMDnsPlugin *plugin,
 		ifindex = ip_data->data->ifindex;
 		nm_assert (ifindex == nm_ip_config_get_ifindex (ip_data->ip_config));
 
+		if (   !full
+		    && !ip_data->data->changed
+		    && g_hash_table_contains (priv->links, GINT_TO_POINTER (ifindex)))
+			continue;
+
 		ic = g_hash_table_lookup (interfaces, GINT_TO_POINTER (ifindex));
 		if (!ic) {
 			ic = g_slice_new (InterfaceConfig);
@@ -369,7 +629,21 @@ update (NMDnsPlugin *plugin,
 		                  &nm_c_list_elem_new_stale (ip_data)->lst);
 	}
 
-	free_pending_updates (self);
+	/* Interfaces that lost all their DNS configuration are reset with
+	 * empty settings. On a full update, that also applies to all links
+	 * that we configured before and that are no longer there. */
+	for (i = 0; i < delta->removed_len; i++)
+		_interfaces_add_empty (interfaces, delta->removed_ifindexes[i]);
+	if (full) {
+		g_hash_table_iter_init (&iter, priv->links);
+		while (g_hash_table_iter_next (&iter, NULL, (gpointer *) &link_state))
+			_interfaces_add_empty (interfaces, link_state->ifindex);
+	}
+
+	if (g_hash_table_size (interfaces) == 0) {
+		/* nothing changed. */
+		return TRUE;
+	}
 
 	interfaces_keys = nm_utils_hash_keys_to_array (interfaces,
 	                                               nm_cmp_int2ptr_p_with_data,
@@ -379,6 +653,11 @@ update (NMDnsPlugin *plugin,
 		InterfaceConfig *ic = g_hash_table_lookup (interfaces, GINT_TO_POINTER (interfaces_keys[i]));
 
 		prepare_one_interface (self, ic);
+
+		/* After the reset, forget about the link. If the ifindex shows up
+		 * again, everything is sent anew. */
+		if (c_list_is_empty (&ic->configs_lst_head))
+			g_hash_table_remove (priv->links, GINT_TO_POINTER (ic->ifindex));
 	}
 
 	send_updates (self);
@@ -388,6 +667,32 @@ update (NMDnsPlugin *plugin,
 
 /*****************************************************************************/
 
+static void
+_resync_all (NMDnsSystemdResolved *self)
+{
+	NMDnsSystemdResolvedPrivate *priv = NM_DNS_SYSTEMD_RESOLVED_GET_PRIVATE (self);
+	GHashTableIter iter;
+	LinkState *link_state;
+	RequestOp op;
+
+	if (g_hash_table_size (priv->links) == 0)
+		return;
+
+	/* systemd-resolved (re)started and lost all our settings. Push the
+	 * full state again, without waiting for the next DNS update. */
+	_LOGT ("send-updates: re-push settings of %u links", g_hash_table_size (priv->links));
+
+	g_hash_table_iter_init (&iter, priv->links);
+	while (g_hash_table_iter_next (&iter, NULL, (gpointer *) &link_state)) {
+		for (op = 0; op < _REQUEST_OP_NUM; op++) {
+			nm_clear_pointer (&link_state->sent[op], g_variant_unref);
+			if (   link_state->desired[op]
+			    && !link_state->queued[op])
+				_request_enqueue (self, link_state, op);
+		}
+	}
+}
+
 static void
 name_owner_changed (NMDnsSystemdResolved *self,
                     const char *owner)
@@ -402,8 +707,10 @@ name_owner_changed (NMDnsSystemdResolved *self,
 		_LOGT ("D-Bus name for systemd-resolved has owner %s", owner);
 
 	priv->dbus_has_owner = !!owner;
-	if (owner)
+	if (owner) {
 		priv->try_start_blocked = FALSE;
+		_resync_all (self);
+	}
 
 	send_updates (self);
 }
@@ -486,6 +793,9 @@ nm_dns_systemd_resolved_init (NMDnsSystemdResolved *self)
 	NMDnsSystemdResolvedPrivate *priv = NM_DNS_SYSTEMD_RESOLVED_GET_PRIVATE (self);
 
 	c_list_init (&priv->request_queue_lst_head);
+	c_list_init (&priv->request_in_flight_lst_head);
+	priv->links = g_hash_table_new_full (nm_direct_hash, NULL,
+	                                     NULL, (GDestroyNotify) _link_state_free);
 
 	priv->dbus_connection = nm_g_object_ref (NM_MAIN_DBUS_CONNECTION_GET);
 	if (!priv->dbus_connection) {
@@ -518,9 +828,21 @@ dispose (GObject *object)
 {
 	NMDnsSystemdResolved *self = NM_DNS_SYSTEMD_RESOLVED (object);
 	NMDnsSystemdResolvedPrivate *priv = NM_DNS_SYSTEMD_RESOLVED_GET_PRIVATE (self);
+	RequestItem *request_item, *request_item_safe;
 
 	free_pending_updates (self);
 
+	/* the calls in flight get cancelled and their callbacks free the
+	 * requests. */
+	c_list_for_each_entry_safe (request_item, request_item_safe, &priv->request_in_flight_lst_head, request_queue_lst)
+		c_list_unlink (&request_item->request_queue_lst);
+	priv->request_in_flight_num = 0;
+	nm_clear_g_cancellable (&priv->calls_cancellable);
+
+	nm_clear_g_source (&priv->retry_id);
+
+	nm_clear_pointer (&priv->links, g_hash_table_destroy);
+
 	nm_clear_g_dbus_connection_signal (priv->dbus_connection,
 	                                   &priv->name_owner_changed_id);
 
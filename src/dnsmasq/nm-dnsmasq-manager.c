@@ -18,9 +18,19 @@
 #include "nm-utils.h"
 #include "NetworkManagerUtils.h"
 #include "nm-core-internal.h"
+#include "nm-config.h"
 
 #define CONFDIR NMCONFDIR "/dnsmasq-shared.d"
 
+#define SHARED_CONF_FILE  RUNSTATEDIR "/nm-dnsmasq-shared.conf"
+#define SHARED_PID_FILE   RUNSTATEDIR "/nm-dnsmasq-shared.pid"
+#define SHARED_LEASE_FILE NMSTATEDIR "/dnsmasq-shared.leases"
+
+/* if the shared process exits within this time after start more than
+ * SHARED_EARLY_EXITS_MAX times in a row, give up restarting it. */
+#define SHARED_EARLY_EXIT_MSEC  10000
+#define SHARED_EARLY_EXITS_MAX  3
+
 /*****************************************************************************/
 
 enum {
@@ -35,6 +45,10 @@ typedef struct {
 	char *pidfile;
 	GPid pid;
 	guint dm_watch_id;
+
+	/* registration with the shared instance, if main.shared-dnsmasq=single. */
+	CList shared_lst;
+	char *shared_conf;
 } NMDnsMasqManagerPrivate;
 
 struct _NMDnsMasqManager {
@@ -52,16 +66,41 @@ G_DEFINE_TYPE (NMDnsMasqManager, nm_dnsmasq_manager, G_TYPE_OBJECT)
 
 /*****************************************************************************/
 
+/* With main.shared-dnsmasq=single, all managers register their per-interface
+ * configuration here and one dnsmasq process serves all of them. */
+typedef struct {
+	CList managers_lst_head;
+
+	/* the configuration the running process was started with. */
+	char *conf;
+
+	GPid pid;
+	guint watch_id;
+	guint reconfigure_id;
+
+	/* to detect a process that keeps dying right after start. */
+	gint64 start_msec;
+	guint n_early_exits;
+
+	/* a previous process is still shutting down. We cannot start the
+	 * next one before, because it would fail to bind the sockets. */
+	bool stopping:1;
+} SharedInstance;
+
+static SharedInstance _shared = {
+	.managers_lst_head = C_LIST_INIT (_shared.managers_lst_head),
+};
+
+/*****************************************************************************/
+
 #define _NMLOG_DOMAIN      LOGD_SHARING
 #define _NMLOG(level, ...) __NMLOG_DEFAULT (level, _NMLOG_DOMAIN, "dnsmasq-manager", __VA_ARGS__)
 
 /*****************************************************************************/
 
 static void
-dm_watch_cb (GPid pid, int status, gpointer user_data)
+_log_exit_status (int status)
 {
-	NMDnsMasqManager *manager = NM_DNSMASQ_MANAGER (user_data);
-	NMDnsMasqManagerPrivate *priv = NM_DNSMASQ_MANAGER_GET_PRIVATE (manager);
 	guint err;
 
 	if (WIFEXITED (status)) {
@@ -77,6 +116,15 @@ dm_watch_cb (GPid pid, int status, gpointer user_data)
 	} else {
 		_LOGW ("dnsmasq died from an unknown cause");
 	}
+}
+
+static void
+dm_watch_cb (GPid pid, int status, gpointer user_data)
+{
+	NMDnsMasqManager *manager = NM_DNSMASQ_MANAGER (user_data);
+	NMDnsMasqManagerPrivate *priv = NM_DNSMASQ_MANAGER_GET_PRIVATE (manager);
+
+	_log_exit_status (status);
 
 	priv->pid = 0;
 	priv->dm_watch_id = 0;
@@ -85,26 +133,10 @@ dm_watch_cb (GPid pid, int status, gpointer user_data)
 }
 
 static GPtrArray *
-create_dm_cmd_line (const char *iface,
-                    const NMIP4Config *ip4_config,
-                    const char *pidfile,
-                    gboolean announce_android_metered,
-                    GError **error)
+_cmd_line_new (const char *conf_file, GError **error)
 {
-	gs_unref_ptrarray GPtrArray *cmd = NULL;
-	nm_auto_free_gstring GString *s = NULL;
-	char first[INET_ADDRSTRLEN];
-	char last[INET_ADDRSTRLEN];
-	char listen_address_s[INET_ADDRSTRLEN];
-	char tmpaddr[INET_ADDRSTRLEN];
-	gs_free char *error_desc = NULL;
+	GPtrArray *cmd;
 	const char *dm_binary;
-	const NMPlatformIP4Address *listen_address;
-	guint i, n;
-
-	listen_address = nm_ip4_config_get_first_address (ip4_config);
-
-	g_return_val_if_fail (listen_address, NULL);
 
 	dm_binary = nm_utils_find_helper ("dnsmasq", DNSMASQ_PATH, error);
 	if (!dm_binary)
@@ -124,9 +156,9 @@ create_dm_cmd_line (const char *iface,
 	 * location is a valid config file, it will combine with the options here
 	 * and cause undesirable side-effects.  Like sending bogus IP addresses
 	 * as the gateway or whatever.  So tell dnsmasq not to use any config file
-	 * at all.
+	 * at all, or only the one we generated.
 	 */
-	nm_strv_ptrarray_add_string_dup (cmd, "--conf-file=/dev/null");
+	nm_strv_ptrarray_add_string_concat (cmd, "--conf-file=", conf_file);
 
 	nm_strv_ptrarray_add_string_dup (cmd, "--no-hosts");
 	nm_strv_ptrarray_add_string_dup (cmd, "--keep-in-foreground");
@@ -140,9 +172,64 @@ create_dm_cmd_line (const char *iface,
 	 */
 	nm_strv_ptrarray_add_string_dup (cmd, "--strict-order");
 
+	return cmd;
+}
+
+static void
+_cmd_line_finish (GPtrArray *cmd,
+                  const char *leasefile,
+                  const char *pidfile)
+{
+	nm_strv_ptrarray_add_string_concat (cmd, "--dhcp-leasefile=", leasefile);
+
+	nm_strv_ptrarray_add_string_concat (cmd, "--pid-file=", pidfile);
+
+	/* dnsmasq exits if the conf dir is not present */
+	if (g_file_test (CONFDIR, G_FILE_TEST_IS_DIR))
+		nm_strv_ptrarray_add_string_dup (cmd, "--conf-dir=" CONFDIR);
+
+	g_ptr_array_add (cmd, NULL);
+}
+
+/* Appends the options for serving one interface to @opts. With @prefix "--"
+ * they are command line arguments, with "" lines of a configuration file.
+ * If @tag is given, the DHCP range sets the tag and the DHCP options only
+ * apply to clients with that tag, so that several interfaces can share
+ * one configuration. */
+static gboolean
+_add_iface_options (GPtrArray *opts,
+                    const char *prefix,
+                    const char *tag,
+                    const NMIP4Config *ip4_config,
+                    gboolean announce_android_metered,
+                    GError **error)
+{
+	nm_auto_free_gstring GString *s = NULL;
+	gs_free char *set_tag = NULL;
+	gs_free char *match_tag = NULL;
+	char first[INET_ADDRSTRLEN];
+	char last[INET_ADDRSTRLEN];
+	char listen_address_s[INET_ADDRSTRLEN];
+	char tmpaddr[INET_ADDRSTRLEN];
+	gs_free char *error_desc = NULL;
+	const NMPlatformIP4Address *listen_address;
+	guint i, n;
+
+	listen_address = nm_ip4_config_get_first_address (ip4_config);
+
+	g_return_val_if_fail (listen_address, FALSE);
+
+	if (tag) {
+		set_tag = g_strdup_printf ("set:%s,", tag);
+		match_tag = g_strdup_printf ("tag:%s,", tag);
+	}
+
 	_nm_utils_inet4_ntop (listen_address->address, listen_address_s);
 
-	nm_strv_ptrarray_add_string_concat (cmd, "--listen-address=", listen_address_s);
+	nm_strv_ptrarray_add_string_printf (opts,
+	                                    "%slisten-address=%s",
+	                                    prefix,
+	                                    listen_address_s);
 
 	if (!nm_dnsmasq_utils_get_range (listen_address, first, last, &error_desc)) {
 		g_set_error_literal (error,
@@ -150,60 +237,82 @@ create_dm_cmd_line (const char *iface,
 		                     NM_MANAGER_ERROR_FAILED,
 		                     error_desc);
 		_LOGW ("failed to find DHCP address ranges: %s", error_desc);
-		return NULL;
+		return FALSE;
 	}
 
-	nm_strv_ptrarray_add_string_printf (cmd,
-	                                    "--dhcp-range=%s,%s,60m",
+	nm_strv_ptrarray_add_string_printf (opts,
+	                                    "%sdhcp-range=%s%s,%s,60m",
+	                                    prefix,
+	                                    set_tag ?: "",
 	                                    first,
 	                                    last);
 
 	if (nm_ip4_config_best_default_route_get (ip4_config)) {
-		nm_strv_ptrarray_add_string_concat (cmd,
-		                                    "--dhcp-option=option:router,",
+		nm_strv_ptrarray_add_string_printf (opts,
+		                                    "%sdhcp-option=%soption:router,%s",
+		                                    prefix,
+		                                    match_tag ?: "",
 		                                    listen_address_s);
 	}
 
 	if ((n = nm_ip4_config_get_num_nameservers (ip4_config))) {
 		nm_gstring_prepare (&s);
-		g_string_append (s, "--dhcp-option=option:dns-server");
+		g_string_append_printf (s, "%sdhcp-option=%soption:dns-server", prefix, match_tag ?: "");
 		for (i = 0; i < n; i++) {
 			g_string_append_c (s, ',');
 			g_string_append (s, _nm_utils_inet4_ntop (nm_ip4_config_get_nameserver (ip4_config, i), tmpaddr));
 		}
-		nm_strv_ptrarray_take_gstring (cmd, &s);
+		nm_strv_ptrarray_take_gstring (opts, &s);
 	}
 
 	if ((n = nm_ip4_config_get_num_searches (ip4_config))) {
 		nm_gstring_prepare (&s);
-		g_string_append (s, "--dhcp-option=option:domain-search");
+		g_string_append_printf (s, "%sdhcp-option=%soption:domain-search", prefix, match_tag ?: "");
 		for (i = 0; i < n; i++) {
 			g_string_append_c (s, ',');
 			g_string_append (s, nm_ip4_config_get_search (ip4_config, i));
 		}
-		nm_strv_ptrarray_take_gstring (cmd, &s);
+		nm_strv_ptrarray_take_gstring (opts, &s);
 	}
 
 	if (announce_android_metered) {
 		/* force option 43 to announce ANDROID_METERED. Do this, even if the client
 		 * did not ask for this option. See https://www.lorier.net/docs/android-metered.html */
-		nm_strv_ptrarray_add_string_dup (cmd, "--dhcp-option-force=43,ANDROID_METERED");
+		nm_strv_ptrarray_add_string_printf (opts,
+		                                    "%sdhcp-option-force=%s43,ANDROID_METERED",
+		                                    prefix,
+		                                    match_tag ?: "");
 	}
 
-	nm_strv_ptrarray_add_string_dup (cmd, "--dhcp-lease-max=50");
+	return TRUE;
+}
 
-	nm_strv_ptrarray_add_string_printf (cmd,
-	                                    "--dhcp-leasefile=%s/dnsmasq-%s.leases",
-	                                    NMSTATEDIR,
-	                                    iface);
+static GPtrArray *
+create_dm_cmd_line (const char *iface,
+                    const NMIP4Config *ip4_config,
+                    const char *pidfile,
+                    gboolean announce_android_metered,
+                    GError **error)
+{
+	gs_unref_ptrarray GPtrArray *cmd = NULL;
+	gs_free char *leasefile = NULL;
 
-	nm_strv_ptrarray_add_string_concat (cmd, "--pid-file=", pidfile);
+	cmd = _cmd_line_new ("/dev/null", error);
+	if (!cmd)
+		return NULL;
 
-	/* dnsmasq exits if the conf dir is not present */
-	if (g_file_test (CONFDIR, G_FILE_TEST_IS_DIR))
-		nm_strv_ptrarray_add_string_dup (cmd, "--conf-dir=" CONFDIR);
+	if (!_add_iface_options (cmd,
+	                         "--",
+	                         NULL,
+	                         ip4_config,
+	                         announce_android_metered,
+	                         error))
+		return NULL;
 
-	g_ptr_array_add (cmd, NULL);
+	nm_strv_ptrarray_add_string_dup (cmd, "--dhcp-lease-max=50");
+
+	leasefile = g_strdup_printf ("%s/dnsmasq-%s.leases", NMSTATEDIR, iface);
+	_cmd_line_finish (cmd, leasefile, pidfile);
 	return g_steal_pointer (&cmd);
 }
 
@@ -246,6 +355,333 @@ out:
 	g_free (contents);
 }
 
+static gboolean
+_spawn (GPtrArray *cmd, GPid *out_pid, GError **error)
+{
+	gs_free char *cmd_str = NULL;
+
+	_LOGD ("command line: %s", (cmd_str = g_strjoinv (" ", (char **) cmd->pdata)));
+
+	*out_pid = 0;
+	if (!g_spawn_async (NULL,
+	                    (char **) cmd->pdata,
+	                    NULL,
+	                    G_SPAWN_DO_NOT_REAP_CHILD,
+	                    nm_utils_setpgid,
+	                    NULL,
+	                    out_pid,
+	                    error))
+		return FALSE;
+
+	nm_assert (*out_pid > 0);
+
+	_LOGD ("dnsmasq started with pid %d", *out_pid);
+	return TRUE;
+}
+
+/*****************************************************************************/
+
+static gboolean
+_shared_mode_enabled (void)
+{
+	gs_free char *value = NULL;
+
+	value = nm_config_data_get_value (NM_CONFIG_GET_DATA,
+	                                  NM_CONFIG_KEYFILE_GROUP_MAIN,
+	                                  NM_CONFIG_KEYFILE_KEY_MAIN_SHARED_DNSMASQ,
+	                                  NM_CONFIG_GET_VALUE_STRIP | NM_CONFIG_GET_VALUE_NO_EMPTY);
+	return nm_streq0 (value, "single");
+}
+
+static void _shared_reconfigure (void);
+
+static void
+_shared_fail_all (void)
+{
+	gs_unref_ptrarray GPtrArray *managers = NULL;
+	NMDnsMasqManager *manager;
+	guint i;
+
+	/* Unregister all interfaces before notifying anybody, so that their
+	 * handlers don't restart the process for the remaining ones. */
+	managers = g_ptr_array_new_with_free_func (g_object_unref);
+	while ((manager = c_list_first_entry (&_shared.managers_lst_head, NMDnsMasqManager, _priv.shared_lst))) {
+		c_list_unlink (&manager->_priv.shared_lst);
+		nm_clear_g_free (&manager->_priv.shared_conf);
+		g_ptr_array_add (managers, g_object_ref (manager));
+	}
+
+	_shared_reconfigure ();
+
+	for (i = 0; i < managers->len; i++)
+		g_signal_emit (managers->pdata[i], signals[STATE_CHANGED], 0, NM_DNSMASQ_STATUS_DEAD);
+}
+
+static gboolean _shared_reconfigure_cb (gpointer user_data);
+
+static void
+_shared_watch_cb (GPid pid, int status, gpointer user_data)
+{
+	_log_exit_status (status);
+
+	_shared.pid = 0;
+	_shared.watch_id = 0;
+	nm_clear_g_free (&_shared.conf);
+
+	if (nm_utils_get_monotonic_timestamp_msec () - _shared.start_msec < SHARED_EARLY_EXIT_MSEC)
+		_shared.n_early_exits++;
+	else
+		_shared.n_early_exits = 0;
+
+	if (_shared.n_early_exits > SHARED_EARLY_EXITS_MAX) {
+		_LOGW ("shared dnsmasq keeps exiting, give up");
+		_shared.n_early_exits = 0;
+		_shared_fail_all ();
+		return;
+	}
+
+	/* the interfaces are still registered. Start a new process for them. */
+	_LOGI ("restarting shared dnsmasq for %u interfaces",
+	       (guint) c_list_length (&_shared.managers_lst_head));
+	if (!_shared.reconfigure_id)
+		_shared.reconfigure_id = g_idle_add (_shared_reconfigure_cb, NULL);
+}
+
+static void
+_shared_kill_cb (pid_t pid, gboolean success, int child_status, void *user_data)
+{
+	_shared.stopping = FALSE;
+	if (!c_list_is_empty (&_shared.managers_lst_head))
+		_shared_reconfigure ();
+}
+
+static void
+_shared_kill (void)
+{
+	nm_clear_g_source (&_shared.watch_id);
+	nm_clear_g_free (&_shared.conf);
+
+	if (_shared.pid) {
+		_shared.stopping = TRUE;
+		nm_utils_kill_child_async (_shared.pid, SIGTERM, LOGD_SHARING, "dnsmasq", 2000,
+		                           _shared_kill_cb, NULL);
+		_shared.pid = 0;
+	}
+}
+
+/**
+ * nm_dnsmasq_manager_shared_iface_conf:
+ * @iface: the interface name
+ * @ip4_config: the IPv4 configuration of the interface
+ * @announce_android_metered: whether to announce ANDROID_METERED
+ * @error: location for a #GError, or %NULL
+ *
+ * Returns: the lines of the shared configuration file that serve @iface.
+ *   The DHCP tag is derived from the interface name, so the result only
+ *   depends on the arguments.
+ */
+char *
+nm_dnsmasq_manager_shared_iface_conf (const char *iface,
+                                      const NMIP4Config *ip4_config,
+                                      gboolean announce_android_metered,
+                                      GError **error)
+{
+	gs_unref_ptrarray GPtrArray *opts = NULL;
+	nm_auto_free_gstring GString *tag = NULL;
+	const char *c;
+
+	g_return_val_if_fail (iface && iface[0], NULL);
+
+	/* dnsmasq tags cannot contain ',', and interface names can. Escape
+	 * everything but alphanumeric characters, so that different interfaces
+	 * always get different tags. */
+	tag = g_string_new ("nm-");
+	for (c = iface; *c; c++) {
+		if (g_ascii_isalnum (*c))
+			g_string_append_c (tag, *c);
+		else
+			g_string_append_printf (tag, "_%02x", (guint) ((guchar) *c));
+	}
+
+	opts = g_ptr_array_new_with_free_func (g_free);
+	if (!_add_iface_options (opts,
+	                         "",
+	                         tag->str,
+	                         ip4_config,
+	                         announce_android_metered,
+	                         error))
+		return NULL;
+	g_ptr_array_add (opts, NULL);
+
+	return g_strjoinv ("\n", (char **) opts->pdata);
+}
+
+/**
+ * nm_dnsmasq_manager_shared_conf_generate:
+ * @iface_confs: the per-interface configurations, as returned by
+ *   nm_dnsmasq_manager_shared_iface_conf()
+ * @len: the number of entries in @iface_confs
+ *
+ * Returns: the content of the configuration file of the shared dnsmasq.
+ */
+char *
+nm_dnsmasq_manager_shared_conf_generate (const char *const *iface_confs,
+                                         gsize len)
+{
+	nm_auto_free_gstring GString *s = NULL;
+	gsize i;
+
+	s = g_string_new ("# Generated by NetworkManager\n");
+
+	for (i = 0; i < len; i++) {
+		g_string_append (s, iface_confs[i]);
+		g_string_append_c (s, '\n');
+	}
+
+	g_string_append_printf (s, "dhcp-lease-max=%u\n", (guint) (50u * len));
+
+	return g_string_free (g_steal_pointer (&s), FALSE);
+}
+
+static char *
+_shared_conf_generate (void)
+{
+	gs_free const char **iface_confs = NULL;
+	NMDnsMasqManager *manager;
+	gsize n = 0;
+
+	iface_confs = g_new (const char *, c_list_length (&_shared.managers_lst_head) + 1);
+	c_list_for_each_entry (manager, &_shared.managers_lst_head, _priv.shared_lst)
+		iface_confs[n++] = NM_DNSMASQ_MANAGER_GET_PRIVATE (manager)->shared_conf;
+
+	return nm_dnsmasq_manager_shared_conf_generate (iface_confs, n);
+}
+
+static void
+_shared_reconfigure (void)
+{
+	gs_unref_ptrarray GPtrArray *cmd = NULL;
+	gs_free_error GError *error = NULL;
+	gs_free char *conf = NULL;
+
+	nm_clear_g_source (&_shared.reconfigure_id);
+
+	if (c_list_is_empty (&_shared.managers_lst_head)) {
+		if (_shared.pid) {
+			_LOGI ("stopping shared dnsmasq");
+			_shared_kill ();
+		}
+		unlink (SHARED_PID_FILE);
+		unlink (SHARED_CONF_FILE);
+		return;
+	}
+
+	if (_shared.stopping) {
+		/* _shared_kill_cb() continues once the old process is gone. */
+		return;
+	}
+
+	conf = _shared_conf_generate ();
+
+	if (_shared.pid) {
+		if (nm_streq0 (conf, _shared.conf))
+			return;
+
+		/* dnsmasq only re-reads hosts and lease related files on SIGHUP.
+		 * Listen addresses and DHCP ranges require a restart. The leases
+		 * are kept in the lease file, so clients are not affected. */
+		_LOGI ("restarting shared dnsmasq for %u interfaces",
+		       (guint) c_list_length (&_shared.managers_lst_head));
+		_shared_kill ();
+		return;
+	}
+
+	kill_existing_by_pidfile (SHARED_PID_FILE);
+
+	if (!nm_utils_file_set_contents (SHARED_CONF_FILE, conf, -1, 0600, NULL, &error)) {
+		_LOGW ("failed to write shared dnsmasq configuration: %s", error->message);
+		_shared_fail_all ();
+		return;
+	}
+
+	cmd = _cmd_line_new (SHARED_CONF_FILE, &error);
+	if (!cmd) {
+		_LOGW ("failed to start shared dnsmasq: %s", error->message);
+		_shared_fail_all ();
+		return;
+	}
+	_cmd_line_finish (cmd, SHARED_LEASE_FILE, SHARED_PID_FILE);
+
+	_LOGI ("starting shared dnsmasq for %u interfaces...",
+	       (guint) c_list_length (&_shared.managers_lst_head));
+
+	if (!_spawn (cmd, &_shared.pid, &error)) {
+		_LOGW ("failed to start shared dnsmasq: %s", error->message);
+		_shared_fail_all ();
+		return;
+	}
+
+	_shared.conf = g_steal_pointer (&conf);
+	_shared.start_msec = nm_utils_get_monotonic_timestamp_msec ();
+	_shared.watch_id = g_child_watch_add (_shared.pid, (GChildWatchFunc) _shared_watch_cb, NULL);
+}
+
+static gboolean
+_shared_reconfigure_cb (gpointer user_data)
+{
+	_shared.reconfigure_id = 0;
+	_shared_reconfigure ();
+	return G_SOURCE_REMOVE;
+}
+
+static gboolean
+_shared_register (NMDnsMasqManager *manager,
+                  NMIP4Config *ip4_config,
+                  gboolean announce_android_metered,
+                  GError **error)
+{
+	NMDnsMasqManagerPrivate *priv = NM_DNSMASQ_MANAGER_GET_PRIVATE (manager);
+
+	if (!nm_utils_find_helper ("dnsmasq", DNSMASQ_PATH, error))
+		return FALSE;
+
+	priv->shared_conf = nm_dnsmasq_manager_shared_iface_conf (priv->iface,
+	                                                          ip4_config,
+	                                                          announce_android_metered,
+	                                                          error);
+	if (!priv->shared_conf)
+		return FALSE;
+	c_list_link_tail (&_shared.managers_lst_head, &priv->shared_lst);
+
+	_LOGI ("serving %s from the shared dnsmasq", priv->iface);
+
+	/* coalesce devices that start sharing at the same time into one
+	 * (re)start of the process. */
+	if (!_shared.reconfigure_id)
+		_shared.reconfigure_id = g_idle_add (_shared_reconfigure_cb, NULL);
+	return TRUE;
+}
+
+static void
+_shared_unregister (NMDnsMasqManager *manager)
+{
+	NMDnsMasqManagerPrivate *priv = NM_DNSMASQ_MANAGER_GET_PRIVATE (manager);
+
+	if (c_list_is_empty (&priv->shared_lst))
+		return;
+
+	c_list_unlink (&priv->shared_lst);
+	nm_clear_g_free (&priv->shared_conf);
+
+	if (c_list_is_empty (&_shared.managers_lst_head)) {
+		/* stop right away, we might be shutting down. */
+		_shared_reconfigure ();
+	} else if (!_shared.reconfigure_id)
+		_shared.reconfigure_id = g_idle_add (_shared_reconfigure_cb, NULL);
+}
+
+/*****************************************************************************/
+
 gboolean
 nm_dnsmasq_manager_start (NMDnsMasqManager *manager,
                           NMIP4Config *ip4_config,
@@ -254,7 +690,6 @@ nm_dnsmasq_manager_start (NMDnsMasqManager *manager,
 {
 	NMDnsMasqManagerPrivate *priv;
 	gs_unref_ptrarray GPtrArray *dm_cmd = NULL;
-	gs_free char *cmd_str = NULL;
 
 	g_return_val_if_fail (NM_IS_DNSMASQ_MANAGER (manager), FALSE);
 	g_return_val_if_fail (!error || !*error, FALSE);
@@ -262,6 +697,11 @@ nm_dnsmasq_manager_start (NMDnsMasqManager *manager,
 
 	priv = NM_DNSMASQ_MANAGER_GET_PRIVATE (manager);
 
+	_shared_unregister (manager);
+
+	if (_shared_mode_enabled ())
+		return _shared_register (manager, ip4_config, announce_android_metered, error);
+
 	kill_existing_by_pidfile (priv->pidfile);
 
 	dm_cmd = create_dm_cmd_line (priv->iface,
@@ -273,23 +713,10 @@ nm_dnsmasq_manager_start (NMDnsMasqManager *manager,
 		return FALSE;
 
 	_LOGI ("starting dnsmasq...");
-	_LOGD ("command line: %s", (cmd_str = g_strjoinv (" ", (char **) dm_cmd->pdata)));
 
-	priv->pid = 0;
-	if (!g_spawn_async (NULL,
-	                    (char **) dm_cmd->pdata,
-	                    NULL,
-	                    G_SPAWN_DO_NOT_REAP_CHILD,
-	                    nm_utils_setpgid,
-	                    NULL,
-	                    &priv->pid,
-	                    error))
+	if (!_spawn (dm_cmd, &priv->pid, error))
 		return FALSE;
 
-	nm_assert (priv->pid > 0);
-
-	_LOGD ("dnsmasq started with pid %d", priv->pid);
-
 	priv->dm_watch_id = g_child_watch_add (priv->pid, (GChildWatchFunc) dm_watch_cb, manager);
 
 	return TRUE;
@@ -304,6 +731,8 @@ nm_dnsmasq_manager_stop (NMDnsMasqManager *manager)
 
 	priv = NM_DNSMASQ_MANAGER_GET_PRIVATE (manager);
 
+	_shared_unregister (manager);
+
 	nm_clear_g_source (&priv->dm_watch_id);
 
 	if (priv->pid) {
@@ -319,6 +748,9 @@ nm_dnsmasq_manager_stop (NMDnsMasqManager *manager)
 static void
 nm_dnsmasq_manager_init (NMDnsMasqManager *manager)
 {
+	NMDnsMasqManagerPrivate *priv = NM_DNSMASQ_MANAGER_GET_PRIVATE (manager);
+
+	c_list_init (&priv->shared_lst);
 }
 
 NMDnsMasqManager *
@@ -38,4 +38,12 @@ gboolean nm_dnsmasq_manager_start (NMDnsMasqManager *manager,
 
 void     nm_dnsmasq_manager_stop  (NMDnsMasqManager *manager);
 
+char *nm_dnsmasq_manager_shared_iface_conf (const char *iface,
+                                            const NMIP4Config *ip4_config,
+                                            gboolean announce_android_metered,
+                                            GError **error);
+
+char *nm_dnsmasq_manager_shared_conf_generate (const char *const *iface_confs,
+                                               gsize len);
+
 #endif /* __NETWORKMANAGER_DNSMASQ_MANAGER_H__ */
@@ -8,6 +8,7 @@
 #include <arpa/inet.h>
 
 #include "dnsmasq/nm-dnsmasq-utils.h"
+#include "dnsmasq/nm-dnsmasq-manager.h"
 
 #include "nm-test-utils-core.h"
 
@@ -150,6 +151,71 @@ test_address_ranges (void)
 
 /*****************************************************************************/
 
+static NMIP4Config *
+_shared_ip4_config_new (const char *address, const char *nameserver)
+{
+	NMIP4Config *config;
+	NMPlatformIP4Address addr;
+
+	config = nmtst_ip4_config_new (1);
+
+	addr = *nmtst_platform_ip4_address (address, NULL, 24);
+	nm_ip4_config_add_address (config, &addr);
+
+	if (nameserver)
+		nm_ip4_config_add_nameserver (config, nmtst_inet4_from_string (nameserver));
+
+	return config;
+}
+
+static void
+test_shared_conf (void)
+{
+	gs_unref_object NMIP4Config *config1 = NULL;
+	gs_unref_object NMIP4Config *config2 = NULL;
+	gs_free char *conf1 = NULL;
+	gs_free char *conf1b = NULL;
+	gs_free char *conf2 = NULL;
+	gs_free char *conf = NULL;
+	const char *iface_confs[2];
+
+	config1 = _shared_ip4_config_new ("10.42.0.1", "10.42.0.1");
+	config2 = _shared_ip4_config_new ("10.43.0.1", NULL);
+
+	conf1 = nm_dnsmasq_manager_shared_iface_conf ("eth0", config1, FALSE, NULL);
+	g_assert_cmpstr (conf1, ==,
+	                 "listen-address=10.42.0.1\n"
+	                 "dhcp-range=set:nm-eth0,10.42.0.10,10.42.0.254,60m\n"
+	                 "dhcp-option=tag:nm-eth0,option:dns-server,10.42.0.1");
+
+	/* the configuration only depends on the arguments. Registering the
+	 * same interface again must not change the generated file. */
+	conf1b = nm_dnsmasq_manager_shared_iface_conf ("eth0", config1, FALSE, NULL);
+	g_assert_cmpstr (conf1, ==, conf1b);
+
+	/* characters that are not allowed in tags get escaped. */
+	conf2 = nm_dnsmasq_manager_shared_iface_conf ("eth,1", config2, TRUE, NULL);
+	g_assert_cmpstr (conf2, ==,
+	                 "listen-address=10.43.0.1\n"
+	                 "dhcp-range=set:nm-eth_2c1,10.43.0.10,10.43.0.254,60m\n"
+	                 "dhcp-option-force=tag:nm-eth_2c1,43,ANDROID_METERED");
+
+	iface_confs[0] = conf1;
+	iface_confs[1] = conf2;
+	conf = nm_dnsmasq_manager_shared_conf_generate (iface_confs, 2);
+	g_assert_cmpstr (conf, ==,
+	                 "# Generated by NetworkManager\n"
+	                 "listen-address=10.42.0.1\n"
+	                 "dhcp-range=set:nm-eth0,10.42.0.10,10.42.0.254,60m\n"
+	                 "dhcp-option=tag:nm-eth0,option:dns-server,10.42.0.1\n"
+	                 "listen-address=10.43.0.1\n"
+	                 "dhcp-range=set:nm-eth_2c1,10.43.0.10,10.43.0.254,60m\n"
+	                 "dhcp-option-force=tag:nm-eth_2c1,43,ANDROID_METERED\n"
+	                 "dhcp-lease-max=100\n");
+}
+
+/*****************************************************************************/
+
 NMTST_DEFINE ();
 
 int
@@ -158,6 +224,7 @@ main (int argc, char **argv)
 	nmtst_init_assert_logging (&argc, &argv, "INFO", "DEFAULT");
 
 	g_test_add_func ("/dnsmasq/address-ranges", test_address_ranges);
+	g_test_add_func ("/dnsmasq/shared-conf", test_shared_conf);
 
 	return g_test_run ();
 }
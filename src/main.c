@@ -32,6 +32,7 @@
 #include "nm-core-internal.h"
 #include "nm-dbus-object.h"
 #include "nm-connectivity.h"
+#include "nm-firewall-utils.h"
 #include "dns/nm-dns-manager.h"
 #include "systemd/nm-sd.h"
 #include "nm-netns.h"
@@ -466,6 +467,9 @@ done:
 
 	nm_manager_stop (manager);
 
+	/* the share rules of stopped devices are removed asynchronously. */
+	nm_firewall_share_rules_flush ();
+
 	nm_config_state_set (config, TRUE, TRUE);
 
 	nm_dns_manager_stop (nm_dns_manager_get ());
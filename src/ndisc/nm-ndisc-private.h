@@ -17,6 +17,20 @@ struct _NMNDiscDataInternal {
 	GArray *routes;
 	GArray *dns_servers;
 	GArray *dns_domains;
+
+	/* Gateways and routes are stored in hash tables, keyed by address
+	 * and by (network, plen) respectively. The arrays above are their
+	 * priority-ordered views, which get rebuilt when dirty. */
+	GHashTable *gateways_idx;
+	GHashTable *routes_idx;
+	guint64 idx_seq;
+
+	/* a lower bound for the earliest expiry in the indexes. */
+	gint64 gateways_expiry_min;
+	gint64 routes_expiry_min;
+
+	bool gateways_dirty:1;
+	bool routes_dirty:1;
 };
 
 typedef struct _NMNDiscDataInternal NMNDiscDataInternal;
@@ -269,9 +269,122 @@ _ASSERT_data_gateways (const NMNDiscDataInternal *data)
 
 /*****************************************************************************/
 
+typedef struct {
+	/* this *must* be the first field, it is the key of the index. */
+	NMNDiscGateway gateway;
+	guint64 seq;
+} GatewayEntry;
+
+typedef struct {
+	/* this *must* be the first field, it is the key of the index. */
+	NMNDiscRoute route;
+	guint64 seq;
+} RouteEntry;
+
+static guint
+_gateway_entry_hash (gconstpointer ptr)
+{
+	const NMNDiscGateway *gateway = ptr;
+	NMHashState h;
+
+	nm_hash_init (&h, 1848410663u);
+	nm_hash_update_valp (&h, &gateway->address);
+	return nm_hash_complete (&h);
+}
+
+static gboolean
+_gateway_entry_equal (gconstpointer a, gconstpointer b)
+{
+	return IN6_ARE_ADDR_EQUAL (&((const NMNDiscGateway *) a)->address,
+	                           &((const NMNDiscGateway *) b)->address);
+}
+
+static guint
+_route_entry_hash (gconstpointer ptr)
+{
+	const NMNDiscRoute *route = ptr;
+	NMHashState h;
+
+	nm_hash_init (&h, 2093150157u);
+	nm_hash_update_valp (&h, &route->network);
+	nm_hash_update_val (&h, route->plen);
+	return nm_hash_complete (&h);
+}
+
+static gboolean
+_route_entry_equal (gconstpointer a, gconstpointer b)
+{
+	const NMNDiscRoute *route_a = a;
+	const NMNDiscRoute *route_b = b;
+
+	return    route_a->plen == route_b->plen
+	       && IN6_ARE_ADDR_EQUAL (&route_a->network, &route_b->network);
+}
+
+static int
+_gateway_entry_cmp (gconstpointer pa, gconstpointer pb, gpointer user_data)
+{
+	const GatewayEntry *a = *((const GatewayEntry *const*) pa);
+	const GatewayEntry *b = *((const GatewayEntry *const*) pb);
+
+	/* more preferable gateways first, otherwise in the order they were added. */
+	NM_CMP_DIRECT (_preference_to_priority (b->gateway.preference),
+	               _preference_to_priority (a->gateway.preference));
+	NM_CMP_FIELD (a, b, seq);
+	return 0;
+}
+
+static int
+_route_entry_cmp (gconstpointer pa, gconstpointer pb, gpointer user_data)
+{
+	const RouteEntry *a = *((const RouteEntry *const*) pa);
+	const RouteEntry *b = *((const RouteEntry *const*) pb);
+
+	/* more preferable routes first, otherwise the most recently added first. */
+	NM_CMP_DIRECT (_preference_to_priority (b->route.preference),
+	               _preference_to_priority (a->route.preference));
+	NM_CMP_FIELD (b, a, seq);
+	return 0;
+}
+
+static void
+_data_sync_view (GHashTable *idx, GArray *view, GCompareDataFunc cmp)
+{
+	gs_free gpointer *entries = NULL;
+	guint i, n;
+
+	g_array_set_size (view, 0);
+
+	entries = g_hash_table_get_keys_as_array (idx, &n);
+	if (n == 0)
+		return;
+
+	g_qsort_with_data (entries, n, sizeof (gpointer), cmp, NULL);
+
+	/* the public data is the first field of the entry. */
+	for (i = 0; i < n; i++)
+		g_array_append_vals (view, entries[i], 1);
+}
+
+static void
+_data_sync (NMNDiscDataInternal *data)
+{
+	if (data->gateways_dirty) {
+		data->gateways_dirty = FALSE;
+		_data_sync_view (data->gateways_idx, data->gateways, _gateway_entry_cmp);
+	}
+	if (data->routes_dirty) {
+		data->routes_dirty = FALSE;
+		_data_sync_view (data->routes_idx, data->routes, _route_entry_cmp);
+	}
+}
+
+/*****************************************************************************/
+
 static const NMNDiscData *
 _data_complete (NMNDiscDataInternal *data)
 {
+	_data_sync (data);
 	_ASSERT_data_gateways (data);
 
 #define _SET(data, field) \
@@ -293,6 +406,7 @@ _data_complete (NMNDiscDataInternal *data)
 void
 nm_ndisc_emit_config_change (NMNDisc *self, NMNDiscConfigMap changed)
 {
+	_data_sync (&NM_NDISC_GET_PRIVATE (self)->rdata);
 	_config_changed_log (self, changed);
 	g_signal_emit (self, signals[CONFIG_RECEIVED], 0,
 	               _data_complete (&NM_NDISC_GET_PRIVATE (self)->rdata),
@@ -305,49 +419,36 @@ gboolean
 nm_ndisc_add_gateway (NMNDisc *ndisc, const NMNDiscGateway *new)
 {
 	NMNDiscDataInternal *rdata = &NM_NDISC_GET_PRIVATE(ndisc)->rdata;
-	guint i;
-	guint insert_idx = G_MAXUINT;
-
-	for (i = 0; i < rdata->gateways->len; ) {
-		NMNDiscGateway *item = &g_array_index (rdata->gateways, NMNDiscGateway, i);
+	GatewayEntry *entry;
 
-		if (IN6_ARE_ADDR_EQUAL (&item->address, &new->address)) {
-			if (new->lifetime == 0) {
-				g_array_remove_index (rdata->gateways, i);
-				_ASSERT_data_gateways (rdata);
-				return TRUE;
-			}
-
-			if (item->preference != new->preference) {
-				g_array_remove_index (rdata->gateways, i);
-				continue;
-			}
-
-			if (get_expiry (item) == get_expiry (new))
-				return FALSE;
-
-			*item = *new;
-			_ASSERT_data_gateways (rdata);
+	entry = g_hash_table_lookup (rdata->gateways_idx, new);
+	if (entry) {
+		if (new->lifetime == 0) {
+			g_hash_table_remove (rdata->gateways_idx, entry);
+			rdata->gateways_dirty = TRUE;
 			return TRUE;
 		}
 
-		/* Put before less preferable gateways. */
-		if (   _preference_to_priority (item->preference) < _preference_to_priority (new->preference)
-		    && insert_idx == G_MAXUINT)
-			insert_idx = i;
+		if (entry->gateway.preference != new->preference) {
+			/* move it behind the other gateways of the new preference. */
+			entry->seq = ++rdata->idx_seq;
+		} else if (get_expiry (&entry->gateway) == get_expiry (new))
+			return FALSE;
 
-		i++;
-	}
+		entry->gateway = *new;
+	} else {
+		if (!new->lifetime)
+			return FALSE;
 
-	if (new->lifetime) {
-		g_array_insert_val (rdata->gateways,
-		                    insert_idx == G_MAXUINT
-		                      ? rdata->gateways->len
-		                      : insert_idx,
-		                    *new);
+		entry = g_slice_new (GatewayEntry);
+		entry->gateway = *new;
+		entry->seq = ++rdata->idx_seq;
+		g_hash_table_add (rdata->gateways_idx, entry);
 	}
-	_ASSERT_data_gateways (rdata);
-	return !!new->lifetime;
+
+	rdata->gateways_expiry_min = MIN (rdata->gateways_expiry_min, get_expiry (new));
+	rdata->gateways_dirty = TRUE;
+	return TRUE;
 }
 
 /**
@@ -538,8 +639,7 @@ nm_ndisc_add_route (NMNDisc *ndisc, const NMNDiscRoute *new)
 {
 	NMNDiscPrivate *priv;
 	NMNDiscDataInternal *rdata;
-	guint i;
-	guint insert_idx = G_MAXUINT;
+	RouteEntry *entry;
 
 	if (new->plen == 0 || new->plen > 128) {
 		/* Only expect non-default routes.  The router has no idea what the
@@ -555,45 +655,35 @@ nm_ndisc_add_route (NMNDisc *ndisc, const NMNDiscRoute *new)
 	priv = NM_NDISC_GET_PRIVATE (ndisc);
 	rdata = &priv->rdata;
 
-	for (i = 0; i < rdata->routes->len; ) {
-		NMNDiscRoute *item = &g_array_index (rdata->routes, NMNDiscRoute, i);
-
-		if (   IN6_ARE_ADDR_EQUAL (&item->network, &new->network)
-		    && item->plen == new->plen) {
-			if (new->lifetime == 0) {
-				g_array_remove_index (rdata->routes, i);
-				return TRUE;
-			}
-
-			if (item->preference != new->preference) {
-				g_array_remove_index (rdata->routes, i);
-				continue;
-			}
-
-			if (   get_expiry (item) == get_expiry (new)
-			    && IN6_ARE_ADDR_EQUAL (&item->gateway, &new->gateway))
-				return FALSE;
-
-			*item = *new;
+	entry = g_hash_table_lookup (rdata->routes_idx, new);
+	if (entry) {
+		if (new->lifetime == 0) {
+			g_hash_table_remove (rdata->routes_idx, entry);
+			rdata->routes_dirty = TRUE;
 			return TRUE;
 		}
 
-		/* Put before less preferable routes. */
-		if (   _preference_to_priority (item->preference) < _preference_to_priority (new->preference)
-		    && insert_idx == G_MAXUINT)
-			insert_idx = i;
+		if (entry->route.preference != new->preference) {
+			/* move it in front of the other routes of the new preference. */
+			entry->seq = ++rdata->idx_seq;
+		} else if (   get_expiry (&entry->route) == get_expiry (new)
+		           && IN6_ARE_ADDR_EQUAL (&entry->route.gateway, &new->gateway))
+			return FALSE;
+
+		entry->route = *new;
+	} else {
+		if (!new->lifetime)
+			return FALSE;
 
-		i++;
+		entry = g_slice_new (RouteEntry);
+		entry->route = *new;
+		entry->seq = ++rdata->idx_seq;
+		g_hash_table_add (rdata->routes_idx, entry);
 	}
 
-	if (new->lifetime) {
-		g_array_insert_val (rdata->routes,
-		                    insert_idx == G_MAXUINT
-		                      ? 0u
-		                      : insert_idx,
-		                    *new);
-	}
-	return !!new->lifetime;
+	rdata->routes_expiry_min = MIN (rdata->routes_expiry_min, get_expiry (new));
+	rdata->routes_dirty = TRUE;
+	return TRUE;
 }
 
 gboolean
@@ -1091,23 +1181,27 @@ static void
 clean_gateways (NMNDisc *ndisc, gint32 now, NMNDiscConfigMap *changed, gint32 *nextevent)
 {
 	NMNDiscDataInternal *rdata;
-	guint i;
+	GHashTableIter iter;
+	GatewayEntry *entry;
+	gint64 expiry_min = _EXPIRY_INFINITY;
 
 	rdata = &NM_NDISC_GET_PRIVATE (ndisc)->rdata;
 
-	for (i = 0; i < rdata->gateways->len; ) {
-		NMNDiscGateway *item = &g_array_index (rdata->gateways, NMNDiscGateway, i);
+	/* nothing can have expired yet. */
+	if (expiry_next (now, rdata->gateways_expiry_min, nextevent))
+		return;
 
-		if (!expiry_next (now, get_expiry (item), nextevent)) {
-			g_array_remove_index (rdata->gateways, i);
+	g_hash_table_iter_init (&iter, rdata->gateways_idx);
+	while (g_hash_table_iter_next (&iter, (gpointer *) &entry, NULL)) {
+		if (!expiry_next (now, get_expiry (&entry->gateway), nextevent)) {
+			g_hash_table_iter_remove (&iter);
+			rdata->gateways_dirty = TRUE;
 			*changed |= NM_NDISC_CONFIG_GATEWAYS;
 			continue;
 		}
-
-		i++;
+		expiry_min = MIN (expiry_min, get_expiry (&entry->gateway));
 	}
-
-	_ASSERT_data_gateways (rdata);
+	rdata->gateways_expiry_min = expiry_min;
 }
 
 static void
@@ -1135,21 +1229,27 @@ static void
 clean_routes (NMNDisc *ndisc, gint32 now, NMNDiscConfigMap *changed, gint32 *nextevent)
 {
 	NMNDiscDataInternal *rdata;
-	guint i;
+	GHashTableIter iter;
+	RouteEntry *entry;
+	gint64 expiry_min = _EXPIRY_INFINITY;
 
 	rdata = &NM_NDISC_GET_PRIVATE (ndisc)->rdata;
 
-	for (i = 0; i < rdata->routes->len; ) {
-		NMNDiscRoute *item = &g_array_index (rdata->routes, NMNDiscRoute, i);
+	/* nothing can have expired yet. */
+	if (expiry_next (now, rdata->routes_expiry_min, nextevent))
+		return;
 
-		if (!expiry_next (now, get_expiry (item), nextevent)) {
-			g_array_remove_index (rdata->routes, i);
+	g_hash_table_iter_init (&iter, rdata->routes_idx);
+	while (g_hash_table_iter_next (&iter, (gpointer *) &entry, NULL)) {
+		if (!expiry_next (now, get_expiry (&entry->route), nextevent)) {
+			g_hash_table_iter_remove (&iter);
+			rdata->routes_dirty = TRUE;
 			*changed |= NM_NDISC_CONFIG_ROUTES;
 			continue;
 		}
-
-		i++;
+		expiry_min = MIN (expiry_min, get_expiry (&entry->route));
 	}
+	rdata->routes_expiry_min = expiry_min;
 }
 
 static void
@@ -1277,6 +1377,18 @@ dns_domain_free (gpointer data)
 	g_free (((NMNDiscDNSDomain *)(data))->domain);
 }
 
+static void
+gateway_entry_free (gpointer data)
+{
+	g_slice_free (GatewayEntry, data);
+}
+
+static void
+route_entry_free (gpointer data)
+{
+	g_slice_free (RouteEntry, data);
+}
+
 static void
 set_property (GObject *object, guint prop_id,
               const GValue *value, GParamSpec *pspec)
@@ -1367,6 +1479,10 @@ nm_ndisc_init (NMNDisc *ndisc)
 	rdata->dns_servers = g_array_new (FALSE, FALSE, sizeof (NMNDiscDNSServer));
 	rdata->dns_domains = g_array_new (FALSE, FALSE, sizeof (NMNDiscDNSDomain));
 	g_array_set_clear_func (rdata->dns_domains, dns_domain_free);
+	rdata->gateways_idx = g_hash_table_new_full (_gateway_entry_hash, _gateway_entry_equal, gateway_entry_free, NULL);
+	rdata->routes_idx = g_hash_table_new_full (_route_entry_hash, _route_entry_equal, route_entry_free, NULL);
+	rdata->gateways_expiry_min = _EXPIRY_INFINITY;
+	rdata->routes_expiry_min = _EXPIRY_INFINITY;
 	priv->rdata.public.hop_limit = 64;
 
 	/* Start at very low number so that last_rs - router_solicitation_interval
@@ -1406,6 +1522,8 @@ finalize (GObject *object)
 	g_array_unref (rdata->routes);
 	g_array_unref (rdata->dns_servers);
 	g_array_unref (rdata->dns_domains);
+	g_hash_table_unref (rdata->gateways_idx);
+	g_hash_table_unref (rdata->routes_idx);
 
 	g_clear_object (&priv->netns);
 	g_clear_object (&priv->platform);
@@ -9,8 +9,6 @@
 #include "nm-act-request.h"
 
 #include <stdlib.h>
-#include <sys/wait.h>
-#include <unistd.h>
 
 #include "c-list/src/c-list.h"
 
@@ -270,59 +268,55 @@ clear_share_rules (NMActRequest *req)
 	priv->share_rules = NULL;
 }
 
-void
-nm_act_request_set_shared (NMActRequest *req, gboolean shared)
+/**
+ * nm_act_request_set_shared:
+ * @req: the #NMActRequest
+ * @shared: whether to insert or to remove the share rules
+ * @callback: (allow-none): invoked once the rules are applied
+ * @user_data: the user data for @callback
+ *
+ * Returns: the call id for nm_firewall_share_rules_cancel(), or %NULL
+ *   if there is no @callback.
+ */
+NMFirewallShareCallId *
+nm_act_request_set_shared (NMActRequest *req,
+                           gboolean shared,
+                           NMFirewallShareCallback callback,
+                           gpointer user_data)
 {
 	NMActRequestPrivate *priv = NM_ACT_REQUEST_GET_PRIVATE (req);
-	GSList *list, *iter;
+	gs_free NMFirewallShareRule *rules = NULL;
+	NMFirewallShareCallId *call_id;
+	GSList *iter;
+	guint n_rules;
+	guint i;
 
-	g_return_if_fail (NM_IS_ACT_REQUEST (req));
+	g_return_val_if_fail (NM_IS_ACT_REQUEST (req), NULL);
 
 	NM_ACT_REQUEST_GET_PRIVATE (req)->shared = shared;
 
-	/* Tear the rules down in reverse order when sharing is stopped */
-	list = g_slist_copy (priv->share_rules);
-	if (!shared)
-		list = g_slist_reverse (list);
+	n_rules = g_slist_length (priv->share_rules);
+	rules = g_new (NMFirewallShareRule, NM_MAX (n_rules, 1u));
 
-	/* Send the rules to iptables */
-	for (iter = list; iter; iter = g_slist_next (iter)) {
+	/* Tear the rules down in reverse order when sharing is stopped */
+	for (iter = priv->share_rules, i = 0; iter; iter = g_slist_next (iter), i++) {
 		ShareRule *rule = (ShareRule *) iter->data;
-		char *envp[1] = { NULL };
-		gs_strfreev char **argv = NULL;
-		gs_free char *cmd = NULL;
-
-		cmd = g_strdup_printf ("%s --table %s %s %s",
-		                       IPTABLES_PATH,
-		                       rule->table,
-		                       shared ? "--insert" : "--delete",
-		                       rule->rule);
-		if (!cmd)
-			continue;
-
-		argv = g_strsplit (cmd, " ", 0);
-		if (argv && argv[0]) {
-			int status;
-			GError *error = NULL;
-
-			nm_log_info (LOGD_SHARING, "Executing: %s", cmd);
-			if (!g_spawn_sync ("/", argv, envp, G_SPAWN_STDOUT_TO_DEV_NULL | G_SPAWN_STDERR_TO_DEV_NULL,
-			                   NULL, NULL, NULL, NULL, &status, &error)) {
-				nm_log_warn (LOGD_SHARING, "Error executing command: %s",
-				             error->message);
-				g_clear_error (&error);
-			} else if (WEXITSTATUS (status)) {
-				nm_log_warn (LOGD_SHARING, "** Command returned exit status %d.",
-				             WEXITSTATUS (status));
-			}
-		}
+
+		rules[shared ? i : n_rules - i - 1] = (NMFirewallShareRule) {
+			.table = rule->table,
+			.rule  = rule->rule,
+		};
 	}
 
-	g_slist_free (list);
+	/* Send the rules to iptables. The rules get copied, so the list
+	 * can be cleared right away. */
+	call_id = nm_firewall_share_rules_apply (rules, n_rules, shared, callback, user_data);
 
 	/* Clear the share rule list when sharing is stopped */
 	if (!shared)
 		clear_share_rules (req);
+
+	return call_id;
 }
 
 gboolean
@@ -569,7 +563,7 @@ dispose (GObject *object)
 
 	/* Clear any share rules */
 	if (priv->share_rules) {
-		nm_act_request_set_shared (NM_ACT_REQUEST (object), FALSE);
+		nm_act_request_set_shared (NM_ACT_REQUEST (object), FALSE, NULL, NULL);
 		clear_share_rules (NM_ACT_REQUEST (object));
 	}
 
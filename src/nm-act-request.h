@@ -8,6 +8,7 @@
 
 #include "nm-connection.h"
 #include "nm-active-connection.h"
+#include "nm-firewall-utils.h"
 
 #define NM_TYPE_ACT_REQUEST            (nm_act_request_get_type ())
 #define NM_ACT_REQUEST(obj)            (G_TYPE_CHECK_INSTANCE_CAST ((obj), NM_TYPE_ACT_REQUEST, NMActRequest))
@@ -36,7 +37,10 @@ NMConnection         *nm_act_request_get_applied_connection (NMActRequest *req);
 
 gboolean              nm_act_request_get_shared (NMActRequest *req);
 
-void                  nm_act_request_set_shared (NMActRequest *req, gboolean shared);
+NMFirewallShareCallId *nm_act_request_set_shared (NMActRequest *req,
+                                                  gboolean shared,
+                                                  NMFirewallShareCallback callback,
+                                                  gpointer user_data);
 
 void                  nm_act_request_add_share_rule (NMActRequest *req,
                                                      const char *table,
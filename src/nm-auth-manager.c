@@ -21,6 +21,12 @@
 #define CANCELLATION_ID_PREFIX "cancellation-id-"
 #define CANCELLATION_TIMEOUT_MS 5000
 
+/* How long a result from polkit is reused for the same subject and action.
+ * The cache is also flushed when polkit signals "Changed", and entries of
+ * a D-Bus client are dropped when its name goes away. */
+#define AUTH_CACHE_TTL_MSEC 5000
+#define AUTH_CACHE_MAX_SIZE 4096
+
 /*****************************************************************************/
 
 NM_GOBJECT_PROPERTIES_DEFINE_BASE (
@@ -38,8 +44,14 @@ typedef struct {
 	CList calls_lst_head;
 	GDBusConnection *dbus_connection;
 	GCancellable *shutdown_cancellable;
+	GHashTable *cache;
+	GHashTable *cache_senders;
 	guint64 call_numid_counter;
+	guint64 cache_generation;
+	guint64 cache_hits;
+	guint64 cache_misses;
 	guint changed_signal_id;
+	guint name_owner_changed_id;
 	bool disposing:1;
 	bool shutting_down:1;
 	NMAuthPolkitMode auth_polkit_mode:3;
@@ -116,11 +128,293 @@ struct _NMAuthManagerCallId {
 	GCancellable *dbus_cancellable;
 	NMAuthManagerCheckAuthorizationCallback callback;
 	gpointer user_data;
+	char *cache_key;
+	char *cache_sender;
 	guint64 call_numid;
+	guint64 cache_generation;
 	guint idle_id;
 	bool idle_is_authorized:1;
+	bool idle_is_challenge:1;
 };
 
+/*****************************************************************************/
+
+typedef struct {
+	char *sender;
+	NMAuthManager *self;
+	CList entries_lst_head;
+	guint name_owner_changed_id;
+} AuthCacheSender;
+
+typedef struct {
+	char *key;
+	AuthCacheSender *sender;
+	CList sender_lst;
+	gint64 expiry_msec;
+	bool is_authorized:1;
+	bool is_challenge:1;
+} AuthCacheEntry;
+
+static void
+_cache_entry_free (gpointer data)
+{
+	AuthCacheEntry *entry = data;
+
+	c_list_unlink_stale (&entry->sender_lst);
+	g_free (entry->key);
+	g_slice_free (AuthCacheEntry, entry);
+}
+
+static void
+_cache_sender_free (gpointer data)
+{
+	AuthCacheSender *cache_sender = data;
+
+	nm_assert (c_list_is_empty (&cache_sender->entries_lst_head));
+
+	nm_clear_g_dbus_connection_signal (NM_AUTH_MANAGER_GET_PRIVATE (cache_sender->self)->dbus_connection,
+	                                   &cache_sender->name_owner_changed_id);
+	g_free (cache_sender->sender);
+	g_slice_free (AuthCacheSender, cache_sender);
+}
+
+static void
+_cache_entry_remove (NMAuthManager *self,
+                     AuthCacheEntry *entry)
+{
+	NMAuthManagerPrivate *priv = NM_AUTH_MANAGER_GET_PRIVATE (self);
+	AuthCacheSender *cache_sender = entry->sender;
+
+	c_list_unlink (&entry->sender_lst);
+	if (   cache_sender
+	    && c_list_is_empty (&cache_sender->entries_lst_head))
+		g_hash_table_remove (priv->cache_senders, cache_sender);
+	g_hash_table_remove (priv->cache, entry);
+}
+
+static void
+_cache_flush (NMAuthManager *self,
+              const char *reason)
+{
+	NMAuthManagerPrivate *priv = NM_AUTH_MANAGER_GET_PRIVATE (self);
+
+	/* invalidate the results of pending requests too. */
+	priv->cache_generation++;
+
+	if (   !priv->cache
+	    || g_hash_table_size (priv->cache) == 0)
+		return;
+
+	_LOGT ("cache: flush %u entries (%s, hits=%"G_GUINT64_FORMAT", misses=%"G_GUINT64_FORMAT")",
+	       g_hash_table_size (priv->cache),
+	       reason,
+	       priv->cache_hits,
+	       priv->cache_misses);
+
+	g_hash_table_remove_all (priv->cache);
+	g_hash_table_remove_all (priv->cache_senders);
+}
+
+static guint
+_cache_drop_sender (NMAuthManager *self,
+                    const char *sender)
+{
+	NMAuthManagerPrivate *priv = NM_AUTH_MANAGER_GET_PRIVATE (self);
+	AuthCacheSender *cache_sender;
+	AuthCacheEntry *entry;
+	guint n = 0;
+
+	cache_sender = g_hash_table_lookup (priv->cache_senders, &sender);
+	if (!cache_sender)
+		return 0;
+
+	/* Take the sender out of the table first. Otherwise _cache_entry_remove()
+	 * would free it together with the last entry while we still iterate its
+	 * list. */
+	g_hash_table_steal (priv->cache_senders, cache_sender);
+
+	while ((entry = c_list_first_entry (&cache_sender->entries_lst_head, AuthCacheEntry, sender_lst))) {
+		c_list_unlink (&entry->sender_lst);
+		entry->sender = NULL;
+		g_hash_table_remove (priv->cache, entry);
+		n++;
+	}
+
+	_cache_sender_free (cache_sender);
+	return n;
+}
+
+static void
+_cache_sender_name_owner_changed_cb (GDBusConnection *connection,
+                                     const char *sender_name,
+                                     const char *object_path,
+                                     const char *interface_name,
+                                     const char *signal_name,
+                                     GVariant *parameters,
+                                     gpointer user_data)
+{
+	NMAuthManager *self = user_data;
+	const char *name;
+	const char *new_owner;
+	guint n;
+
+	if (!g_variant_is_of_type (parameters, G_VARIANT_TYPE ("(sss)")))
+		return;
+
+	g_variant_get (parameters, "(&s&s&s)", &name, NULL, &new_owner);
+
+	if (new_owner[0])
+		return;
+
+	n = _cache_drop_sender (self, name);
+	if (n > 0)
+		_LOGT ("cache: dropped %u entries for \"%s\" which left the bus", n, name);
+}
+
+static char *
+_cache_key_create (NMAuthSubject *subject,
+                   const char *action_id)
+{
+	char subject_buf[64];
+
+	nm_assert (nm_auth_subject_get_subject_type (subject) == NM_AUTH_SUBJECT_TYPE_UNIX_PROCESS);
+
+	/* the subject string contains pid, uid and the process start time. Together with
+	 * the D-Bus sender this identifies the process reliably. */
+	return g_strdup_printf ("%s|%s|%s",
+	                        nm_auth_subject_get_unix_process_dbus_sender (subject) ?: "",
+	                        nm_auth_subject_to_string (subject, subject_buf, sizeof (subject_buf)),
+	                        action_id);
+}
+
+static AuthCacheEntry *
+_cache_lookup (NMAuthManager *self,
+               const char *key)
+{
+	NMAuthManagerPrivate *priv = NM_AUTH_MANAGER_GET_PRIVATE (self);
+	AuthCacheEntry *entry;
+
+	entry = g_hash_table_lookup (priv->cache, &key);
+	if (!entry)
+		return NULL;
+
+	if (entry->expiry_msec <= nm_utils_get_monotonic_timestamp_msec ()) {
+		_cache_entry_remove (self, entry);
+		return NULL;
+	}
+
+	return entry;
+}
+
+static void
+_cache_add (NMAuthManager *self,
+            char *key_take,
+            const char *sender,
+            gboolean is_authorized,
+            gboolean is_challenge)
+{
+	NMAuthManagerPrivate *priv = NM_AUTH_MANAGER_GET_PRIVATE (self);
+	AuthCacheSender *cache_sender = NULL;
+	AuthCacheEntry *entry;
+
+	entry = g_hash_table_lookup (priv->cache, &key_take);
+	if (entry)
+		_cache_entry_remove (self, entry);
+
+	if (g_hash_table_size (priv->cache) >= AUTH_CACHE_MAX_SIZE)
+		_cache_flush (self, "too many entries");
+
+	if (sender) {
+		cache_sender = g_hash_table_lookup (priv->cache_senders, &sender);
+		if (!cache_sender) {
+			cache_sender = g_slice_new (AuthCacheSender);
+			*cache_sender = (AuthCacheSender) {
+				.sender                = g_strdup (sender),
+				.self                  = self,
+				.entries_lst_head      = C_LIST_INIT (cache_sender->entries_lst_head),
+			};
+			if (priv->dbus_connection) {
+				cache_sender->name_owner_changed_id = nm_dbus_connection_signal_subscribe_name_owner_changed (priv->dbus_connection,
+				                                                                                              sender,
+				                                                                                              _cache_sender_name_owner_changed_cb,
+				                                                                                              self,
+				                                                                                              NULL);
+			}
+			g_hash_table_add (priv->cache_senders, cache_sender);
+		}
+	}
+
+	entry = g_slice_new (AuthCacheEntry);
+	*entry = (AuthCacheEntry) {
+		.key           = key_take,
+		.sender        = cache_sender,
+		.expiry_msec   = nm_utils_get_monotonic_timestamp_msec () + AUTH_CACHE_TTL_MSEC,
+		.is_authorized = is_authorized,
+		.is_challenge  = is_challenge,
+	};
+	if (cache_sender)
+		c_list_link_tail (&cache_sender->entries_lst_head, &entry->sender_lst);
+	else
+		c_list_init (&entry->sender_lst);
+	g_hash_table_add (priv->cache, entry);
+}
+
+/**
+ * nm_auth_manager_get_cache_stats:
+ * @self: the #NMAuthManager
+ * @out_hits: (allow-none): the number of requests answered from the cache.
+ * @out_misses: (allow-none): the number of requests sent to polkit.
+ */
+void
+nm_auth_manager_get_cache_stats (NMAuthManager *self,
+                                 guint64 *out_hits,
+                                 guint64 *out_misses)
+{
+	NMAuthManagerPrivate *priv;
+
+	g_return_if_fail (NM_IS_AUTH_MANAGER (self));
+
+	priv = NM_AUTH_MANAGER_GET_PRIVATE (self);
+	NM_SET_OUT (out_hits, priv->cache_hits);
+	NM_SET_OUT (out_misses, priv->cache_misses);
+}
+
+/*****************************************************************************/
+
+void
+_nm_auth_manager_cache_add (NMAuthManager *self,
+                            const char *key,
+                            const char *sender,
+                            gboolean is_authorized)
+{
+	g_return_if_fail (NM_IS_AUTH_MANAGER (self));
+	g_return_if_fail (key);
+
+	_cache_add (self, g_strdup (key), sender, is_authorized, FALSE);
+}
+
+gboolean
+_nm_auth_manager_cache_has (NMAuthManager *self,
+                            const char *key)
+{
+	g_return_val_if_fail (NM_IS_AUTH_MANAGER (self), FALSE);
+	g_return_val_if_fail (key, FALSE);
+
+	return !!_cache_lookup (self, key);
+}
+
+guint
+_nm_auth_manager_cache_drop_sender (NMAuthManager *self,
+                                    const char *sender)
+{
+	g_return_val_if_fail (NM_IS_AUTH_MANAGER (self), 0);
+	g_return_val_if_fail (sender, 0);
+
+	return _cache_drop_sender (self, sender);
+}
+
+/*****************************************************************************/
+
 #define cancellation_id_to_str_a(call_numid) \
 	nm_sprintf_bufa (NM_STRLEN (CANCELLATION_ID_PREFIX) + 60, \
 	                 CANCELLATION_ID_PREFIX"%"G_GUINT64_FORMAT, \
@@ -139,6 +433,8 @@ _call_id_free (NMAuthManagerCallId *call_id)
 		return;
 	}
 
+	g_free (call_id->cache_key);
+	g_free (call_id->cache_sender);
 	g_object_unref (call_id->self);
 	g_slice_free (NMAuthManagerCallId, call_id);
 }
@@ -247,6 +543,16 @@ _call_check_authorize_cb (GObject *proxy,
 		               NULL);
 		_LOG2T (call_id, "completed: authorized=%d, challenge=%d",
 		        is_authorized, is_challenge);
+
+		if (   call_id->cache_key
+		    && call_id->cache_generation == priv->cache_generation
+		    && !priv->disposing) {
+			_cache_add (self,
+			            g_steal_pointer (&call_id->cache_key),
+			            call_id->cache_sender,
+			            is_authorized,
+			            is_challenge);
+		}
 	} else
 		_LOG2T (call_id, "completed: failed: %s", error->message);
 
@@ -258,13 +564,15 @@ _call_on_idle (gpointer user_data)
 {
 	NMAuthManagerCallId *call_id = user_data;
 	gboolean is_authorized;
-	gboolean is_challenge = FALSE;
+	gboolean is_challenge;
 
 	is_authorized = call_id->idle_is_authorized;
+	is_challenge = call_id->idle_is_challenge;
 	call_id->idle_id = 0;
 
-	_LOG2T (call_id, "completed: authorized=%d, challenge=%d (simulated)",
-	        is_authorized, is_challenge);
+	_LOG2T (call_id, "completed: authorized=%d, challenge=%d (%s)",
+	        is_authorized, is_challenge,
+	        call_id->cache_key ? "cached" : "simulated");
 
 	_call_id_invoke_callback (call_id, is_authorized, is_challenge, NULL);
 	return G_SOURCE_REMOVE;
@@ -338,6 +646,35 @@ nm_auth_manager_check_authorization (NMAuthManager *self,
 		GVariantBuilder builder;
 		GVariant *subject_value;
 		GVariant *details_value;
+		AuthCacheEntry *entry;
+
+		call_id->cache_key = _cache_key_create (subject, action_id);
+
+		/* A cached "yes" is good for every request. Other results are only
+		 * good for requests that don't allow user interaction, because with
+		 * interaction the user may still be able to authenticate. Likewise,
+		 * we only cache results of requests without interaction, because
+		 * an interactive authentication may only be valid once. */
+		entry = _cache_lookup (self, call_id->cache_key);
+		if (   entry
+		    && (   entry->is_authorized
+		        || !allow_user_interaction)) {
+			priv->cache_hits++;
+			_LOG2T (call_id, "CheckAuthorization(%s), subject=%s (cached result)", action_id, nm_auth_subject_to_string (subject, subject_buf, sizeof (subject_buf)));
+			call_id->idle_is_authorized = entry->is_authorized;
+			call_id->idle_is_challenge = entry->is_challenge;
+			call_id->idle_id = g_idle_add (_call_on_idle, call_id);
+			return call_id;
+		}
+
+		priv->cache_misses++;
+
+		if (allow_user_interaction)
+			nm_clear_g_free (&call_id->cache_key);
+		else {
+			call_id->cache_sender = g_strdup (nm_auth_subject_get_unix_process_dbus_sender (subject));
+			call_id->cache_generation = priv->cache_generation;
+		}
 
 		subject_value = nm_auth_subject_unix_to_polkit_gvariant (subject);
 		nm_assert (g_variant_is_floating (subject_value));
@@ -413,9 +750,25 @@ changed_signal_cb (GDBusConnection *connection,
 	NMAuthManager *self = user_data;
 
 	_LOGD ("dbus signal: \"Changed\"");
+	_cache_flush (self, "polkit changed");
 	g_signal_emit (self, signals[CHANGED_SIGNAL], 0);
 }
 
+static void
+name_owner_changed_cb (GDBusConnection *connection,
+                       const char *sender_name,
+                       const char *object_path,
+                       const char *interface_name,
+                       const char *signal_name,
+                       GVariant *parameters,
+                       gpointer user_data)
+{
+	NMAuthManager *self = user_data;
+
+	/* polkit restarted. Forget what we know. */
+	_cache_flush (self, "polkit name owner changed");
+}
+
 /*****************************************************************************/
 
 NMAuthManager *
@@ -493,6 +846,8 @@ nm_auth_manager_init (NMAuthManager *self)
 
 	c_list_init (&priv->calls_lst_head);
 	priv->auth_polkit_mode = NM_AUTH_POLKIT_MODE_ROOT_ONLY;
+	priv->cache = g_hash_table_new_full (nm_pstr_hash, nm_pstr_equal, _cache_entry_free, NULL);
+	priv->cache_senders = g_hash_table_new_full (nm_pstr_hash, nm_pstr_equal, _cache_sender_free, NULL);
 }
 
 static void
@@ -536,6 +891,12 @@ constructed (GObject *object)
 	                                                              self,
 	                                                              NULL);
 
+	priv->name_owner_changed_id = nm_dbus_connection_signal_subscribe_name_owner_changed (priv->dbus_connection,
+	                                                                                      POLKIT_SERVICE,
+	                                                                                      name_owner_changed_cb,
+	                                                                                      self,
+	                                                                                      NULL);
+
 	create_message = "polkit enabled";
 
 out:
@@ -582,6 +943,12 @@ dispose (GObject *object)
 
 	nm_clear_g_dbus_connection_signal (priv->dbus_connection,
 	                                   &priv->changed_signal_id);
+	nm_clear_g_dbus_connection_signal (priv->dbus_connection,
+	                                   &priv->name_owner_changed_id);
+
+	_cache_flush (self, "dispose");
+	nm_clear_pointer (&priv->cache, g_hash_table_destroy);
+	nm_clear_pointer (&priv->cache_senders, g_hash_table_destroy);
 
 	G_OBJECT_CLASS (nm_auth_manager_parent_class)->dispose (object);
 
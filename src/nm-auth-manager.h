@@ -63,6 +63,10 @@ void nm_auth_manager_force_shutdown (NMAuthManager *self);
 
 gboolean nm_auth_manager_get_polkit_enabled (NMAuthManager *self);
 
+void nm_auth_manager_get_cache_stats (NMAuthManager *self,
+                                      guint64 *out_hits,
+                                      guint64 *out_misses);
+
 /*****************************************************************************/
 
 typedef struct _NMAuthManagerCallId NMAuthManagerCallId;
@@ -83,4 +87,19 @@ NMAuthManagerCallId *nm_auth_manager_check_authorization (NMAuthManager *self,
 
 void nm_auth_manager_check_authorization_cancel (NMAuthManagerCallId *call_id);
 
+/*****************************************************************************/
+
+/* Internal access to the authorization cache, for unit tests. */
+
+void _nm_auth_manager_cache_add (NMAuthManager *self,
+                                 const char *key,
+                                 const char *sender,
+                                 gboolean is_authorized);
+
+gboolean _nm_auth_manager_cache_has (NMAuthManager *self,
+                                     const char *key);
+
+guint _nm_auth_manager_cache_drop_sender (NMAuthManager *self,
+                                          const char *sender);
+
 #endif /* NM_AUTH_MANAGER_H */
@@ -24,6 +24,7 @@ typedef struct {
 		 * "match-device" was unspecified. */
 		gboolean has;
 		GSList *spec;
+		NMMatchSpec *compiled;
 	} match_device;
 } MatchSectionInfo;
 
@@ -71,6 +72,13 @@ typedef struct {
 	 * [device] sections. This is to speed up lookup. */
 	MatchSectionInfo *device_infos;
 
+	guint connection_infos_len;
+	guint device_infos_len;
+
+	/* a unique, never reused ID to tie the per-device match cache
+	 * to this instance. */
+	guint64 id;
+
 	struct {
 		gboolean enabled;
 		char *uri;
@@ -85,13 +93,18 @@ typedef struct {
 		/* from /var/lib/NetworkManager/no-auto-default.state */
 		char **arr;
 		GSList *specs;
+		NMMatchSpec *specs_compiled;
 
 		/* from main.no-auto-default setting in NetworkManager.conf. */
 		GSList *specs_config;
+		NMMatchSpec *specs_config_compiled;
 	} no_auto_default;
 
 	GSList *ignore_carrier;
+	NMMatchSpec *ignore_carrier_compiled;
 	GSList *assume_ipv6ll_only;
+	NMMatchSpec *assume_ipv6ll_only_compiled;
+	NMMatchSpec *ignore_links_compiled;
 
 	char *dns_mode;
 	char *rc_manager;
@@ -290,8 +303,8 @@ nm_config_data_get_no_auto_default_for_device (const NMConfigData *self, NMDevic
 	g_return_val_if_fail (NM_IS_DEVICE (device), FALSE);
 
 	priv = NM_CONFIG_DATA_GET_PRIVATE (self);
-	return    nm_device_spec_match_list (device, priv->no_auto_default.specs)
-	       || nm_device_spec_match_list (device, priv->no_auto_default.specs_config);
+	return    nm_device_match_spec (device, priv->no_auto_default.specs_compiled)
+	       || nm_device_match_spec (device, priv->no_auto_default.specs_config_compiled);
 }
 
 const char *
@@ -332,7 +345,7 @@ nm_config_data_get_ignore_carrier (const NMConfigData *self, NMDevice *device)
 	if (has_match)
 		m = nm_config_parse_boolean (value, -1);
 	else
-		m = nm_device_spec_match_list_full (device, NM_CONFIG_DATA_GET_PRIVATE (self)->ignore_carrier, -1);
+		m = nm_device_match_spec_full (device, NM_CONFIG_DATA_GET_PRIVATE (self)->ignore_carrier_compiled, -1);
 
 	if (NM_IN_SET (m, TRUE, FALSE))
 		return m;
@@ -347,7 +360,37 @@ nm_config_data_get_assume_ipv6ll_only (const NMConfigData *self, NMDevice *devic
 	g_return_val_if_fail (NM_IS_CONFIG_DATA (self), FALSE);
 	g_return_val_if_fail (NM_IS_DEVICE (device), FALSE);
 
-	return nm_device_spec_match_list (device, NM_CONFIG_DATA_GET_PRIVATE (self)->assume_ipv6ll_only);
+	return nm_device_match_spec (device, NM_CONFIG_DATA_GET_PRIVATE (self)->assume_ipv6ll_only_compiled);
+}
+
+/**
+ * nm_config_data_get_ignore_link:
+ * @self: the #NMConfigData
+ * @pllink: the platform link
+ *
+ * Whether no #NMDevice should be created for @pllink, according to
+ * main.ignore-links. The link type is matched by "type:".
+ *
+ * Returns: %TRUE if the link is ignored.
+ */
+gboolean
+nm_config_data_get_ignore_link (const NMConfigData *self, const NMPlatformLink *pllink)
+{
+	const NMConfigDataPrivate *priv;
+
+	g_return_val_if_fail (NM_IS_CONFIG_DATA (self), FALSE);
+	g_return_val_if_fail (pllink, FALSE);
+
+	priv = NM_CONFIG_DATA_GET_PRIVATE (self);
+
+	if (!priv->ignore_links_compiled)
+		return FALSE;
+
+	return nm_match_spec_device_by_pllink (pllink,
+	                                       nm_link_type_to_string (pllink->type),
+	                                       nm_dhcp_manager_get_config (nm_dhcp_manager_get ()),
+	                                       priv->ignore_links_compiled,
+	                                       FALSE);
 }
 
 GKeyFile *
@@ -1306,8 +1349,86 @@ global_dns_equal (NMGlobalDnsConfig *old, NMGlobalDnsConfig *new)
 
 /*****************************************************************************/
 
+/* Per-device cache of which [connection*] and [device*] sections match
+ * the device. It is attached to the device and only valid for the
+ * NMConfigData with the same @config_data_id and as long as the
+ * matchable attributes of the device don't change. */
+typedef struct {
+	guint64 config_data_id;
+	char *interface_name;
+	char *driver;
+	char *driver_version;
+	char *hwaddr;
+	char *s390_subchannels;
+
+	/* for each section (first the [connection*], then the [device*] ones)
+	 * whether it was not yet evaluated (0), does not match (1) or matches (2). */
+	guint8 *matches;
+} DeviceMatchCache;
+
+static void
+_device_match_cache_free (gpointer data)
+{
+	DeviceMatchCache *cache = data;
+
+	g_free (cache->interface_name);
+	g_free (cache->driver);
+	g_free (cache->driver_version);
+	g_free (cache->hwaddr);
+	g_free (cache->s390_subchannels);
+	g_free (cache->matches);
+	g_slice_free (DeviceMatchCache, cache);
+}
+
+static guint8 *
+_device_match_cache_get (const NMConfigData *self,
+                         NMDevice *device,
+                         const MatchSectionInfo *match_section_infos)
+{
+	const NMConfigDataPrivate *priv = NM_CONFIG_DATA_GET_PRIVATE (self);
+	NMDeviceSpecMatchData data;
+	DeviceMatchCache *cache;
+	guint n;
+
+	n = priv->connection_infos_len + priv->device_infos_len;
+	if (n == 0)
+		return NULL;
+
+	nm_device_get_spec_match_data (device, &data);
+
+	cache = g_object_get_qdata (G_OBJECT (device), NM_CACHED_QUARK ("nm-config-data-match-cache"));
+	if (   !cache
+	    || cache->config_data_id != priv->id
+	    || !nm_streq0 (cache->interface_name, data.interface_name)
+	    || !nm_streq0 (cache->driver, data.driver)
+	    || !nm_streq0 (cache->driver_version, data.driver_version)
+	    || !nm_streq0 (cache->hwaddr, data.hwaddr)
+	    || !nm_streq0 (cache->s390_subchannels, data.s390_subchannels)) {
+		cache = g_slice_new (DeviceMatchCache);
+		*cache = (DeviceMatchCache) {
+			.config_data_id   = priv->id,
+			.interface_name   = g_strdup (data.interface_name),
+			.driver           = g_strdup (data.driver),
+			.driver_version   = g_strdup (data.driver_version),
+			.hwaddr           = g_strdup (data.hwaddr),
+			.s390_subchannels = g_strdup (data.s390_subchannels),
+			.matches          = g_new0 (guint8, n),
+		};
+		g_object_set_qdata_full (G_OBJECT (device),
+		                         NM_CACHED_QUARK ("nm-config-data-match-cache"),
+		                         cache,
+		                         _device_match_cache_free);
+	}
+
+	if (match_section_infos == priv->connection_infos)
+		return cache->matches;
+	nm_assert (match_section_infos == priv->device_infos);
+	return &cache->matches[priv->connection_infos_len];
+}
+
 static const MatchSectionInfo *
-_match_section_infos_lookup (const MatchSectionInfo *match_section_infos,
+_match_section_infos_lookup (const NMConfigData *self,
+                             const MatchSectionInfo *match_section_infos,
                              GKeyFile *keyfile,
                              const char *property,
                              NMDevice *device,
@@ -1315,7 +1436,9 @@ _match_section_infos_lookup (const MatchSectionInfo *match_section_infos,
                              const char *match_device_type,
                              char **out_value)
 {
+	const MatchSectionInfo *match_section_infos_head = match_section_infos;
 	const char *match_dhcp_plugin;
+	guint8 *matches = NULL;
 
 	if (!match_section_infos)
 		return NULL;
@@ -1338,10 +1461,18 @@ _match_section_infos_lookup (const MatchSectionInfo *match_section_infos,
 			continue;
 
 		if (match_section_infos->match_device.has) {
-			if (device)
-				match = nm_device_spec_match_list (device, match_section_infos->match_device.spec);
-			else if (pllink)
-				match = nm_match_spec_device_by_pllink (pllink, match_device_type, match_dhcp_plugin, match_section_infos->match_device.spec, FALSE);
+			if (device) {
+				guint idx = match_section_infos - match_section_infos_head;
+
+				/* the same sections are evaluated for many properties of
+				 * the same device. Remember the result. */
+				if (!matches)
+					matches = _device_match_cache_get (self, device, match_section_infos_head);
+				if (matches[idx] == 0)
+					matches[idx] = nm_device_match_spec (device, match_section_infos->match_device.compiled) ? 2 : 1;
+				match = (matches[idx] == 2);
+			} else if (pllink)
+				match = nm_match_spec_device_by_pllink (pllink, match_device_type, match_dhcp_plugin, match_section_infos->match_device.compiled, FALSE);
 			else
 				match = FALSE;
 		} else
@@ -1371,7 +1502,8 @@ nm_config_data_get_device_config (const NMConfigData *self,
 
 	priv = NM_CONFIG_DATA_GET_PRIVATE (self);
 
-	connection_info = _match_section_infos_lookup (&priv->device_infos[0],
+	connection_info = _match_section_infos_lookup (self,
+	                                               &priv->device_infos[0],
 	                                               priv->keyfile,
 	                                               property,
 	                                               device,
@@ -1398,7 +1530,8 @@ nm_config_data_get_device_config_by_pllink (const NMConfigData *self,
 
 	priv = NM_CONFIG_DATA_GET_PRIVATE (self);
 
-	connection_info = _match_section_infos_lookup (&priv->device_infos[0],
+	connection_info = _match_section_infos_lookup (self,
+	                                               &priv->device_infos[0],
 	                                               priv->keyfile,
 	                                               property,
 	                                               NULL,
@@ -1452,7 +1585,8 @@ nm_config_data_get_connection_default (const NMConfigData *self,
 	}
 #endif
 
-	_match_section_infos_lookup (&priv->connection_infos[0],
+	_match_section_infos_lookup (self,
+	                             &priv->connection_infos[0],
 	                             priv->keyfile,
 	                             property,
 	                             device,
@@ -1486,6 +1620,7 @@ _get_connection_info_init (MatchSectionInfo *connection_info, GKeyFile *keyfile,
 	                                                               group,
 	                                                               NM_CONFIG_KEYFILE_KEY_MATCH_DEVICE,
 	                                                               &connection_info->match_device.has);
+	connection_info->match_device.compiled = nm_match_spec_new (connection_info->match_device.spec);
 	connection_info->stop_match = nm_config_keyfile_get_boolean (keyfile,
 	                                                             group,
 	                                                             NM_CONFIG_KEYFILE_KEY_STOP_MATCH,
@@ -1502,12 +1637,13 @@ _match_section_infos_free (MatchSectionInfo *match_section_infos)
 	for (i = 0; match_section_infos[i].group_name; i++) {
 		g_free (match_section_infos[i].group_name);
 		g_slist_free_full (match_section_infos[i].match_device.spec, g_free);
+		nm_match_spec_free (match_section_infos[i].match_device.compiled);
 	}
 	g_free (match_section_infos);
 }
 
 static MatchSectionInfo *
-_match_section_infos_construct (GKeyFile *keyfile, const char *prefix)
+_match_section_infos_construct (GKeyFile *keyfile, const char *prefix, guint *out_len)
 {
 	char **groups;
 	gsize i, j, ngroups;
@@ -1519,6 +1655,8 @@ _match_section_infos_construct (GKeyFile *keyfile, const char *prefix)
 	 * We expect the sections in their right order, with lowest priority
 	 * first. Only exception is the (literal) [connection] section, which
 	 * we will always reorder to the end. */
+	*out_len = 0;
+
 	groups = g_key_file_get_groups (keyfile, &ngroups);
 	if (!groups)
 		return NULL;
@@ -1551,9 +1689,11 @@ _match_section_infos_construct (GKeyFile *keyfile, const char *prefix)
 	if (connection_tag) {
 		/* pass ownership of @connection_tag on... */
 		_get_connection_info_init (&match_section_infos[i], keyfile, connection_tag);
+		i++;
 	}
 	g_free (groups);
 
+	*out_len = i;
 	return match_section_infos;
 }
 
@@ -1760,12 +1900,15 @@ constructed (GObject *object)
 {
 	NMConfigData *self = NM_CONFIG_DATA (object);
 	NMConfigDataPrivate *priv = NM_CONFIG_DATA_GET_PRIVATE (self);
+	static guint64 id_counter = 0;
 	char *str;
 
+	priv->id = ++id_counter;
+
 	priv->keyfile = _merge_keyfiles (priv->keyfile_user, priv->keyfile_intern);
 
-	priv->connection_infos = _match_section_infos_construct (priv->keyfile, NM_CONFIG_KEYFILE_GROUPPREFIX_CONNECTION);
-	priv->device_infos = _match_section_infos_construct (priv->keyfile, NM_CONFIG_KEYFILE_GROUPPREFIX_DEVICE);
+	priv->connection_infos = _match_section_infos_construct (priv->keyfile, NM_CONFIG_KEYFILE_GROUPPREFIX_CONNECTION, &priv->connection_infos_len);
+	priv->device_infos = _match_section_infos_construct (priv->keyfile, NM_CONFIG_KEYFILE_GROUPPREFIX_DEVICE, &priv->device_infos_len);
 
 	priv->connectivity.enabled = nm_config_keyfile_get_boolean (priv->keyfile,
 	                                                            NM_CONFIG_KEYFILE_GROUP_CONNECTIVITY,
@@ -1819,6 +1962,25 @@ constructed (GObject *object)
 	                                                               NM_CONFIG_KEYFILE_GROUP_MAIN,
 	                                                               NM_CONFIG_KEYFILE_KEY_MAIN_NO_AUTO_DEFAULT,
 	                                                               NULL);
+	{
+		GSList *ignore_links;
+
+		ignore_links = nm_config_get_match_spec (priv->keyfile,
+		                                         NM_CONFIG_KEYFILE_GROUP_MAIN,
+		                                         NM_CONFIG_KEYFILE_KEY_MAIN_IGNORE_LINKS,
+		                                         NULL);
+		if (ignore_links) {
+			priv->ignore_links_compiled = nm_match_spec_new (ignore_links);
+			g_slist_free_full (ignore_links, g_free);
+		}
+	}
+
+	/* the specs are evaluated for every device and every lookup of a device
+	 * specific default. Parse them only once. */
+	priv->no_auto_default.specs_compiled = nm_match_spec_new (priv->no_auto_default.specs);
+	priv->no_auto_default.specs_config_compiled = nm_match_spec_new (priv->no_auto_default.specs_config);
+	priv->ignore_carrier_compiled = nm_match_spec_new (priv->ignore_carrier);
+	priv->assume_ipv6ll_only_compiled = nm_match_spec_new (priv->assume_ipv6ll_only);
 
 	priv->global_dns = load_global_dns (priv->keyfile_user, FALSE);
 	if (!priv->global_dns)
@@ -1885,6 +2047,8 @@ finalize (GObject *gobject)
 
 	g_slist_free_full (priv->no_auto_default.specs, g_free);
 	g_slist_free_full (priv->no_auto_default.specs_config, g_free);
+	nm_match_spec_free (priv->no_auto_default.specs_compiled);
+	nm_match_spec_free (priv->no_auto_default.specs_config_compiled);
 	g_strfreev (priv->no_auto_default.arr);
 
 	g_free (priv->dns_mode);
@@ -1892,6 +2056,9 @@ finalize (GObject *gobject)
 
 	g_slist_free_full (priv->ignore_carrier, g_free);
 	g_slist_free_full (priv->assume_ipv6ll_only, g_free);
+	nm_match_spec_free (priv->ignore_carrier_compiled);
+	nm_match_spec_free (priv->assume_ipv6ll_only_compiled);
+	nm_match_spec_free (priv->ignore_links_compiled);
 
 	nm_global_dns_config_free (priv->global_dns);
 
@@ -165,6 +165,7 @@ gboolean nm_config_data_get_systemd_resolved (const NMConfigData *self);
 
 gboolean nm_config_data_get_ignore_carrier (const NMConfigData *self, NMDevice *device);
 gboolean nm_config_data_get_assume_ipv6ll_only (const NMConfigData *self, NMDevice *device);
+gboolean nm_config_data_get_ignore_link (const NMConfigData *self, const NMPlatformLink *pllink);
 int      nm_config_data_get_sriov_num_vfs (const NMConfigData *self, NMDevice *device);
 
 NMGlobalDnsConfig *nm_config_data_get_global_dns_config (const NMConfigData *self);
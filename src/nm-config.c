@@ -729,6 +729,7 @@ _setting_is_device_spec (const char *group, const char *key)
 #define _IS(group_v, key_v) (strcmp (group, (""group_v)) == 0 && strcmp (key, (""key_v)) == 0)
 	return    _IS (NM_CONFIG_KEYFILE_GROUP_MAIN, NM_CONFIG_KEYFILE_KEY_MAIN_NO_AUTO_DEFAULT)
 	       || _IS (NM_CONFIG_KEYFILE_GROUP_MAIN, NM_CONFIG_KEYFILE_KEY_MAIN_IGNORE_CARRIER)
+	       || _IS (NM_CONFIG_KEYFILE_GROUP_MAIN, NM_CONFIG_KEYFILE_KEY_MAIN_IGNORE_LINKS)
 	       || _IS (NM_CONFIG_KEYFILE_GROUP_MAIN, NM_CONFIG_KEYFILE_KEY_MAIN_ASSUME_IPV6LL_ONLY)
 	       || _IS (NM_CONFIG_KEYFILE_GROUP_KEYFILE, NM_CONFIG_KEYFILE_KEY_KEYFILE_UNMANAGED_DEVICES)
 	       || (g_str_has_prefix (group, NM_CONFIG_KEYFILE_GROUPPREFIX_CONNECTION) && !strcmp (key, NM_CONFIG_KEYFILE_KEY_MATCH_DEVICE))
@@ -768,10 +769,13 @@ static const ConfigGroup config_groups[] = {
 			NM_CONFIG_KEYFILE_KEY_MAIN_DNS,
 			NM_CONFIG_KEYFILE_KEY_MAIN_HOSTNAME_MODE,
 			NM_CONFIG_KEYFILE_KEY_MAIN_IGNORE_CARRIER,
+			NM_CONFIG_KEYFILE_KEY_MAIN_IGNORE_LINKS,
 			NM_CONFIG_KEYFILE_KEY_MAIN_MONITOR_CONNECTION_FILES,
 			NM_CONFIG_KEYFILE_KEY_MAIN_NO_AUTO_DEFAULT,
 			NM_CONFIG_KEYFILE_KEY_MAIN_PLUGINS,
 			NM_CONFIG_KEYFILE_KEY_MAIN_RC_MANAGER,
+			NM_CONFIG_KEYFILE_KEY_MAIN_SHARED_DHCP,
+			NM_CONFIG_KEYFILE_KEY_MAIN_SHARED_DNSMASQ,
 			NM_CONFIG_KEYFILE_KEY_MAIN_SLAVES_ORDER,
 			NM_CONFIG_KEYFILE_KEY_MAIN_SYSTEMD_RESOLVED,
 		),
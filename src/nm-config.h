@@ -51,10 +51,13 @@
 #define NM_CONFIG_KEYFILE_KEY_MAIN_DNS                      "dns"
 #define NM_CONFIG_KEYFILE_KEY_MAIN_HOSTNAME_MODE            "hostname-mode"
 #define NM_CONFIG_KEYFILE_KEY_MAIN_IGNORE_CARRIER           "ignore-carrier"
+#define NM_CONFIG_KEYFILE_KEY_MAIN_IGNORE_LINKS             "ignore-links"
 #define NM_CONFIG_KEYFILE_KEY_MAIN_MONITOR_CONNECTION_FILES "monitor-connection-files"
 #define NM_CONFIG_KEYFILE_KEY_MAIN_NO_AUTO_DEFAULT          "no-auto-default"
 #define NM_CONFIG_KEYFILE_KEY_MAIN_PLUGINS                  "plugins"
 #define NM_CONFIG_KEYFILE_KEY_MAIN_RC_MANAGER               "rc-manager"
+#define NM_CONFIG_KEYFILE_KEY_MAIN_SHARED_DHCP              "shared-dhcp"
+#define NM_CONFIG_KEYFILE_KEY_MAIN_SHARED_DNSMASQ           "shared-dnsmasq"
 #define NM_CONFIG_KEYFILE_KEY_MAIN_SLAVES_ORDER             "slaves-order"
 #define NM_CONFIG_KEYFILE_KEY_MAIN_SYSTEMD_RESOLVED         "systemd-resolved"
 
@@ -1392,6 +1392,501 @@ nm_match_spec_device (const GSList *specs,
 	return _match_result (has_except, has_not_except, has_match, has_match_except);
 }
 
+/*****************************************************************************/
+
+typedef enum {
+	MATCH_SPEC_GLOB_PREFIX,
+	MATCH_SPEC_GLOB_SUFFIX,
+	MATCH_SPEC_GLOB_PATTERN,
+} MatchSpecGlobType;
+
+typedef struct {
+	MatchSpecGlobType type;
+	gsize len;
+	char *str;
+	GPatternSpec *pspec;
+} MatchSpecGlob;
+
+typedef struct {
+	char *driver;
+	gsize driver_len;
+	GPatternSpec *version;
+} MatchSpecDriver;
+
+typedef struct {
+	guint32 a;
+	guint32 b;
+	guint32 c;
+} MatchSpecS390;
+
+typedef struct {
+	guint8 len;
+	guint8 bin[NM_UTILS_HWADDR_LEN_MAX];
+} MatchSpecHwaddr;
+
+typedef struct {
+	GHashTable *interface_names;
+	GPtrArray *interface_name_globs;
+	GHashTable *hwaddrs;
+	GHashTable *device_types;
+	GHashTable *drivers;
+	GPtrArray *driver_versions;
+	GArray *s390_subchannels;
+	GHashTable *dhcp_plugins;
+	bool has_entries:1;
+	bool match_all:1;
+} MatchSpecPart;
+
+struct _NMMatchSpec {
+	/* the plain entries and the "except:" entries. */
+	MatchSpecPart parts[2];
+};
+
+static void
+_match_spec_glob_free (gpointer data)
+{
+	MatchSpecGlob *glob = data;
+
+	g_free (glob->str);
+	if (glob->pspec)
+		g_pattern_spec_free (glob->pspec);
+	g_slice_free (MatchSpecGlob, glob);
+}
+
+static void
+_match_spec_driver_free (gpointer data)
+{
+	MatchSpecDriver *drv = data;
+
+	g_free (drv->driver);
+	g_pattern_spec_free (drv->version);
+	g_slice_free (MatchSpecDriver, drv);
+}
+
+static void
+_match_spec_hwaddr_free (gpointer data)
+{
+	g_slice_free (MatchSpecHwaddr, data);
+}
+
+static guint
+_match_spec_hwaddr_hash (gconstpointer ptr)
+{
+	const MatchSpecHwaddr *h = ptr;
+	NMHashState state;
+
+	nm_hash_init (&state, 1429733423u);
+	nm_hash_update_val (&state, h->len);
+	nm_hash_update_mem (&state, h->bin, h->len);
+	return nm_hash_complete (&state);
+}
+
+static gboolean
+_match_spec_hwaddr_equal (gconstpointer a, gconstpointer b)
+{
+	const MatchSpecHwaddr *h_a = a;
+	const MatchSpecHwaddr *h_b = b;
+
+	return    h_a->len == h_b->len
+	       && memcmp (h_a->bin, h_b->bin, h_a->len) == 0;
+}
+
+static gboolean
+_match_spec_hwaddr_parse (const char *str, MatchSpecHwaddr *out)
+{
+	gsize l;
+
+	memset (out, 0, sizeof (*out));
+	if (!_nm_utils_hwaddr_aton (str, out->bin, sizeof (out->bin), &l))
+		return FALSE;
+	out->len = l;
+
+	/* like nm_utils_hwaddr_matches(), only compare the last 8 bytes
+	 * of an infiniband address. */
+	if (l == INFINIBAND_ALEN)
+		memset (out->bin, 0, INFINIBAND_ALEN - 8);
+	return TRUE;
+}
+
+static void
+_match_spec_part_add_str (GHashTable **p_hash, const char *str)
+{
+	if (!*p_hash)
+		*p_hash = g_hash_table_new_full (nm_str_hash, g_str_equal, g_free, NULL);
+	if (!g_hash_table_contains (*p_hash, str))
+		g_hash_table_add (*p_hash, g_strdup (str));
+}
+
+static void
+_match_spec_part_add_hwaddr (MatchSpecPart *part, const char *str)
+{
+	MatchSpecHwaddr hwaddr;
+
+	if (!_match_spec_hwaddr_parse (str, &hwaddr))
+		return;
+	if (!part->hwaddrs) {
+		part->hwaddrs = g_hash_table_new_full (_match_spec_hwaddr_hash,
+		                                       _match_spec_hwaddr_equal,
+		                                       _match_spec_hwaddr_free,
+		                                       NULL);
+	}
+	if (!g_hash_table_contains (part->hwaddrs, &hwaddr))
+		g_hash_table_add (part->hwaddrs, g_slice_dup (MatchSpecHwaddr, &hwaddr));
+}
+
+static void
+_match_spec_part_add_interface_name (MatchSpecPart *part, const char *str, gboolean use_pattern)
+{
+	MatchSpecGlob *glob;
+	const char *s;
+	gsize len;
+
+	/* the exact match is always tried first, also for patterns. */
+	_match_spec_part_add_str (&part->interface_names, str);
+
+	if (!use_pattern)
+		return;
+
+	s = strpbrk (str, "*?");
+	if (!s) {
+		/* a pattern without wildcards is no different from the exact match. */
+		return;
+	}
+
+	if (!part->interface_name_globs)
+		part->interface_name_globs = g_ptr_array_new_with_free_func (_match_spec_glob_free);
+
+	len = strlen (str);
+	glob = g_slice_new0 (MatchSpecGlob);
+
+	if (   s == &str[len - 1]
+	    && s[0] == '*') {
+		/* "prefix*" */
+		glob->type = MATCH_SPEC_GLOB_PREFIX;
+		glob->str = g_strndup (str, len - 1);
+		glob->len = len - 1;
+	} else if (   s == str
+	           && s[0] == '*'
+	           && !strpbrk (&str[1], "*?")) {
+		/* "*suffix" */
+		glob->type = MATCH_SPEC_GLOB_SUFFIX;
+		glob->str = g_strdup (&str[1]);
+		glob->len = len - 1;
+	} else {
+		glob->type = MATCH_SPEC_GLOB_PATTERN;
+		glob->pspec = g_pattern_spec_new (str);
+	}
+	g_ptr_array_add (part->interface_name_globs, glob);
+}
+
+static void
+_match_spec_part_add (MatchSpecPart *part, const char *spec_str, gboolean allow_fuzzy)
+{
+	part->has_entries = TRUE;
+
+	if (part->match_all)
+		return;
+
+	if (spec_str[0] == '*' && spec_str[1] == '\0') {
+		part->match_all = TRUE;
+		return;
+	}
+
+	if (_MATCH_CHECK (spec_str, DEVICE_TYPE_TAG)) {
+		_match_spec_part_add_str (&part->device_types, spec_str);
+		return;
+	}
+
+	if (_MATCH_CHECK (spec_str, NM_MATCH_SPEC_MAC_TAG)) {
+		_match_spec_part_add_hwaddr (part, spec_str);
+		return;
+	}
+
+	if (_MATCH_CHECK (spec_str, NM_MATCH_SPEC_INTERFACE_NAME_TAG)) {
+		if (spec_str[0] == '=')
+			_match_spec_part_add_interface_name (part, &spec_str[1], FALSE);
+		else {
+			if (spec_str[0] == '~')
+				spec_str += 1;
+			_match_spec_part_add_interface_name (part, spec_str, TRUE);
+		}
+		return;
+	}
+
+	if (_MATCH_CHECK (spec_str, DRIVER_TAG)) {
+		MatchSpecDriver *drv;
+		const char *t;
+
+		/* see match_device_eval() for the supported formats. */
+		t = strrchr (spec_str, '/');
+		if (!t) {
+			_match_spec_part_add_str (&part->drivers, spec_str);
+			return;
+		}
+
+		if (!part->driver_versions)
+			part->driver_versions = g_ptr_array_new_with_free_func (_match_spec_driver_free);
+		drv = g_slice_new (MatchSpecDriver);
+		drv->driver_len = t - spec_str;
+		drv->driver = g_strndup (spec_str, drv->driver_len);
+		drv->version = g_pattern_spec_new (&t[1]);
+		g_ptr_array_add (part->driver_versions, drv);
+		return;
+	}
+
+	if (_MATCH_CHECK (spec_str, NM_MATCH_SPEC_S390_SUBCHANNELS_TAG)) {
+		MatchSpecS390 s390;
+
+		if (!match_device_s390_subchannels_parse (spec_str, &s390.a, &s390.b, &s390.c))
+			return;
+		if (!part->s390_subchannels)
+			part->s390_subchannels = g_array_new (FALSE, FALSE, sizeof (MatchSpecS390));
+		g_array_append_val (part->s390_subchannels, s390);
+		return;
+	}
+
+	if (_MATCH_CHECK (spec_str, DHCP_PLUGIN_TAG)) {
+		_match_spec_part_add_str (&part->dhcp_plugins, spec_str);
+		return;
+	}
+
+	if (allow_fuzzy) {
+		_match_spec_part_add_hwaddr (part, spec_str);
+		_match_spec_part_add_str (&part->interface_names, spec_str);
+	}
+}
+
+/**
+ * nm_match_spec_new:
+ * @specs: the list of device match specs.
+ *
+ * Pre-parses @specs so that they can be evaluated repeatedly with
+ * nm_match_spec_match_device() without re-parsing the strings.
+ * The result is identical to nm_match_spec_device() with the same
+ * @specs.
+ *
+ * Returns: (transfer full): the compiled match spec. Free with
+ *   nm_match_spec_free().
+ */
+NMMatchSpec *
+nm_match_spec_new (const GSList *specs)
+{
+	NMMatchSpec *spec;
+	const GSList *iter;
+
+	spec = g_slice_new0 (NMMatchSpec);
+
+	for (iter = specs; iter; iter = iter->next) {
+		const char *spec_str = iter->data;
+		gboolean except;
+
+		if (!spec_str || !*spec_str)
+			continue;
+
+		spec_str = match_except (spec_str, &except);
+		_match_spec_part_add (&spec->parts[except ? 1 : 0], spec_str, !except);
+	}
+
+	return spec;
+}
+
+static void
+_match_spec_part_clear (MatchSpecPart *part)
+{
+	nm_clear_pointer (&part->interface_names, g_hash_table_unref);
+	nm_clear_pointer (&part->interface_name_globs, g_ptr_array_unref);
+	nm_clear_pointer (&part->hwaddrs, g_hash_table_unref);
+	nm_clear_pointer (&part->device_types, g_hash_table_unref);
+	nm_clear_pointer (&part->drivers, g_hash_table_unref);
+	nm_clear_pointer (&part->driver_versions, g_ptr_array_unref);
+	nm_clear_pointer (&part->s390_subchannels, g_array_unref);
+	nm_clear_pointer (&part->dhcp_plugins, g_hash_table_unref);
+}
+
+void
+nm_match_spec_free (NMMatchSpec *spec)
+{
+	if (!spec)
+		return;
+
+	_match_spec_part_clear (&spec->parts[0]);
+	_match_spec_part_clear (&spec->parts[1]);
+	g_slice_free (NMMatchSpec, spec);
+}
+
+typedef struct {
+	const char *interface_name;
+	gsize interface_name_len;
+	const char *device_type;
+	const char *driver;
+	const char *driver_version;
+	const char *dhcp_plugin;
+	const char *hwaddr_str;
+	const char *s390_subchannels_str;
+	bool hwaddr_is_parsed:1;
+	bool hwaddr_valid:1;
+	bool s390_is_parsed:1;
+	bool s390_valid:1;
+	MatchSpecHwaddr hwaddr;
+	MatchSpecS390 s390;
+} MatchSpecInput;
+
+static gboolean
+_match_spec_part_eval (const MatchSpecPart *part,
+                       MatchSpecInput *input)
+{
+	guint i;
+
+	if (!part->has_entries)
+		return FALSE;
+	if (part->match_all)
+		return TRUE;
+
+	if (input->interface_name) {
+		if (   part->interface_names
+		    && g_hash_table_contains (part->interface_names, input->interface_name))
+			return TRUE;
+
+		if (part->interface_name_globs) {
+			for (i = 0; i < part->interface_name_globs->len; i++) {
+				const MatchSpecGlob *glob = part->interface_name_globs->pdata[i];
+
+				switch (glob->type) {
+				case MATCH_SPEC_GLOB_PREFIX:
+					if (strncmp (input->interface_name, glob->str, glob->len) == 0)
+						return TRUE;
+					break;
+				case MATCH_SPEC_GLOB_SUFFIX:
+					if (   input->interface_name_len >= glob->len
+					    && memcmp (&input->interface_name[input->interface_name_len - glob->len],
+					               glob->str,
+					               glob->len) == 0)
+						return TRUE;
+					break;
+				case MATCH_SPEC_GLOB_PATTERN:
+					if (g_pattern_match (glob->pspec,
+					                     input->interface_name_len,
+					                     input->interface_name,
+					                     NULL))
+						return TRUE;
+					break;
+				}
+			}
+		}
+	}
+
+	if (   part->device_types
+	    && input->device_type
+	    && g_hash_table_contains (part->device_types, input->device_type))
+		return TRUE;
+
+	if (part->hwaddrs) {
+		if (G_UNLIKELY (!input->hwaddr_is_parsed)) {
+			input->hwaddr_is_parsed = TRUE;
+			if (input->hwaddr_str) {
+				if (!_match_spec_hwaddr_parse (input->hwaddr_str, &input->hwaddr))
+					g_return_val_if_reached (FALSE);
+				input->hwaddr_valid = TRUE;
+			}
+		}
+		if (   input->hwaddr_valid
+		    && g_hash_table_contains (part->hwaddrs, &input->hwaddr))
+			return TRUE;
+	}
+
+	if (input->driver) {
+		if (   part->drivers
+		    && g_hash_table_contains (part->drivers, input->driver))
+			return TRUE;
+
+		if (part->driver_versions) {
+			for (i = 0; i < part->driver_versions->len; i++) {
+				const MatchSpecDriver *drv = part->driver_versions->pdata[i];
+
+				if (   strncmp (drv->driver, input->driver, drv->driver_len) == 0
+				    && g_pattern_match_string (drv->version, input->driver_version ?: ""))
+					return TRUE;
+			}
+		}
+	}
+
+	if (part->s390_subchannels) {
+		if (G_UNLIKELY (!input->s390_is_parsed)) {
+			input->s390_is_parsed = TRUE;
+			input->s390_valid =    input->s390_subchannels_str
+			                    && match_device_s390_subchannels_parse (input->s390_subchannels_str,
+			                                                            &input->s390.a,
+			                                                            &input->s390.b,
+			                                                            &input->s390.c);
+		}
+		if (input->s390_valid) {
+			for (i = 0; i < part->s390_subchannels->len; i++) {
+				const MatchSpecS390 *s390 = &g_array_index (part->s390_subchannels, MatchSpecS390, i);
+
+				if (   s390->a == input->s390.a
+				    && s390->b == input->s390.b
+				    && s390->c == input->s390.c)
+					return TRUE;
+			}
+		}
+	}
+
+	if (   part->dhcp_plugins
+	    && input->dhcp_plugin
+	    && g_hash_table_contains (part->dhcp_plugins, input->dhcp_plugin))
+		return TRUE;
+
+	return FALSE;
+}
+
+/**
+ * nm_match_spec_match_device:
+ * @spec: (allow-none): the compiled match spec from nm_match_spec_new().
+ *
+ * Same as nm_match_spec_device(), but evaluates a pre-parsed spec. Lookups
+ * of interface names, MAC addresses, device types, drivers and DHCP plugins
+ * are hash lookups, independent of the number of entries in the spec.
+ *
+ * Returns: the match result.
+ */
+NMMatchSpecMatchType
+nm_match_spec_match_device (const NMMatchSpec *spec,
+                            const char *interface_name,
+                            const char *device_type,
+                            const char *driver,
+                            const char *driver_version,
+                            const char *hwaddr,
+                            const char *s390_subchannels,
+                            const char *dhcp_plugin)
+{
+	MatchSpecInput input = {
+		.interface_name = interface_name,
+		.interface_name_len = interface_name ? strlen (interface_name) : 0,
+		.device_type = nm_str_not_empty (device_type),
+		.driver = nm_str_not_empty (driver),
+		.driver_version = nm_str_not_empty (driver_version),
+		.dhcp_plugin = nm_str_not_empty (dhcp_plugin),
+		.hwaddr_str = hwaddr,
+		.s390_subchannels_str = s390_subchannels,
+	};
+	gboolean has_match_except;
+
+	nm_assert (!hwaddr || nm_utils_hwaddr_valid (hwaddr, -1));
+
+	if (!spec)
+		return NM_MATCH_SPEC_NO_MATCH;
+
+	/* the "except:" entries take precedence. If one of them matches, the
+	 * result is a negative match regardless of the other entries. */
+	has_match_except = _match_spec_part_eval (&spec->parts[1], &input);
+
+	return _match_result (spec->parts[1].has_entries,
+	                      spec->parts[0].has_entries,
+	                         !has_match_except
+	                      && _match_spec_part_eval (&spec->parts[0], &input),
+	                      has_match_except);
+}
+
 static gboolean
 match_config_eval (const char *str, const char *tag, guint cur_nm_version)
 {
@@ -220,6 +220,22 @@ NMMatchSpecMatchType nm_match_spec_device (const GSList *specs,
                                            const char *hwaddr,
                                            const char *s390_subchannels,
                                            const char *dhcp_plugin);
+
+NMMatchSpec *nm_match_spec_new (const GSList *specs);
+void nm_match_spec_free (NMMatchSpec *spec);
+
+NM_AUTO_DEFINE_FCN0 (NMMatchSpec *, _nm_auto_free_match_spec, nm_match_spec_free)
+#define nm_auto_free_match_spec nm_auto (_nm_auto_free_match_spec)
+
+NMMatchSpecMatchType nm_match_spec_match_device (const NMMatchSpec *spec,
+                                                 const char *interface_name,
+                                                 const char *device_type,
+                                                 const char *driver,
+                                                 const char *driver_version,
+                                                 const char *hwaddr,
+                                                 const char *s390_subchannels,
+                                                 const char *dhcp_plugin);
+
 NMMatchSpecMatchType nm_match_spec_config (const GSList *specs,
                                            guint nm_version,
                                            const char *env);
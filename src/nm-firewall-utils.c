@@ -0,0 +1,434 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Copyright (C) 2020 Red Hat, Inc.
+ */
+
+#include "nm-default.h"
+
+#include "nm-firewall-utils.h"
+
+#include <sys/wait.h>
+
+#include "c-list/src/c-list.h"
+#include "nm-core-utils.h"
+
+/*****************************************************************************/
+
+/* iptables-restore is installed next to iptables, both for the legacy and the
+ * nft variant (e.g. "iptables-nft" and "iptables-nft-restore"). */
+#define IPTABLES_RESTORE_PATH IPTABLES_PATH "-restore"
+
+/*****************************************************************************/
+
+#define _NMLOG_DOMAIN      LOGD_SHARING
+#define _NMLOG(level, ...) __NMLOG_DEFAULT (level, _NMLOG_DOMAIN, "firewall", __VA_ARGS__)
+
+/*****************************************************************************/
+
+struct _NMFirewallShareCallId {
+	CList jobs_lst;
+
+	/* pairs of table and rule, in the order in which they get applied. */
+	char **rules;
+	guint n_rules;
+
+	/* the next rule to apply when falling back to one iptables call per rule. */
+	guint fallback_idx;
+
+	NMFirewallShareCallback callback;
+	gpointer user_data;
+
+	bool add:1;
+	bool fallback:1;
+};
+
+typedef NMFirewallShareCallId FwJob;
+
+/* All jobs are serialized, so that a removal never overtakes the
+ * insertion of the same rules and we don't contend for the xtables
+ * lock with ourself. */
+static struct {
+	CList jobs_lst_head;
+
+	/* the child watches and the idle source that starts the next job are
+	 * attached to a context of their own. Normally, it is integrated into
+	 * the main context. After nm_firewall_share_rules_flush(), it is
+	 * iterated directly, as there is no main loop anymore. */
+	GMainContext *context;
+	GSource *integrate_source;
+	GSource *process_source;
+
+	GPid pid;
+	bool restore_unavailable:1;
+	bool flushed:1;
+} _fw = {
+	.jobs_lst_head = C_LIST_INIT (_fw.jobs_lst_head),
+	.pid = -1,
+};
+
+static void _fw_process_schedule (void);
+
+/*****************************************************************************/
+
+static void
+_fw_job_free (FwJob *job)
+{
+	c_list_unlink_stable (&job->jobs_lst);
+	g_strfreev (job->rules);
+	g_slice_free (FwJob, job);
+}
+
+static void
+_fw_job_complete (FwJob *job)
+{
+	c_list_unlink_stable (&job->jobs_lst);
+	if (job->callback)
+		job->callback (job, job->user_data);
+	_fw_job_free (job);
+}
+
+static void
+_fw_job_done (int status)
+{
+	FwJob *job;
+
+	job = c_list_first_entry (&_fw.jobs_lst_head, FwJob, jobs_lst);
+	nm_assert (job);
+
+	if (!job->fallback) {
+		if (WIFEXITED (status) && WEXITSTATUS (status) == 0) {
+			_fw_job_complete (job);
+			return;
+		}
+
+		/* iptables-restore either applies the whole table or nothing. Retry
+		 * rule by rule, so that a single bad (or, on removal, already missing)
+		 * rule doesn't prevent the others. */
+		_LOGW ("%s failed (%s %d), falling back to one call per rule",
+		       IPTABLES_RESTORE_PATH,
+		       WIFEXITED (status) ? "exit status" : "signal",
+		       WIFEXITED (status) ? WEXITSTATUS (status) : WTERMSIG (status));
+		job->fallback = TRUE;
+	} else {
+		if (!WIFEXITED (status) || WEXITSTATUS (status)) {
+			_LOGW ("** Command %s %d.",
+			       WIFEXITED (status) ? "returned exit status" : "was killed by signal",
+			       WIFEXITED (status) ? WEXITSTATUS (status) : WTERMSIG (status));
+		}
+		job->fallback_idx++;
+	}
+}
+
+static void
+_fw_watch_cb (GPid pid, int status, gpointer user_data)
+{
+	nm_assert (pid == _fw.pid);
+
+	_fw.pid = -1;
+
+	_fw_job_done (status);
+	_fw_process_schedule ();
+}
+
+static gboolean
+_fw_spawn (const char *const*argv, int *out_stdin_fd)
+{
+	const char *envp[1] = { NULL };
+	gs_free_error GError *error = NULL;
+	GSource *source;
+
+	if (!g_spawn_async_with_pipes ("/",
+	                               (char **) argv,
+	                               (char **) envp,
+	                                 G_SPAWN_DO_NOT_REAP_CHILD
+	                               | G_SPAWN_STDOUT_TO_DEV_NULL
+	                               | G_SPAWN_STDERR_TO_DEV_NULL,
+	                               nm_utils_setpgid,
+	                               NULL,
+	                               &_fw.pid,
+	                               out_stdin_fd,
+	                               NULL,
+	                               NULL,
+	                               &error)) {
+		_fw.pid = -1;
+		if (   !out_stdin_fd
+		    || !g_error_matches (error, G_SPAWN_ERROR, G_SPAWN_ERROR_NOENT))
+			_LOGW ("Error executing command: %s", error->message);
+		else {
+			_LOGD ("%s not available, using %s for each rule", argv[0], IPTABLES_PATH);
+			_fw.restore_unavailable = TRUE;
+		}
+		return FALSE;
+	}
+
+	/* the child is only ever reaped by the child watch, also while
+	 * flushing. */
+	source = g_child_watch_source_new (_fw.pid);
+	g_source_set_callback (source, (GSourceFunc) _fw_watch_cb, NULL, NULL);
+	g_source_attach (source, _fw.context);
+	g_source_unref (source);
+	return TRUE;
+}
+
+static gboolean
+_fw_job_spawn_restore (FwJob *job)
+{
+	static const char *const argv[] = { IPTABLES_RESTORE_PATH, "--noflush", NULL };
+	nm_auto_free_gstring GString *str = NULL;
+	gs_unref_hashtable GHashTable *tables = NULL;
+	int fd;
+	gsize written;
+	guint i, j;
+
+	str = g_string_new (NULL);
+	tables = g_hash_table_new (nm_str_hash, g_str_equal);
+
+	/* Rules are grouped per table, but within a table they keep their
+	 * relative order. */
+	for (i = 0; i < job->n_rules; i++) {
+		const char *table = job->rules[2 * i];
+
+		if (!g_hash_table_add (tables, (gpointer) table))
+			continue;
+
+		g_string_append_printf (str, "*%s\n", table);
+		for (j = i; j < job->n_rules; j++) {
+			if (!nm_streq (job->rules[2 * j], table))
+				continue;
+			g_string_append_printf (str, "%s %s\n",
+			                        job->add ? "-I" : "-D",
+			                        job->rules[2 * j + 1]);
+		}
+		g_string_append (str, "COMMIT\n");
+	}
+
+	if (!_fw_spawn (argv, &fd))
+		return FALSE;
+
+	_LOGI ("Executing: %s --noflush (%s %u rules)",
+	       IPTABLES_RESTORE_PATH,
+	       job->add ? "insert" : "delete",
+	       job->n_rules);
+	_LOGT ("%s input:\n%s", IPTABLES_RESTORE_PATH, str->str);
+
+	/* the input is small and fits into the pipe buffer. */
+	written = 0;
+	while (written < str->len) {
+		gssize l;
+
+		l = write (fd, &str->str[written], str->len - written);
+		if (l < 0) {
+			if (errno == EINTR)
+				continue;
+			_LOGW ("failure to write rules to %s: %s",
+			       IPTABLES_RESTORE_PATH,
+			       nm_strerror_native (errno));
+			break;
+		}
+		written += l;
+	}
+	nm_close (fd);
+	return TRUE;
+}
+
+static gboolean
+_fw_job_spawn_fallback (FwJob *job)
+{
+	for (; job->fallback_idx < job->n_rules; job->fallback_idx++) {
+		gs_strfreev char **argv = NULL;
+		gs_free char *cmd = NULL;
+
+		cmd = g_strdup_printf ("%s --table %s %s %s",
+		                       IPTABLES_PATH,
+		                       job->rules[2 * job->fallback_idx],
+		                       job->add ? "--insert" : "--delete",
+		                       job->rules[2 * job->fallback_idx + 1]);
+		argv = g_strsplit (cmd, " ", 0);
+
+		_LOGI ("Executing: %s", cmd);
+		if (_fw_spawn ((const char *const*) argv, NULL))
+			return TRUE;
+	}
+	return FALSE;
+}
+
+static gboolean
+_fw_job_spawn (FwJob *job)
+{
+	if (   !job->fallback
+	    && !_fw.restore_unavailable) {
+		if (_fw_job_spawn_restore (job))
+			return TRUE;
+		job->fallback = TRUE;
+	}
+
+	return _fw_job_spawn_fallback (job);
+}
+
+static gboolean
+_fw_process_cb (gpointer user_data)
+{
+	FwJob *job;
+
+	nm_clear_g_source_inst (&_fw.process_source);
+
+	/* a callback might have issued a new request, and with it this
+	 * source, while the loop below started the next job already. */
+	if (_fw.pid != -1)
+		return G_SOURCE_REMOVE;
+
+	while ((job = c_list_first_entry (&_fw.jobs_lst_head, FwJob, jobs_lst))) {
+		if (   job->n_rules > 0
+		    && _fw_job_spawn (job))
+			return G_SOURCE_REMOVE;
+
+		/* nothing (more) to spawn. The job is done. */
+		_fw_job_complete (job);
+	}
+
+	return G_SOURCE_REMOVE;
+}
+
+/* Start the next job, unless one is running. This always happens from
+ * the context, so that the callback of a job is never invoked before
+ * nm_firewall_share_rules_apply() returns. */
+static void
+_fw_process_schedule (void)
+{
+	if (   _fw.pid != -1
+	    || _fw.process_source)
+		return;
+
+	_fw.process_source = g_idle_source_new ();
+	g_source_set_callback (_fw.process_source, _fw_process_cb, NULL, NULL);
+	g_source_attach (_fw.process_source, _fw.context);
+}
+
+static void
+_fw_context_init (void)
+{
+	if (_fw.context)
+		return;
+
+	_fw.context = g_main_context_new ();
+	if (!_fw.flushed) {
+		_fw.integrate_source = nm_utils_g_main_context_create_integrate_source (_fw.context);
+		g_source_attach (_fw.integrate_source, NULL);
+	}
+}
+
+/* Iterate the context until all jobs are done. */
+static void
+_fw_run (void)
+{
+	nm_assert (_fw.flushed);
+	nm_assert (!_fw.integrate_source);
+
+	while (!c_list_is_empty (&_fw.jobs_lst_head))
+		g_main_context_iteration (_fw.context, TRUE);
+}
+
+/*****************************************************************************/
+
+/**
+ * nm_firewall_share_rules_apply:
+ * @rules: the rules to insert or delete, in the order in which
+ *   they get applied.
+ * @n_rules: the number of rules
+ * @add: whether to insert or to delete the rules
+ * @callback: (allow-none): invoked once the request is done
+ * @user_data: the user data for @callback
+ *
+ * Applies the iptables rules for a shared connection. All rules are
+ * handed to a single iptables-restore call, which commits them atomically
+ * per table. If that is not possible, iptables gets called for each rule.
+ * Requests are applied strictly in the order in which they are issued.
+ *
+ * The rules are applied asynchronously. @callback is invoked when they
+ * are in place (or when applying them failed), but never before this
+ * function returns.
+ *
+ * Returns: the call id that can be passed to nm_firewall_share_rules_cancel(),
+ *   or %NULL if there is no @callback. It is invalid after @callback
+ *   got invoked.
+ */
+NMFirewallShareCallId *
+nm_firewall_share_rules_apply (const NMFirewallShareRule *rules,
+                               guint n_rules,
+                               gboolean add,
+                               NMFirewallShareCallback callback,
+                               gpointer user_data)
+{
+	FwJob *job;
+	guint i;
+
+	g_return_val_if_fail (rules || n_rules == 0, NULL);
+
+	if (   n_rules == 0
+	    && !callback)
+		return NULL;
+
+	_fw_context_init ();
+
+	job = g_slice_new0 (FwJob);
+	job->add = add;
+	job->callback = callback;
+	job->user_data = user_data;
+	job->n_rules = n_rules;
+	job->rules = g_new (char *, 2 * n_rules + 1);
+	for (i = 0; i < n_rules; i++) {
+		job->rules[2 * i]     = g_strdup (rules[i].table);
+		job->rules[2 * i + 1] = g_strdup (rules[i].rule);
+	}
+	job->rules[2 * n_rules] = NULL;
+
+	c_list_link_tail (&_fw.jobs_lst_head, &job->jobs_lst);
+	_fw_process_schedule ();
+
+	if (_fw.flushed) {
+		_fw_run ();
+		return NULL;
+	}
+
+	return callback ? job : NULL;
+}
+
+/**
+ * nm_firewall_share_rules_cancel:
+ * @call_id: the call id returned by nm_firewall_share_rules_apply()
+ *
+ * Drops the callback of a pending request. The rules still get applied,
+ * so that a later removal of the same rules finds them.
+ */
+void
+nm_firewall_share_rules_cancel (NMFirewallShareCallId *call_id)
+{
+	g_return_if_fail (call_id);
+
+	call_id->callback = NULL;
+	call_id->user_data = NULL;
+}
+
+/**
+ * nm_firewall_share_rules_flush:
+ *
+ * Applies all pending requests synchronously. Call this on shutdown,
+ * so that no rules stay behind. Later requests are applied synchronously
+ * too, and their callback is invoked before nm_firewall_share_rules_apply()
+ * returns.
+ */
+void
+nm_firewall_share_rules_flush (void)
+{
+	if (_fw.flushed)
+		return;
+
+	_fw.flushed = TRUE;
+
+	if (!_fw.context)
+		return;
+
+	/* the context cannot be iterated while it is integrated. */
+	nm_clear_g_source_inst (&_fw.integrate_source);
+	_fw_run ();
+}
@@ -0,0 +1,29 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Copyright (C) 2020 Red Hat, Inc.
+ */
+
+#ifndef __NM_FIREWALL_UTILS_H__
+#define __NM_FIREWALL_UTILS_H__
+
+typedef struct {
+	const char *table;
+	const char *rule;
+} NMFirewallShareRule;
+
+typedef struct _NMFirewallShareCallId NMFirewallShareCallId;
+
+typedef void (*NMFirewallShareCallback) (NMFirewallShareCallId *call_id,
+                                         gpointer user_data);
+
+NMFirewallShareCallId *nm_firewall_share_rules_apply (const NMFirewallShareRule *rules,
+                                                      guint n_rules,
+                                                      gboolean add,
+                                                      NMFirewallShareCallback callback,
+                                                      gpointer user_data);
+
+void nm_firewall_share_rules_cancel (NMFirewallShareCallId *call_id);
+
+void nm_firewall_share_rules_flush (void);
+
+#endif /* __NM_FIREWALL_UTILS_H__ */
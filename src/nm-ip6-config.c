@@ -45,6 +45,7 @@ typedef struct {
 	int ifindex;
 	int dns_priority;
 	NMSettingIP6ConfigPrivacy privacy;
+	guint32 dad_ifa_flags;
 	GArray *nameservers;
 	GPtrArray *domains;
 	GPtrArray *searches;
@@ -124,6 +125,16 @@ nm_ip6_config_set_privacy (NMIP6Config *self, NMSettingIP6ConfigPrivacy privacy)
 	priv->privacy = privacy;
 }
 
+void
+nm_ip6_config_set_dad_ifa_flags (NMIP6Config *self, guint32 dad_ifa_flags)
+{
+	NMIP6ConfigPrivate *priv = NM_IP6_CONFIG_GET_PRIVATE (self);
+
+	nm_assert (NM_IN_SET (dad_ifa_flags, 0, IFA_F_OPTIMISTIC, IFA_F_NODAD));
+
+	priv->dad_ifa_flags = dad_ifa_flags;
+}
+
 /*****************************************************************************/
 
 const NMDedupMultiHeadEntry *
@@ -559,8 +570,10 @@ nm_ip6_config_commit (const NMIP6Config *self,
 	gs_unref_ptrarray GPtrArray *addresses = NULL;
 	gs_unref_ptrarray GPtrArray *routes = NULL;
 	gs_unref_ptrarray GPtrArray *routes_prune = NULL;
+	guint32 dad_ifa_flags;
 	int ifindex;
 	gboolean success = TRUE;
+	guint i;
 
 	g_return_val_if_fail (NM_IS_IP6_CONFIG (self), FALSE);
 
@@ -570,6 +583,27 @@ nm_ip6_config_commit (const NMIP6Config *self,
 	addresses = nm_dedup_multi_objs_to_ptr_array_head (nm_ip6_config_lookup_addresses (self),
 	                                                   NULL, NULL);
 
+	/* Request optimistic DAD or no DAD at all for the addresses that we add.
+	 * Addresses generated by kernel follow the "optimistic_dad" and
+	 * "accept_dad" sysctls instead. */
+	dad_ifa_flags = NM_IP6_CONFIG_GET_PRIVATE (self)->dad_ifa_flags;
+	if (   dad_ifa_flags
+	    && addresses) {
+		for (i = 0; i < addresses->len; i++) {
+			const NMPlatformIP6Address *a = NMP_OBJECT_CAST_IP6_ADDRESS (addresses->pdata[i]);
+			NMPObject *obj;
+
+			if (   a->addr_source == NM_IP_CONFIG_SOURCE_KERNEL
+			    || NM_FLAGS_ALL (a->n_ifa_flags, dad_ifa_flags))
+				continue;
+
+			obj = nmp_object_clone (addresses->pdata[i], FALSE);
+			obj->ip6_address.n_ifa_flags |= dad_ifa_flags;
+			nmp_object_unref (addresses->pdata[i]);
+			addresses->pdata[i] = obj;
+		}
+	}
+
 	routes = nm_dedup_multi_objs_to_ptr_array_head (nm_ip6_config_lookup_routes (self),
 	                                                NULL, NULL);
 
@@ -1519,6 +1553,11 @@ nm_ip6_config_replace (NMIP6Config *dst, const NMIP6Config *src, gboolean *relev
 		has_minor_changes = TRUE;
 	}
 
+	if (src_priv->dad_ifa_flags != dst_priv->dad_ifa_flags) {
+		dst_priv->dad_ifa_flags = src_priv->dad_ifa_flags;
+		has_minor_changes = TRUE;
+	}
+
 	if (src_priv->ipv6_disabled != dst_priv->ipv6_disabled) {
 		dst_priv->ipv6_disabled = src_priv->ipv6_disabled;
 		has_minor_changes = TRUE;
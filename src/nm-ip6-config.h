@@ -194,6 +194,7 @@ void nm_ip6_config_hash (const NMIP6Config *self, GChecksum *sum, gboolean dns_o
 gboolean nm_ip6_config_equal (const NMIP6Config *a, const NMIP6Config *b);
 
 void nm_ip6_config_set_privacy (NMIP6Config *self, NMSettingIP6ConfigPrivacy privacy);
+void nm_ip6_config_set_dad_ifa_flags (NMIP6Config *self, guint32 dad_ifa_flags);
 
 struct _NMNDiscAddress;
 void nm_ip6_config_reset_addresses_ndisc (NMIP6Config *self,
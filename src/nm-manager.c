@@ -150,6 +150,20 @@ typedef struct {
 
 	CList devices_lst_head;
 
+	struct {
+		GHashTable *by_device;
+		GHashTable *by_ifindex;
+		GHashTable *by_iface;
+		GHashTable *by_ip_iface;
+		GHashTable *by_perm_hw_addr;
+		GHashTable *perm_hw_addr_pending;
+		guint64 seq;
+	} devices_idx;
+
+	/* links for which no device is created because of main.ignore-links.
+	 * Maps the ifindex to the interface name. */
+	GHashTable *ignored_links;
+
 	NMState state;
 	NMConfig *config;
 	NMConnectivity *concheck_mgr;
@@ -340,6 +354,8 @@ static void settings_startup_complete_changed (NMSettings *settings,
 
 static void retry_connections_for_parent_device (NMManager *self, NMDevice *device);
 
+static void _platform_link_cb_schedule (NMManager *self, int ifindex);
+
 static void active_connection_state_changed (NMActiveConnection *active,
                                              GParamSpec *pspec,
                                              NMManager *self);
@@ -1092,6 +1108,48 @@ nm_manager_get_activatable_connections (NMManager *manager,
 	                                          NULL);
 }
 
+/**
+ * nm_manager_get_autoconnect_candidates:
+ * @manager: the #NMManager
+ * @device: the #NMDevice which is about to autoconnect
+ * @out_len: (allow-none): the number of returned profiles
+ *
+ * Like nm_manager_get_activatable_connections() for auto activation,
+ * but only returns the profiles that have autoconnect enabled and that
+ * are plausible for @device, based on the connection type and the
+ * interface name. The caller still needs to check nm_device_can_auto_connect().
+ *
+ * Returns: (transfer container): the %NULL terminated list of candidates,
+ *   sorted by autoconnect priority.
+ */
+NMSettingsConnection **
+nm_manager_get_autoconnect_candidates (NMManager *manager,
+                                       NMDevice *device,
+                                       guint *out_len)
+{
+	NMManagerPrivate *priv = NM_MANAGER_GET_PRIVATE (manager);
+	const GetActivatableConnectionsFilterData d = {
+		.self = manager,
+		.for_auto_activation = TRUE,
+	};
+	NMSettingsConnection **list;
+	guint i, j;
+
+	list = nm_settings_get_autoconnect_candidates (priv->settings,
+	                                               NM_DEVICE_GET_CLASS (device)->connection_type_check_compatible,
+	                                               nm_device_get_iface (device),
+	                                               NULL);
+
+	for (i = 0, j = 0; list[i]; i++) {
+		if (_get_activatable_connections_filter (priv->settings, list[i], (gpointer) &d))
+			list[j++] = list[i];
+	}
+	list[j] = NULL;
+
+	NM_SET_OUT (out_len, j);
+	return list;
+}
+
 static NMActiveConnection *
 active_connection_get_by_path (NMManager *self, const char *path)
 {
@@ -1111,9 +1169,39 @@ active_connection_get_by_path (NMManager *self, const char *path)
 
 /*****************************************************************************/
 
+static void
+_ignored_links_recheck (NMManager *self, const NMConfigData *config_data)
+{
+	NMManagerPrivate *priv = NM_MANAGER_GET_PRIVATE (self);
+	GHashTableIter iter;
+	gpointer key;
+
+	/* links that are no longer ignored get a device. Note that links
+	 * that now would be ignored keep their existing device. */
+	g_hash_table_iter_init (&iter, priv->ignored_links);
+	while (g_hash_table_iter_next (&iter, &key, NULL)) {
+		int ifindex = GPOINTER_TO_INT (key);
+		const NMPlatformLink *plink;
+
+		plink = nm_platform_link_get (priv->platform, ifindex);
+		if (   plink
+		    && nm_config_data_get_ignore_link (config_data, plink))
+			continue;
+
+		g_hash_table_iter_remove (&iter);
+		if (plink)
+			_platform_link_cb_schedule (self, ifindex);
+	}
+}
+
 static void
 _config_changed_cb (NMConfig *config, NMConfigData *config_data, NMConfigChangeFlags changes, NMConfigData *old_data, NMManager *self)
 {
+	NMManagerPrivate *priv = NM_MANAGER_GET_PRIVATE (self);
+
+	if (g_hash_table_size (priv->ignored_links) > 0)
+		_ignored_links_recheck (self, config_data);
+
 	g_object_freeze_notify (G_OBJECT (self));
 
 	if (NM_FLAGS_HAS (changes, NM_CONFIG_CHANGE_GLOBAL_DNS_CONFIG))
@@ -1222,6 +1310,280 @@ impl_manager_reload (NMDBusObject *obj,
 
 /*****************************************************************************/
 
+/* Index of the devices in devices_lst_head by their lookup keys. The
+ * keys are updated whenever the device notifies about a change of
+ * them. As a device might change a key while its notifications are frozen,
+ * the lookups always verify the current value of the device.
+ *
+ * Each index maps a key to a GPtrArray of DeviceIdxEntry, sorted in the
+ * order in which the devices were added (which is also their order in
+ * devices_lst_head). */
+typedef struct {
+	NMDevice *device;
+	guint64 seq;
+	int ifindex;
+	char *iface;
+	char *ip_iface;
+
+	/* the permanent MAC address, normalized by _devices_idx_hwaddr_normalize(). */
+	char *perm_hw_addr;
+
+	/* whether the device didn't yet determine its permanent MAC address. */
+	bool perm_hw_addr_pending:1;
+} DeviceIdxEntry;
+
+static char *
+_devices_idx_hwaddr_normalize (const char *hwaddr)
+{
+	guint8 bin[NM_UTILS_HWADDR_LEN_MAX];
+	gsize len;
+
+	if (   !hwaddr
+	    || !_nm_utils_hwaddr_aton (hwaddr, bin, sizeof (bin), &len))
+		return NULL;
+
+	/* like nm_utils_hwaddr_matches(), only the last 8 bytes of an
+	 * infiniband address are significant. */
+	if (len == INFINIBAND_ALEN)
+		memset (bin, 0, INFINIBAND_ALEN - 8);
+	return nm_utils_hwaddr_ntoa (bin, len);
+}
+
+static int
+_devices_idx_entry_cmp_seq_p (gconstpointer a, gconstpointer b, gpointer user_data)
+{
+	const DeviceIdxEntry *entry_a = *((const DeviceIdxEntry *const*) a);
+	const DeviceIdxEntry *entry_b = *((const DeviceIdxEntry *const*) b);
+
+	NM_CMP_FIELD (entry_a, entry_b, seq);
+	return 0;
+}
+
+static GPtrArray *
+_devices_idx_lookup (GHashTable *idx, gconstpointer key)
+{
+	if (!key)
+		return NULL;
+	return g_hash_table_lookup (idx, key);
+}
+
+static void
+_devices_idx_bucket_add (GHashTable *idx, gconstpointer key, gboolean key_is_str, DeviceIdxEntry *entry)
+{
+	GPtrArray *bucket;
+	guint i;
+
+	if (!key)
+		return;
+
+	bucket = g_hash_table_lookup (idx, key);
+	if (!bucket) {
+		bucket = g_ptr_array_new ();
+		g_hash_table_insert (idx,
+		                     key_is_str ? g_strdup (key) : (gpointer) key,
+		                     bucket);
+	}
+
+	for (i = bucket->len; i > 0; i--) {
+		if (((DeviceIdxEntry *) bucket->pdata[i - 1])->seq < entry->seq)
+			break;
+	}
+	g_ptr_array_insert (bucket, i, entry);
+}
+
+static void
+_devices_idx_bucket_remove (GHashTable *idx, gconstpointer key, DeviceIdxEntry *entry)
+{
+	GPtrArray *bucket;
+
+	if (!key)
+		return;
+
+	bucket = g_hash_table_lookup (idx, key);
+	if (!bucket)
+		g_return_if_reached ();
+	if (!g_ptr_array_remove (bucket, entry))
+		g_return_if_reached ();
+	if (bucket->len == 0)
+		g_hash_table_remove (idx, key);
+}
+
+static void
+_devices_idx_set_pending (NMManager *self, DeviceIdxEntry *entry, gboolean pending)
+{
+	NMManagerPrivate *priv = NM_MANAGER_GET_PRIVATE (self);
+
+	if (entry->perm_hw_addr_pending == (!!pending))
+		return;
+
+	entry->perm_hw_addr_pending = pending;
+	if (pending)
+		g_hash_table_add (priv->devices_idx.perm_hw_addr_pending, entry);
+	else
+		g_hash_table_remove (priv->devices_idx.perm_hw_addr_pending, entry);
+}
+
+static void
+_devices_idx_update (NMManager *self, NMDevice *device)
+{
+	NMManagerPrivate *priv = NM_MANAGER_GET_PRIVATE (self);
+	DeviceIdxEntry *entry;
+	const char *str;
+	char *perm_hw_addr;
+	int ifindex;
+
+	entry = g_hash_table_lookup (priv->devices_idx.by_device, device);
+	if (!entry)
+		return;
+
+	ifindex = nm_device_get_ifindex (device);
+	if (ifindex <= 0)
+		ifindex = 0;
+	if (entry->ifindex != ifindex) {
+		_devices_idx_bucket_remove (priv->devices_idx.by_ifindex, GINT_TO_POINTER (entry->ifindex), entry);
+		entry->ifindex = ifindex;
+		_devices_idx_bucket_add (priv->devices_idx.by_ifindex, GINT_TO_POINTER (entry->ifindex), FALSE, entry);
+	}
+
+	str = nm_device_get_iface (device);
+	if (!nm_streq0 (entry->iface, str)) {
+		_devices_idx_bucket_remove (priv->devices_idx.by_iface, entry->iface, entry);
+		g_free (entry->iface);
+		entry->iface = g_strdup (str);
+		_devices_idx_bucket_add (priv->devices_idx.by_iface, entry->iface, TRUE, entry);
+	}
+
+	str = nm_device_get_ip_iface (device);
+	if (!nm_streq0 (entry->ip_iface, str)) {
+		_devices_idx_bucket_remove (priv->devices_idx.by_ip_iface, entry->ip_iface, entry);
+		g_free (entry->ip_iface);
+		entry->ip_iface = g_strdup (str);
+		_devices_idx_bucket_add (priv->devices_idx.by_ip_iface, entry->ip_iface, TRUE, entry);
+	}
+
+	/* don't force the device to determine its permanent MAC address. Devices
+	 * without ifindex or without current MAC address cannot determine one,
+	 * don't keep them pending. */
+	str = nm_device_get_permanent_hw_address_full (device, FALSE, NULL);
+	_devices_idx_set_pending (self,
+	                          entry,
+	                             !str
+	                          && ifindex > 0
+	                          && nm_device_get_hw_address (device));
+	perm_hw_addr = _devices_idx_hwaddr_normalize (str);
+	if (!nm_streq0 (entry->perm_hw_addr, perm_hw_addr)) {
+		_devices_idx_bucket_remove (priv->devices_idx.by_perm_hw_addr, entry->perm_hw_addr, entry);
+		g_free (entry->perm_hw_addr);
+		entry->perm_hw_addr = g_steal_pointer (&perm_hw_addr);
+		_devices_idx_bucket_add (priv->devices_idx.by_perm_hw_addr, entry->perm_hw_addr, TRUE, entry);
+	} else
+		g_free (perm_hw_addr);
+}
+
+static void
+_devices_idx_add (NMManager *self, NMDevice *device)
+{
+	NMManagerPrivate *priv = NM_MANAGER_GET_PRIVATE (self);
+	DeviceIdxEntry *entry;
+
+	nm_assert (!g_hash_table_contains (priv->devices_idx.by_device, device));
+
+	entry = g_slice_new (DeviceIdxEntry);
+	*entry = (DeviceIdxEntry) {
+		.device = device,
+		.seq    = ++priv->devices_idx.seq,
+	};
+	g_hash_table_insert (priv->devices_idx.by_device, device, entry);
+	_devices_idx_update (self, device);
+}
+
+static void
+_devices_idx_remove (NMManager *self, NMDevice *device)
+{
+	NMManagerPrivate *priv = NM_MANAGER_GET_PRIVATE (self);
+	DeviceIdxEntry *entry;
+
+	entry = g_hash_table_lookup (priv->devices_idx.by_device, device);
+	if (!entry)
+		return;
+
+	_devices_idx_bucket_remove (priv->devices_idx.by_ifindex, GINT_TO_POINTER (entry->ifindex), entry);
+	_devices_idx_bucket_remove (priv->devices_idx.by_iface, entry->iface, entry);
+	_devices_idx_bucket_remove (priv->devices_idx.by_ip_iface, entry->ip_iface, entry);
+	_devices_idx_bucket_remove (priv->devices_idx.by_perm_hw_addr, entry->perm_hw_addr, entry);
+	g_hash_table_remove (priv->devices_idx.perm_hw_addr_pending, entry);
+	g_hash_table_remove (priv->devices_idx.by_device, device);
+
+	g_free (entry->iface);
+	g_free (entry->ip_iface);
+	g_free (entry->perm_hw_addr);
+	g_slice_free (DeviceIdxEntry, entry);
+}
+
+static void
+_devices_idx_init (NMManager *self)
+{
+	NMManagerPrivate *priv = NM_MANAGER_GET_PRIVATE (self);
+
+	priv->devices_idx.by_device = g_hash_table_new (nm_direct_hash, NULL);
+	priv->devices_idx.by_ifindex = g_hash_table_new_full (nm_direct_hash, NULL, NULL, (GDestroyNotify) g_ptr_array_unref);
+	priv->devices_idx.by_iface = g_hash_table_new_full (nm_str_hash, g_str_equal, g_free, (GDestroyNotify) g_ptr_array_unref);
+	priv->devices_idx.by_ip_iface = g_hash_table_new_full (nm_str_hash, g_str_equal, g_free, (GDestroyNotify) g_ptr_array_unref);
+	priv->devices_idx.by_perm_hw_addr = g_hash_table_new_full (nm_str_hash, g_str_equal, g_free, (GDestroyNotify) g_ptr_array_unref);
+	priv->devices_idx.perm_hw_addr_pending = g_hash_table_new (nm_direct_hash, NULL);
+}
+
+static void
+_devices_idx_clear (NMManager *self)
+{
+	NMManagerPrivate *priv = NM_MANAGER_GET_PRIVATE (self);
+
+	nm_assert (!priv->devices_idx.by_device || g_hash_table_size (priv->devices_idx.by_device) == 0);
+
+	nm_clear_pointer (&priv->devices_idx.by_device, g_hash_table_unref);
+	nm_clear_pointer (&priv->devices_idx.by_ifindex, g_hash_table_unref);
+	nm_clear_pointer (&priv->devices_idx.by_iface, g_hash_table_unref);
+	nm_clear_pointer (&priv->devices_idx.by_ip_iface, g_hash_table_unref);
+	nm_clear_pointer (&priv->devices_idx.by_perm_hw_addr, g_hash_table_unref);
+	nm_clear_pointer (&priv->devices_idx.perm_hw_addr_pending, g_hash_table_unref);
+}
+
+static void
+device_idx_keys_changed (NMDevice *device,
+                         NMManager *self)
+{
+	_devices_idx_update (self, device);
+}
+
+static NMDevice **
+_devices_idx_lookup_iface_all (NMManager *self, const char *iface, guint *out_len)
+{
+	NMManagerPrivate *priv = NM_MANAGER_GET_PRIVATE (self);
+	GPtrArray *bucket;
+	NMDevice **arr;
+	guint i, j;
+
+	bucket = _devices_idx_lookup (priv->devices_idx.by_iface, iface);
+	if (!bucket) {
+		*out_len = 0;
+		return NULL;
+	}
+
+	/* return a copy, so that the caller may modify the devices while iterating. */
+	arr = g_new (NMDevice *, bucket->len + 1);
+	for (i = 0, j = 0; i < bucket->len; i++) {
+		NMDevice *candidate = ((DeviceIdxEntry *) bucket->pdata[i])->device;
+
+		if (nm_streq0 (nm_device_get_iface (candidate), iface))
+			arr[j++] = candidate;
+	}
+	arr[j] = NULL;
+	*out_len = j;
+	return arr;
+}
+
+/*****************************************************************************/
+
 NMDevice *
 nm_manager_get_device_by_path (NMManager *self, const char *path)
 {
@@ -1245,15 +1607,21 @@ NMDevice *
 nm_manager_get_device_by_ifindex (NMManager *self, int ifindex)
 {
 	NMManagerPrivate *priv = NM_MANAGER_GET_PRIVATE (self);
-	NMDevice *device;
+	GPtrArray *bucket;
+	guint i;
 
-	if (ifindex > 0) {
-		c_list_for_each_entry (device, &priv->devices_lst_head, devices_lst) {
-			if (nm_device_get_ifindex (device) == ifindex)
-				return device;
-		}
-	}
+	if (ifindex <= 0)
+		return NULL;
 
+	bucket = _devices_idx_lookup (priv->devices_idx.by_ifindex, GINT_TO_POINTER (ifindex));
+	if (!bucket)
+		return NULL;
+	for (i = 0; i < bucket->len; i++) {
+		NMDevice *device = ((DeviceIdxEntry *) bucket->pdata[i])->device;
+
+		if (nm_device_get_ifindex (device) == ifindex)
+			return device;
+	}
 	return NULL;
 }
 
@@ -1261,34 +1629,79 @@ static NMDevice *
 find_device_by_permanent_hw_addr (NMManager *self, const char *hwaddr)
 {
 	NMManagerPrivate *priv = NM_MANAGER_GET_PRIVATE (self);
-	NMDevice *device;
+	gs_free char *hwaddr_normalized = NULL;
+	const DeviceIdxEntry *found = NULL;
 	const char *device_addr;
 	guint8 hwaddr_bin[NM_UTILS_HWADDR_LEN_MAX];
 	gsize hwaddr_len;
+	GPtrArray *bucket;
+	guint i;
 
 	g_return_val_if_fail (hwaddr != NULL, NULL);
 
 	if (!_nm_utils_hwaddr_aton (hwaddr, hwaddr_bin, sizeof (hwaddr_bin), &hwaddr_len))
 		return NULL;
 
-	c_list_for_each_entry (device, &priv->devices_lst_head, devices_lst) {
-		device_addr = nm_device_get_permanent_hw_address (device);
-		if (   device_addr
-		    && nm_utils_hwaddr_matches (hwaddr_bin, hwaddr_len, device_addr, -1))
-			return device;
+	hwaddr_normalized = _devices_idx_hwaddr_normalize (hwaddr);
+	bucket = _devices_idx_lookup (priv->devices_idx.by_perm_hw_addr, hwaddr_normalized);
+	if (bucket) {
+		for (i = 0; i < bucket->len; i++) {
+			const DeviceIdxEntry *entry = bucket->pdata[i];
+
+			device_addr = nm_device_get_permanent_hw_address_full (entry->device, FALSE, NULL);
+			if (   device_addr
+			    && nm_utils_hwaddr_matches (hwaddr_bin, hwaddr_len, device_addr, -1)) {
+				found = entry;
+				break;
+			}
+		}
 	}
-	return NULL;
+
+	if (g_hash_table_size (priv->devices_idx.perm_hw_addr_pending) > 0) {
+		gs_free DeviceIdxEntry **pending = NULL;
+		guint n_pending;
+
+		/* Devices that did not yet determine their permanent MAC address are
+		 * forced to do so now. Only do that for devices that come before the
+		 * found one, as a linear search would. */
+		pending = (DeviceIdxEntry **) g_hash_table_get_keys_as_array (priv->devices_idx.perm_hw_addr_pending, &n_pending);
+		g_qsort_with_data (pending, n_pending, sizeof (pending[0]), _devices_idx_entry_cmp_seq_p, NULL);
+
+		for (i = 0; i < n_pending; i++) {
+			NMDevice *device = pending[i]->device;
+
+			if (found && pending[i]->seq > found->seq)
+				break;
+			device_addr = nm_device_get_permanent_hw_address (device);
+			if (!device_addr) {
+				/* the device tried and failed. Don't retry on every lookup,
+				 * only once its ifindex or MAC address changes. */
+				_devices_idx_set_pending (self, pending[i], FALSE);
+				continue;
+			}
+			if (nm_utils_hwaddr_matches (hwaddr_bin, hwaddr_len, device_addr, -1))
+				return device;
+		}
+	}
+
+	return found ? found->device : NULL;
 }
 
 static NMDevice *
 find_device_by_ip_iface (NMManager *self, const char *iface)
 {
 	NMManagerPrivate *priv = NM_MANAGER_GET_PRIVATE (self);
-	NMDevice *device;
+	GPtrArray *bucket;
+	guint i;
 
 	g_return_val_if_fail (iface, NULL);
 
-	c_list_for_each_entry (device, &priv->devices_lst_head, devices_lst) {
+	bucket = _devices_idx_lookup (priv->devices_idx.by_ip_iface, iface);
+	if (!bucket)
+		return NULL;
+	for (i = 0; i < bucket->len; i++) {
+		NMDevice *device = ((DeviceIdxEntry *) bucket->pdata[i])->device;
+
 		if (   nm_device_is_real (device)
 		    && nm_streq0 (nm_device_get_ip_iface (device), iface))
 			return device;
@@ -1319,13 +1732,16 @@ find_device_by_iface (NMManager *self,
 {
 	NMManagerPrivate *priv = NM_MANAGER_GET_PRIVATE (self);
 	NMDevice *fallback = NULL;
-	NMDevice *candidate;
+	GPtrArray *bucket;
+	guint i;
 
 	g_return_val_if_fail (iface != NULL, NULL);
 
-	c_list_for_each_entry (candidate, &priv->devices_lst_head, devices_lst) {
+	bucket = _devices_idx_lookup (priv->devices_idx.by_iface, iface);
+	for (i = 0; bucket && i < bucket->len; i++) {
+		NMDevice *candidate = ((DeviceIdxEntry *) bucket->pdata[i])->device;
 
-		if (strcmp (nm_device_get_iface (candidate), iface))
+		if (!nm_streq0 (nm_device_get_iface (candidate), iface))
 			continue;
 		if (connection && !nm_device_check_connection_compatible (candidate, connection, NULL))
 			continue;
@@ -1666,6 +2082,7 @@ remove_device (NMManager *self,
 	nm_settings_device_removed (priv->settings, device, quitting);
 
 	c_list_unlink (&device->devices_lst);
+	_devices_idx_remove (self, device);
 
 	_parent_notify_changed (self, device, TRUE);
 
@@ -1885,12 +2302,16 @@ NMDevice *
 nm_manager_get_device (NMManager *self, const char *ifname, NMDeviceType device_type)
 {
 	NMManagerPrivate *priv = NM_MANAGER_GET_PRIVATE (self);
-	NMDevice *device;
+	GPtrArray *bucket;
+	guint i;
 
 	g_return_val_if_fail (ifname, NULL);
 	g_return_val_if_fail (device_type != NM_DEVICE_TYPE_UNKNOWN, NULL);
 
-	c_list_for_each_entry (device, &priv->devices_lst_head, devices_lst) {
+	bucket = _devices_idx_lookup (priv->devices_idx.by_iface, ifname);
+	for (i = 0; bucket && i < bucket->len; i++) {
+		NMDevice *device = ((DeviceIdxEntry *) bucket->pdata[i])->device;
+
 		if (   nm_device_get_device_type (device) == device_type
 		    && nm_streq0 (nm_device_get_iface (device), ifname))
 			return device;
@@ -2880,19 +3301,23 @@ device_ip_iface_changed (NMDevice *device,
                          GParamSpec *pspec,
                          NMManager *self)
 {
-	NMManagerPrivate *priv = NM_MANAGER_GET_PRIVATE (self);
-	const char *ip_iface = nm_device_get_ip_iface (device);
+	const char *ip_iface;
 	NMDeviceType device_type = nm_device_get_device_type (device);
-	NMDevice *candidate;
+	gs_free NMDevice **candidates = NULL;
+	guint i, n;
+
+	ip_iface = nm_device_get_ip_iface (device);
 
 	/* Remove NMDevice objects that are actually child devices of others,
 	 * when the other device finally knows its IP interface name.  For example,
 	 * remove the PPP interface that's a child of a WWAN device, since it's
 	 * not really a standalone NMDevice.
 	 */
-	c_list_for_each_entry (candidate, &priv->devices_lst_head, devices_lst) {
+	candidates = _devices_idx_lookup_iface_all (self, ip_iface, &n);
+	for (i = 0; i < n; i++) {
+		NMDevice *candidate = candidates[i];
+
 		if (   candidate != device
-		    && g_strcmp0 (nm_device_get_iface (candidate), ip_iface) == 0
 		    && nm_device_get_device_type (candidate) == device_type
 		    && nm_device_is_real (candidate)) {
 			remove_device (self, candidate, FALSE);
@@ -3107,6 +3532,7 @@ add_device (NMManager *self, NMDevice *device, GError **error)
 
 	nm_assert (c_list_is_empty (&device->devices_lst));
 	c_list_link_tail (&priv->devices_lst_head, &device->devices_lst);
+	_devices_idx_add (self, device);
 
 	g_signal_connect (device, NM_DEVICE_STATE_CHANGED,
 	                  G_CALLBACK (manager_device_state_changed),
@@ -3136,6 +3562,10 @@ add_device (NMManager *self, NMDevice *device, GError **error)
 	                  G_CALLBACK (device_iface_changed),
 	                  self);
 
+	g_signal_connect (device, NM_DEVICE_IDX_KEYS_CHANGED,
+	                  G_CALLBACK (device_idx_keys_changed),
+	                  self);
+
 	g_signal_connect (device, "notify::" NM_DEVICE_REAL,
 	                  G_CALLBACK (device_realized),
 	                  self);
@@ -3250,22 +3680,28 @@ platform_link_added (NMManager *self,
 	NMManagerPrivate *priv = NM_MANAGER_GET_PRIVATE (self);
 	NMDeviceFactory *factory;
 	NMDevice *device = NULL;
-	NMDevice *candidate;
+	gs_free NMDevice **candidates = NULL;
+	guint i, n_candidates;
 
 	g_return_if_fail (ifindex > 0);
 
 	if (nm_manager_get_device_by_ifindex (self, ifindex))
 		return;
 
+	if (g_hash_table_contains (priv->ignored_links, GINT_TO_POINTER (ifindex)))
+		return;
+
 	/* Let unrealized devices try to realize themselves with the link */
-	c_list_for_each_entry (candidate, &priv->devices_lst_head, devices_lst) {
+	candidates = _devices_idx_lookup_iface_all (self, plink->name, &n_candidates);
+	for (i = 0; i < n_candidates; i++) {
+		NMDevice *candidate = candidates[i];
 		gboolean compatible = TRUE;
 		gs_free_error GError *error = NULL;
 
 		if (nm_device_get_link_type (candidate) != plink->type)
 			continue;
 
-		if (strcmp (nm_device_get_iface (candidate), plink->name))
+		if (!nm_streq0 (nm_device_get_iface (candidate), plink->name))
 			continue;
 
 		if (nm_device_is_real (candidate)) {
@@ -3304,6 +3740,14 @@ platform_link_added (NMManager *self,
 	}
 
 add:
+	if (nm_config_data_get_ignore_link (nm_config_get_data (priv->config), plink)) {
+		/* Don't create a device for the link. It is only remembered, so that
+		 * further events for the link are cheap. */
+		_LOGT (LOGD_PLATFORM, "(%s): ignore link %d by configuration", plink->name, ifindex);
+		g_hash_table_insert (priv->ignored_links, GINT_TO_POINTER (ifindex), g_strdup (plink->name));
+		return;
+	}
+
 	/* Try registered device factories */
 	factory = nm_device_factory_manager_find_factory_for_link_type (plink->type);
 	if (factory) {
@@ -3406,6 +3850,9 @@ _platform_link_cb_idle (PlatformLinkCbData *data)
 		NMDevice *device;
 		GError *error = NULL;
 
+		if (g_hash_table_remove (priv->ignored_links, GINT_TO_POINTER (ifindex)))
+			return G_SOURCE_REMOVE;
+
 		device = nm_manager_get_device_by_ifindex (self, ifindex);
 		if (device) {
 			if (nm_device_is_software (device)) {
@@ -3428,6 +3875,19 @@ _platform_link_cb_idle (PlatformLinkCbData *data)
 	return G_SOURCE_REMOVE;
 }
 
+static void
+_platform_link_cb_schedule (NMManager *self, int ifindex)
+{
+	NMManagerPrivate *priv = NM_MANAGER_GET_PRIVATE (self);
+	PlatformLinkCbData *data;
+
+	data = g_slice_new (PlatformLinkCbData);
+	data->self = self;
+	data->ifindex = ifindex;
+	c_list_link_tail (&priv->link_cb_lst, &data->lst);
+	data->idle_id = g_idle_add ((GSourceFunc) _platform_link_cb_idle, data);
+}
+
 static void
 platform_link_cb (NMPlatform *platform,
                   int obj_type_i,
@@ -3436,22 +3896,12 @@ platform_link_cb (NMPlatform *platform,
                   int change_type_i,
                   gpointer user_data)
 {
-	NMManager *self;
-	NMManagerPrivate *priv;
 	const NMPlatformSignalChangeType change_type = change_type_i;
-	PlatformLinkCbData *data;
 
 	switch (change_type) {
 	case NM_PLATFORM_SIGNAL_ADDED:
 	case NM_PLATFORM_SIGNAL_REMOVED:
-		self = NM_MANAGER (user_data);
-		priv = NM_MANAGER_GET_PRIVATE (self);
-
-		data = g_slice_new (PlatformLinkCbData);
-		data->self = self;
-		data->ifindex = ifindex;
-		c_list_link_tail (&priv->link_cb_lst, &data->lst);
-		data->idle_id = g_idle_add ((GSourceFunc) _platform_link_cb_idle, data);
+		_platform_link_cb_schedule (NM_MANAGER (user_data), ifindex);
 		break;
 	default:
 		break;
@@ -7435,6 +7885,8 @@ nm_manager_init (NMManager *self)
 	c_list_init (&priv->auth_lst_head);
 	c_list_init (&priv->link_cb_lst);
 	c_list_init (&priv->devices_lst_head);
+	_devices_idx_init (self);
+	priv->ignored_links = g_hash_table_new_full (nm_direct_hash, NULL, NULL, g_free);
 	c_list_init (&priv->active_connections_lst_head);
 	c_list_init (&priv->async_op_lst_head);
 	c_list_init (&priv->delete_volatile_connection_lst_head);
@@ -7802,6 +8254,9 @@ finalize (GObject *object)
 
 	g_array_free (priv->capabilities, TRUE);
 
+	_devices_idx_clear (NM_MANAGER (object));
+	g_hash_table_unref (priv->ignored_links);
+
 	G_OBJECT_CLASS (nm_manager_parent_class)->finalize (object);
 
 	g_object_unref (priv->platform);
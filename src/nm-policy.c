@@ -1240,7 +1240,9 @@ auto_activate_device (NMPolicy *self,
 	if (!nm_device_autoconnect_allowed (device))
 		return;
 
-	connections = nm_manager_get_activatable_connections (priv->manager, TRUE, TRUE, &len);
+	/* The candidates have autoconnect enabled and are already sorted
+	 * by autoconnect priority. */
+	connections = nm_manager_get_autoconnect_candidates (priv->manager, device, &len);
 	if (!connections[0])
 		return;
 
@@ -1249,7 +1251,6 @@ auto_activate_device (NMPolicy *self,
 	for (i = 0; i < len; i++) {
 		NMSettingsConnection *candidate = connections[i];
 		NMConnection *cand_conn;
-		NMSettingConnection *s_con;
 		const char *permission;
 
 		if (nm_settings_connection_autoconnect_is_blocked (candidate))
@@ -1257,10 +1258,6 @@ auto_activate_device (NMPolicy *self,
 
 		cand_conn = nm_settings_connection_get_connection (candidate);
 
-		s_con = nm_connection_get_setting_connection (cand_conn);
-		if (!nm_setting_connection_get_autoconnect (s_con))
-			continue;
-
 		permission = nm_utils_get_shared_wifi_permission (cand_conn);
 		if (   permission
 		    && !nm_settings_connection_check_permission (candidate, permission))
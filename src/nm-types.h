@@ -39,6 +39,7 @@ typedef struct _NMKeepAlive          NMKeepAlive;
 typedef struct _NMSleepMonitor       NMSleepMonitor;
 typedef struct _NMLldpListener       NMLldpListener;
 typedef struct _NMConfigDeviceStateData NMConfigDeviceStateData;
+typedef struct _NMMatchSpec          NMMatchSpec;
 
 struct _NMDedupMultiIndex;
 
@@ -7980,6 +7980,17 @@ wifi_set_wake_on_wlan (NMPlatform *platform, int ifindex,
 	return nm_wifi_utils_set_wake_on_wlan (wifi_data, wowl);
 }
 
+static gboolean
+wifi_set_link_monitor (NMPlatform *platform,
+                       int ifindex,
+                       guint32 hysteresis,
+                       NMPlatformWifiLinkMonitorFunc callback,
+                       gpointer user_data)
+{
+	WIFI_GET_WIFI_DATA_NETNS (wifi_data, platform, ifindex, !callback);
+	return nm_wifi_utils_set_link_monitor (wifi_data, hysteresis, callback, user_data);
+}
+
 /*****************************************************************************/
 
 static gboolean
@@ -9256,6 +9267,7 @@ nm_linux_platform_class_init (NMLinuxPlatformClass *klass)
 	platform_class->wifi_indicate_addressing_running = wifi_indicate_addressing_running;
 	platform_class->wifi_get_wake_on_wlan = wifi_get_wake_on_wlan;
 	platform_class->wifi_set_wake_on_wlan = wifi_set_wake_on_wlan;
+	platform_class->wifi_set_link_monitor = wifi_set_link_monitor;
 
 	platform_class->mesh_get_channel = mesh_get_channel;
 	platform_class->mesh_set_channel = mesh_set_channel;
@@ -818,6 +818,95 @@ genl_ctrl_resolve (struct nl_sock *sk, const char *name)
 	return response_data;
 }
 
+typedef struct {
+	const char *grp_name;
+	gint32 grp_id;
+} GenlParseGetFamilyGrpData;
+
+static int
+_genl_parse_getfamily_grp (struct nl_msg *msg, void *arg)
+{
+	static const struct nla_policy ctrl_policy[] = {
+		[CTRL_ATTR_FAMILY_ID]    = { .type = NLA_U16 },
+		[CTRL_ATTR_MCAST_GROUPS] = { .type = NLA_NESTED },
+	};
+	static const struct nla_policy grp_policy[] = {
+		[CTRL_ATTR_MCAST_GRP_NAME] = { .type = NLA_STRING },
+		[CTRL_ATTR_MCAST_GRP_ID]   = { .type = NLA_U32 },
+	};
+	struct nlattr *tb[G_N_ELEMENTS (ctrl_policy)];
+	struct nlmsghdr *nlh = nlmsg_hdr (msg);
+	GenlParseGetFamilyGrpData *data = arg;
+	struct nlattr *mcgrp;
+	int rem;
+
+	if (genlmsg_parse_arr (nlh, 0, tb, ctrl_policy) < 0)
+		return NL_SKIP;
+
+	if (!tb[CTRL_ATTR_MCAST_GROUPS])
+		return NL_STOP;
+
+	nla_for_each_nested (mcgrp, tb[CTRL_ATTR_MCAST_GROUPS], rem) {
+		struct nlattr *tb_grp[G_N_ELEMENTS (grp_policy)];
+
+		if (nla_parse_nested_arr (tb_grp, mcgrp, grp_policy) < 0)
+			continue;
+		if (   !tb_grp[CTRL_ATTR_MCAST_GRP_NAME]
+		    || !tb_grp[CTRL_ATTR_MCAST_GRP_ID])
+			continue;
+		if (!nm_streq (nla_data (tb_grp[CTRL_ATTR_MCAST_GRP_NAME]), data->grp_name))
+			continue;
+
+		data->grp_id = nla_get_u32 (tb_grp[CTRL_ATTR_MCAST_GRP_ID]);
+		break;
+	}
+
+	return NL_STOP;
+}
+
+int
+genl_ctrl_resolve_grp (struct nl_sock *sk, const char *family_name, const char *grp_name)
+{
+	nm_auto_nlmsg struct nl_msg *msg = NULL;
+	int nmerr;
+	GenlParseGetFamilyGrpData response_data = {
+		.grp_name = grp_name,
+		.grp_id = -1,
+	};
+	const struct nl_cb cb = {
+		.valid_cb = _genl_parse_getfamily_grp,
+		.valid_arg = &response_data,
+	};
+
+	msg = nlmsg_alloc ();
+
+	if (!genlmsg_put (msg, NL_AUTO_PORT, NL_AUTO_SEQ, GENL_ID_CTRL,
+	                  0, 0, CTRL_CMD_GETFAMILY, 1))
+		return -ENOMEM;
+
+	nmerr = nla_put_string (msg, CTRL_ATTR_FAMILY_NAME, family_name);
+	if (nmerr < 0)
+		return nmerr;
+
+	nmerr = nl_send_auto (sk, msg);
+	if (nmerr < 0)
+		return nmerr;
+
+	nmerr = nl_recvmsgs (sk, &cb);
+	if (nmerr < 0)
+		return nmerr;
+
+	/* If search was successful, request may be ACKed after data */
+	nmerr = nl_wait_for_ack (sk, NULL);
+	if (nmerr < 0)
+		return nmerr;
+
+	if (response_data.grp_id < 0)
+		return -NME_UNSPEC;
+
+	return response_data.grp_id;
+}
+
 /*****************************************************************************/
 
 struct nl_sock *
@@ -622,6 +622,8 @@ int genlmsg_parse (struct nlmsghdr *nlh,
 
 int genl_ctrl_resolve (struct nl_sock *sk, const char *name);
 
+int genl_ctrl_resolve_grp (struct nl_sock *sk, const char *family_name, const char *grp_name);
+
 /*****************************************************************************/
 
 #endif /* __NM_NETLINK_H__ */
@@ -3024,6 +3024,41 @@ nm_platform_wifi_set_wake_on_wlan (NMPlatform *self, int ifindex, NMSettingWirel
 	return klass->wifi_set_wake_on_wlan (self, ifindex, wowl);
 }
 
+/**
+ * nm_platform_wifi_set_link_monitor:
+ * @self: the #NMPlatform
+ * @ifindex: the Wi-Fi interface
+ * @hysteresis: the signal change in dBm that triggers a notification
+ * @callback: (allow-none): invoked with the new quality and bitrate, or
+ *   %NULL to stop monitoring
+ * @user_data: data for @callback
+ *
+ * Subscribes to signal quality changes of the current BSS, as reported by
+ * driver events. The bitrate is reported along with them, but a change of
+ * the bitrate alone triggers no notification. The interface must be
+ * associated, as the notifications are relative to the current signal.
+ *
+ * Returns: %FALSE if the driver does not report such events, or the
+ *   interface is not associated. In that case the caller has to poll
+ *   nm_platform_wifi_get_quality() and nm_platform_wifi_get_rate().
+ */
+gboolean
+nm_platform_wifi_set_link_monitor (NMPlatform *self,
+                                   int ifindex,
+                                   guint32 hysteresis,
+                                   NMPlatformWifiLinkMonitorFunc callback,
+                                   gpointer user_data)
+{
+	_CHECK_SELF (self, klass, FALSE);
+
+	g_return_val_if_fail (ifindex > 0, FALSE);
+
+	if (!klass->wifi_set_link_monitor)
+		return !callback;
+
+	return klass->wifi_set_link_monitor (self, ifindex, hysteresis, callback, user_data);
+}
+
 guint32
 nm_platform_mesh_get_channel (NMPlatform *self, int ifindex)
 {
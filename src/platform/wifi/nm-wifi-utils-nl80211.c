@@ -42,6 +42,15 @@ typedef struct {
 	int id;
 	int num_freqs;
 	int phy;
+	struct {
+		/* separate socket for nl80211 multicast events, so that they don't
+		 * interfere with the request/response exchanges on @nl_sock. */
+		struct nl_sock *nl_sock;
+		GSource *source;
+		NMWifiUtilsLinkMonitorFunc callback;
+		gpointer user_data;
+		guint32 hysteresis;
+	} monitor;
 	bool can_wowlan:1;
 } NMWifiUtilsNl80211;
 
@@ -147,11 +156,14 @@ nl80211_send_and_recv (NMWifiUtilsNl80211 *self,
 	return err;
 }
 
+static void nl80211_monitor_stop (NMWifiUtilsNl80211 *self);
+
 static void
 dispose (GObject *object)
 {
 	NMWifiUtilsNl80211 *self = NM_WIFI_UTILS_NL80211 (object);
 
+	nl80211_monitor_stop (self);
 	g_clear_pointer (&self->freqs, g_free);
 }
 
@@ -539,6 +551,7 @@ struct nl80211_station_info {
 	guint32 txrate;
 	gboolean txrate_valid;
 	guint8 signal;
+	gint8 signal_dbm;
 	gboolean signal_valid;
 };
 
@@ -599,18 +612,37 @@ nl80211_station_handler (struct nl_msg *msg, void *arg)
 	info->txrate_valid = TRUE;
 
 	if (sinfo[NL80211_STA_INFO_SIGNAL] != NULL) {
-		info->signal = nl80211_xbm_to_percent ((gint8) nla_get_u8 (sinfo[NL80211_STA_INFO_SIGNAL]), 1);
+		info->signal_dbm = (gint8) nla_get_u8 (sinfo[NL80211_STA_INFO_SIGNAL]);
+		info->signal = nl80211_xbm_to_percent (info->signal_dbm, 1);
 		info->signal_valid = TRUE;
 	}
 
 	return NL_SKIP;
 }
 
+static void
+nl80211_get_station_info (NMWifiUtilsNl80211 *self,
+                          const guint8 *bssid,
+                          struct nl80211_station_info *sta_info)
+{
+	nm_auto_nlmsg struct nl_msg *msg = NULL;
+
+	memset (sta_info, 0, sizeof (*sta_info));
+
+	msg = nl80211_alloc_msg (self, NL80211_CMD_GET_STATION, 0);
+	NLA_PUT (msg, NL80211_ATTR_MAC, ETH_ALEN, bssid);
+
+	nl80211_send_and_recv (self, msg, nl80211_station_handler, sta_info);
+	return;
+
+nla_put_failure:
+	g_return_if_reached ();
+}
+
 static void
 nl80211_get_ap_info (NMWifiUtilsNl80211 *self,
                      struct nl80211_station_info *sta_info)
 {
-	nm_auto_nlmsg struct nl_msg *msg = NULL;
 	struct nl80211_bss_info bss_info;
 
 	memset (sta_info, 0, sizeof (*sta_info));
@@ -619,19 +651,11 @@ nl80211_get_ap_info (NMWifiUtilsNl80211 *self,
 	if (!bss_info.valid)
 		return;
 
-	msg = nl80211_alloc_msg (self, NL80211_CMD_GET_STATION, 0);
-	NLA_PUT (msg, NL80211_ATTR_MAC, ETH_ALEN, bss_info.bssid);
-
-	nl80211_send_and_recv (self, msg, nl80211_station_handler, sta_info);
+	nl80211_get_station_info (self, bss_info.bssid, sta_info);
 	if (!sta_info->signal_valid) {
 		/* Fall back to bss_info signal quality (both are in percent) */
 		sta_info->signal = bss_info.beacon_signal;
 	}
-
-	return;
-
-nla_put_failure:
-	g_return_if_reached ();
 }
 
 static guint32
@@ -655,6 +679,250 @@ wifi_nl80211_get_qual (NMWifiUtils *data)
 	return sta_info.signal;
 }
 
+static gboolean
+nl80211_set_cqm_rssi (NMWifiUtilsNl80211 *self, int signal_dbm)
+{
+	nm_auto_nlmsg struct nl_msg *msg = NULL;
+	struct nlattr *cqm;
+	gint32 thresholds[2];
+	int err;
+
+	msg = nl80211_alloc_msg (self, NL80211_CMD_SET_CQM, 0);
+
+	cqm = nla_nest_start (msg, NL80211_ATTR_CQM);
+	if (!cqm)
+		goto nla_put_failure;
+
+	if (self->monitor.callback) {
+		/* Request a notification once the signal leaves the range of
+		 * +/- hysteresis around the current level. Afterwards the range
+		 * gets re-centered on the new level. Drivers that cannot handle
+		 * a list of thresholds reject this and we fall back to polling. */
+		thresholds[0] = signal_dbm - (int) self->monitor.hysteresis;
+		thresholds[1] = signal_dbm + (int) self->monitor.hysteresis;
+		NLA_PUT (msg, NL80211_ATTR_CQM_RSSI_THOLD, sizeof (thresholds), thresholds);
+	} else {
+		/* a threshold of zero disables RSSI monitoring */
+		NLA_PUT_U32 (msg, NL80211_ATTR_CQM_RSSI_THOLD, 0);
+	}
+	NLA_PUT_U32 (msg, NL80211_ATTR_CQM_RSSI_HYST, 0);
+
+	nla_nest_end (msg, cqm);
+
+	err = nl80211_send_and_recv (self, msg, NULL, NULL);
+	if (err < 0) {
+		_LOGD ("NL80211_CMD_SET_CQM request failed: %s", nm_strerror (err));
+		return FALSE;
+	}
+	return TRUE;
+
+nla_put_failure:
+	g_return_val_if_reached (FALSE);
+}
+
+static void
+nl80211_monitor_update (NMWifiUtilsNl80211 *self, const guint8 *bssid)
+{
+	struct nl80211_station_info sta_info;
+
+	if (bssid)
+		nl80211_get_station_info (self, bssid, &sta_info);
+	else
+		nl80211_get_ap_info (self, &sta_info);
+
+	if (sta_info.signal_valid)
+		nl80211_set_cqm_rssi (self, sta_info.signal_dbm);
+
+	_LOGT ("link monitor: signal %d%%, rate %u Kbps",
+	       sta_info.signal_valid ? sta_info.signal : -1,
+	       sta_info.txrate);
+
+	self->monitor.callback (sta_info.signal_valid ? sta_info.signal : -1,
+	                        sta_info.txrate,
+	                        self->monitor.user_data);
+}
+
+static void
+nl80211_monitor_handle_event (NMWifiUtilsNl80211 *self, struct nlmsghdr *hdr)
+{
+	struct genlmsghdr *gnlh;
+	struct nlattr *tb[NL80211_ATTR_MAX + 1];
+	const guint8 *bssid = NULL;
+
+	if (hdr->nlmsg_type != self->id)
+		return;
+
+	if (genlmsg_parse (hdr, 0, tb, NL80211_ATTR_MAX, NULL) < 0)
+		return;
+
+	if (   !tb[NL80211_ATTR_IFINDEX]
+	    || nla_get_u32 (tb[NL80211_ATTR_IFINDEX]) != self->parent.ifindex)
+		return;
+
+	gnlh = nlmsg_data (hdr);
+	switch (gnlh->cmd) {
+	case NL80211_CMD_NOTIFY_CQM:
+	{
+		static const struct nla_policy cqm_policy[] = {
+			[NL80211_ATTR_CQM_RSSI_THRESHOLD_EVENT] = { .type = NLA_U32 },
+		};
+		struct nlattr *cqm[G_N_ELEMENTS (cqm_policy)];
+
+		/* only RSSI threshold events, ignore packet and beacon loss */
+		if (!tb[NL80211_ATTR_CQM])
+			return;
+		if (nla_parse_nested_arr (cqm, tb[NL80211_ATTR_CQM], cqm_policy) < 0)
+			return;
+		if (!cqm[NL80211_ATTR_CQM_RSSI_THRESHOLD_EVENT])
+			return;
+		break;
+	}
+	case NL80211_CMD_CONNECT:
+	case NL80211_CMD_ROAM:
+		break;
+	default:
+		return;
+	}
+
+	if (   tb[NL80211_ATTR_MAC]
+	    && nla_len (tb[NL80211_ATTR_MAC]) >= ETH_ALEN)
+		bssid = nla_data (tb[NL80211_ATTR_MAC]);
+
+	nl80211_monitor_update (self, bssid);
+}
+
+static gboolean
+nl80211_monitor_event_cb (int fd,
+                          GIOCondition condition,
+                          gpointer user_data)
+{
+	NMWifiUtilsNl80211 *self = user_data;
+	struct nl_sock *sk = self->monitor.nl_sock;
+
+	/* the callback might stop the monitor, check that the socket is still ours. */
+	while (self->monitor.nl_sock == sk) {
+		gs_free unsigned char *buf = NULL;
+		struct sockaddr_nl nla = { };
+		struct ucred creds;
+		gboolean creds_has;
+		struct nlmsghdr *hdr;
+		int n;
+
+		n = nl_recv (sk, &nla, &buf, &creds, &creds_has);
+		if (n <= 0) {
+			if (n < 0 && n != -EAGAIN)
+				_LOGD ("link monitor: failed to receive events: %s", nm_strerror (n));
+			break;
+		}
+
+		hdr = (struct nlmsghdr *) buf;
+		while (   nlmsg_ok (hdr, n)
+		       && self->monitor.nl_sock == sk) {
+			nl80211_monitor_handle_event (self, hdr);
+			hdr = nlmsg_next (hdr, &n);
+		}
+	}
+
+	return G_SOURCE_CONTINUE;
+}
+
+static gboolean
+nl80211_monitor_start (NMWifiUtilsNl80211 *self)
+{
+	struct nl_sock *sk;
+	int grp;
+	int err;
+
+	if (self->monitor.nl_sock)
+		return TRUE;
+
+	sk = nl_socket_alloc ();
+
+	err = nl_connect (sk, NETLINK_GENERIC);
+	if (err < 0) {
+		_LOGD ("link monitor: unable to connect generic netlink socket: %s", nm_strerror (err));
+		goto fail;
+	}
+
+	grp = genl_ctrl_resolve_grp (sk, "nl80211", "mlme");
+	if (grp < 0) {
+		_LOGD ("link monitor: failed to resolve \"nl80211\" \"mlme\" group: %s", nm_strerror (grp));
+		goto fail;
+	}
+
+	err = nl_socket_add_memberships (sk, grp, 0);
+	if (err >= 0)
+		err = nl_socket_set_nonblocking (sk);
+	if (err < 0) {
+		_LOGD ("link monitor: failed to join \"mlme\" group: %s", nm_strerror (err));
+		goto fail;
+	}
+
+	self->monitor.nl_sock = sk;
+	self->monitor.source = nm_g_unix_fd_source_new (nl_socket_get_fd (sk),
+	                                                G_IO_IN | G_IO_NVAL | G_IO_PRI | G_IO_ERR | G_IO_HUP,
+	                                                G_PRIORITY_DEFAULT,
+	                                                nl80211_monitor_event_cb,
+	                                                self,
+	                                                NULL);
+	g_source_attach (self->monitor.source, NULL);
+	return TRUE;
+
+fail:
+	nl_socket_free (sk);
+	return FALSE;
+}
+
+static void
+nl80211_monitor_stop (NMWifiUtilsNl80211 *self)
+{
+	nm_clear_g_source_inst (&self->monitor.source);
+	nm_clear_pointer (&self->monitor.nl_sock, nl_socket_free);
+}
+
+static gboolean
+wifi_nl80211_set_link_monitor (NMWifiUtils *data,
+                               guint32 hysteresis,
+                               NMWifiUtilsLinkMonitorFunc callback,
+                               gpointer user_data)
+{
+	NMWifiUtilsNl80211 *self = (NMWifiUtilsNl80211 *) data;
+	struct nl80211_station_info sta_info;
+
+	if (!callback) {
+		if (self->monitor.callback) {
+			self->monitor.callback = NULL;
+			self->monitor.user_data = NULL;
+			nl80211_monitor_stop (self);
+			nl80211_set_cqm_rssi (self, 0);
+		}
+		return TRUE;
+	}
+
+	if (!nl80211_monitor_start (self))
+		return FALSE;
+
+	self->monitor.callback = callback;
+	self->monitor.user_data = user_data;
+	self->monitor.hysteresis = hysteresis;
+
+	/* Arm the thresholds around the current signal level. Without one,
+	 * there is nothing to arm them around. */
+	nl80211_get_ap_info (self, &sta_info);
+	if (   !sta_info.signal_valid
+	    || !nl80211_set_cqm_rssi (self, sta_info.signal_dbm)) {
+		self->monitor.callback = NULL;
+		self->monitor.user_data = NULL;
+		nl80211_monitor_stop (self);
+		return FALSE;
+	}
+
+	_LOGD ("link monitor: using CQM RSSI events with %u dBm hysteresis", hysteresis);
+	return TRUE;
+}
+
+/*****************************************************************************/
+
 static gboolean
 wifi_nl80211_indicate_addressing_running (NMWifiUtils *data, gboolean running)
 {
@@ -988,6 +1256,7 @@ nm_wifi_utils_nl80211_class_init (NMWifiUtilsNl80211Class *klass)
 	wifi_utils_class->get_bssid = wifi_nl80211_get_bssid;
 	wifi_utils_class->get_rate = wifi_nl80211_get_rate;
 	wifi_utils_class->get_qual = wifi_nl80211_get_qual;
+	wifi_utils_class->set_link_monitor = wifi_nl80211_set_link_monitor;
 	wifi_utils_class->indicate_addressing_running = wifi_nl80211_indicate_addressing_running;
 	wifi_utils_class->get_mesh_channel = wifi_nl80211_get_mesh_channel;
 	wifi_utils_class->set_mesh_channel = wifi_nl80211_set_mesh_channel;
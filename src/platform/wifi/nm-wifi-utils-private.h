@@ -41,6 +41,13 @@ typedef struct {
 	 */
 	int (*get_qual) (NMWifiUtils *data);
 
+	/* Report signal quality and bitrate changes via @callback instead of
+	 * being polled; return FALSE if the driver can't do that. */
+	gboolean (*set_link_monitor) (NMWifiUtils *data,
+	                              guint32 hysteresis,
+	                              NMWifiUtilsLinkMonitorFunc callback,
+	                              gpointer user_data);
+
 	/* OLPC Mesh-only functions */
 
 	guint32 (*get_mesh_channel) (NMWifiUtils *data);
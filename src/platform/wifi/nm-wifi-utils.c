@@ -157,6 +157,24 @@ nm_wifi_utils_get_qual (NMWifiUtils *data)
 	return NM_WIFI_UTILS_GET_CLASS (data)->get_qual (data);
 }
 
+gboolean
+nm_wifi_utils_set_link_monitor (NMWifiUtils *data,
+                                guint32 hysteresis,
+                                NMWifiUtilsLinkMonitorFunc callback,
+                                gpointer user_data)
+{
+	NMWifiUtilsClass *klass;
+
+	g_return_val_if_fail (data != NULL, FALSE);
+	g_return_val_if_fail (!callback || hysteresis > 0, FALSE);
+
+	klass = NM_WIFI_UTILS_GET_CLASS (data);
+	if (!klass->set_link_monitor)
+		return !callback;
+
+	return klass->set_link_monitor (data, hysteresis, callback, user_data);
+}
+
 gboolean
 nm_wifi_utils_is_wifi (int dirfd, const char *ifname)
 {
@@ -50,6 +50,19 @@ guint32 nm_wifi_utils_get_rate (NMWifiUtils *data);
 /* Returns quality 0 - 100% on success, or -1 on error */
 int nm_wifi_utils_get_qual (NMWifiUtils *data);
 
+typedef void (*NMWifiUtilsLinkMonitorFunc) (int quality,
+                                            guint32 rate,
+                                            gpointer user_data);
+
+/* Invokes @callback with the quality (0 - 100%, or -1) and bitrate in Kbps
+ * whenever the signal changes by more than @hysteresis dBm, or the device
+ * connects or roams. Returns FALSE if the driver doesn't support that and the
+ * caller has to poll instead. Pass a %NULL @callback to stop monitoring. */
+gboolean nm_wifi_utils_set_link_monitor (NMWifiUtils *data,
+                                         guint32 hysteresis,
+                                         NMWifiUtilsLinkMonitorFunc callback,
+                                         gpointer user_data);
+
 /* Tells the driver DHCP or SLAAC is running */
 gboolean nm_wifi_utils_indicate_addressing_running (NMWifiUtils *data, gboolean running);
 
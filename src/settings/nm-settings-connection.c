@@ -62,6 +62,9 @@ NM_GOBJECT_PROPERTIES_DEFINE (NMSettingsConnection,
 	PROP_UNSAVED,
 	PROP_FLAGS,
 	PROP_FILENAME,
+	PROP_ID,
+	PROP_UUID,
+	PROP_TYPE,
 );
 
 enum {
@@ -260,6 +263,36 @@ nm_settings_connection_get_connection (NMSettingsConnection *self)
 	return NM_SETTINGS_CONNECTION_GET_PRIVATE (self)->connection;
 }
 
+/* Unlike GetSettings(), the "Id", "Uuid" and "Type" properties are readable
+ * by everybody. Only export them for profiles that are visible to all users,
+ * for the others clients have to call GetSettings(), which checks the
+ * permissions of the caller. */
+static const char *
+_lw_prop_get (NMConnection *connection,
+              guint prop_id)
+{
+	NMSettingConnection *s_con;
+
+	if (!connection)
+		return NULL;
+
+	s_con = nm_connection_get_setting_connection (connection);
+	if (   !s_con
+	    || nm_setting_connection_get_num_permissions (s_con) > 0)
+		return NULL;
+
+	switch (prop_id) {
+	case PROP_ID:
+		return nm_setting_connection_get_id (s_con);
+	case PROP_UUID:
+		return nm_setting_connection_get_uuid (s_con);
+	case PROP_TYPE:
+		return nm_setting_connection_get_connection_type (s_con);
+	}
+	nm_assert_not_reached ();
+	return NULL;
+}
+
 void
 _nm_settings_connection_set_connection (NMSettingsConnection *self,
                                         NMConnection *new_connection,
@@ -282,6 +315,19 @@ _nm_settings_connection_set_connection (NMSettingsConnection *self,
 		priv->connection = g_object_ref (new_connection);
 		nmtst_connection_assert_unchanging (priv->connection);
 
+		/* the UUID never changes, but the ID and the type might. Also, the
+		 * properties get hidden when the profile becomes restricted to
+		 * certain users. */
+		if (!nm_streq0 (_lw_prop_get (connection_old, PROP_ID),
+		                _lw_prop_get (priv->connection, PROP_ID)))
+			_notify (self, PROP_ID);
+		if (!nm_streq0 (_lw_prop_get (connection_old, PROP_UUID),
+		                _lw_prop_get (priv->connection, PROP_UUID)))
+			_notify (self, PROP_UUID);
+		if (!nm_streq0 (_lw_prop_get (connection_old, PROP_TYPE),
+		                _lw_prop_get (priv->connection, PROP_TYPE)))
+			_notify (self, PROP_TYPE);
+
 		/* note that we only return @connection_old if the new connection actually differs from
 		 * before.
 		 *
@@ -1307,22 +1353,23 @@ auth_start (NMSettingsConnection *self,
 
 /**** DBus method handlers ************************************/
 
-static void
-get_settings_auth_cb (NMSettingsConnection *self,
-                      GDBusMethodInvocation *context,
-                      NMAuthSubject *subject,
-                      GError *error,
-                      gpointer data)
+/**
+ * nm_settings_connection_to_dbus_no_secrets:
+ * @self: the #NMSettingsConnection
+ *
+ * Serializes the connection the way GetSettings() returns it, that is
+ * without secrets and with the real timestamp and seen-bssids.
+ *
+ * Returns: a floating #GVariant of type "a{sa{sv}}".
+ */
+GVariant *
+nm_settings_connection_to_dbus_no_secrets (NMSettingsConnection *self)
 {
 	gs_free const char **seen_bssids = NULL;
 	NMConnectionSerializationOptions options = {
 	};
-	GVariant *settings;
 
-	if (error) {
-		g_dbus_method_invocation_return_gerror (context, error);
-		return;
-	}
+	g_return_val_if_fail (NM_IS_SETTINGS_CONNECTION (self), NULL);
 
 	/* Timestamp is not updated in connection's 'timestamp' property,
 	 * because it would force updating the connection and in turn
@@ -1344,11 +1391,26 @@ get_settings_auth_cb (NMSettingsConnection *self,
 	 * get returned by the GetSecrets method which can be better
 	 * protected against leakage of secrets to unprivileged callers.
 	 */
-	settings = nm_connection_to_dbus_full (nm_settings_connection_get_connection (self),
-	                                       NM_CONNECTION_SERIALIZE_NO_SECRETS,
-	                                       &options);
+	return nm_connection_to_dbus_full (nm_settings_connection_get_connection (self),
+	                                   NM_CONNECTION_SERIALIZE_NO_SECRETS,
+	                                   &options);
+}
+
+static void
+get_settings_auth_cb (NMSettingsConnection *self,
+                      GDBusMethodInvocation *context,
+                      NMAuthSubject *subject,
+                      GError *error,
+                      gpointer data)
+{
+	if (error) {
+		g_dbus_method_invocation_return_gerror (context, error);
+		return;
+	}
+
 	g_dbus_method_invocation_return_value (context,
-	                                       g_variant_new ("(@a{sa{sv}})", settings));
+	                                       g_variant_new ("(@a{sa{sv}})",
+	                                                      nm_settings_connection_to_dbus_no_secrets (self)));
 }
 
 static void
@@ -1375,7 +1437,6 @@ impl_settings_connection_get_settings (NMDBusObject *obj,
 
 typedef struct {
 	GDBusMethodInvocation *context;
-	NMAgentManager *agent_mgr;
 	NMAuthSubject *subject;
 	NMConnection *new_settings;
 	NMSettingsUpdate2Flags flags;
@@ -1403,12 +1464,142 @@ update_complete (NMSettingsConnection *self,
 	                            info->subject, error ? error->message : NULL);
 
 	g_clear_object (&info->subject);
-	g_clear_object (&info->agent_mgr);
 	g_clear_object (&info->new_settings);
 	g_free (info->audit_args);
 	g_slice_free (UpdateInfo, info);
 }
 
+/**
+ * _nm_settings_connection_update_merge_secrets:
+ * @self: the #NMSettingsConnection
+ * @new_settings: the new settings from an update request.
+ *
+ * Prepares @new_settings before updating @self from a D-Bus request.
+ * If @new_settings has no secrets, the existing secrets are merged in.
+ * Otherwise, the new secrets are cached as agent secrets.
+ */
+void
+_nm_settings_connection_update_merge_secrets (NMSettingsConnection *self,
+                                              NMConnection *new_settings)
+{
+	NMSettingsConnectionPrivate *priv = NM_SETTINGS_CONNECTION_GET_PRIVATE (self);
+
+	if (!_nm_connection_aggregate (new_settings, NM_CONNECTION_AGGREGATE_ANY_SECRETS, NULL)) {
+		/* If the new connection has no secrets, we do not want to remove all
+		 * secrets, rather we keep all the existing ones. Do that by merging
+		 * them in to the new connection.
+		 */
+		if (priv->agent_secrets)
+			nm_connection_update_secrets (new_settings, NULL, priv->agent_secrets, NULL);
+		if (priv->system_secrets)
+			nm_connection_update_secrets (new_settings, NULL, priv->system_secrets, NULL);
+	} else {
+		/* Cache the new secrets from the agent, as stuff like inotify-triggered
+		 * changes to connection's backing config files will blow them away if
+		 * they're in the main connection.
+		 */
+		update_agent_secrets_cache (self, new_settings);
+	}
+}
+
+/**
+ * _nm_settings_connection_update_complete:
+ * @self: the #NMSettingsConnection
+ * @subject: the subject that requested the update.
+ * @success: whether the update was successful.
+ *
+ * After a successful update from D-Bus, the agent owned secrets are sent to
+ * the agents of @subject. In any case, the autoconnect retries are reset.
+ */
+void
+_nm_settings_connection_update_complete (NMSettingsConnection *self,
+                                         NMAuthSubject *subject,
+                                         gboolean success)
+{
+	NMSettingsConnectionPrivate *priv = NM_SETTINGS_CONNECTION_GET_PRIVATE (self);
+
+	if (success) {
+		gs_unref_object NMConnection *for_agent = NULL;
+
+		/* Dupe the connection so we can clear out non-agent-owned secrets,
+		 * as agent-owned secrets are the only ones we send back be saved.
+		 * Only send secrets to agents of the same UID that called update too.
+		 */
+		for_agent = nm_simple_connection_new_clone (nm_settings_connection_get_connection (self));
+		_nm_connection_clear_secrets_by_secret_flags (for_agent,
+		                                              NM_SETTING_SECRET_FLAG_AGENT_OWNED);
+		nm_agent_manager_save_secrets (priv->agent_mgr,
+		                               nm_dbus_object_get_path (NM_DBUS_OBJECT (self)),
+		                               for_agent,
+		                               subject);
+	}
+
+	/* Reset auto retries back to default since connection was updated */
+	nm_settings_connection_autoconnect_retries_reset (self);
+}
+
+gboolean
+_nm_settings_update2_flags_validate (guint32 flags_u,
+                                     GError **error)
+{
+	if (NM_FLAGS_ANY (flags_u, ~((guint32) (  _NM_SETTINGS_UPDATE2_FLAG_ALL_PERSIST_MODES
+	                                        | NM_SETTINGS_UPDATE2_FLAG_VOLATILE
+	                                        | NM_SETTINGS_UPDATE2_FLAG_BLOCK_AUTOCONNECT
+	                                        | NM_SETTINGS_UPDATE2_FLAG_NO_REAPPLY)))) {
+		g_set_error_literal (error,
+		                     NM_SETTINGS_ERROR,
+		                     NM_SETTINGS_ERROR_INVALID_ARGUMENTS,
+		                     "Unknown flags");
+		return FALSE;
+	}
+
+	if (   (   NM_FLAGS_ANY (flags_u, _NM_SETTINGS_UPDATE2_FLAG_ALL_PERSIST_MODES)
+	        && !nm_utils_is_power_of_two (flags_u & _NM_SETTINGS_UPDATE2_FLAG_ALL_PERSIST_MODES))
+	    || (   NM_FLAGS_HAS (flags_u, NM_SETTINGS_UPDATE2_FLAG_VOLATILE)
+	        && !NM_FLAGS_ANY (flags_u,   NM_SETTINGS_UPDATE2_FLAG_IN_MEMORY
+	                                   | NM_SETTINGS_UPDATE2_FLAG_IN_MEMORY_DETACHED
+	                                   | NM_SETTINGS_UPDATE2_FLAG_IN_MEMORY_ONLY))) {
+		g_set_error_literal (error,
+		                     NM_SETTINGS_ERROR,
+		                     NM_SETTINGS_ERROR_INVALID_ARGUMENTS,
+		                     "Conflicting flags");
+		return FALSE;
+	}
+
+	return TRUE;
+}
+
+NMSettingsConnectionPersistMode
+_nm_settings_update2_flags_get_persist_mode (NMSettingsUpdate2Flags flags)
+{
+	nm_assert (   !NM_FLAGS_ANY (flags, _NM_SETTINGS_UPDATE2_FLAG_ALL_PERSIST_MODES)
+	           || nm_utils_is_power_of_two (flags & _NM_SETTINGS_UPDATE2_FLAG_ALL_PERSIST_MODES));
+
+	if (NM_FLAGS_HAS (flags, NM_SETTINGS_UPDATE2_FLAG_TO_DISK))
+		return NM_SETTINGS_CONNECTION_PERSIST_MODE_TO_DISK;
+	if (NM_FLAGS_ANY (flags, NM_SETTINGS_UPDATE2_FLAG_IN_MEMORY))
+		return NM_SETTINGS_CONNECTION_PERSIST_MODE_IN_MEMORY;
+	if (NM_FLAGS_ANY (flags, NM_SETTINGS_UPDATE2_FLAG_IN_MEMORY_DETACHED))
+		return NM_SETTINGS_CONNECTION_PERSIST_MODE_IN_MEMORY_DETACHED;
+	if (NM_FLAGS_HAS (flags, NM_SETTINGS_UPDATE2_FLAG_IN_MEMORY_ONLY))
+		return NM_SETTINGS_CONNECTION_PERSIST_MODE_IN_MEMORY_ONLY;
+	return NM_SETTINGS_CONNECTION_PERSIST_MODE_KEEP;
+}
+
+NMSettingsConnectionUpdateReason
+_nm_settings_update2_flags_get_update_reason (NMSettingsUpdate2Flags flags)
+{
+	return   NM_SETTINGS_CONNECTION_UPDATE_REASON_FORCE_RENAME
+	       | (  NM_FLAGS_HAS (flags, NM_SETTINGS_UPDATE2_FLAG_NO_REAPPLY)
+	          ? NM_SETTINGS_CONNECTION_UPDATE_REASON_NONE
+	          : NM_SETTINGS_CONNECTION_UPDATE_REASON_REAPPLY_PARTIAL)
+	       | NM_SETTINGS_CONNECTION_UPDATE_REASON_RESET_SYSTEM_SECRETS
+	       | NM_SETTINGS_CONNECTION_UPDATE_REASON_RESET_AGENT_SECRETS
+	       | (  NM_FLAGS_HAS (flags, NM_SETTINGS_UPDATE2_FLAG_BLOCK_AUTOCONNECT)
+	          ? NM_SETTINGS_CONNECTION_UPDATE_REASON_BLOCK_AUTOCONNECT
+	          : NM_SETTINGS_CONNECTION_UPDATE_REASON_NONE);
+}
+
 static void
 update_auth_cb (NMSettingsConnection *self,
                 GDBusMethodInvocation *context,
@@ -1416,36 +1607,16 @@ update_auth_cb (NMSettingsConnection *self,
                 GError *error,
                 gpointer data)
 {
-	NMSettingsConnectionPrivate *priv;
 	UpdateInfo *info = data;
 	gs_free_error GError *local = NULL;
-	NMSettingsConnectionPersistMode persist_mode;
 
 	if (error) {
 		update_complete (self, info, error);
 		return;
 	}
 
-	priv = NM_SETTINGS_CONNECTION_GET_PRIVATE (self);
-
-	if (info->new_settings) {
-		if (!_nm_connection_aggregate (info->new_settings, NM_CONNECTION_AGGREGATE_ANY_SECRETS, NULL)) {
-			/* If the new connection has no secrets, we do not want to remove all
-			 * secrets, rather we keep all the existing ones. Do that by merging
-			 * them in to the new connection.
-			 */
-			if (priv->agent_secrets)
-				nm_connection_update_secrets (info->new_settings, NULL, priv->agent_secrets, NULL);
-			if (priv->system_secrets)
-				nm_connection_update_secrets (info->new_settings, NULL, priv->system_secrets, NULL);
-		} else {
-			/* Cache the new secrets from the agent, as stuff like inotify-triggered
-			 * changes to connection's backing config files will blow them away if
-			 * they're in the main connection.
-			 */
-			update_agent_secrets_cache (self, info->new_settings);
-		}
-	}
+	if (info->new_settings)
+		_nm_settings_connection_update_merge_secrets (self, info->new_settings);
 
 	if (info->new_settings) {
 		if (nm_audit_manager_audit_enabled (nm_audit_manager_get ())) {
@@ -1461,64 +1632,25 @@ update_auth_cb (NMSettingsConnection *self,
 		}
 	}
 
-	nm_assert (   !NM_FLAGS_ANY (info->flags, _NM_SETTINGS_UPDATE2_FLAG_ALL_PERSIST_MODES)
-	           || nm_utils_is_power_of_two (info->flags & _NM_SETTINGS_UPDATE2_FLAG_ALL_PERSIST_MODES));
-
-	if (NM_FLAGS_HAS (info->flags, NM_SETTINGS_UPDATE2_FLAG_TO_DISK))
-		persist_mode = NM_SETTINGS_CONNECTION_PERSIST_MODE_TO_DISK;
-	else if (NM_FLAGS_ANY (info->flags, NM_SETTINGS_UPDATE2_FLAG_IN_MEMORY))
-		persist_mode = NM_SETTINGS_CONNECTION_PERSIST_MODE_IN_MEMORY;
-	else if (NM_FLAGS_ANY (info->flags, NM_SETTINGS_UPDATE2_FLAG_IN_MEMORY_DETACHED))
-		persist_mode = NM_SETTINGS_CONNECTION_PERSIST_MODE_IN_MEMORY_DETACHED;
-	else if (NM_FLAGS_HAS (info->flags, NM_SETTINGS_UPDATE2_FLAG_IN_MEMORY_ONLY)) {
-		persist_mode = NM_SETTINGS_CONNECTION_PERSIST_MODE_IN_MEMORY_ONLY;
-	} else
-		persist_mode = NM_SETTINGS_CONNECTION_PERSIST_MODE_KEEP;
-
 	nm_settings_connection_update (self,
 	                               info->new_settings,
-	                               persist_mode,
+	                               _nm_settings_update2_flags_get_persist_mode (info->flags),
 	                               (  NM_FLAGS_HAS (info->flags, NM_SETTINGS_UPDATE2_FLAG_VOLATILE)
 	                                ? NM_SETTINGS_CONNECTION_INT_FLAGS_VOLATILE
 	                                : NM_SETTINGS_CONNECTION_INT_FLAGS_NONE),
 	                                 NM_SETTINGS_CONNECTION_INT_FLAGS_NM_GENERATED
 	                               | NM_SETTINGS_CONNECTION_INT_FLAGS_VOLATILE,
-	                                 NM_SETTINGS_CONNECTION_UPDATE_REASON_FORCE_RENAME
-	                               | (  NM_FLAGS_HAS (info->flags, NM_SETTINGS_UPDATE2_FLAG_NO_REAPPLY)
-	                                  ? NM_SETTINGS_CONNECTION_UPDATE_REASON_NONE
-	                                  : NM_SETTINGS_CONNECTION_UPDATE_REASON_REAPPLY_PARTIAL)
-	                               | NM_SETTINGS_CONNECTION_UPDATE_REASON_RESET_SYSTEM_SECRETS
-	                               | NM_SETTINGS_CONNECTION_UPDATE_REASON_RESET_AGENT_SECRETS
-	                               | (  NM_FLAGS_HAS (info->flags, NM_SETTINGS_UPDATE2_FLAG_BLOCK_AUTOCONNECT)
-	                                  ? NM_SETTINGS_CONNECTION_UPDATE_REASON_BLOCK_AUTOCONNECT
-	                                  : NM_SETTINGS_CONNECTION_UPDATE_REASON_NONE),
+	                               _nm_settings_update2_flags_get_update_reason (info->flags),
 	                               "update-from-dbus",
 	                               &local);
 
-	if (!local) {
-		gs_unref_object NMConnection *for_agent = NULL;
-
-		/* Dupe the connection so we can clear out non-agent-owned secrets,
-		 * as agent-owned secrets are the only ones we send back be saved.
-		 * Only send secrets to agents of the same UID that called update too.
-		 */
-		for_agent = nm_simple_connection_new_clone (nm_settings_connection_get_connection (self));
-		_nm_connection_clear_secrets_by_secret_flags (for_agent,
-		                                              NM_SETTING_SECRET_FLAG_AGENT_OWNED);
-		nm_agent_manager_save_secrets (info->agent_mgr,
-		                               nm_dbus_object_get_path (NM_DBUS_OBJECT (self)),
-		                               for_agent,
-		                               info->subject);
-	}
-
-	/* Reset auto retries back to default since connection was updated */
-	nm_settings_connection_autoconnect_retries_reset (self);
+	_nm_settings_connection_update_complete (self, info->subject, !local);
 
 	update_complete (self, info, local);
 }
 
-static const char *
-get_update_modify_permission (NMConnection *old, NMConnection *new)
+const char *
+nm_settings_connection_get_update_modify_permission (NMConnection *old, NMConnection *new)
 {
 	NMSettingConnection *s_con;
 	guint32 orig_num = 0, new_num = 0;
@@ -1596,13 +1728,12 @@ settings_connection_update (NMSettingsConnection *self,
 	info = g_slice_new0 (UpdateInfo);
 	info->is_update2 = is_update2;
 	info->context = context;
-	info->agent_mgr = g_object_ref (priv->agent_mgr);
 	info->subject = subject;
 	info->flags = flags;
 	info->new_settings = tmp;
 
-	permission = get_update_modify_permission (nm_settings_connection_get_connection (self),
-	                                           tmp ?: nm_settings_connection_get_connection (self));
+	permission = nm_settings_connection_get_update_modify_permission (nm_settings_connection_get_connection (self),
+	                                                                  tmp ?: nm_settings_connection_get_connection (self));
 	auth_start (self, context, subject, permission, update_auth_cb, info);
 	return;
 
@@ -1682,32 +1813,13 @@ impl_settings_connection_update2 (NMDBusObject *obj,
 
 	g_variant_get (parameters, "(@a{sa{sv}}u@a{sv})", &settings, &flags_u, &args);
 
-	if (NM_FLAGS_ANY (flags_u, ~((guint32) (  _NM_SETTINGS_UPDATE2_FLAG_ALL_PERSIST_MODES
-	                                        | NM_SETTINGS_UPDATE2_FLAG_VOLATILE
-	                                        | NM_SETTINGS_UPDATE2_FLAG_BLOCK_AUTOCONNECT
-	                                        | NM_SETTINGS_UPDATE2_FLAG_NO_REAPPLY)))) {
-		error = g_error_new_literal (NM_SETTINGS_ERROR,
-		                             NM_SETTINGS_ERROR_INVALID_ARGUMENTS,
-		                             "Unknown flags");
+	if (!_nm_settings_update2_flags_validate (flags_u, &error)) {
 		g_dbus_method_invocation_take_error (invocation, error);
 		return;
 	}
 
 	flags = (NMSettingsUpdate2Flags) flags_u;
 
-	if (   (   NM_FLAGS_ANY (flags, _NM_SETTINGS_UPDATE2_FLAG_ALL_PERSIST_MODES)
-	        && !nm_utils_is_power_of_two (flags & _NM_SETTINGS_UPDATE2_FLAG_ALL_PERSIST_MODES))
-	    || (   NM_FLAGS_HAS (flags, NM_SETTINGS_UPDATE2_FLAG_VOLATILE)
-	        && !NM_FLAGS_ANY (flags,   NM_SETTINGS_UPDATE2_FLAG_IN_MEMORY
-	                                 | NM_SETTINGS_UPDATE2_FLAG_IN_MEMORY_DETACHED
-	                                 | NM_SETTINGS_UPDATE2_FLAG_IN_MEMORY_ONLY))) {
-		error = g_error_new_literal (NM_SETTINGS_ERROR,
-		                             NM_SETTINGS_ERROR_INVALID_ARGUMENTS,
-		                             "Conflicting flags");
-		g_dbus_method_invocation_take_error (invocation, error);
-		return;
-	}
-
 	nm_assert (g_variant_is_of_type (args, G_VARIANT_TYPE ("a{sv}")));
 
 	g_variant_iter_init (&iter, args);
@@ -2142,6 +2254,13 @@ nm_settings_connection_update_timestamp (NMSettingsConnection *self,
 
 	g_return_if_fail (NM_IS_SETTINGS_CONNECTION (self));
 
+	if (   priv->settings
+	    && (   !priv->timestamp_set
+	        || priv->timestamp != timestamp)) {
+		/* the timestamp is a tie breaker for the autoconnect priority. */
+		nm_settings_autoconnect_candidates_invalidate (priv->settings);
+	}
+
 	priv->timestamp = timestamp;
 	priv->timestamp_set = TRUE;
 
@@ -2555,6 +2674,13 @@ get_property (GObject *object, guint prop_id,
 	case PROP_FILENAME:
 		g_value_set_string (value, nm_settings_connection_get_filename (self));
 		break;
+	case PROP_ID:
+	case PROP_UUID:
+	case PROP_TYPE:
+		g_value_set_string (value,
+		                    _lw_prop_get (NM_SETTINGS_CONNECTION_GET_PRIVATE (self)->connection,
+		                                  prop_id));
+		break;
 	default:
 		G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
 		break;
@@ -2724,6 +2850,9 @@ static const NMDBusInterfaceInfoExtended interface_info_settings_connection = {
 			NM_DEFINE_DBUS_PROPERTY_INFO_EXTENDED_READABLE_L ("Unsaved",  "b",  NM_SETTINGS_CONNECTION_UNSAVED),
 			NM_DEFINE_DBUS_PROPERTY_INFO_EXTENDED_READABLE   ("Flags",    "u",  NM_SETTINGS_CONNECTION_FLAGS),
 			NM_DEFINE_DBUS_PROPERTY_INFO_EXTENDED_READABLE   ("Filename", "s",  NM_SETTINGS_CONNECTION_FILENAME),
+			NM_DEFINE_DBUS_PROPERTY_INFO_EXTENDED_READABLE   ("Id",       "s",  NM_SETTINGS_CONNECTION_ID),
+			NM_DEFINE_DBUS_PROPERTY_INFO_EXTENDED_READABLE   ("Uuid",     "s",  NM_SETTINGS_CONNECTION_UUID),
+			NM_DEFINE_DBUS_PROPERTY_INFO_EXTENDED_READABLE   ("Type",     "s",  NM_SETTINGS_CONNECTION_TYPE),
 		),
 	),
 	.legacy_property_changed = TRUE,
@@ -2761,6 +2890,24 @@ nm_settings_connection_class_init (NMSettingsConnectionClass *klass)
 	                          G_PARAM_READABLE |
 	                          G_PARAM_STATIC_STRINGS);
 
+	obj_properties[PROP_ID] =
+	     g_param_spec_string (NM_SETTINGS_CONNECTION_ID, "", "",
+	                          NULL,
+	                          G_PARAM_READABLE |
+	                          G_PARAM_STATIC_STRINGS);
+
+	obj_properties[PROP_UUID] =
+	     g_param_spec_string (NM_SETTINGS_CONNECTION_UUID, "", "",
+	                          NULL,
+	                          G_PARAM_READABLE |
+	                          G_PARAM_STATIC_STRINGS);
+
+	obj_properties[PROP_TYPE] =
+	     g_param_spec_string (NM_SETTINGS_CONNECTION_TYPE, "", "",
+	                          NULL,
+	                          G_PARAM_READABLE |
+	                          G_PARAM_STATIC_STRINGS);
+
 	g_object_class_install_properties (object_class, _PROPERTY_ENUMS_LAST, obj_properties);
 
 	/* internal signal, with an argument (NMSettingsConnectionUpdateReason update_reason) as
@@ -133,6 +133,9 @@ typedef enum {
 #define NM_SETTINGS_CONNECTION_UNSAVED  "unsaved"
 #define NM_SETTINGS_CONNECTION_FLAGS    "flags"
 #define NM_SETTINGS_CONNECTION_FILENAME "filename"
+#define NM_SETTINGS_CONNECTION_ID       "id"
+#define NM_SETTINGS_CONNECTION_UUID     "uuid"
+#define NM_SETTINGS_CONNECTION_TYPE     "type"
 
 /**
  * NMSettingsConnectionIntFlags:
@@ -242,6 +245,23 @@ gboolean nm_settings_connection_update (NMSettingsConnection *self,
 void nm_settings_connection_delete (NMSettingsConnection *self,
                                     gboolean allow_add_to_no_auto_default);
 
+const char *nm_settings_connection_get_update_modify_permission (NMConnection *old,
+                                                                 NMConnection *new);
+
+void _nm_settings_connection_update_merge_secrets (NMSettingsConnection *self,
+                                                   NMConnection *new_settings);
+
+void _nm_settings_connection_update_complete (NMSettingsConnection *self,
+                                              NMAuthSubject *subject,
+                                              gboolean success);
+
+gboolean _nm_settings_update2_flags_validate (guint32 flags_u,
+                                              GError **error);
+
+NMSettingsConnectionPersistMode _nm_settings_update2_flags_get_persist_mode (NMSettingsUpdate2Flags flags);
+
+NMSettingsConnectionUpdateReason _nm_settings_update2_flags_get_update_reason (NMSettingsUpdate2Flags flags);
+
 typedef void (*NMSettingsConnectionSecretsFunc) (NMSettingsConnection *self,
                                                  NMSettingsConnectionCallId *call_id,
                                                  const char *agent_username,
@@ -324,6 +344,8 @@ void nm_settings_connection_update_timestamp (NMSettingsConnection *self,
 
 const char **nm_settings_connection_get_seen_bssids (NMSettingsConnection *self);
 
+GVariant *nm_settings_connection_to_dbus_no_secrets (NMSettingsConnection *self);
+
 gboolean nm_settings_connection_has_seen_bssid (NMSettingsConnection *self,
                                                 const char *bssid);
 
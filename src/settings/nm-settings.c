@@ -366,8 +366,14 @@ typedef struct {
 
 	NMSettingsConnection **connections_cached_list;
 
+	/* index of the profiles that may autoconnect, partitioned by connection
+	 * type and interface name. See nm_settings_get_autoconnect_candidates(). */
+	GHashTable *autoconnect_idx;
+
 	GSList *unmanaged_specs;
 	GSList *unrecognized_specs;
+	NMMatchSpec *unmanaged_specs_compiled;
+	NMMatchSpec *unrecognized_specs_compiled;
 
 	GHashTable *startup_complete_idx;
 	NMSettingsConnection *startup_complete_blocked_by;
@@ -700,8 +706,16 @@ nm_settings_get_unmanaged_specs (NMSettings *self)
 	return priv->unmanaged_specs;
 }
 
+const NMMatchSpec *
+nm_settings_get_unmanaged_match_spec (NMSettings *self)
+{
+	NMSettingsPrivate *priv = NM_SETTINGS_GET_PRIVATE (self);
+
+	return priv->unmanaged_specs_compiled;
+}
+
 static gboolean
-update_specs (NMSettings *self, GSList **specs_ptr,
+update_specs (NMSettings *self, GSList **specs_ptr, NMMatchSpec **compiled_ptr,
               GSList * (*get_specs_func) (NMSettingsPlugin *))
 {
 	NMSettingsPrivate *priv = NM_SETTINGS_GET_PRIVATE (self);
@@ -733,6 +747,8 @@ update_specs (NMSettings *self, GSList **specs_ptr,
 
 	g_slist_free_full (*specs_ptr, g_free);
 	*specs_ptr = new;
+	nm_match_spec_free (*compiled_ptr);
+	*compiled_ptr = nm_match_spec_new (new);
 	return TRUE;
 
 }
@@ -744,7 +760,7 @@ _plugin_unmanaged_specs_changed (NMSettingsPlugin *config,
 	NMSettings *self = NM_SETTINGS (user_data);
 	NMSettingsPrivate *priv = NM_SETTINGS_GET_PRIVATE (self);
 
-	if (update_specs (self, &priv->unmanaged_specs,
+	if (update_specs (self, &priv->unmanaged_specs, &priv->unmanaged_specs_compiled,
 	                  nm_settings_plugin_get_unmanaged_specs))
 		_notify (self, PROP_UNMANAGED_SPECS);
 }
@@ -756,7 +772,7 @@ _plugin_unrecognized_specs_changed (NMSettingsPlugin *config,
 	NMSettings *self = NM_SETTINGS (user_data);
 	NMSettingsPrivate *priv = NM_SETTINGS_GET_PRIVATE (self);
 
-	update_specs (self, &priv->unrecognized_specs,
+	update_specs (self, &priv->unrecognized_specs, &priv->unrecognized_specs_compiled,
 	              nm_settings_plugin_get_unrecognized_specs);
 }
 
@@ -766,6 +782,8 @@ static void
 connection_flags_changed (NMSettingsConnection *sett_conn,
                           gpointer user_data)
 {
+	/* the volatile flag affects the autoconnect candidates. */
+	nm_settings_autoconnect_candidates_invalidate (NM_SETTINGS (user_data));
 	_emit_connection_flags_changed (NM_SETTINGS (user_data), sett_conn);
 }
 
@@ -1056,6 +1074,8 @@ _connection_changed_update (NMSettings *self,
 
 	_nm_settings_connection_set_connection (sett_conn, connection, &connection_old, update_reason);
 
+	if (connection_old)
+		nm_settings_autoconnect_candidates_invalidate (self);
 
 	if (is_new) {
 		_nm_settings_connection_register_kf_dbs (sett_conn,
@@ -1642,30 +1662,27 @@ _set_nmmeta_tombstone (NMSettings *self,
 	}
 }
 
-/**
- * nm_settings_add_connection:
- * @self: the #NMSettings object
- * @connection: the source connection to create a new #NMSettingsConnection from
- * @persist_mode: the persist-mode for this profile.
- * @add_reason: the add-reason flags.
- * @sett_flags: the settings flags to set.
- * @out_sett_conn: (allow-none) (transfer none): the added settings connection on success.
- * @error: on return, a location to store any errors that may occur
- *
- * Creates a new #NMSettingsConnection for the given source @connection.
- * The returned object is owned by @self and the caller must reference
- * the object to continue using it.
+static NMSettingsConnectionUpdateReason
+_add_reason_to_update_reason (NMSettingsConnectionAddReason add_reason)
+{
+	return   NM_SETTINGS_CONNECTION_UPDATE_REASON_RESET_SYSTEM_SECRETS
+	       | NM_SETTINGS_CONNECTION_UPDATE_REASON_RESET_AGENT_SECRETS
+	       | (  NM_FLAGS_HAS (add_reason, NM_SETTINGS_CONNECTION_ADD_REASON_BLOCK_AUTOCONNECT)
+	          ? NM_SETTINGS_CONNECTION_UPDATE_REASON_BLOCK_AUTOCONNECT
+	          : NM_SETTINGS_CONNECTION_UPDATE_REASON_NONE);
+}
+
+/* _add_connection_write:
  *
- * Returns: TRUE on success.
- */
-gboolean
-nm_settings_add_connection (NMSettings *self,
-                            NMConnection *connection,
-                            NMSettingsConnectionPersistMode persist_mode,
-                            NMSettingsConnectionAddReason add_reason,
-                            NMSettingsConnectionIntFlags sett_flags,
-                            NMSettingsConnection **out_sett_conn,
-                            GError **error)
+ * Persists @connection to the first suitable plugin and tracks the
+ * change event, but does not process the dirty entries. The caller
+ * must call _connection_changed_process_all_dirty() afterwards. */
+static SettConnEntry *
+_add_connection_write (NMSettings *self,
+                       NMConnection *connection,
+                       NMSettingsConnectionPersistMode persist_mode,
+                       NMSettingsConnectionIntFlags sett_flags,
+                       GError **error)
 {
 	NMSettingsPrivate *priv;
 	gs_unref_object NMConnection *connection_cloned_1 = NULL;
@@ -1696,10 +1713,6 @@ nm_settings_add_connection (NMSettings *self,
 		new_in_memory = TRUE;
 	}
 
-	nm_assert (!NM_FLAGS_ANY (add_reason, ~NM_SETTINGS_CONNECTION_ADD_REASON_BLOCK_AUTOCONNECT));
-
-	NM_SET_OUT (out_sett_conn, NULL);
-
 	uuid = nm_connection_get_uuid (connection);
 
 	sett_conn_entry = _sett_conn_entries_get (self, uuid);
@@ -1708,7 +1721,7 @@ nm_settings_add_connection (NMSettings *self,
 		                     NM_SETTINGS_ERROR,
 		                     NM_SETTINGS_ERROR_UUID_EXISTS,
 		                     "a connection with this UUID already exists");
-		return FALSE;
+		return NULL;
 	}
 
 	if (!_nm_connection_ensure_normalized (connection,
@@ -1722,7 +1735,7 @@ nm_settings_add_connection (NMSettings *self,
 		             NM_SETTINGS_ERROR_INVALID_CONNECTION,
 		             "connection is invalid: %s",
 		             local->message);
-		return FALSE;
+		return NULL;
 	}
 	if (connection_cloned_1)
 		connection = connection_cloned_1;
@@ -1827,7 +1840,7 @@ again_add_connection:
 			             nm_settings_storage_get_filename (update_storage),
 			             local->message);
 		}
-		return FALSE;
+		return NULL;
 	}
 
 	sett_conn_entry = _connection_changed_track (self, new_storage, new_connection, TRUE);
@@ -1875,16 +1888,54 @@ again_delete_tombstone:
 			_connection_changed_track (self, new_tombstone_storage, NULL, FALSE);
 	}
 
+	return sett_conn_entry;
+}
+
+/**
+ * nm_settings_add_connection:
+ * @self: the #NMSettings object
+ * @connection: the source connection to create a new #NMSettingsConnection from
+ * @persist_mode: the persist-mode for this profile.
+ * @add_reason: the add-reason flags.
+ * @sett_flags: the settings flags to set.
+ * @out_sett_conn: (allow-none) (transfer none): the added settings connection on success.
+ * @error: on return, a location to store any errors that may occur
+ *
+ * Creates a new #NMSettingsConnection for the given source @connection.
+ * The returned object is owned by @self and the caller must reference
+ * the object to continue using it.
+ *
+ * Returns: TRUE on success.
+ */
+gboolean
+nm_settings_add_connection (NMSettings *self,
+                            NMConnection *connection,
+                            NMSettingsConnectionPersistMode persist_mode,
+                            NMSettingsConnectionAddReason add_reason,
+                            NMSettingsConnectionIntFlags sett_flags,
+                            NMSettingsConnection **out_sett_conn,
+                            GError **error)
+{
+	SettConnEntry *sett_conn_entry;
+
+	nm_assert (!NM_FLAGS_ANY (add_reason, ~NM_SETTINGS_CONNECTION_ADD_REASON_BLOCK_AUTOCONNECT));
+
+	NM_SET_OUT (out_sett_conn, NULL);
+
+	sett_conn_entry = _add_connection_write (self,
+	                                         connection,
+	                                         persist_mode,
+	                                         sett_flags,
+	                                         error);
+	if (!sett_conn_entry)
+		return FALSE;
+
 	_connection_changed_process_all_dirty (self,
 	                                       FALSE,
 	                                       sett_flags,
 	                                       _NM_SETTINGS_CONNECTION_INT_FLAGS_PERSISTENT_MASK,
 	                                       FALSE,
-	                                         NM_SETTINGS_CONNECTION_UPDATE_REASON_RESET_SYSTEM_SECRETS
-	                                       | NM_SETTINGS_CONNECTION_UPDATE_REASON_RESET_AGENT_SECRETS
-	                                       | (  NM_FLAGS_HAS (add_reason, NM_SETTINGS_CONNECTION_ADD_REASON_BLOCK_AUTOCONNECT)
-	                                          ? NM_SETTINGS_CONNECTION_UPDATE_REASON_BLOCK_AUTOCONNECT
-	                                          : NM_SETTINGS_CONNECTION_UPDATE_REASON_NONE));
+	                                       _add_reason_to_update_reason (add_reason));
 
 	nm_assert (sett_conn_entry == _sett_conn_entries_get (self, sett_conn_entry->uuid));
 	nm_assert (NM_IS_SETTINGS_CONNECTION (sett_conn_entry->sett_conn));
@@ -1893,19 +1944,107 @@ again_delete_tombstone:
 	return TRUE;
 }
 
+/**
+ * nm_settings_add_connections:
+ * @self: the #NMSettings object
+ * @items: the batch items. For each item, the "connection" field must be set
+ *   on input. On return, either "sett_conn" or "error" is set.
+ * @n_items: the number of @items.
+ * @persist_mode: the persist-mode for all profiles.
+ * @add_reason: the add-reason flags.
+ * @sett_flags: the settings flags to set.
+ *
+ * Like nm_settings_add_connection(), but for a batch of profiles. All
+ * profiles get persisted first, and only then the change events are
+ * processed in one pass. That means, the "connection-added" signals
+ * are emitted in one burst at the end.
+ */
+void
+nm_settings_add_connections (NMSettings *self,
+                             NMSettingsBatchItem *items,
+                             guint n_items,
+                             NMSettingsConnectionPersistMode persist_mode,
+                             NMSettingsConnectionAddReason add_reason,
+                             NMSettingsConnectionIntFlags sett_flags)
+{
+	gs_unref_hashtable GHashTable *uuids = NULL;
+	gs_free SettConnEntry **entries = NULL;
+	guint i;
+
+	g_return_if_fail (NM_IS_SETTINGS (self));
+	g_return_if_fail (items || n_items == 0);
+
+	nm_assert (!NM_FLAGS_ANY (add_reason, ~NM_SETTINGS_CONNECTION_ADD_REASON_BLOCK_AUTOCONNECT));
+
+	if (n_items == 0)
+		return;
+
+	uuids = g_hash_table_new (nm_str_hash, g_str_equal);
+	entries = g_new0 (SettConnEntry *, n_items);
+
+	for (i = 0; i < n_items; i++) {
+		NMSettingsBatchItem *item = &items[i];
+		const char *uuid;
+
+		item->sett_conn = NULL;
+		if (item->error)
+			continue;
+
+		nm_assert (NM_IS_CONNECTION (item->connection));
+
+		uuid = nm_connection_get_uuid (item->connection);
+		if (   !uuid
+		    || !g_hash_table_add (uuids, (gpointer) uuid)) {
+			g_set_error_literal (&item->error,
+			                     NM_SETTINGS_ERROR,
+			                     NM_SETTINGS_ERROR_UUID_EXISTS,
+			                     "a connection with this UUID is already part of the request");
+			continue;
+		}
+
+		entries[i] = _add_connection_write (self,
+		                                    item->connection,
+		                                    persist_mode,
+		                                    sett_flags,
+		                                    &item->error);
+	}
+
+	_connection_changed_process_all_dirty (self,
+	                                       FALSE,
+	                                       sett_flags,
+	                                       _NM_SETTINGS_CONNECTION_INT_FLAGS_PERSISTENT_MASK,
+	                                       FALSE,
+	                                       _add_reason_to_update_reason (add_reason));
+
+	for (i = 0; i < n_items; i++) {
+		if (!entries[i])
+			continue;
+		nm_assert (entries[i] == _sett_conn_entries_get (self, entries[i]->uuid));
+		items[i].sett_conn = _sett_conn_entry_get_conn (entries[i]);
+		if (!items[i].sett_conn) {
+			g_set_error_literal (&items[i].error,
+			                     NM_SETTINGS_ERROR,
+			                     NM_SETTINGS_ERROR_FAILED,
+			                     "the added profile is shadowed by another storage");
+		}
+	}
+}
+
 /*****************************************************************************/
 
-gboolean
-nm_settings_update_connection (NMSettings *self,
-                               NMSettingsConnection *sett_conn,
-                               NMConnection *connection,
-                               NMSettingsConnectionPersistMode persist_mode,
-                               NMSettingsConnectionIntFlags sett_flags,
-                               NMSettingsConnectionIntFlags sett_mask,
-                               NMSettingsConnectionUpdateReason update_reason,
-                               const char *log_context_name,
-                               GError **error)
+static gboolean
+_update_connection_write (NMSettings *self,
+                          NMSettingsConnection *sett_conn,
+                          NMConnection *connection,
+                          NMSettingsConnectionPersistMode persist_mode,
+                          NMSettingsConnectionIntFlags *p_sett_flags,
+                          NMSettingsConnectionIntFlags *p_sett_mask,
+                          NMSettingsConnectionUpdateReason update_reason,
+                          const char *log_context_name,
+                          GError **error)
 {
+	NMSettingsConnectionIntFlags sett_flags = *p_sett_flags;
+	NMSettingsConnectionIntFlags sett_mask = *p_sett_mask;
 	gs_unref_object NMConnection *connection_cloned_1 = NULL;
 	gs_unref_object NMConnection *new_connection_cloned = NULL;
 	gs_unref_object NMConnection *new_connection = NULL;
@@ -1920,9 +2059,9 @@ nm_settings_update_connection (NMSettings *self,
 	gboolean tombstone_in_memory = FALSE;
 	gboolean tombstone_on_disk = FALSE;
 
-	g_return_val_if_fail (NM_IS_SETTINGS (self), FALSE);
-	g_return_val_if_fail (NM_IS_SETTINGS_CONNECTION (sett_conn), FALSE);
-	g_return_val_if_fail (!connection || NM_IS_CONNECTION (connection), FALSE);
+	nm_assert (NM_IS_SETTINGS (self));
+	nm_assert (NM_IS_SETTINGS_CONNECTION (sett_conn));
+	nm_assert (!connection || NM_IS_CONNECTION (connection));
 
 	nm_assert (!NM_FLAGS_ANY (sett_mask, ~_NM_SETTINGS_CONNECTION_INT_FLAGS_PERSISTENT_MASK));
 	nm_assert (!NM_FLAGS_ANY (sett_flags, ~sett_mask));
@@ -2226,16 +2365,168 @@ nm_settings_update_connection (NMSettings *self,
 	                       tombstone_in_memory,
 	                       NULL);
 
+	*p_sett_flags = sett_flags;
+	*p_sett_mask = sett_mask;
+	return TRUE;
+}
+
+gboolean
+nm_settings_update_connection (NMSettings *self,
+                               NMSettingsConnection *sett_conn,
+                               NMConnection *connection,
+                               NMSettingsConnectionPersistMode persist_mode,
+                               NMSettingsConnectionIntFlags sett_flags,
+                               NMSettingsConnectionIntFlags sett_mask,
+                               NMSettingsConnectionUpdateReason update_reason,
+                               const char *log_context_name,
+                               GError **error)
+{
+	g_return_val_if_fail (NM_IS_SETTINGS (self), FALSE);
+	g_return_val_if_fail (NM_IS_SETTINGS_CONNECTION (sett_conn), FALSE);
+	g_return_val_if_fail (!connection || NM_IS_CONNECTION (connection), FALSE);
+
+	if (!_update_connection_write (self,
+	                               sett_conn,
+	                               connection,
+	                               persist_mode,
+	                               &sett_flags,
+	                               &sett_mask,
+	                               update_reason,
+	                               log_context_name,
+	                               error))
+		return FALSE;
+
 	_connection_changed_process_all_dirty (self,
 	                                       FALSE,
 	                                       sett_flags,
 	                                       sett_mask,
 	                                       FALSE,
 	                                       update_reason);
-
 	return TRUE;
 }
 
+/**
+ * nm_settings_update_connections:
+ * @self: the #NMSettings object
+ * @items: the batch items. For each item, "sett_conn" must be set and
+ *   "connection" may be set to the new settings (or %NULL to only re-persist
+ *   the profile). On return, "error" is set for the items that failed.
+ * @n_items: the number of @items.
+ * @persist_mode: the persist-mode for all profiles.
+ * @sett_flags: the settings flags to set.
+ * @sett_mask: the mask for @sett_flags.
+ * @update_reason: the update reason.
+ * @log_context_name: a name for logging.
+ *
+ * Like nm_settings_update_connection(), but for a batch of profiles.
+ * All profiles are persisted first, and then the change events are processed
+ * in one pass.
+ *
+ * Persisting a profile may adjust the flags (for example, profiles written
+ * to disk cannot be volatile). These adjustments are kept per profile and
+ * only applied to the profile they belong to.
+ */
+void
+nm_settings_update_connections (NMSettings *self,
+                                NMSettingsBatchItem *items,
+                                guint n_items,
+                                NMSettingsConnectionPersistMode persist_mode,
+                                NMSettingsConnectionIntFlags sett_flags,
+                                NMSettingsConnectionIntFlags sett_mask,
+                                NMSettingsConnectionUpdateReason update_reason,
+                                const char *log_context_name)
+{
+	gs_unref_hashtable GHashTable *seen = NULL;
+	gs_free NMSettingsConnectionIntFlags *item_flags = NULL;
+	gs_free NMSettingsConnectionIntFlags *item_masks = NULL;
+	gs_free char **item_uuids = NULL;
+	guint i;
+
+	g_return_if_fail (NM_IS_SETTINGS (self));
+	g_return_if_fail (items || n_items == 0);
+
+	if (n_items == 0)
+		return;
+
+	seen = g_hash_table_new (nm_direct_hash, NULL);
+	item_flags = g_new (NMSettingsConnectionIntFlags, n_items);
+	item_masks = g_new (NMSettingsConnectionIntFlags, n_items);
+	item_uuids = g_new0 (char *, n_items);
+
+	for (i = 0; i < n_items; i++) {
+		NMSettingsBatchItem *item = &items[i];
+
+		item_flags[i] = sett_flags;
+		item_masks[i] = sett_mask;
+
+		if (item->error)
+			continue;
+
+		nm_assert (NM_IS_SETTINGS_CONNECTION (item->sett_conn));
+		nm_assert (!item->connection || NM_IS_CONNECTION (item->connection));
+
+		if (!nm_settings_has_connection (self, item->sett_conn)) {
+			g_set_error_literal (&item->error,
+			                     NM_SETTINGS_ERROR,
+			                     NM_SETTINGS_ERROR_INVALID_CONNECTION,
+			                     "the profile was deleted in the meantime");
+			continue;
+		}
+
+		if (!g_hash_table_add (seen, item->sett_conn)) {
+			g_set_error_literal (&item->error,
+			                     NM_SETTINGS_ERROR,
+			                     NM_SETTINGS_ERROR_INVALID_ARGUMENTS,
+			                     "the profile is already part of the request");
+			continue;
+		}
+
+		if (!_update_connection_write (self,
+		                               item->sett_conn,
+		                               item->connection,
+		                               persist_mode,
+		                               &item_flags[i],
+		                               &item_masks[i],
+		                               update_reason,
+		                               log_context_name,
+		                               &item->error))
+			continue;
+
+		item_uuids[i] = g_strdup (nm_settings_connection_get_uuid (item->sett_conn));
+	}
+
+	/* Process each written profile with its own flags. Look the entries up
+	 * by UUID, because processing one profile emits signals and the handlers
+	 * may modify the other entries. */
+	for (i = 0; i < n_items; i++) {
+		gs_free char *uuid = g_steal_pointer (&item_uuids[i]);
+		SettConnEntry *sett_conn_entry;
+
+		if (!uuid)
+			continue;
+
+		sett_conn_entry = _sett_conn_entries_get (self, uuid);
+		if (   !sett_conn_entry
+		    || !c_list_is_linked (&sett_conn_entry->sce_dirty_lst))
+			continue;
+
+		_connection_changed_process_one (self,
+		                                 sett_conn_entry,
+		                                 FALSE,
+		                                 item_flags[i],
+		                                 item_masks[i],
+		                                 FALSE,
+		                                 update_reason);
+	}
+
+	_connection_changed_process_all_dirty (self,
+	                                       FALSE,
+	                                       sett_flags,
+	                                       sett_mask,
+	                                       FALSE,
+	                                       update_reason);
+}
+
 void
 nm_settings_delete_connection (NMSettings *self,
                                NMSettingsConnection *sett_conn,
@@ -2636,6 +2927,61 @@ impl_settings_add_connection_unsaved (NMDBusObject *obj,
 	settings_add_connection_helper (self, invocation, FALSE, settings, NM_SETTINGS_ADD_CONNECTION2_FLAG_IN_MEMORY);
 }
 
+static gboolean
+_add_connection2_flags_validate (guint32 flags_u,
+                                 GError **error)
+{
+	if (NM_FLAGS_ANY (flags_u, ~((guint32) (  NM_SETTINGS_ADD_CONNECTION2_FLAG_TO_DISK
+	                                        | NM_SETTINGS_ADD_CONNECTION2_FLAG_IN_MEMORY
+	                                        | NM_SETTINGS_ADD_CONNECTION2_FLAG_BLOCK_AUTOCONNECT)))) {
+		g_set_error_literal (error,
+		                     NM_SETTINGS_ERROR,
+		                     NM_SETTINGS_ERROR_INVALID_ARGUMENTS,
+		                     "Unknown flags");
+		return FALSE;
+	}
+
+	if (!NM_FLAGS_ANY (flags_u,   NM_SETTINGS_ADD_CONNECTION2_FLAG_TO_DISK
+	                            | NM_SETTINGS_ADD_CONNECTION2_FLAG_IN_MEMORY)) {
+		g_set_error_literal (error,
+		                     NM_SETTINGS_ERROR,
+		                     NM_SETTINGS_ERROR_INVALID_ARGUMENTS,
+		                     "Requires either to-disk (0x1) or in-memory (0x2) flags");
+		return FALSE;
+	}
+
+	if (NM_FLAGS_ALL (flags_u,   NM_SETTINGS_ADD_CONNECTION2_FLAG_TO_DISK
+	                           | NM_SETTINGS_ADD_CONNECTION2_FLAG_IN_MEMORY)) {
+		g_set_error_literal (error,
+		                     NM_SETTINGS_ERROR,
+		                     NM_SETTINGS_ERROR_INVALID_ARGUMENTS,
+		                     "Cannot set to-disk (0x1) and in-memory (0x2) flags together");
+		return FALSE;
+	}
+
+	return TRUE;
+}
+
+static gboolean
+_args_validate_empty (GVariant *args,
+                      GError **error)
+{
+	const char *args_name;
+	GVariantIter iter;
+
+	nm_assert (g_variant_is_of_type (args, G_VARIANT_TYPE ("a{sv}")));
+
+	g_variant_iter_init (&iter, args);
+	while (g_variant_iter_next (&iter, "{&sv}", &args_name, NULL)) {
+		g_set_error (error,
+		             NM_SETTINGS_ERROR,
+		             NM_SETTINGS_ERROR_INVALID_ARGUMENTS,
+		             "Unsupported argument '%s'", args_name);
+		return FALSE;
+	}
+	return TRUE;
+}
+
 static void
 impl_settings_add_connection2 (NMDBusObject *obj,
                                const NMDBusInterfaceInfoExtended *interface_info,
@@ -2648,55 +2994,417 @@ impl_settings_add_connection2 (NMDBusObject *obj,
 	NMSettings *self = NM_SETTINGS (obj);
 	gs_unref_variant GVariant *settings = NULL;
 	gs_unref_variant GVariant *args = NULL;
-	NMSettingsAddConnection2Flags flags;
-	const char *args_name;
-	GVariantIter iter;
+	GError *error = NULL;
 	guint32 flags_u;
 
 	g_variant_get (parameters, "(@a{sa{sv}}u@a{sv})", &settings, &flags_u, &args);
 
-	if (NM_FLAGS_ANY (flags_u, ~((guint32) (  NM_SETTINGS_ADD_CONNECTION2_FLAG_TO_DISK
-	                                        | NM_SETTINGS_ADD_CONNECTION2_FLAG_IN_MEMORY
-	                                        | NM_SETTINGS_ADD_CONNECTION2_FLAG_BLOCK_AUTOCONNECT)))) {
-		g_dbus_method_invocation_take_error (invocation,
-		                                     g_error_new_literal (NM_SETTINGS_ERROR,
-		                                                          NM_SETTINGS_ERROR_INVALID_ARGUMENTS,
-		                                                          "Unknown flags"));
+	if (   !_add_connection2_flags_validate (flags_u, &error)
+	    || !_args_validate_empty (args, &error)) {
+		g_dbus_method_invocation_take_error (invocation, error);
 		return;
 	}
 
-	flags = flags_u;
+	settings_add_connection_helper (self, invocation, TRUE, settings, (NMSettingsAddConnection2Flags) flags_u);
+}
 
-	if (!NM_FLAGS_ANY (flags,   NM_SETTINGS_ADD_CONNECTION2_FLAG_TO_DISK
-	                          | NM_SETTINGS_ADD_CONNECTION2_FLAG_IN_MEMORY)) {
-		g_dbus_method_invocation_take_error (invocation,
-		                                     g_error_new_literal (NM_SETTINGS_ERROR,
-		                                                          NM_SETTINGS_ERROR_INVALID_ARGUMENTS,
-		                                                          "Requires either to-disk (0x1) or in-memory (0x2) flags"));
-		return;
-	}
+/*****************************************************************************/
 
-	if (NM_FLAGS_ALL (flags,   NM_SETTINGS_ADD_CONNECTION2_FLAG_TO_DISK
-	                         | NM_SETTINGS_ADD_CONNECTION2_FLAG_IN_MEMORY)) {
-		g_dbus_method_invocation_take_error (invocation,
-		                                     g_error_new_literal (NM_SETTINGS_ERROR,
-		                                                          NM_SETTINGS_ERROR_INVALID_ARGUMENTS,
-		                                                          "Cannot set to-disk (0x1) and in-memory (0x2) flags together"));
-		return;
+typedef struct {
+	NMSettingsBatchItem *items;
+	char **audit_args;
+	guint n_items;
+	guint32 flags;
+	bool is_update:1;
+} BatchRequest;
+
+static void
+_batch_request_free (BatchRequest *batch)
+{
+	guint i;
+
+	for (i = 0; i < batch->n_items; i++) {
+		NMSettingsBatchItem *item = &batch->items[i];
+
+		nm_g_object_unref (item->connection);
+		if (batch->is_update)
+			nm_g_object_unref (item->sett_conn);
+		nm_clear_error (&item->error);
+		g_free (batch->audit_args[i]);
 	}
+	g_free (batch->items);
+	g_free (batch->audit_args);
+	g_slice_free (BatchRequest, batch);
+}
 
-	nm_assert (g_variant_is_of_type (args, G_VARIANT_TYPE ("a{sv}")));
+static BatchRequest *
+_batch_request_new (guint n_items,
+                    guint32 flags,
+                    gboolean is_update)
+{
+	BatchRequest *batch;
+
+	batch = g_slice_new (BatchRequest);
+	*batch = (BatchRequest) {
+		.items      = g_new0 (NMSettingsBatchItem, n_items),
+		.audit_args = g_new0 (char *, n_items),
+		.n_items    = n_items,
+		.flags      = flags,
+		.is_update  = is_update,
+	};
+	return batch;
+}
 
-	g_variant_iter_init (&iter, args);
-	while (g_variant_iter_next (&iter, "{&sv}", &args_name, NULL)) {
-		g_dbus_method_invocation_take_error (invocation,
-		                                     g_error_new (NM_SETTINGS_ERROR,
-		                                                  NM_SETTINGS_ERROR_INVALID_ARGUMENTS,
-		                                                  "Unsupported argument '%s'", args_name));
+static void
+_batch_request_return (NMSettings *self,
+                       BatchRequest *batch,
+                       GDBusMethodInvocation *context,
+                       NMAuthSubject *subject)
+{
+	GVariantBuilder results;
+	guint i;
+
+	g_variant_builder_init (&results, G_VARIANT_TYPE ("aa{sv}"));
+
+	for (i = 0; i < batch->n_items; i++) {
+		NMSettingsBatchItem *item = &batch->items[i];
+		GVariantBuilder result;
+
+		g_variant_builder_init (&result, G_VARIANT_TYPE_VARDICT);
+		if (item->error) {
+			g_variant_builder_add (&result, "{sv}", "error",
+			                       g_variant_new_string (item->error->message));
+		} else {
+			g_variant_builder_add (&result, "{sv}", "path",
+			                       g_variant_new_object_path (nm_dbus_object_get_path (NM_DBUS_OBJECT (item->sett_conn))));
+		}
+		g_variant_builder_add (&results, "a{sv}", &result);
+
+		nm_audit_log_connection_op (  batch->is_update
+		                            ? NM_AUDIT_OP_CONN_UPDATE
+		                            : NM_AUDIT_OP_CONN_ADD,
+		                            item->sett_conn,
+		                            !item->error,
+		                            batch->audit_args[i],
+		                            subject,
+		                            item->error ? item->error->message : NULL);
+	}
+
+	g_dbus_method_invocation_return_value (context,
+	                                       g_variant_new ("(aa{sv})", &results));
+}
+
+static void
+pk_batch_cb (NMAuthChain *chain,
+             GDBusMethodInvocation *context,
+             gpointer user_data)
+{
+	NMSettings *self = NM_SETTINGS (user_data);
+	BatchRequest *batch;
+	NMAuthSubject *subject;
+	const char *perm;
+	guint i;
+
+	nm_assert (G_IS_DBUS_METHOD_INVOCATION (context));
+
+	c_list_unlink (nm_auth_chain_parent_lst_list (chain));
+
+	perm = nm_auth_chain_get_data (chain, "perm");
+	batch = nm_auth_chain_get_data (chain, "batch");
+	subject = nm_auth_chain_get_data (chain, "subject");
+
+	if (nm_auth_chain_get_result (chain, perm) != NM_AUTH_CALL_RESULT_YES) {
+		if (batch->is_update) {
+			for (i = 0; i < batch->n_items; i++) {
+				if (batch->items[i].sett_conn) {
+					nm_audit_log_connection_op (NM_AUDIT_OP_CONN_UPDATE, batch->items[i].sett_conn, FALSE, NULL,
+					                            subject, NM_UTILS_ERROR_MSG_INSUFF_PRIV);
+				}
+			}
+		} else
+			nm_audit_log_connection_op (NM_AUDIT_OP_CONN_ADD, NULL, FALSE, NULL, subject, NM_UTILS_ERROR_MSG_INSUFF_PRIV);
+		g_dbus_method_invocation_return_error_literal (context,
+		                                               NM_SETTINGS_ERROR,
+		                                               NM_SETTINGS_ERROR_PERMISSION_DENIED,
+		                                               NM_UTILS_ERROR_MSG_INSUFF_PRIV);
 		return;
 	}
 
-	settings_add_connection_helper (self, invocation, TRUE, settings, flags);
+	if (!batch->is_update) {
+		NMSettingsAddConnection2Flags flags = batch->flags;
+
+		nm_settings_add_connections (self,
+		                             batch->items,
+		                             batch->n_items,
+		                               NM_FLAGS_HAS (flags, NM_SETTINGS_ADD_CONNECTION2_FLAG_TO_DISK)
+		                             ? NM_SETTINGS_CONNECTION_PERSIST_MODE_TO_DISK
+		                             : NM_SETTINGS_CONNECTION_PERSIST_MODE_IN_MEMORY_ONLY,
+		                               NM_FLAGS_HAS (flags, NM_SETTINGS_ADD_CONNECTION2_FLAG_BLOCK_AUTOCONNECT)
+		                             ? NM_SETTINGS_CONNECTION_ADD_REASON_BLOCK_AUTOCONNECT
+		                             : NM_SETTINGS_CONNECTION_ADD_REASON_NONE,
+		                             NM_SETTINGS_CONNECTION_INT_FLAGS_NONE);
+
+		_batch_request_return (self, batch, context, subject);
+
+		for (i = 0; i < batch->n_items; i++) {
+			NMSettingsBatchItem *item = &batch->items[i];
+
+			if (   item->sett_conn
+			    && nm_settings_has_connection (self, item->sett_conn))
+				send_agent_owned_secrets (self, item->sett_conn, subject);
+		}
+	} else {
+		NMSettingsUpdate2Flags flags = batch->flags;
+		gboolean audit_enabled;
+
+		audit_enabled = nm_audit_manager_audit_enabled (nm_audit_manager_get ());
+
+		for (i = 0; i < batch->n_items; i++) {
+			NMSettingsBatchItem *item = &batch->items[i];
+
+			if (   item->error
+			    || !item->connection)
+				continue;
+
+			_nm_settings_connection_update_merge_secrets (item->sett_conn, item->connection);
+
+			if (audit_enabled) {
+				gs_unref_hashtable GHashTable *diff = NULL;
+
+				if (   !nm_connection_diff (nm_settings_connection_get_connection (item->sett_conn),
+				                            item->connection,
+				                              NM_SETTING_COMPARE_FLAG_EXACT
+				                            | NM_SETTING_COMPARE_FLAG_DIFF_RESULT_NO_DEFAULT,
+				                            &diff)
+				    && diff)
+					batch->audit_args[i] = nm_utils_format_con_diff_for_audit (diff);
+			}
+		}
+
+		nm_settings_update_connections (self,
+		                                batch->items,
+		                                batch->n_items,
+		                                _nm_settings_update2_flags_get_persist_mode (flags),
+		                                (  NM_FLAGS_HAS (flags, NM_SETTINGS_UPDATE2_FLAG_VOLATILE)
+		                                 ? NM_SETTINGS_CONNECTION_INT_FLAGS_VOLATILE
+		                                 : NM_SETTINGS_CONNECTION_INT_FLAGS_NONE),
+		                                  NM_SETTINGS_CONNECTION_INT_FLAGS_NM_GENERATED
+		                                | NM_SETTINGS_CONNECTION_INT_FLAGS_VOLATILE,
+		                                _nm_settings_update2_flags_get_update_reason (flags),
+		                                "update-from-dbus");
+
+		/* Items rejected before writing (or whose write failed) were not
+		 * updated, don't reset their autoconnect retries. */
+		for (i = 0; i < batch->n_items; i++) {
+			NMSettingsBatchItem *item = &batch->items[i];
+
+			if (   item->sett_conn
+			    && !item->error)
+				_nm_settings_connection_update_complete (item->sett_conn, subject, TRUE);
+		}
+
+		_batch_request_return (self, batch, context, subject);
+	}
+}
+
+static void
+settings_batch_start (NMSettings *self,
+                      GDBusMethodInvocation *context,
+                      NMAuthSubject *subject,
+                      BatchRequest *batch,
+                      const char *perm)
+{
+	NMSettingsPrivate *priv = NM_SETTINGS_GET_PRIVATE (self);
+	NMAuthChain *chain;
+
+	chain = nm_auth_chain_new_subject (subject, context, pk_batch_cb, self);
+	if (!chain) {
+		_batch_request_free (batch);
+		g_dbus_method_invocation_return_error_literal (context,
+		                                               NM_SETTINGS_ERROR,
+		                                               NM_SETTINGS_ERROR_PERMISSION_DENIED,
+		                                               NM_UTILS_ERROR_MSG_REQ_AUTH_FAILED);
+		return;
+	}
+
+	c_list_link_tail (&priv->auth_lst_head, nm_auth_chain_parent_lst_list (chain));
+
+	nm_auth_chain_set_data (chain, "perm", (gpointer) perm, NULL);
+	nm_auth_chain_set_data (chain, "batch", batch, (GDestroyNotify) _batch_request_free);
+	nm_auth_chain_set_data (chain, "subject", g_object_ref (subject), g_object_unref);
+	nm_auth_chain_add_call_unsafe (chain, perm, TRUE);
+}
+
+static void
+impl_settings_add_connections (NMDBusObject *obj,
+                               const NMDBusInterfaceInfoExtended *interface_info,
+                               const NMDBusMethodInfoExtended *method_info,
+                               GDBusConnection *dbus_connection,
+                               const char *sender,
+                               GDBusMethodInvocation *invocation,
+                               GVariant *parameters)
+{
+	NMSettings *self = NM_SETTINGS (obj);
+	gs_unref_variant GVariant *settings_arr = NULL;
+	gs_unref_variant GVariant *args = NULL;
+	gs_unref_object NMAuthSubject *subject = NULL;
+	BatchRequest *batch;
+	GError *error = NULL;
+	const char *perm;
+	guint32 flags_u;
+	guint i;
+
+	g_variant_get (parameters, "(@aa{sa{sv}}u@a{sv})", &settings_arr, &flags_u, &args);
+
+	if (   !_add_connection2_flags_validate (flags_u, &error)
+	    || !_args_validate_empty (args, &error)) {
+		g_dbus_method_invocation_take_error (invocation, error);
+		return;
+	}
+
+	subject = nm_dbus_manager_new_auth_subject_from_context (invocation);
+	if (!subject) {
+		g_dbus_method_invocation_return_error_literal (invocation,
+		                                               NM_SETTINGS_ERROR,
+		                                               NM_SETTINGS_ERROR_PERMISSION_DENIED,
+		                                               NM_UTILS_ERROR_MSG_REQ_UID_UKNOWN);
+		return;
+	}
+
+	batch = _batch_request_new (g_variant_n_children (settings_arr), flags_u, FALSE);
+
+	/* Like for AddConnection2(), the caller may use the 'modify.own' permission
+	 * only if it is the only user in the permissions of every profile. */
+	perm = NM_AUTH_PERMISSION_SETTINGS_MODIFY_OWN;
+
+	for (i = 0; i < batch->n_items; i++) {
+		NMSettingsBatchItem *item = &batch->items[i];
+		gs_unref_variant GVariant *settings = NULL;
+		NMConnection *connection;
+
+		settings = g_variant_get_child_value (settings_arr, i);
+
+		connection = _nm_simple_connection_new_from_dbus (settings,
+		                                                    NM_SETTING_PARSE_FLAGS_STRICT
+		                                                  | NM_SETTING_PARSE_FLAGS_NORMALIZE,
+		                                                  &item->error);
+		if (!connection)
+			continue;
+
+		item->connection = connection;
+
+		if (!nm_connection_verify_secrets (connection, &item->error))
+			continue;
+
+		if (!nm_auth_is_subject_in_acl_set_error (connection,
+		                                          subject,
+		                                          NM_SETTINGS_ERROR,
+		                                          NM_SETTINGS_ERROR_PERMISSION_DENIED,
+		                                          &item->error))
+			continue;
+
+		if (nm_setting_connection_get_num_permissions (nm_connection_get_setting_connection (connection)) != 1)
+			perm = NM_AUTH_PERMISSION_SETTINGS_MODIFY_SYSTEM;
+	}
+
+	settings_batch_start (self, invocation, subject, batch, perm);
+}
+
+static void
+impl_settings_update_connections (NMDBusObject *obj,
+                                  const NMDBusInterfaceInfoExtended *interface_info,
+                                  const NMDBusMethodInfoExtended *method_info,
+                                  GDBusConnection *dbus_connection,
+                                  const char *sender,
+                                  GDBusMethodInvocation *invocation,
+                                  GVariant *parameters)
+{
+	NMSettings *self = NM_SETTINGS (obj);
+	gs_unref_variant GVariant *update_arr = NULL;
+	gs_unref_variant GVariant *args = NULL;
+	gs_unref_object NMAuthSubject *subject = NULL;
+	BatchRequest *batch;
+	GError *error = NULL;
+	const char *perm;
+	guint32 flags_u;
+	guint i;
+
+	g_variant_get (parameters, "(@a(oa{sa{sv}})u@a{sv})", &update_arr, &flags_u, &args);
+
+	if (   !_nm_settings_update2_flags_validate (flags_u, &error)
+	    || !_args_validate_empty (args, &error)) {
+		g_dbus_method_invocation_take_error (invocation, error);
+		return;
+	}
+
+	subject = nm_dbus_manager_new_auth_subject_from_context (invocation);
+	if (!subject) {
+		g_dbus_method_invocation_return_error_literal (invocation,
+		                                               NM_SETTINGS_ERROR,
+		                                               NM_SETTINGS_ERROR_PERMISSION_DENIED,
+		                                               NM_UTILS_ERROR_MSG_REQ_UID_UKNOWN);
+		return;
+	}
+
+	batch = _batch_request_new (g_variant_n_children (update_arr), flags_u, TRUE);
+
+	perm = NM_AUTH_PERMISSION_SETTINGS_MODIFY_OWN;
+
+	for (i = 0; i < batch->n_items; i++) {
+		NMSettingsBatchItem *item = &batch->items[i];
+		gs_unref_variant GVariant *settings = NULL;
+		NMSettingsConnection *sett_conn;
+		NMConnection *connection_old;
+		const char *path;
+
+		g_variant_get_child (update_arr, i, "(&o@a{sa{sv}})", &path, &settings);
+
+		sett_conn = nm_settings_get_connection_by_path (self, path);
+		if (!sett_conn) {
+			g_set_error (&item->error,
+			             NM_SETTINGS_ERROR,
+			             NM_SETTINGS_ERROR_INVALID_CONNECTION,
+			             "Connection '%s' does not exist",
+			             path);
+			continue;
+		}
+
+		item->sett_conn = g_object_ref (sett_conn);
+		connection_old = nm_settings_connection_get_connection (sett_conn);
+
+		if (g_variant_n_children (settings) > 0) {
+			item->connection = _nm_simple_connection_new_from_dbus (settings,
+			                                                          NM_SETTING_PARSE_FLAGS_STRICT
+			                                                        | NM_SETTING_PARSE_FLAGS_NORMALIZE,
+			                                                        &item->error);
+			if (!item->connection)
+				continue;
+
+			if (!nm_connection_verify_secrets (item->connection, &item->error))
+				continue;
+		}
+
+		/* Both the old and the new settings must be visible to the caller. */
+		if (   !nm_auth_is_subject_in_acl_set_error (connection_old,
+		                                             subject,
+		                                             NM_SETTINGS_ERROR,
+		                                             NM_SETTINGS_ERROR_PERMISSION_DENIED,
+		                                             &item->error)
+		    || (   item->connection
+		        && !nm_auth_is_subject_in_acl_set_error (item->connection,
+		                                                 subject,
+		                                                 NM_SETTINGS_ERROR,
+		                                                 NM_SETTINGS_ERROR_PERMISSION_DENIED,
+		                                                 &item->error)))
+			continue;
+
+		if (nm_streq (nm_settings_connection_get_update_modify_permission (connection_old,
+		                                                                   item->connection ?: connection_old),
+		              NM_AUTH_PERMISSION_SETTINGS_MODIFY_SYSTEM))
+			perm = NM_AUTH_PERMISSION_SETTINGS_MODIFY_SYSTEM;
+	}
+
+	settings_batch_start (self, invocation, subject, batch, perm);
 }
 
 /*****************************************************************************/
@@ -2829,9 +3537,227 @@ impl_settings_reload_connections (NMDBusObject *obj,
 
 /*****************************************************************************/
 
+typedef struct {
+	const char *connection_type;
+	const char *ifname;
+	GPtrArray *sett_conns;
+} AutoconnectIdxEntry;
+
+static guint
+_autoconnect_idx_entry_hash (gconstpointer ptr)
+{
+	const AutoconnectIdxEntry *entry = ptr;
+	NMHashState h;
+
+	nm_hash_init (&h, 1870718263u);
+	nm_hash_update_str0 (&h, entry->connection_type);
+	nm_hash_update_str0 (&h, entry->ifname);
+	return nm_hash_complete (&h);
+}
+
+static gboolean
+_autoconnect_idx_entry_equal (gconstpointer a, gconstpointer b)
+{
+	const AutoconnectIdxEntry *entry_a = a;
+	const AutoconnectIdxEntry *entry_b = b;
+
+	return    nm_streq0 (entry_a->connection_type, entry_b->connection_type)
+	       && nm_streq0 (entry_a->ifname, entry_b->ifname);
+}
+
+static void
+_autoconnect_idx_entry_free (gpointer ptr)
+{
+	AutoconnectIdxEntry *entry = ptr;
+
+	g_ptr_array_unref (entry->sett_conns);
+	g_slice_free (AutoconnectIdxEntry, entry);
+}
+
+static void
+_autoconnect_idx_add (GHashTable *idx,
+                      const char *connection_type,
+                      const char *ifname,
+                      NMSettingsConnection *sett_conn)
+{
+	AutoconnectIdxEntry needle = {
+		.connection_type = connection_type,
+		.ifname          = ifname,
+	};
+	AutoconnectIdxEntry *entry;
+
+	entry = g_hash_table_lookup (idx, &needle);
+	if (!entry) {
+		entry = g_slice_new (AutoconnectIdxEntry);
+		*entry = needle;
+		entry->sett_conns = g_ptr_array_new ();
+		g_hash_table_add (idx, entry);
+	}
+	g_ptr_array_add (entry->sett_conns, sett_conn);
+}
+
+static gboolean
+_autoconnect_idx_filter (NMSettings *self,
+                         NMSettingsConnection *sett_conn,
+                         gpointer user_data)
+{
+	NMSettingConnection *s_con;
+
+	if (NM_FLAGS_HAS (nm_settings_connection_get_flags (sett_conn),
+	                  NM_SETTINGS_CONNECTION_INT_FLAGS_VOLATILE))
+		return FALSE;
+
+	s_con = nm_connection_get_setting_connection (nm_settings_connection_get_connection (sett_conn));
+	return nm_setting_connection_get_autoconnect (s_con);
+}
+
+static GHashTable *
+_autoconnect_idx_ensure (NMSettings *self)
+{
+	NMSettingsPrivate *priv = NM_SETTINGS_GET_PRIVATE (self);
+	gs_free NMSettingsConnection **list = NULL;
+	guint len;
+	guint i;
+
+	if (priv->autoconnect_idx)
+		return priv->autoconnect_idx;
+
+	priv->autoconnect_idx = g_hash_table_new_full (_autoconnect_idx_entry_hash,
+	                                               _autoconnect_idx_entry_equal,
+	                                               _autoconnect_idx_entry_free,
+	                                               NULL);
+
+	list = nm_settings_get_connections_clone (self,
+	                                          &len,
+	                                          _autoconnect_idx_filter,
+	                                          NULL,
+	                                          nm_settings_connection_cmp_autoconnect_priority_p_with_data,
+	                                          NULL);
+
+	/* The profiles are added in order of their autoconnect priority, so every
+	 * partition is sorted too. Each profile is tracked once for its type
+	 * and once for the devices that accept any type. The strings are owned
+	 * by the profiles, which invalidate the index when they change. */
+	for (i = 0; i < len; i++) {
+		NMConnection *connection = nm_settings_connection_get_connection (list[i]);
+		const char *ifname = nm_connection_get_interface_name (connection);
+
+		_autoconnect_idx_add (priv->autoconnect_idx,
+		                      nm_connection_get_connection_type (connection),
+		                      ifname,
+		                      list[i]);
+		_autoconnect_idx_add (priv->autoconnect_idx,
+		                      NULL,
+		                      ifname,
+		                      list[i]);
+	}
+
+	return priv->autoconnect_idx;
+}
+
+/**
+ * nm_settings_autoconnect_candidates_invalidate:
+ * @self: the #NMSettings
+ *
+ * Drops the index of nm_settings_get_autoconnect_candidates(). This must be
+ * called whenever the autoconnect order of a profile might have changed.
+ */
+void
+nm_settings_autoconnect_candidates_invalidate (NMSettings *self)
+{
+	g_return_if_fail (NM_IS_SETTINGS (self));
+
+	nm_clear_pointer (&NM_SETTINGS_GET_PRIVATE (self)->autoconnect_idx, g_hash_table_unref);
+}
+
+/**
+ * nm_settings_get_autoconnect_candidates:
+ * @self: the #NMSettings
+ * @connection_type: (allow-none): the connection type the device
+ *   requires, or %NULL if the device can handle various types.
+ * @ifname: (allow-none): the interface name of the device.
+ * @out_len: (allow-none): the number of returned profiles.
+ *
+ * Returns the profiles that have autoconnect enabled, are not volatile
+ * and which could be compatible with a device of @connection_type
+ * and @ifname. That means, profiles that are bound to a different
+ * interface name are skipped. The caller still must check whether the
+ * device can actually autoconnect the profiles.
+ *
+ * Returns: (transfer container): a %NULL terminated array, sorted by
+ *   nm_settings_connection_cmp_autoconnect_priority(). Free with g_free().
+ */
+NMSettingsConnection **
+nm_settings_get_autoconnect_candidates (NMSettings *self,
+                                        const char *connection_type,
+                                        const char *ifname,
+                                        guint *out_len)
+{
+	GHashTable *idx;
+	const AutoconnectIdxEntry *entry;
+	GPtrArray *arr_a = NULL;
+	GPtrArray *arr_b = NULL;
+	NMSettingsConnection **list;
+	guint i_a, i_b, len;
+
+	g_return_val_if_fail (NM_IS_SETTINGS (self), NULL);
+
+	idx = _autoconnect_idx_ensure (self);
+
+	entry = g_hash_table_lookup (idx, &((const AutoconnectIdxEntry) {
+	                                       .connection_type = connection_type,
+	                                   }));
+	if (entry)
+		arr_a = entry->sett_conns;
+
+	if (ifname) {
+		entry = g_hash_table_lookup (idx, &((const AutoconnectIdxEntry) {
+		                                       .connection_type = connection_type,
+		                                       .ifname          = ifname,
+		                                   }));
+		if (entry)
+			arr_b = entry->sett_conns;
+	}
+
+	i_a = arr_a ? arr_a->len : 0;
+	i_b = arr_b ? arr_b->len : 0;
+	len = i_a + i_b;
+	list = g_new (NMSettingsConnection *, (gsize) len + 1);
+
+	/* merge the profiles without interface name with those bound
+	 * to @ifname. Both lists are sorted. */
+	len = 0;
+	i_a = 0;
+	i_b = 0;
+	while (TRUE) {
+		NMSettingsConnection *a = arr_a && i_a < arr_a->len ? arr_a->pdata[i_a] : NULL;
+		NMSettingsConnection *b = arr_b && i_b < arr_b->len ? arr_b->pdata[i_b] : NULL;
+
+		if (!a && !b)
+			break;
+		if (   a
+		    && (   !b
+		        || nm_settings_connection_cmp_autoconnect_priority (a, b) <= 0)) {
+			list[len++] = a;
+			i_a++;
+		} else {
+			list[len++] = b;
+			i_b++;
+		}
+	}
+	list[len] = NULL;
+
+	NM_SET_OUT (out_len, len);
+	return list;
+}
+
+/*****************************************************************************/
+
 static void
 _clear_connections_cached_list (NMSettingsPrivate *priv)
 {
+	nm_clear_pointer (&priv->autoconnect_idx, g_hash_table_unref);
+
 	if (!priv->connections_cached_list)
 		return;
 
@@ -2871,6 +3797,54 @@ impl_settings_list_connections (NMDBusObject *obj,
 	                                       g_variant_new ("(^ao)", strv));
 }
 
+static void
+impl_settings_get_all_settings (NMDBusObject *obj,
+                                const NMDBusInterfaceInfoExtended *interface_info,
+                                const NMDBusMethodInfoExtended *method_info,
+                                GDBusConnection *dbus_connection,
+                                const char *sender,
+                                GDBusMethodInvocation *invocation,
+                                GVariant *parameters)
+{
+	NMSettings *self = NM_SETTINGS (obj);
+	NMSettingsPrivate *priv = NM_SETTINGS_GET_PRIVATE (self);
+	gs_unref_object NMAuthSubject *subject = NULL;
+	NMSettingsConnection *sett_conn;
+	GVariantBuilder builder;
+
+	subject = nm_dbus_manager_new_auth_subject_from_context (invocation);
+	if (!subject) {
+		g_dbus_method_invocation_return_error_literal (invocation,
+		                                               NM_SETTINGS_ERROR,
+		                                               NM_SETTINGS_ERROR_PERMISSION_DENIED,
+		                                               NM_UTILS_ERROR_MSG_REQ_UID_UKNOWN);
+		return;
+	}
+
+	/* Like GetSettings() on each connection, but in one round trip. Connections
+	 * which are not visible to the requestor are silently omitted. */
+	g_variant_builder_init (&builder, G_VARIANT_TYPE ("a{oa{sa{sv}}}"));
+	c_list_for_each_entry (sett_conn, &priv->connections_lst_head, _connections_lst) {
+		const char *path;
+
+		path = nm_dbus_object_get_path (NM_DBUS_OBJECT (sett_conn));
+		if (!path)
+			continue;
+		if (!nm_auth_is_subject_in_acl (nm_settings_connection_get_connection (sett_conn),
+		                                subject,
+		                                NULL))
+			continue;
+
+		g_variant_builder_add (&builder,
+		                       "{o@a{sa{sv}}}",
+		                       path,
+		                       nm_settings_connection_to_dbus_no_secrets (sett_conn));
+	}
+
+	g_dbus_method_invocation_return_value (invocation,
+	                                       g_variant_new ("(a{oa{sa{sv}}})", &builder));
+}
+
 NMSettingsConnection *
 nm_settings_get_connection_by_uuid (NMSettings *self, const char *uuid)
 {
@@ -3378,7 +4352,7 @@ have_connection_for_device (NMSettings *self, NMDevice *device)
 	}
 
 	/* See if there's a known non-NetworkManager configuration for the device */
-	if (nm_device_spec_match_list (device, priv->unrecognized_specs))
+	if (nm_device_match_spec (device, priv->unrecognized_specs_compiled))
 		return TRUE;
 
 	return FALSE;
@@ -3871,6 +4845,8 @@ finalize (GObject *object)
 
 	g_slist_free_full (priv->unmanaged_specs, g_free);
 	g_slist_free_full (priv->unrecognized_specs, g_free);
+	nm_clear_pointer (&priv->unmanaged_specs_compiled, nm_match_spec_free);
+	nm_clear_pointer (&priv->unrecognized_specs_compiled, nm_match_spec_free);
 
 	while ((iter = priv->plugins)) {
 		gs_unref_object NMSettingsPlugin *plugin = iter->data;
@@ -3924,6 +4900,15 @@ static const NMDBusInterfaceInfoExtended interface_info_settings = {
 				),
 				.handle = impl_settings_list_connections,
 			),
+			NM_DEFINE_DBUS_METHOD_INFO_EXTENDED (
+				NM_DEFINE_GDBUS_METHOD_INFO_INIT (
+					"GetAllSettings",
+					.out_args = NM_DEFINE_GDBUS_ARG_INFOS (
+						NM_DEFINE_GDBUS_ARG_INFO ("settings", "a{oa{sa{sv}}}"),
+					),
+				),
+				.handle = impl_settings_get_all_settings,
+			),
 			NM_DEFINE_DBUS_METHOD_INFO_EXTENDED (
 				NM_DEFINE_GDBUS_METHOD_INFO_INIT (
 					"GetConnectionByUuid",
@@ -3975,6 +4960,34 @@ static const NMDBusInterfaceInfoExtended interface_info_settings = {
 				),
 				.handle = impl_settings_add_connection2,
 			),
+			NM_DEFINE_DBUS_METHOD_INFO_EXTENDED (
+				NM_DEFINE_GDBUS_METHOD_INFO_INIT (
+					"AddConnections",
+					.in_args = NM_DEFINE_GDBUS_ARG_INFOS (
+						NM_DEFINE_GDBUS_ARG_INFO ("settings", "aa{sa{sv}}"),
+						NM_DEFINE_GDBUS_ARG_INFO ("flags",    "u"),
+						NM_DEFINE_GDBUS_ARG_INFO ("args",     "a{sv}"),
+					),
+					.out_args = NM_DEFINE_GDBUS_ARG_INFOS (
+						NM_DEFINE_GDBUS_ARG_INFO ("results", "aa{sv}"),
+					),
+				),
+				.handle = impl_settings_add_connections,
+			),
+			NM_DEFINE_DBUS_METHOD_INFO_EXTENDED (
+				NM_DEFINE_GDBUS_METHOD_INFO_INIT (
+					"UpdateConnections",
+					.in_args = NM_DEFINE_GDBUS_ARG_INFOS (
+						NM_DEFINE_GDBUS_ARG_INFO ("connections", "a(oa{sa{sv}})"),
+						NM_DEFINE_GDBUS_ARG_INFO ("flags",       "u"),
+						NM_DEFINE_GDBUS_ARG_INFO ("args",        "a{sv}"),
+					),
+					.out_args = NM_DEFINE_GDBUS_ARG_INFOS (
+						NM_DEFINE_GDBUS_ARG_INFO ("results", "aa{sv}"),
+					),
+				),
+				.handle = impl_settings_update_connections,
+			),
 			NM_DEFINE_DBUS_METHOD_INFO_EXTENDED (
 				NM_DEFINE_GDBUS_METHOD_INFO_INIT (
 					"LoadConnections",
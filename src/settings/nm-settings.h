@@ -83,6 +83,13 @@ NMSettingsConnection **nm_settings_get_connections_clone (NMSettings *self,
                                                           GCompareDataFunc sort_compare_func,
                                                           gpointer sort_data);
 
+NMSettingsConnection **nm_settings_get_autoconnect_candidates (NMSettings *self,
+                                                               const char *connection_type,
+                                                               const char *ifname,
+                                                               guint *out_len);
+
+void nm_settings_autoconnect_candidates_invalidate (NMSettings *self);
+
 gboolean nm_settings_add_connection (NMSettings *settings,
                                      NMConnection *connection,
                                      NMSettingsConnectionPersistMode persist_mode,
@@ -91,6 +98,28 @@ gboolean nm_settings_add_connection (NMSettings *settings,
                                      NMSettingsConnection **out_sett_conn,
                                      GError **error);
 
+/**
+ * NMSettingsBatchItem:
+ * @connection: the profile to add or the new settings for an update.
+ * @sett_conn: for adding, the resulting settings connection (transfer none).
+ *   For updating, the settings connection to update.
+ * @error: set on failure for this item.
+ *
+ * An entry for nm_settings_add_connections() and nm_settings_update_connections().
+ */
+typedef struct {
+	NMConnection *connection;
+	NMSettingsConnection *sett_conn;
+	GError *error;
+} NMSettingsBatchItem;
+
+void nm_settings_add_connections (NMSettings *self,
+                                  NMSettingsBatchItem *items,
+                                  guint n_items,
+                                  NMSettingsConnectionPersistMode persist_mode,
+                                  NMSettingsConnectionAddReason add_reason,
+                                  NMSettingsConnectionIntFlags sett_flags);
+
 gboolean nm_settings_update_connection (NMSettings *self,
                                         NMSettingsConnection *sett_conn,
                                         NMConnection *new_connection,
@@ -101,6 +130,15 @@ gboolean nm_settings_update_connection (NMSettings *self,
                                         const char *log_context_name,
                                         GError **error);
 
+void nm_settings_update_connections (NMSettings *self,
+                                     NMSettingsBatchItem *items,
+                                     guint n_items,
+                                     NMSettingsConnectionPersistMode persist_mode,
+                                     NMSettingsConnectionIntFlags sett_flags,
+                                     NMSettingsConnectionIntFlags sett_mask,
+                                     NMSettingsConnectionUpdateReason update_reason,
+                                     const char *log_context_name);
+
 void nm_settings_delete_connection (NMSettings *self,
                                     NMSettingsConnection *sett_conn,
                                     gboolean allow_add_to_no_auto_default);
@@ -117,6 +155,7 @@ const char *nm_settings_get_dbus_path_for_uuid (NMSettings *self,
 gboolean nm_settings_has_connection (NMSettings *self, NMSettingsConnection *connection);
 
 const GSList *nm_settings_get_unmanaged_specs (NMSettings *self);
+const NMMatchSpec *nm_settings_get_unmanaged_match_spec (NMSettings *self);
 
 void nm_settings_device_added (NMSettings *self, NMDevice *device);
 
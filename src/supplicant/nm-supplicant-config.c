@@ -553,14 +553,15 @@ nm_supplicant_config_add_setting_wireless (NMSupplicantConfig * self,
 	return TRUE;
 }
 
-gboolean
-nm_supplicant_config_add_bgscan (NMSupplicantConfig *self,
-                                 NMConnection *connection,
-                                 GError **error)
+/* Returns the "bgscan" option for @connection, or %NULL if background
+ * scanning is disabled. The "simple" module configures the CQM RSSI
+ * threshold of the interface, which is why others must not touch it
+ * while bgscan is in use. */
+const char *
+nm_supplicant_config_get_bgscan (NMConnection *connection)
 {
 	NMSettingWireless *s_wifi;
 	NMSettingWirelessSecurity *s_wsec;
-	const char *bgscan;
 
 	s_wifi = nm_connection_get_setting_wireless (connection);
 	g_assert (s_wifi);
@@ -571,21 +572,14 @@ nm_supplicant_config_add_bgscan (NMSupplicantConfig *self,
 	if (NM_IN_STRSET (nm_setting_wireless_get_mode (s_wifi),
 	                  NM_SETTING_WIRELESS_MODE_AP,
 	                  NM_SETTING_WIRELESS_MODE_ADHOC))
-		return TRUE;
+		return NULL;
 
 	/* Don't scan when the connection is locked to a specific AP, since
 	 * intra-ESS roaming (which requires periodic scanning) isn't being
 	 * used due to the specific AP lock. (bgo #513820)
 	 */
 	if (nm_setting_wireless_get_bssid (s_wifi))
-		return TRUE;
-
-	/* Default to a very long bgscan interval when signal is OK on the assumption
-	 * that either (a) there aren't multiple APs and we don't need roaming, or
-	 * (b) since EAP/802.1x isn't used and thus there are fewer steps to fail
-	 * during a roam, we can wait longer before scanning for roam candidates.
-	 */
-	bgscan = "simple:30:-70:86400";
+		return NULL;
 
 	/* If using WPA Enterprise, Dynamic WEP or we have seen more than one AP use
 	 * a shorter bgscan interval on the assumption that this is a multi-AP ESS
@@ -598,7 +592,26 @@ nm_supplicant_config_add_bgscan (NMSupplicantConfig *self,
 	        && NM_IN_STRSET (nm_setting_wireless_security_get_key_mgmt (s_wsec),
 	                         "ieee8021x",
 	                         "wpa-eap")))
-		bgscan = "simple:30:-65:300";
+		return "simple:30:-65:300";
+
+	/* Default to a very long bgscan interval when signal is OK on the assumption
+	 * that either (a) there aren't multiple APs and we don't need roaming, or
+	 * (b) since EAP/802.1x isn't used and thus there are fewer steps to fail
+	 * during a roam, we can wait longer before scanning for roam candidates.
+	 */
+	return "simple:30:-70:86400";
+}
+
+gboolean
+nm_supplicant_config_add_bgscan (NMSupplicantConfig *self,
+                                 NMConnection *connection,
+                                 GError **error)
+{
+	const char *bgscan;
+
+	bgscan = nm_supplicant_config_get_bgscan (connection);
+	if (!bgscan)
+		return TRUE;
 
 	return nm_supplicant_config_add_option (self, "bgscan", bgscan, -1, FALSE, error);
 }
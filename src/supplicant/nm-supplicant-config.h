@@ -44,6 +44,8 @@ gboolean nm_supplicant_config_add_bgscan           (NMSupplicantConfig *self,
                                                     NMConnection *connection,
                                                     GError **error);
 
+const char *nm_supplicant_config_get_bgscan (NMConnection *connection);
+
 gboolean nm_supplicant_config_add_setting_wireless_security (NMSupplicantConfig *self,
                                                              NMSettingWirelessSecurity *setting,
                                                              NMSetting8021x *setting_8021x,
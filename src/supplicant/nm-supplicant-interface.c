@@ -15,12 +15,14 @@
 #include "nm-supplicant-config.h"
 #include "nm-core-internal.h"
 #include "nm-std-aux/nm-dbus-compat.h"
+#include "nm-glib-aux/nm-dbus-aux.h"
 
 /*****************************************************************************/
 
 typedef struct {
-	GDBusProxy *proxy;
-	gulong change_id;
+	char *object_path;
+	GHashTable *properties;
+	bool initialized:1;
 } BssData;
 
 typedef struct {
@@ -115,9 +117,13 @@ typedef struct _NMSupplicantInterfacePrivate {
 	AssocData *    assoc_data;
 
 	char *         net_path;
-	GHashTable *   bss_proxies;
+	GHashTable *   bss_infos;
 	char *         current_bss;
 
+	GDBusConnection *dbus_connection;
+	char *         bss_name_owner;
+	guint          bss_properties_changed_id;
+
 	GHashTable *   peer_proxies;
 
 	gint64         last_scan; /* timestamp as returned by nm_utils_get_monotonic_timestamp_msec() */
@@ -211,120 +217,201 @@ bss_data_destroy (gpointer user_data)
 {
 	BssData *bss_data = user_data;
 
-	nm_clear_g_signal_handler (bss_data->proxy, &bss_data->change_id);
-	g_object_unref (bss_data->proxy);
+	g_hash_table_unref (bss_data->properties);
+	g_free (bss_data->object_path);
 	g_slice_free (BssData, bss_data);
 }
 
 static void
-bss_proxy_properties_changed_cb (GDBusProxy *proxy,
-                                 GVariant *changed_properties,
-                                 char **invalidated_properties,
-                                 gpointer user_data)
+bss_data_update_properties (BssData *bss_data, GVariant *properties)
 {
-	NMSupplicantInterface *self = NM_SUPPLICANT_INTERFACE (user_data);
-	NMSupplicantInterfacePrivate *priv = NM_SUPPLICANT_INTERFACE_GET_PRIVATE (self);
-
-	if (priv->scanning)
-		priv->last_scan = nm_utils_get_monotonic_timestamp_msec ();
+	GVariantIter iter;
+	const char *name;
+	GVariant *value;
 
-	g_signal_emit (self, signals[BSS_UPDATED], 0,
-	               g_dbus_proxy_get_object_path (proxy),
-	               changed_properties);
+	g_variant_iter_init (&iter, properties);
+	while (g_variant_iter_next (&iter, "{&sv}", &name, &value))
+		g_hash_table_insert (bss_data->properties, g_strdup (name), value);
 }
 
 static GVariant *
-bss_proxy_get_properties (NMSupplicantInterface *self, GDBusProxy *proxy)
+bss_data_get_properties (BssData *bss_data)
 {
-	gs_strfreev char **properties = NULL;
 	GVariantBuilder builder;
-	char **iter;
-
-	iter = properties = g_dbus_proxy_get_cached_property_names (proxy);
+	GHashTableIter iter;
+	const char *name;
+	GVariant *value;
 
 	g_variant_builder_init (&builder, G_VARIANT_TYPE ("a{sv}"));
-	if (iter) {
-		while (*iter) {
-			GVariant *copy = g_dbus_proxy_get_cached_property (proxy, *iter);
-
-			g_variant_builder_add (&builder, "{sv}", *iter++, copy);
-			g_variant_unref (copy);
-		}
-	}
+	g_hash_table_iter_init (&iter, bss_data->properties);
+	while (g_hash_table_iter_next (&iter, (gpointer *) &name, (gpointer *) &value))
+		g_variant_builder_add (&builder, "{sv}", name, value);
 	return g_variant_builder_end (&builder);
 }
 
 static void
-bss_proxy_acquired_cb (GDBusProxy *proxy, GAsyncResult *result, gpointer user_data)
+bss_properties_changed_cb (GDBusConnection *connection,
+                           const char *sender_name,
+                           const char *object_path,
+                           const char *signal_interface_name,
+                           const char *signal_name,
+                           GVariant *parameters,
+                           gpointer user_data)
+{
+	NMSupplicantInterface *self = NM_SUPPLICANT_INTERFACE (user_data);
+	NMSupplicantInterfacePrivate *priv = NM_SUPPLICANT_INTERFACE_GET_PRIVATE (self);
+	gs_unref_variant GVariant *changed_properties = NULL;
+	BssData *bss_data;
+
+	if (!g_variant_is_of_type (parameters, G_VARIANT_TYPE ("(sa{sv}as)")))
+		return;
+
+	/* we get the signals for the BSS of all interfaces. */
+	bss_data = g_hash_table_lookup (priv->bss_infos, object_path);
+	if (!bss_data)
+		return;
+
+	g_variant_get (parameters, "(&s@a{sv}^a&s)", NULL, &changed_properties, NULL);
+
+	bss_data_update_properties (bss_data, changed_properties);
+
+	/* until the initial GetAll() returns, we only track the changes. */
+	if (!bss_data->initialized)
+		return;
+
+	if (priv->scanning)
+		priv->last_scan = nm_utils_get_monotonic_timestamp_msec ();
+
+	g_signal_emit (self, signals[BSS_UPDATED], 0,
+	               object_path,
+	               changed_properties);
+}
+
+static void
+bss_get_all_cb (GObject *source, GAsyncResult *result, gpointer user_data)
 {
 	NMSupplicantInterface *self;
 	NMSupplicantInterfacePrivate *priv;
+	gs_free char *object_path = NULL;
+	gs_unref_variant GVariant *res = NULL;
+	gs_unref_variant GVariant *props = NULL;
 	gs_free_error GError *error = NULL;
-	GVariant *props = NULL;
-	const char *object_path;
 	BssData *bss_data;
-	gboolean success;
 
-	success = g_async_initable_init_finish (G_ASYNC_INITABLE (proxy), result, &error);
+	nm_utils_user_data_unpack (user_data, &self, &object_path);
+
+	res = g_dbus_connection_call_finish (G_DBUS_CONNECTION (source), result, &error);
 	if (nm_utils_error_is_cancelled (error))
 		return;
 
-	self = NM_SUPPLICANT_INTERFACE (user_data);
 	priv = NM_SUPPLICANT_INTERFACE_GET_PRIVATE (self);
 
-	if (!success) {
-		_LOGD ("failed to acquire BSS proxy: (%s)", error->message);
-		g_hash_table_remove (priv->bss_proxies,
-		                     g_dbus_proxy_get_object_path (proxy));
-		return;
-	}
-
-	object_path = g_dbus_proxy_get_object_path (proxy);
-	bss_data = g_hash_table_lookup (priv->bss_proxies, object_path);
+	bss_data = g_hash_table_lookup (priv->bss_infos, object_path);
 	if (!bss_data)
 		return;
 
-	bss_data->change_id = g_signal_connect (proxy, "g-properties-changed", G_CALLBACK (bss_proxy_properties_changed_cb), self);
+	if (!res) {
+		_LOGD ("failed to get properties of BSS %s: (%s)", object_path, error->message);
+		g_hash_table_remove (priv->bss_infos, object_path);
+	} else {
+		g_variant_get (res, "(@a{sv})", &props);
+		bss_data_update_properties (bss_data, props);
+		bss_data->initialized = TRUE;
 
-	props = bss_proxy_get_properties (self, proxy);
-	g_signal_emit (self, signals[BSS_UPDATED], 0,
-	               g_dbus_proxy_get_object_path (proxy),
-	               g_variant_ref_sink (props));
-	g_variant_unref (props);
+		g_signal_emit (self, signals[BSS_UPDATED], 0,
+		               object_path,
+		               props);
+	}
 
 	if (priv->scan_done_pending)
 		scan_done_emit_signal (self);
 }
 
+static gboolean
+bss_subscribe (NMSupplicantInterface *self)
+{
+	NMSupplicantInterfacePrivate *priv = NM_SUPPLICANT_INTERFACE_GET_PRIVATE (self);
+
+	if (priv->bss_properties_changed_id)
+		return TRUE;
+
+	if (!priv->iface_proxy)
+		return FALSE;
+
+	if (!priv->bss_name_owner) {
+		priv->bss_name_owner = g_dbus_proxy_get_name_owner (priv->iface_proxy);
+		if (!priv->bss_name_owner)
+			return FALSE;
+	}
+
+	if (!priv->dbus_connection)
+		priv->dbus_connection = g_object_ref (g_dbus_proxy_get_connection (priv->iface_proxy));
+
+	/* A single subscription for the property changes of all BSS, instead of
+	 * one proxy per BSS. */
+	priv->bss_properties_changed_id = nm_dbus_connection_signal_subscribe_properties_changed (priv->dbus_connection,
+	                                                                                          priv->bss_name_owner,
+	                                                                                          NULL,
+	                                                                                          NM_WPAS_DBUS_IFACE_BSS,
+	                                                                                          bss_properties_changed_cb,
+	                                                                                          self,
+	                                                                                          NULL);
+	return TRUE;
+}
+
 static void
-bss_add_new (NMSupplicantInterface *self, const char *object_path)
+bss_add_new (NMSupplicantInterface *self, const char *object_path, GVariant *properties)
 {
 	NMSupplicantInterfacePrivate *priv = NM_SUPPLICANT_INTERFACE_GET_PRIVATE (self);
-	GDBusProxy *bss_proxy;
 	BssData *bss_data;
 
 	g_return_if_fail (object_path != NULL);
 
-	if (g_hash_table_lookup (priv->bss_proxies, object_path))
+	if (   properties
+	    && g_variant_n_children (properties) == 0)
+		properties = NULL;
+
+	bss_data = g_hash_table_lookup (priv->bss_infos, object_path);
+	if (   bss_data
+	    && (   bss_data->initialized
+	        || !properties))
 		return;
 
-	bss_proxy = g_object_new (G_TYPE_DBUS_PROXY,
-	                          "g-bus-type", G_BUS_TYPE_SYSTEM,
-	                          "g-flags", G_DBUS_PROXY_FLAGS_NONE,
-	                          "g-name", NM_WPAS_DBUS_SERVICE,
-	                          "g-object-path", object_path,
-	                          "g-interface-name", NM_WPAS_DBUS_IFACE_BSS,
-	                          NULL);
-	bss_data = g_slice_new0 (BssData);
-	bss_data->proxy = bss_proxy;
-	g_hash_table_insert (priv->bss_proxies,
-	                     (char *) g_dbus_proxy_get_object_path (bss_proxy),
-	                     bss_data);
-	g_async_initable_init_async (G_ASYNC_INITABLE (bss_proxy),
-	                             G_PRIORITY_DEFAULT,
-	                             priv->other_cancellable,
-	                             (GAsyncReadyCallback) bss_proxy_acquired_cb,
-	                             self);
+	if (!bss_data) {
+		if (!bss_subscribe (self)) {
+			_LOGD ("cannot track BSS %s without supplicant name owner", object_path);
+			return;
+		}
+
+		bss_data = g_slice_new0 (BssData);
+		bss_data->object_path = g_strdup (object_path);
+		bss_data->properties = g_hash_table_new_full (nm_str_hash, g_str_equal,
+		                                              g_free, (GDestroyNotify) g_variant_unref);
+		g_hash_table_insert (priv->bss_infos, bss_data->object_path, bss_data);
+	}
+
+	if (properties) {
+		/* BSSAdded already carries all properties of the BSS. */
+		bss_data_update_properties (bss_data, properties);
+		bss_data->initialized = TRUE;
+		g_signal_emit (self, signals[BSS_UPDATED], 0,
+		               object_path,
+		               properties);
+		return;
+	}
+
+	g_dbus_connection_call (priv->dbus_connection,
+	                        priv->bss_name_owner,
+	                        object_path,
+	                        DBUS_INTERFACE_PROPERTIES,
+	                        "GetAll",
+	                        g_variant_new ("(s)", NM_WPAS_DBUS_IFACE_BSS),
+	                        G_VARIANT_TYPE ("(a{sv})"),
+	                        G_DBUS_CALL_FLAGS_NONE,
+	                        -1,
+	                        priv->other_cancellable,
+	                        bss_get_all_cb,
+	                        nm_utils_user_data_pack (self, g_strdup (object_path)));
 }
 
 static void
@@ -469,6 +556,8 @@ set_state (NMSupplicantInterface *self, NMSupplicantInterfaceState new_state)
 
 		if (priv->iface_proxy)
 			g_signal_handlers_disconnect_by_data (priv->iface_proxy, self);
+		nm_clear_g_dbus_connection_signal (priv->dbus_connection,
+		                                   &priv->bss_properties_changed_id);
 	}
 
 	priv->state = new_state;
@@ -1079,22 +1168,22 @@ scan_done_emit_signal (NMSupplicantInterface *self)
 	gboolean success;
 	GHashTableIter iter;
 
-	g_hash_table_iter_init (&iter, priv->bss_proxies);
+	g_hash_table_iter_init (&iter, priv->bss_infos);
 	while (g_hash_table_iter_next (&iter, NULL, (gpointer *) &bss_data)) {
 		/* we have some BSS' that need to be initialized first. Delay
 		 * emitting signal. */
-		if (!bss_data->change_id) {
+		if (!bss_data->initialized) {
 			priv->scan_done_pending = TRUE;
 			return;
 		}
 	}
 
 	/* Emit BSS_UPDATED so that wifi device has the APs (in case it removed them) */
-	g_hash_table_iter_init (&iter, priv->bss_proxies);
+	g_hash_table_iter_init (&iter, priv->bss_infos);
 	while (g_hash_table_iter_next (&iter, (gpointer *) &object_path, (gpointer *) &bss_data)) {
 		gs_unref_variant GVariant *props = NULL;
 
-		props = bss_proxy_get_properties (self, bss_data->proxy);
+		props = bss_data_get_properties (bss_data);
 		g_signal_emit (self, signals[BSS_UPDATED], 0,
 		               object_path,
 		               g_variant_ref_sink (props));
@@ -1132,7 +1221,7 @@ wpas_iface_bss_added (GDBusProxy *proxy,
 	if (priv->scanning)
 		priv->last_scan = nm_utils_get_monotonic_timestamp_msec ();
 
-	bss_add_new (self, path);
+	bss_add_new (self, path, props);
 }
 
 static void
@@ -1144,10 +1233,10 @@ wpas_iface_bss_removed (GDBusProxy *proxy,
 	NMSupplicantInterfacePrivate *priv = NM_SUPPLICANT_INTERFACE_GET_PRIVATE (self);
 	BssData *bss_data;
 
-	bss_data = g_hash_table_lookup (priv->bss_proxies, path);
+	bss_data = g_hash_table_lookup (priv->bss_infos, path);
 	if (!bss_data)
 		return;
-	g_hash_table_steal (priv->bss_proxies, path);
+	g_hash_table_steal (priv->bss_infos, path);
 	g_signal_emit (self, signals[BSS_REMOVED], 0, path);
 	bss_data_destroy (bss_data);
 }
@@ -1211,7 +1300,7 @@ props_changed_cb (GDBusProxy *proxy,
 	if (g_variant_lookup (changed_properties, "BSSs", "^a&o", &array)) {
 		iter = array;
 		while (*iter)
-			bss_add_new (self, *iter++);
+			bss_add_new (self, *iter++, NULL);
 		g_free (array);
 	}
 
@@ -2613,7 +2702,7 @@ nm_supplicant_interface_init (NMSupplicantInterface * self)
 	nm_assert (priv->iface_capabilities == NM_SUPPL_CAP_MASK_NONE);
 
 	priv->state = NM_SUPPLICANT_INTERFACE_STATE_INIT;
-	priv->bss_proxies = g_hash_table_new_full (nm_str_hash, g_str_equal, NULL, bss_data_destroy);
+	priv->bss_infos = g_hash_table_new_full (nm_str_hash, g_str_equal, NULL, bss_data_destroy);
 	priv->peer_proxies = g_hash_table_new_full (nm_str_hash, g_str_equal, NULL, peer_data_destroy);
 }
 
@@ -2675,7 +2764,11 @@ dispose (GObject *object)
 	if (priv->wpas_proxy)
 		g_signal_handlers_disconnect_by_data (priv->wpas_proxy, object);
 	g_clear_object (&priv->wpas_proxy);
-	g_clear_pointer (&priv->bss_proxies, g_hash_table_destroy);
+	nm_clear_g_dbus_connection_signal (priv->dbus_connection,
+	                                   &priv->bss_properties_changed_id);
+	g_clear_object (&priv->dbus_connection);
+	g_clear_pointer (&priv->bss_name_owner, g_free);
+	g_clear_pointer (&priv->bss_infos, g_hash_table_destroy);
 	g_clear_pointer (&priv->peer_proxies, g_hash_table_destroy);
 
 	g_clear_pointer (&priv->net_path, g_free);
@@ -0,0 +1,70 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Copyright (C) 2020 Red Hat, Inc.
+ */
+
+#include "nm-default.h"
+
+#include "nm-auth-manager.h"
+
+#include "nm-test-utils-core.h"
+
+/*****************************************************************************/
+
+static NMAuthManager *
+_auth_manager_new (void)
+{
+	/* without polkit there is no D-Bus connection, but the cache still works. */
+	return g_object_new (NM_TYPE_AUTH_MANAGER,
+	                     NM_AUTH_MANAGER_POLKIT_ENABLED, (int) NM_AUTH_POLKIT_MODE_ROOT_ONLY,
+	                     NULL);
+}
+
+static void
+test_cache_drop_sender (void)
+{
+	gs_unref_object NMAuthManager *self = _auth_manager_new ();
+
+	_nm_auth_manager_cache_add (self, "key-1a", ":1.1", TRUE);
+	_nm_auth_manager_cache_add (self, "key-1b", ":1.1", FALSE);
+	_nm_auth_manager_cache_add (self, "key-1c", ":1.1", TRUE);
+	_nm_auth_manager_cache_add (self, "key-2a", ":1.2", TRUE);
+	_nm_auth_manager_cache_add (self, "key-xa", NULL, TRUE);
+
+	g_assert_cmpint (_nm_auth_manager_cache_drop_sender (self, ":1.3"), ==, 0);
+
+	/* dropping a sender with several entries must drop all of them,
+	 * and only them. */
+	g_assert_cmpint (_nm_auth_manager_cache_drop_sender (self, ":1.1"), ==, 3);
+	g_assert (!_nm_auth_manager_cache_has (self, "key-1a"));
+	g_assert (!_nm_auth_manager_cache_has (self, "key-1b"));
+	g_assert (!_nm_auth_manager_cache_has (self, "key-1c"));
+	g_assert (_nm_auth_manager_cache_has (self, "key-2a"));
+	g_assert (_nm_auth_manager_cache_has (self, "key-xa"));
+
+	g_assert_cmpint (_nm_auth_manager_cache_drop_sender (self, ":1.1"), ==, 0);
+
+	/* the sender can come back. */
+	_nm_auth_manager_cache_add (self, "key-1a", ":1.1", TRUE);
+	g_assert (_nm_auth_manager_cache_has (self, "key-1a"));
+
+	/* replacing the only entry of a sender releases the sender. */
+	_nm_auth_manager_cache_add (self, "key-2a", ":1.2", FALSE);
+	g_assert_cmpint (_nm_auth_manager_cache_drop_sender (self, ":1.2"), ==, 1);
+	g_assert_cmpint (_nm_auth_manager_cache_drop_sender (self, ":1.1"), ==, 1);
+	g_assert (_nm_auth_manager_cache_has (self, "key-xa"));
+}
+
+/*****************************************************************************/
+
+NMTST_DEFINE ();
+
+int
+main (int argc, char **argv)
+{
+	nmtst_init_with_logging (&argc, &argv, NULL, "ALL");
+
+	g_test_add_func ("/auth-manager/cache/drop-sender", test_cache_drop_sender);
+
+	return g_test_run ();
+}
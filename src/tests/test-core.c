@@ -1090,11 +1090,30 @@ test_connection_sort_autoconnect_priority (void)
 #define MATCH_S390 "S390:"
 #define MATCH_DRIVER "DRIVER:"
 
+static NMMatchSpecMatchType
+_test_match_spec_device_eval (const GSList *specs,
+                              const char *interface_name,
+                              const char *driver,
+                              const char *driver_version,
+                              const char *hwaddr,
+                              const char *s390_subchannels)
+{
+	nm_auto_free_match_spec NMMatchSpec *spec = NULL;
+	NMMatchSpecMatchType m;
+
+	m = nm_match_spec_device (specs, interface_name, NULL, driver, driver_version, hwaddr, s390_subchannels, NULL);
+
+	/* the compiled spec must always agree with the interpreted one. */
+	spec = nm_match_spec_new (specs);
+	g_assert_cmpint (m, ==, nm_match_spec_match_device (spec, interface_name, NULL, driver, driver_version, hwaddr, s390_subchannels, NULL));
+	return m;
+}
+
 static NMMatchSpecMatchType
 _test_match_spec_device (const GSList *specs, const char *match_str)
 {
 	if (match_str && g_str_has_prefix (match_str, MATCH_S390))
-		return nm_match_spec_device (specs, NULL, NULL, NULL, NULL, NULL, &match_str[NM_STRLEN (MATCH_S390)], NULL);
+		return _test_match_spec_device_eval (specs, NULL, NULL, NULL, NULL, &match_str[NM_STRLEN (MATCH_S390)]);
 	if (match_str && g_str_has_prefix (match_str, MATCH_DRIVER)) {
 		gs_free char *s = g_strdup (&match_str[NM_STRLEN (MATCH_DRIVER)]);
 		char *t;
@@ -1104,9 +1123,9 @@ _test_match_spec_device (const GSList *specs, const char *match_str)
 			t[0] = '\0';
 			t++;
 		}
-		return nm_match_spec_device (specs, NULL, NULL, s, t, NULL, NULL, NULL);
+		return _test_match_spec_device_eval (specs, NULL, s, t, NULL, NULL);
 	}
-	return nm_match_spec_device (specs, match_str, NULL, NULL, NULL, NULL, NULL, NULL);
+	return _test_match_spec_device_eval (specs, match_str, NULL, NULL, NULL, NULL);
 }
 
 static void
@@ -1281,6 +1300,97 @@ test_match_spec_device (void)
 	                            NULL);
 }
 
+static void
+test_match_spec_device_hwaddr (void)
+{
+	GSList *specs;
+
+	specs = nm_match_spec_split ("mac:00:11:22:33:44:55,AA-BB-CC-DD-EE-FF,except:mac:00:11:22:33:44:66,mac:invalid,"
+	                             "mac:80:00:02:08:fe:80:00:00:00:00:00:00:00:02:c9:03:00:00:0f:65");
+
+	g_assert_cmpint (_test_match_spec_device_eval (specs, NULL, NULL, NULL, "00:11:22:33:44:55", NULL), ==, NM_MATCH_SPEC_MATCH);
+	g_assert_cmpint (_test_match_spec_device_eval (specs, NULL, NULL, NULL, "aa:bb:cc:dd:ee:ff", NULL), ==, NM_MATCH_SPEC_MATCH);
+	g_assert_cmpint (_test_match_spec_device_eval (specs, NULL, NULL, NULL, "00:11:22:33:44:66", NULL), ==, NM_MATCH_SPEC_NEG_MATCH);
+	g_assert_cmpint (_test_match_spec_device_eval (specs, NULL, NULL, NULL, "00:11:22:33:44:77", NULL), ==, NM_MATCH_SPEC_NO_MATCH);
+	g_assert_cmpint (_test_match_spec_device_eval (specs, NULL, NULL, NULL, NULL, NULL), ==, NM_MATCH_SPEC_NO_MATCH);
+	g_assert_cmpint (_test_match_spec_device_eval (specs, "AA-BB-CC-DD-EE-FF", NULL, NULL, NULL, NULL), ==, NM_MATCH_SPEC_MATCH);
+
+	/* for infiniband, only the last 8 bytes are compared. */
+	g_assert_cmpint (_test_match_spec_device_eval (specs, NULL, NULL, NULL, "80:00:02:08:fe:80:00:00:00:00:00:00:00:02:c9:03:00:00:0f:65", NULL), ==, NM_MATCH_SPEC_MATCH);
+	g_assert_cmpint (_test_match_spec_device_eval (specs, NULL, NULL, NULL, "80:00:00:48:fe:80:00:00:00:00:00:00:00:02:c9:03:00:00:0f:65", NULL), ==, NM_MATCH_SPEC_MATCH);
+	g_assert_cmpint (_test_match_spec_device_eval (specs, NULL, NULL, NULL, "80:00:02:08:fe:80:00:00:00:00:00:00:00:02:c9:03:00:00:0f:66", NULL), ==, NM_MATCH_SPEC_NO_MATCH);
+	g_assert_cmpint (_test_match_spec_device_eval (specs, NULL, NULL, NULL, "00:02:c9:03:00:00:0f:65", NULL), ==, NM_MATCH_SPEC_NO_MATCH);
+
+	g_slist_free_full (specs, g_free);
+}
+
+static void
+test_match_spec_device_perf (void)
+{
+	const guint N_SPECS = 2000;
+	const guint N_DEVICES = 500;
+	const guint N_ROUNDS = 20;
+	nm_auto_free_match_spec NMMatchSpec *spec = NULL;
+	gs_free NMMatchSpecMatchType *results = NULL;
+	GSList *specs = NULL;
+	char **ifnames;
+	gint64 t_start;
+	gint64 t_interpreted;
+	gint64 t_compiled;
+	guint i, r;
+
+	if (nmtst_test_quick ()) {
+		g_print ("Skipping test: don't run long running test %s (NMTST_DEBUG=slow)\n", g_get_prgname () ?: "test-core");
+		g_test_skip ("Skip long running test");
+		return;
+	}
+
+	/* a spec like one generated for many unmanaged veth devices. */
+	for (i = 0; i < N_SPECS; i++) {
+		switch (i % 4) {
+		case 0:
+			specs = g_slist_prepend (specs, g_strdup_printf ("interface-name:veth%u", i));
+			break;
+		case 1:
+			specs = g_slist_prepend (specs, g_strdup_printf ("mac:02:00:00:00:%02x:%02x", i / 256, i % 256));
+			break;
+		case 2:
+			specs = g_slist_prepend (specs, g_strdup_printf ("interface-name:cni%u*", i));
+			break;
+		case 3:
+			specs = g_slist_prepend (specs, g_strdup_printf ("except:interface-name:veth%u", i));
+			break;
+		}
+	}
+
+	ifnames = g_new0 (char *, N_DEVICES + 1);
+	for (i = 0; i < N_DEVICES; i++)
+		ifnames[i] = g_strdup_printf ("%s%u", (i % 3) ? "veth" : "eth", nmtst_get_rand_uint32 () % (N_SPECS * 2));
+
+	results = g_new (NMMatchSpecMatchType, N_DEVICES);
+
+	t_start = g_get_monotonic_time ();
+	for (r = 0; r < N_ROUNDS; r++) {
+		for (i = 0; i < N_DEVICES; i++)
+			results[i] = nm_match_spec_device (specs, ifnames[i], "ethernet", "veth", NULL, "02:00:00:00:00:05", NULL, NULL);
+	}
+	t_interpreted = g_get_monotonic_time () - t_start;
+
+	t_start = g_get_monotonic_time ();
+	spec = nm_match_spec_new (specs);
+	for (r = 0; r < N_ROUNDS; r++) {
+		for (i = 0; i < N_DEVICES; i++)
+			g_assert_cmpint (results[i], ==, nm_match_spec_match_device (spec, ifnames[i], "ethernet", "veth", NULL, "02:00:00:00:00:05", NULL, NULL));
+	}
+	t_compiled = g_get_monotonic_time () - t_start;
+
+	g_print ("match-spec: %u specs, %u lookups: interpreted %"G_GINT64_FORMAT" usec, compiled %"G_GINT64_FORMAT" usec\n",
+	         N_SPECS, N_DEVICES * N_ROUNDS, t_interpreted, t_compiled);
+
+	g_strfreev (ifnames);
+	g_slist_free_full (specs, g_free);
+}
+
 /*****************************************************************************/
 
 static void
@@ -1992,6 +2102,188 @@ test_dns_create_resolv_conf (void)
 
 /*****************************************************************************/
 
+static char *
+_dns_filter_domains_join (const int *priorities,
+                          const char *const*const*domains,
+                          guint n)
+{
+	GString *str = g_string_new (NULL);
+	char ***result;
+	guint i;
+
+	result = nmtst_dns_filter_domains (priorities, domains, n);
+	for (i = 0; i < n; i++) {
+		gs_free char *s = g_strjoinv (",", result[i]);
+
+		if (i > 0)
+			g_string_append_c (str, '|');
+		g_string_append (str, s);
+		g_strfreev (result[i]);
+	}
+	g_free (result);
+	return g_string_free (str, FALSE);
+}
+
+static void
+_test_filter_domains (const int *priorities,
+                      const char *const*const*domains,
+                      guint n,
+                      const char *expected)
+{
+	gs_free char *result = NULL;
+
+	result = _dns_filter_domains_join (priorities, domains, n);
+	g_assert_cmpstr (result, ==, expected);
+}
+
+static void
+test_dns_filter_domains (void)
+{
+	{
+		const int p[] = { 50, 100 };
+		const char *const*const d[] = { NM_MAKE_STRV ("~", "example.com"),
+		                                NM_MAKE_STRV ("~", "example.com", "other.org") };
+
+		_test_filter_domains (p, d, G_N_ELEMENTS (d), "~,example.com|other.org");
+	}
+	{
+		const int p[] = { -10, 100 };
+		const char *const*const d[] = { NM_MAKE_STRV ("corp.com"),
+		                                NM_MAKE_STRV ("a.corp.com", "corp.com.", "~b.org", "corp.co") };
+
+		_test_filter_domains (p, d, G_N_ELEMENTS (d), "corp.com|~b.org,corp.co");
+	}
+	{
+		const int p[] = { -1, 50, 50 };
+		const char *const*const d[] = { NM_MAKE_STRV ("~"),
+		                                NM_MAKE_STRV ("x.com", "~y.com"),
+		                                NM_MAKE_STRV ("~") };
+
+		_test_filter_domains (p, d, G_N_ELEMENTS (d), "~||");
+	}
+	{
+		const int p[] = { -20, -10, 100 };
+		const char *const*const d[] = { NM_MAKE_STRV ("b.c"),
+		                                NM_MAKE_STRV ("a.b.c", "c"),
+		                                NM_MAKE_STRV ("x.a.b.c", "x.c", "b.c") };
+
+		_test_filter_domains (p, d, G_N_ELEMENTS (d), "b.c|c|");
+	}
+}
+
+/* The algorithm from before the label trie, as reference. */
+static char ***
+_dns_filter_domains_reference (const int *priorities,
+                               const char *const*const*domains,
+                               guint n)
+{
+	gs_unref_hashtable GHashTable *ht = g_hash_table_new (nm_str_hash, g_str_equal);
+	char ***result;
+	guint i, j;
+
+	result = g_new0 (char **, n + 1);
+	for (i = 0; i < n; i++) {
+		GPtrArray *arr = g_ptr_array_new ();
+
+		for (j = 0; domains[i][j]; j++) {
+			const char *domain = nm_utils_parse_dns_domain (domains[i][j], NULL);
+			int old_priority;
+			const char *parent;
+			gboolean shadowed = FALSE;
+
+			old_priority = GPOINTER_TO_INT (g_hash_table_lookup (ht, domain));
+			if (old_priority) {
+				if (old_priority < priorities[i])
+					continue;
+			} else {
+				int p;
+
+				p = GPOINTER_TO_INT (g_hash_table_lookup (ht, ""));
+				shadowed = (p < 0 && p < priorities[i]);
+				for (parent = strchr (domain, '.'); !shadowed && parent && parent[1]; parent = strchr (parent, '.')) {
+					parent++;
+					p = GPOINTER_TO_INT (g_hash_table_lookup (ht, parent));
+					shadowed = (p < 0 && p < priorities[i]);
+				}
+				if (shadowed)
+					continue;
+			}
+			g_hash_table_insert (ht, (gpointer) domain, GINT_TO_POINTER (priorities[i]));
+			g_ptr_array_add (arr, g_strdup (domains[i][j]));
+		}
+		g_ptr_array_add (arr, NULL);
+		result[i] = (char **) g_ptr_array_free (arr, FALSE);
+	}
+	return result;
+}
+
+static void
+test_dns_filter_domains_perf (void)
+{
+	const guint N_CONFIGS = 200;
+	const guint N_DOMAINS = 150;
+	gs_free int *priorities = NULL;
+	char ***domains;
+	char ***result;
+	char ***expected;
+	gint64 t_start;
+	gint64 t_reference;
+	gint64 t_trie;
+	guint i, j;
+
+	if (nmtst_test_quick ()) {
+		g_print ("Skipping test: don't run long running test %s (NMTST_DEBUG=slow)\n", g_get_prgname () ?: "test-core");
+		g_test_skip ("Skip long running test");
+		return;
+	}
+
+	/* many VPNs with overlapping routing domains below a few shared
+	 * parents, some of them with negative priorities. */
+	priorities = g_new (int, N_CONFIGS);
+	domains = g_new0 (char **, N_CONFIGS + 1);
+	for (i = 0; i < N_CONFIGS; i++) {
+		priorities[i] = ((int) i - 20) * 5;
+		if (priorities[i] == 0)
+			priorities[i] = 1;
+		domains[i] = g_new0 (char *, N_DOMAINS + 1);
+		for (j = 0; j < N_DOMAINS; j++) {
+			guint32 r = nmtst_get_rand_uint32 ();
+
+			if (j == 0 && i % 7 == 0)
+				domains[i][j] = g_strdup_printf ("~region%u.corp.example.com", r % 10);
+			else {
+				domains[i][j] = g_strdup_printf ("~host%u.site%u.region%u.corp.example.com",
+				                                 r % 1000,
+				                                 (r / 1000) % 50,
+				                                 (r / 50000) % 10);
+			}
+		}
+	}
+
+	t_start = g_get_monotonic_time ();
+	expected = _dns_filter_domains_reference (priorities, (const char *const*const*) domains, N_CONFIGS);
+	t_reference = g_get_monotonic_time () - t_start;
+
+	t_start = g_get_monotonic_time ();
+	result = nmtst_dns_filter_domains (priorities, (const char *const*const*) domains, N_CONFIGS);
+	t_trie = g_get_monotonic_time () - t_start;
+
+	for (i = 0; i < N_CONFIGS; i++) {
+		g_assert (_nm_utils_strv_equal (result[i], expected[i]));
+		g_strfreev (result[i]);
+		g_strfreev (expected[i]);
+		g_strfreev (domains[i]);
+	}
+	g_free (result);
+	g_free (expected);
+	g_free (domains);
+
+	g_print ("dns-domains: %u domains: hash table %"G_GINT64_FORMAT" usec, label trie %"G_GINT64_FORMAT" usec\n",
+	         N_CONFIGS * N_DOMAINS, t_reference, t_trie);
+}
+
+/*****************************************************************************/
+
 static void
 test_machine_id_read (void)
 {
@@ -2210,6 +2502,8 @@ main (int argc, char **argv)
 	g_test_add_func ("/general/connection-sort/autoconnect-priority", test_connection_sort_autoconnect_priority);
 
 	g_test_add_func ("/general/match-spec/device", test_match_spec_device);
+	g_test_add_func ("/general/match-spec/device-hwaddr", test_match_spec_device_hwaddr);
+	g_test_add_func ("/general/match-spec/device-perf", test_match_spec_device_perf);
 	g_test_add_func ("/general/match-spec/config", test_match_spec_config);
 	g_test_add_func ("/general/duplicate_decl_specifier", test_duplicate_decl_specifier);
 
@@ -2224,6 +2518,8 @@ main (int argc, char **argv)
 	g_test_add_func ("/general/test_utils_file_is_in_path", test_utils_file_is_in_path);
 
 	g_test_add_func ("/general/test_dns_create_resolv_conf", test_dns_create_resolv_conf);
+	g_test_add_func ("/general/dns/filter-domains", test_dns_filter_domains);
+	g_test_add_func ("/general/dns/filter-domains-perf", test_dns_filter_domains_perf);
 
 	g_test_add_data_func ("/general/nm_utils_dhcp_client_id_systemd_node_specific/0", GINT_TO_POINTER (0), test_nm_utils_dhcp_client_id_systemd_node_specific);
 	g_test_add_data_func ("/general/nm_utils_dhcp_client_id_systemd_node_specific/1", GINT_TO_POINTER (1), test_nm_utils_dhcp_client_id_systemd_node_specific);
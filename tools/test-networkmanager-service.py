@@ -1522,6 +1522,10 @@ class NetworkManager(ExportedObj):
     def UpdateConnection(self, path, con_hash, do_verify_strict):
         return gl.settings.update_connection(con_hash, path, do_verify_strict)
 
+    @dbus.service.method(dbus_interface=IFACE_TEST, in_signature='', out_signature='uu')
+    def GetSettingsCallCounts(self):
+        return (gl.settings.get_settings_calls, gl.settings.get_all_settings_calls)
+
     @dbus.service.method(dbus_interface=IFACE_TEST, in_signature='ba{ss}', out_signature='')
     def ConnectionSetVisible(self, vis, selector_args):
         cons = list(gl.settings.find_connections(**selector_args))
@@ -1592,8 +1596,12 @@ class Connection(ExportedObj):
         self.con_hash = con_hash;
         self.Updated()
 
+    def set_unsaved(self, unsaved):
+        self._dbus_property_set(IFACE_CONNECTION, PRP_CONNECTION_UNSAVED, unsaved)
+
     @dbus.service.method(dbus_interface=IFACE_CONNECTION, in_signature='', out_signature='a{sa{sv}}')
     def GetSettings(self):
+        gl.settings.get_settings_calls += 1
         if hasattr(self, '_remove_next_connection_cb'):
             self._remove_next_connection_cb()
             raise BusErr.UnknownConnectionException("Connection not found")
@@ -1640,6 +1648,8 @@ class Settings(ExportedObj):
         self.connections = {}
         self.c_counter = 0
         self.remove_next_connection = False
+        self.get_settings_calls = 0
+        self.get_all_settings_calls = 0
 
         props = {
             PRP_SETTINGS_HOSTNAME:    "foobar.baz",
@@ -1682,10 +1692,52 @@ class Settings(ExportedObj):
     def ListConnections(self):
         return self.get_connection_paths()
 
+    @dbus.service.method(dbus_interface=IFACE_SETTINGS, in_signature='', out_signature='a{oa{sa{sv}}}')
+    def GetAllSettings(self):
+        # Like GetSettings() on each connection. Invisible connections are
+        # omitted.
+        self.get_all_settings_calls += 1
+        return dbus.Dictionary(dict((c.path, c.con_hash) for c in self.get_connections() if c.visible),
+                               signature='oa{sa{sv}}')
+
     @dbus.service.method(dbus_interface=IFACE_SETTINGS, in_signature='a{sa{sv}}', out_signature='o')
     def AddConnection(self, con_hash):
         return self.add_connection(con_hash)
 
+    @dbus.service.method(dbus_interface=IFACE_SETTINGS, in_signature='aa{sa{sv}}ua{sv}', out_signature='aa{sv}')
+    def AddConnections(self, con_hashes, flags, args):
+        # Like NetworkManager, each profile gets its own result and a failing
+        # profile does not prevent the others from being added.
+        results = []
+        for con_hash in con_hashes:
+            try:
+                path = self.add_connection(con_hash)
+            except dbus.DBusException as e:
+                results.append({ 'error': dbus.String(e.get_dbus_message()) })
+                continue
+            # NM_SETTINGS_ADD_CONNECTION2_FLAG_IN_MEMORY
+            self.connections[path].set_unsaved(bool(flags & 0x2))
+            results.append({ 'path': dbus.ObjectPath(path) })
+        return dbus.Array(results, 'a{sv}')
+
+    @dbus.service.method(dbus_interface=IFACE_SETTINGS, in_signature='a(oa{sa{sv}})ua{sv}', out_signature='aa{sv}')
+    def UpdateConnections(self, updates, flags, args):
+        results = []
+        for (path, con_hash) in updates:
+            try:
+                self.update_connection(con_hash, path)
+            except dbus.DBusException as e:
+                results.append({ 'error': dbus.String(e.get_dbus_message()) })
+                continue
+            # The persist mode is evaluated per profile. Without any of the
+            # persist flags, each profile keeps its current storage.
+            if flags & 0x1:
+                self.connections[path].set_unsaved(False)
+            elif flags & (0x2 | 0x4 | 0x8):
+                self.connections[path].set_unsaved(True)
+            results.append({ 'path': dbus.ObjectPath(path) })
+        return dbus.Array(results, 'a{sv}')
+
     def add_connection(self, con_hash, do_verify_strict=True):
         self.c_counter += 1
         con_inst = Connection(self.c_counter, con_hash, do_verify_strict)